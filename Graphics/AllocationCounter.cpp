@@ -0,0 +1,56 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new and delete, the nothrow versions go through these
+static std::atomic<unsigned long long> heapAllocationCount(0);
+
+unsigned long long GetHeapAllocationCount()
+{
+	return heapAllocationCount.load(std::memory_order_relaxed);
+}
+
+static void* CountedAllocate(std::size_t size)
+{
+	heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+	void* pointer = std::malloc(size ? size : 1);
+	if (!pointer)
+	{
+		throw std::bad_alloc();
+	}
+
+	return pointer;
+}
+
+void* operator new(std::size_t size)
+{
+	return CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return CountedAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t /*size*/) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t /*size*/) noexcept
+{
+	std::free(pointer);
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Counts every operator new in the program, on any thread, so a frame can be checked for heap allocations by
+// comparing the count before and after it. Aligned new isn't counted, and neither is anything that calls malloc
+// directly (e.g. the GL driver or GLFW).
+unsigned long long GetHeapAllocationCount();
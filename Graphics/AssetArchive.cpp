@@ -0,0 +1,244 @@
+#include "AssetArchive.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+
+static const char ARCHIVE_MAGIC[4] = { 'A', 'P', 'A', 'K' };
+
+AssetArchive::AssetArchive()
+{
+	this->header = NULL;
+	this->entries = NULL;
+	this->names = NULL;
+}
+
+bool AssetArchive::Open(const std::string& path)
+{
+	this->Close();
+	if (!this->file.Open(path) || this->file.GetSize() < sizeof(sHeader))
+	{
+		this->Close();
+		return false;
+	}
+
+	const unsigned char* data = this->file.GetData();
+	size_t size = this->file.GetSize();
+	const sHeader* fileHeader = (const sHeader*) data;
+	if (memcmp(fileHeader->magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || fileHeader->version != VERSION)
+	{
+		this->Close();
+		return false;
+	}
+
+	// Make sure nothing points outside the file, so Find never has to check. Every check subtracts from the size
+	// instead of adding offsets together, so offsets near 2^64 can't wrap around and pass.
+	uint64_t indexSize = (uint64_t) fileHeader->entryCount * sizeof(sEntry); // Can't wrap, entryCount is 32 bits
+	if (fileHeader->indexOffset % alignof(sEntry) != 0 || indexSize > size || fileHeader->indexOffset > size - indexSize
+		|| fileHeader->namesOffset > size)
+	{
+		this->Close();
+		return false;
+	}
+
+	uint64_t namesSize = size - fileHeader->namesOffset;
+	const sEntry* fileEntries = (const sEntry*) (data + fileHeader->indexOffset);
+	for (uint32_t i = 0; i < fileHeader->entryCount; i++)
+	{
+		const sEntry& entry = fileEntries[i];
+		if (entry.size > size || entry.dataOffset > size - entry.size
+			|| entry.nameLength > namesSize || entry.nameOffset > namesSize - entry.nameLength)
+		{
+			this->Close();
+			return false;
+		}
+	}
+
+	this->header = fileHeader;
+	this->entries = fileEntries;
+	this->names = (const char*) (data + fileHeader->namesOffset);
+	return true;
+}
+
+void AssetArchive::Close()
+{
+	this->file.Close();
+	this->header = NULL;
+	this->entries = NULL;
+	this->names = NULL;
+}
+
+std::string AssetArchive::NormalizeName(const std::string& name)
+{
+	std::string normalized = name;
+	for (char& c : normalized)
+	{
+		c = c == '\\' ? '/' : (char) tolower((unsigned char) c);
+	}
+
+	return normalized;
+}
+
+// Same order as std::string's operator<, which is what Build sorts by
+static int CompareNames(const char* a, size_t aLength, const char* b, size_t bLength)
+{
+	int result = memcmp(a, b, std::min(aLength, bLength));
+	if (result != 0)
+	{
+		return result;
+	}
+
+	return aLength < bLength ? -1 : (aLength > bLength ? 1 : 0);
+}
+
+const unsigned char* AssetArchive::Find(const std::string& name, size_t& size, eArchiveEntryType* type) const
+{
+	if (!this->header)
+	{
+		return NULL;
+	}
+
+	std::string normalized = NormalizeName(name);
+
+	uint32_t low = 0;
+	uint32_t high = this->header->entryCount;
+	while (low < high)
+	{
+		uint32_t middle = low + (high - low) / 2;
+		const sEntry& entry = this->entries[middle];
+		int compare = CompareNames(this->names + entry.nameOffset, entry.nameLength, normalized.data(), normalized.size());
+		if (compare == 0)
+		{
+			size = (size_t) entry.size;
+			if (type)
+			{
+				*type = (eArchiveEntryType) entry.type;
+			}
+
+			return this->file.GetData() + entry.dataOffset;
+		}
+
+		if (compare < 0)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	return NULL;
+}
+
+static void WritePadding(std::ofstream& output, uint64_t& offset, uint64_t alignment)
+{
+	static const char zeros[AssetArchive::DATA_ALIGNMENT] = {};
+	uint64_t padding = (alignment - offset % alignment) % alignment;
+	output.write(zeros, (std::streamsize) padding);
+	offset += padding;
+}
+
+bool AssetArchive::Build(const std::string& outputPath, const std::vector<sBuildInput>& inputs, std::string& error)
+{
+	// The index has to be sorted, the data can go in any order. Keep the data in input order so the
+	// caller decides what's next to what on disk (e.g. everything needed at startup first).
+	std::vector<size_t> sorted(inputs.size());
+	std::vector<std::string> normalizedNames(inputs.size());
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		sorted[i] = i;
+		normalizedNames[i] = NormalizeName(inputs[i].name);
+	}
+	std::sort(sorted.begin(), sorted.end(), [&normalizedNames](size_t a, size_t b) { return normalizedNames[a] < normalizedNames[b]; });
+
+	for (size_t i = 1; i < sorted.size(); i++)
+	{
+		if (normalizedNames[sorted[i]] == normalizedNames[sorted[i - 1]])
+		{
+			error = "Two entries are named " + normalizedNames[sorted[i]];
+			return false;
+		}
+	}
+
+	std::ofstream output(outputPath.c_str(), std::ios::binary | std::ios::trunc);
+	if (!output.is_open())
+	{
+		error = "Couldn't create " + outputPath;
+		return false;
+	}
+
+	sHeader fileHeader;
+	memset(&fileHeader, 0, sizeof(fileHeader));
+	output.write((const char*) &fileHeader, sizeof(fileHeader)); // Filled in at the end
+	uint64_t offset = sizeof(fileHeader);
+
+	std::vector<sEntry> fileEntries(inputs.size());
+	std::vector<unsigned char> fileData;
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		const sBuildInput& input = inputs[i];
+		const std::vector<unsigned char>* data = &input.data;
+		if (input.data.empty() && !input.sourcePath.empty())
+		{
+			std::ifstream source(input.sourcePath.c_str(), std::ios::binary);
+			if (!source.is_open())
+			{
+				error = "Couldn't read " + input.sourcePath;
+				return false;
+			}
+
+			fileData.assign(std::istreambuf_iterator<char>(source), std::istreambuf_iterator<char>());
+			data = &fileData;
+		}
+
+		WritePadding(output, offset, DATA_ALIGNMENT);
+
+		sEntry& entry = fileEntries[i];
+		memset(&entry, 0, sizeof(entry));
+		entry.dataOffset = offset;
+		entry.size = data->size();
+		entry.type = (uint32_t) input.type;
+
+		output.write((const char*) data->data(), (std::streamsize) data->size());
+		offset += data->size();
+	}
+
+	// Index, in name order
+	WritePadding(output, offset, alignof(sEntry));
+	fileHeader.indexOffset = offset;
+
+	uint32_t nameOffset = 0;
+	for (size_t i : sorted)
+	{
+		sEntry& entry = fileEntries[i];
+		entry.nameOffset = nameOffset;
+		entry.nameLength = (uint32_t) normalizedNames[i].size();
+		nameOffset += entry.nameLength;
+
+		output.write((const char*) &entry, sizeof(entry));
+		offset += sizeof(entry);
+	}
+
+	fileHeader.namesOffset = offset;
+	for (size_t i : sorted)
+	{
+		output.write(normalizedNames[i].data(), (std::streamsize) normalizedNames[i].size());
+	}
+
+	memcpy(fileHeader.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+	fileHeader.version = VERSION;
+	fileHeader.entryCount = (uint32_t) inputs.size();
+	fileHeader.dataAlignment = DATA_ALIGNMENT;
+	output.seekp(0);
+	output.write((const char*) &fileHeader, sizeof(fileHeader));
+
+	if (!output.good())
+	{
+		error = "Failed writing " + outputPath;
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum eArchiveEntryType
+{
+	ARCHIVE_ENTRY_RAW,
+	ARCHIVE_ENTRY_MESH,
+	ARCHIVE_ENTRY_TEXTURE,
+	ARCHIVE_ENTRY_SHADER
+};
+
+// One pack file holding all our assets, so startup is one sequential read of one file instead of dozens of opens.
+// Layout:
+//	sHeader
+//	entry data, each starting on a DATA_ALIGNMENT boundary so it can go straight into a GPU buffer
+//	sEntry index, sorted by name for binary search
+//	entry names, not null terminated
+// Everything is little endian, and the archive is used straight out of the mapping (nothing is copied on open).
+class AssetArchive
+{
+public:
+	static const uint32_t VERSION = 1;
+	static const uint32_t DATA_ALIGNMENT = 256;
+
+	struct sHeader
+	{
+		char magic[4];			// "APAK"
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t dataAlignment;
+		uint64_t indexOffset;
+		uint64_t namesOffset;
+	};
+
+	struct sEntry
+	{
+		uint64_t dataOffset;
+		uint64_t size;
+		uint32_t nameOffset;	// From namesOffset
+		uint32_t nameLength;
+		uint32_t type;			// eArchiveEntryType
+		uint32_t reserved;
+	};
+
+	AssetArchive();
+
+	// Maps the archive and checks its header and index, returns false if it isn't a valid archive
+	bool Open(const std::string& path);
+	void Close();
+
+	// Zero copy, the data points into the mapping and stays valid until Close. NULL if there's no such entry.
+	// The name is normalized first, see NormalizeName.
+	const unsigned char* Find(const std::string& name, size_t& size, eArchiveEntryType* type = NULL) const;
+
+	inline void Prefetch() const
+	{
+		this->file.Prefetch();
+	}
+
+	inline unsigned int GetEntryCount() const
+	{
+		return this->header ? this->header->entryCount : 0;
+	}
+
+	inline size_t GetFileSize() const
+	{
+		return this->file.GetSize();
+	}
+
+	// How entry names are stored: forward slashes, lowercase (our asset paths come from Windows, where case doesn't matter)
+	static std::string NormalizeName(const std::string& name);
+
+	struct sBuildInput
+	{
+		std::string name;
+		eArchiveEntryType type = ARCHIVE_ENTRY_RAW;
+		std::string sourcePath;				// Read from here if data is empty
+		std::vector<unsigned char> data;
+	};
+
+	// Writes an archive with the given entries, used by the asset tools. Returns false and fills in error if it fails.
+	static bool Build(const std::string& outputPath, const std::vector<sBuildInput>& inputs, std::string& error);
+
+private:
+	MappedFile file;
+	const sHeader* header;
+	const sEntry* entries;
+	const char* names;
+};
@@ -0,0 +1,484 @@
+#include "AssetReader.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#endif
+
+AssetReader* AssetReader::instance = NULL;
+
+AssetReader::AssetReader()
+{
+	this->uringUnavailable = false;
+}
+
+AssetReader::~AssetReader()
+{
+
+}
+
+AssetReader* AssetReader::GetInstance()
+{
+	if (AssetReader::instance == NULL)
+	{
+		AssetReader::instance = new AssetReader();
+	}
+
+	return instance;
+}
+
+void AssetReader::Request(const std::string& path)
+{
+	sFileView view;
+	if (VirtualFileSystem::GetInstance()->Find(path, view))
+	{
+		return;
+	}
+
+	if (this->files.find(path) != this->files.end() || std::find(this->requested.begin(), this->requested.end(), path) != this->requested.end())
+	{
+		return;
+	}
+
+	this->requested.push_back(path);
+}
+
+bool AssetReader::ReadRequested()
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	std::vector<sRead> reads(this->requested.size());
+	for (size_t i = 0; i < this->requested.size(); i++)
+	{
+		reads[i].path = this->requested[i];
+	}
+	this->requested.clear();
+
+	this->lastBatch = sBatchStats();
+	this->lastBatch.usedUring = this->ReadWithUring(reads);
+	if (!this->lastBatch.usedUring)
+	{
+		this->ReadWithJobs(reads);
+	}
+
+	bool success = true;
+	for (sRead& read : reads)
+	{
+		if (read.failed)
+		{
+			std::cout << "Couldn't read asset file " << read.path << std::endl;
+			this->freeBuffers.push_back(std::move(read.buffer));
+			this->lastBatch.failedCount++;
+			success = false;
+			continue;
+		}
+
+		read.buffer.resize(read.bytesRead); // Only shrinks if the file got shorter while we read it
+		this->lastBatch.fileCount++;
+		this->lastBatch.bytes += read.bytesRead;
+		this->files[read.path] = std::move(read.buffer);
+	}
+
+	this->lastBatch.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return success;
+}
+
+bool AssetReader::GetFile(const std::string& path, sFileView& view) const
+{
+	if (VirtualFileSystem::GetInstance()->Find(path, view))
+	{
+		return true;
+	}
+
+	std::map<std::string, std::vector<unsigned char>>::const_iterator it = this->files.find(path);
+	if (it == this->files.end())
+	{
+		return false;
+	}
+
+	view.data = it->second.data();
+	view.size = it->second.size();
+	return true;
+}
+
+void AssetReader::Release(const std::string& path)
+{
+	std::map<std::string, std::vector<unsigned char>>::iterator it = this->files.find(path);
+	if (it != this->files.end())
+	{
+		this->freeBuffers.push_back(std::move(it->second));
+		this->files.erase(it);
+	}
+}
+
+void AssetReader::ReleaseAll()
+{
+	std::map<std::string, std::vector<unsigned char>>::iterator it;
+	for (it = this->files.begin(); it != this->files.end(); it++)
+	{
+		this->freeBuffers.push_back(std::move(it->second));
+	}
+
+	this->files.clear();
+}
+
+void AssetReader::PrintLastBatchReport() const
+{
+	std::cout << "Read " << this->lastBatch.fileCount << " asset files (" << this->lastBatch.bytes / 1024 << " KB) in "
+		<< this->lastBatch.seconds * 1000.0 << " ms with " << (this->lastBatch.usedUring ? "io_uring" : "jobs");
+	if (this->lastBatch.failedCount > 0)
+	{
+		std::cout << ", " << this->lastBatch.failedCount << " failed";
+	}
+	std::cout << std::endl;
+}
+
+std::vector<unsigned char> AssetReader::AcquireBuffer(size_t size)
+{
+	// Smallest pooled buffer that's big enough, otherwise the biggest one so it grows the least
+	size_t best = this->freeBuffers.size();
+	for (size_t i = 0; i < this->freeBuffers.size(); i++)
+	{
+		size_t capacity = this->freeBuffers[i].capacity();
+		if (best == this->freeBuffers.size())
+		{
+			best = i;
+			continue;
+		}
+
+		size_t bestCapacity = this->freeBuffers[best].capacity();
+		bool fits = capacity >= size;
+		bool bestFits = bestCapacity >= size;
+		if ((fits && (!bestFits || capacity < bestCapacity)) || (!fits && !bestFits && capacity > bestCapacity))
+		{
+			best = i;
+		}
+	}
+
+	std::vector<unsigned char> buffer;
+	if (best != this->freeBuffers.size())
+	{
+		buffer = std::move(this->freeBuffers[best]);
+		this->freeBuffers.erase(this->freeBuffers.begin() + best);
+	}
+
+	buffer.resize(size);
+	return buffer;
+}
+
+// Reads a whole file on the calling thread, used by the job fallback
+static bool ReadWholeFile(const std::string& path, std::vector<unsigned char>& buffer, size_t& bytesRead)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	bytesRead = 0;
+	if (fseek(file, 0, SEEK_END) == 0)
+	{
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		if (size > 0)
+		{
+			buffer.resize((size_t) size);
+			bytesRead = fread(buffer.data(), 1, buffer.size(), file);
+		}
+	}
+
+	bool success = ferror(file) == 0;
+	fclose(file);
+	return success;
+}
+
+void AssetReader::ReadWithJobs(std::vector<sRead>& reads)
+{
+	// Hand out the pooled buffers up front, the pool isn't thread safe
+	for (sRead& read : reads)
+	{
+		if (read.buffer.capacity() == 0)
+		{
+			read.buffer = this->AcquireBuffer(0);
+		}
+	}
+
+	// One file a job, the workers block on the disk in parallel
+	JobSystem::GetInstance()->ParallelFor((unsigned int) reads.size(), 1, [&reads](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			reads[i].failed = !ReadWholeFile(reads[i].path, reads[i].buffer, reads[i].bytesRead);
+		}
+	});
+}
+
+#ifdef __linux__
+// Just enough of io_uring to batch reads, straight on the syscalls so we don't need liburing
+struct sUring
+{
+	int fd = -1;
+	unsigned int entries = 0;
+
+	void* sqRing = MAP_FAILED;
+	size_t sqRingSize = 0;
+	unsigned int* sqHead = NULL;
+	unsigned int* sqTail = NULL;
+	unsigned int* sqMask = NULL;
+	unsigned int* sqArray = NULL;
+	io_uring_sqe* sqes = (io_uring_sqe*) MAP_FAILED;
+	size_t sqesSize = 0;
+
+	void* cqRing = MAP_FAILED;
+	size_t cqRingSize = 0;
+	unsigned int* cqHead = NULL;
+	unsigned int* cqTail = NULL;
+	unsigned int* cqMask = NULL;
+	io_uring_cqe* cqes = NULL;
+};
+
+static void DestroyUring(sUring& ring)
+{
+	if (ring.sqes != MAP_FAILED)
+	{
+		munmap(ring.sqes, ring.sqesSize);
+	}
+	if (ring.cqRing != MAP_FAILED)
+	{
+		munmap(ring.cqRing, ring.cqRingSize);
+	}
+	if (ring.sqRing != MAP_FAILED)
+	{
+		munmap(ring.sqRing, ring.sqRingSize);
+	}
+	if (ring.fd != -1)
+	{
+		close(ring.fd);
+	}
+}
+
+static bool SetupUring(sUring& ring, unsigned int entries)
+{
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	ring.fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+	if (ring.fd < 0) // Old kernel, or blocked (containers often seccomp it out)
+	{
+		ring.fd = -1;
+		return false;
+	}
+	ring.entries = params.sq_entries;
+
+	ring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	ring.sqRing = mmap(NULL, ring.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+	ring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	ring.cqRing = mmap(NULL, ring.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+	ring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	ring.sqes = (io_uring_sqe*) mmap(NULL, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+	if (ring.sqRing == MAP_FAILED || ring.cqRing == MAP_FAILED || ring.sqes == MAP_FAILED)
+	{
+		return false;
+	}
+
+	unsigned char* sq = (unsigned char*) ring.sqRing;
+	ring.sqHead = (unsigned int*) (sq + params.sq_off.head);
+	ring.sqTail = (unsigned int*) (sq + params.sq_off.tail);
+	ring.sqMask = (unsigned int*) (sq + params.sq_off.ring_mask);
+	ring.sqArray = (unsigned int*) (sq + params.sq_off.array);
+
+	unsigned char* cq = (unsigned char*) ring.cqRing;
+	ring.cqHead = (unsigned int*) (cq + params.cq_off.head);
+	ring.cqTail = (unsigned int*) (cq + params.cq_off.tail);
+	ring.cqMask = (unsigned int*) (cq + params.cq_off.ring_mask);
+	ring.cqes = (io_uring_cqe*) (cq + params.cq_off.cqes);
+	return true;
+}
+
+// Queues a read of whatever's left of the file, the ring must have room
+static void QueueUringRead(sUring& ring, int fileDescriptor, unsigned char* buffer, size_t remaining, size_t offset, size_t readIndex)
+{
+	const size_t MAXREADSIZE = 1 << 30; // The length is 32 bit, bigger files just take a few reads
+
+	unsigned int tail = *ring.sqTail;
+	unsigned int index = tail & *ring.sqMask;
+
+	io_uring_sqe& sqe = ring.sqes[index];
+	memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = IORING_OP_READ;
+	sqe.fd = fileDescriptor;
+	sqe.addr = (unsigned long long) (uintptr_t) buffer;
+	sqe.len = (unsigned int) std::min(remaining, MAXREADSIZE);
+	sqe.off = offset;
+	sqe.user_data = readIndex;
+
+	ring.sqArray[index] = index;
+	__atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE); // The kernel can see the entry now
+}
+
+bool AssetReader::ReadWithUring(std::vector<sRead>& reads)
+{
+	if (this->uringUnavailable || reads.empty())
+	{
+		return false;
+	}
+
+	sUring ring;
+	if (!SetupUring(ring, 64))
+	{
+		DestroyUring(ring);
+		this->uringUnavailable = true;
+		return false;
+	}
+
+	// Open everything and size the buffers first, the reads themselves all go through the ring
+	std::vector<size_t> toQueue;
+	for (size_t i = 0; i < reads.size(); i++)
+	{
+		sRead& read = reads[i];
+		read.fileDescriptor = open(read.path.c_str(), O_RDONLY);
+		struct stat fileStat;
+		if (read.fileDescriptor == -1 || fstat(read.fileDescriptor, &fileStat) != 0)
+		{
+			read.failed = true;
+			continue;
+		}
+
+		read.buffer = this->AcquireBuffer((size_t) fileStat.st_size);
+		if (!read.buffer.empty())
+		{
+			toQueue.push_back(i);
+		}
+	}
+
+	bool unsupported = false;
+	unsigned int inFlight = 0;	// Taken by the kernel, not completed yet
+	unsigned int unsubmitted = 0;	// In the submission ring, the kernel hasn't taken them yet
+	size_t nextQueued = 0;
+	while (nextQueued < toQueue.size() || inFlight > 0 || unsubmitted > 0)
+	{
+		// Fill the ring
+		while (nextQueued < toQueue.size() && inFlight + unsubmitted < ring.entries)
+		{
+			size_t readIndex = toQueue[nextQueued++];
+			sRead& read = reads[readIndex];
+			QueueUringRead(ring, read.fileDescriptor, read.buffer.data() + read.bytesRead, read.buffer.size() - read.bytesRead, read.bytesRead, readIndex);
+			unsubmitted++;
+		}
+
+		// Only wait if something was in flight already, a submission the kernel doesn't take could leave nothing to wait for.
+		// It returns how many it took, the rest stay in the ring for the next call.
+		unsigned int waitFor = inFlight > 0 ? 1 : 0;
+		int result = (int) syscall(__NR_io_uring_enter, ring.fd, unsubmitted, waitFor, waitFor > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+		if (result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+		{
+			unsupported = true;
+			break;
+		}
+
+		unsigned int submitted = result > 0 ? (unsigned int) result : 0;
+		inFlight += submitted;
+		unsubmitted -= submitted;
+		if (inFlight == 0 && unsubmitted > 0 && (result < 0 ? errno != EINTR : submitted == 0)) // Nothing will free up room, the jobs read them instead
+		{
+			unsupported = true;
+			break;
+		}
+
+		// Reap whatever's done, short reads get queued again for the rest
+		unsigned int head = *ring.cqHead;
+		unsigned int tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+		for (; head != tail; head++)
+		{
+			const io_uring_cqe& cqe = ring.cqes[head & *ring.cqMask];
+			sRead& read = reads[(size_t) cqe.user_data];
+			inFlight--;
+
+			if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) // IORING_OP_READ needs 5.6, older kernels have the ring but not this
+			{
+				unsupported = true;
+			}
+			else if (cqe.res == -EAGAIN || cqe.res == -EINTR)
+			{
+				toQueue.push_back((size_t) cqe.user_data);
+			}
+			else if (cqe.res < 0)
+			{
+				read.failed = true;
+			}
+			else if (cqe.res > 0)
+			{
+				read.bytesRead += (size_t) cqe.res;
+				if (read.bytesRead < read.buffer.size())
+				{
+					toQueue.push_back((size_t) cqe.user_data);
+				}
+			}
+			// 0 is end of file, the file got shorter since we sized it and bytesRead is all there is
+		}
+		__atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+
+		if (unsupported)
+		{
+			break;
+		}
+	}
+
+	if (unsupported) // Wait out anything still in flight before the buffers can go anywhere
+	{
+		while (inFlight > 0)
+		{
+			if (syscall(__NR_io_uring_enter, ring.fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+			{
+				break;
+			}
+
+			unsigned int head = *ring.cqHead;
+			unsigned int tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+			inFlight -= tail - head;
+			__atomic_store_n(ring.cqHead, tail, __ATOMIC_RELEASE);
+		}
+	}
+
+	DestroyUring(ring);
+	for (sRead& read : reads)
+	{
+		if (read.fileDescriptor != -1)
+		{
+			close(read.fileDescriptor);
+			read.fileDescriptor = -1;
+		}
+
+		if (unsupported) // Start over on the jobs
+		{
+			read.bytesRead = 0;
+			read.failed = false;
+		}
+	}
+
+	if (unsupported)
+	{
+		this->uringUnavailable = true;
+		return false;
+	}
+
+	return true;
+}
+#else
+bool AssetReader::ReadWithUring(std::vector<sRead>& /*reads*/)
+{
+	return false; // No io_uring here, ReadWithJobs does them
+}
+#endif
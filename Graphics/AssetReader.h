@@ -0,0 +1,73 @@
+#pragma once
+
+#include "VirtualFileSystem.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Reads whole asset files into memory in batches, so the loaders can parse from memory instead of each doing its own blocking I/O.
+// Request every file of a load set, ReadRequested() once, then hand GetFile() to the loaders.
+// On Linux the batch goes through io_uring so the reads overlap in the kernel, anywhere else (or if io_uring isn't
+// available) the job system's workers read the files in parallel. Files in a mounted archive (see VirtualFileSystem) are never read,
+// GetFile hands out a view into the archive instead.
+class AssetReader
+{
+public:
+	~AssetReader();
+
+	static AssetReader* GetInstance();
+
+	// Queues a file for the next ReadRequested. Files that are already read (or queued), or are in a mounted archive, are skipped.
+	void Request(const std::string& path);
+
+	// Reads every requested file, returns false if any of them couldn't be read (those are left out of GetFile)
+	bool ReadRequested();
+
+	// The contents of a file read by ReadRequested or found in a mounted archive, false if it's neither.
+	// Read files are valid until they're released, archive files until the archive is unmounted.
+	bool GetFile(const std::string& path, sFileView& view) const;
+
+	// Gives the file's buffer back to the pool for the next batch
+	void Release(const std::string& path);
+	void ReleaseAll();
+
+	// Prints what the last ReadRequested read and how long it took
+	void PrintLastBatchReport() const;
+
+private:
+	AssetReader();
+
+	struct sRead
+	{
+		std::string path;
+		std::vector<unsigned char> buffer;
+		size_t bytesRead = 0;
+		int fileDescriptor = -1;
+		bool failed = false;
+	};
+
+	// Fills in every read, returns false if the backend couldn't be used at all (the reads are left untouched then)
+	bool ReadWithUring(std::vector<sRead>& reads);
+	void ReadWithJobs(std::vector<sRead>& reads);
+
+	std::vector<unsigned char> AcquireBuffer(size_t size);
+
+	static AssetReader* instance;
+
+	std::vector<std::string> requested;
+	std::map<std::string, std::vector<unsigned char>> files;
+	std::vector<std::vector<unsigned char>> freeBuffers; // Released buffers, reused so every batch doesn't reallocate
+
+	bool uringUnavailable; // Set the first time io_uring setup fails, so we don't try every batch
+
+	struct sBatchStats
+	{
+		unsigned int fileCount = 0;
+		unsigned int failedCount = 0;
+		size_t bytes = 0;
+		double seconds = 0.0;
+		bool usedUring = false;
+	};
+	sBatchStats lastBatch;
+};
@@ -0,0 +1,318 @@
+#include "CommandList.h"
+#include "FrameAllocator.h"
+#include "ShaderManager.h"
+#include "VertexLayout.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <glm/gtc/type_ptr.hpp>
+
+static_assert(ShaderManager::VARIANT_COUNT <= 8, "The sort key has 3 bits for the variant flags");
+
+uint64_t MakeSortKey(bool isTransparent, unsigned int variantFlags, GLuint firstTexture, GLuint vao, unsigned int order)
+{
+	// 63: transparent, 62-60: variant, 59-44: texture, 43-24: VAO, 23-0: order. Transparent draws only use the order.
+	uint64_t key = order & 0xFFFFFFu;
+	if (isTransparent)
+	{
+		return (1ull << 63) | key;
+	}
+
+	key |= (uint64_t) (vao & 0xFFFFFu) << 24;
+	key |= (uint64_t) (firstTexture & 0xFFFFu) << 44;
+	key |= (uint64_t) (variantFlags & 0x7u) << 60;
+	return key;
+}
+
+CommandList::CommandList()
+{
+	this->Clear();
+}
+
+void CommandList::Clear()
+{
+	this->draws.clear();
+	this->sortedDraws.clear();
+	this->textures.clear();
+	this->visibleCount = 0;
+
+	this->variantFlags = 0;
+	this->isWireframe = false;
+	this->data.matModel = glm::mat4(1.0f);
+	this->data.matInvTransposeModel = glm::mat4(1.0f);
+	this->data.colorOverride = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+	this->data.transparency = 1.0f;
+	this->firstTexture = 0;
+	this->samplerCounts[SAMPLER_DIFFUSE] = 0;
+	this->samplerCounts[SAMPLER_SPECULAR] = 0;
+}
+
+void CommandList::BindProgram(unsigned int variantFlags)
+{
+	this->variantFlags = variantFlags;
+}
+
+void CommandList::SetPolygonMode(bool isWireframe)
+{
+	this->isWireframe = isWireframe;
+}
+
+void CommandList::BindTexture(GLuint texture, eSamplerType type)
+{
+	if (this->textures.size() - this->firstTexture >= MAX_DRAW_TEXTURES || this->samplerCounts[type] >= MAX_SAMPLERS_PER_TYPE)
+	{
+		return;
+	}
+
+	sTextureBinding binding;
+	binding.texture = texture;
+	binding.type = type;
+	binding.typeIndex = this->samplerCounts[type]++;
+	this->textures.push_back(binding);
+}
+
+void CommandList::SetDrawData(const glm::mat4& matModel, const glm::mat4& matInvTransposeModel, float transparency, const glm::vec4& colorOverride)
+{
+	this->data.matModel = matModel;
+	this->data.matInvTransposeModel = matInvTransposeModel;
+	this->data.transparency = transparency;
+	this->data.colorOverride = colorOverride;
+}
+
+void CommandList::Draw(uint64_t sortKey, GLuint vao, GLsizei indexCount, GLenum indexType, unsigned int vertexAttributes)
+{
+	sDraw draw;
+	draw.sortKey = sortKey;
+	draw.data = this->data;
+	draw.vao = vao;
+	draw.indexCount = indexCount;
+	draw.indexType = indexType;
+	draw.vertexAttributes = vertexAttributes;
+	draw.variantFlags = this->variantFlags;
+	draw.isWireframe = this->isWireframe;
+	draw.firstTexture = this->firstTexture;
+	draw.textureCount = (unsigned int) this->textures.size() - this->firstTexture;
+	draw.isVisible = true;
+	this->draws.push_back(draw);
+	this->visibleCount++;
+
+	this->firstTexture = (unsigned int) this->textures.size();
+	this->samplerCounts[SAMPLER_DIFFUSE] = 0;
+	this->samplerCounts[SAMPLER_SPECULAR] = 0;
+}
+
+void CommandList::Sort()
+{
+	this->sortedDraws.resize(this->draws.size());
+	for (unsigned int i = 0; i < this->sortedDraws.size(); i++)
+	{
+		this->sortedDraws[i] = i;
+	}
+
+	std::sort(this->sortedDraws.begin(), this->sortedDraws.end(), [this](unsigned int a, unsigned int b) { return this->draws[a].sortKey < this->draws[b].sortKey; });
+}
+
+void CommandList::PatchDrawData(unsigned int draw, const glm::mat4& matModel, const glm::mat4& matInvTransposeModel, float transparency)
+{
+	sDrawData& data = this->draws[draw].data;
+	data.matModel = matModel;
+	data.matInvTransposeModel = matInvTransposeModel;
+	data.transparency = transparency;
+}
+
+void CommandList::SetVisible(unsigned int draw, bool isVisible)
+{
+	if (this->draws[draw].isVisible != isVisible)
+	{
+		this->draws[draw].isVisible = isVisible;
+		isVisible ? this->visibleCount++ : this->visibleCount--;
+	}
+}
+
+CommandListPlayer::CommandListPlayer()
+	: drawCount(0), stateChangeCount(0)
+{
+	sProgramUniforms unloaded;
+	unloaded.programID = 0; // Never a real program, so the first use looks the locations up
+	this->programs.resize(ShaderManager::VARIANT_COUNT, unloaded);
+}
+
+bool CommandListPlayer::FindVisibleDraw(const CommandList& list, unsigned int& next)
+{
+	while (next < list.sortedDraws.size() && !list.draws[list.sortedDraws[next]].isVisible)
+	{
+		next++;
+	}
+
+	return next < list.sortedDraws.size();
+}
+
+static void LoadProgramUniforms(GLuint programID, GLint& matModel, GLint& matModelInverseTranspose, GLint& transparency, GLint& colorOverride, GLint& isOverrideColor, GLint& isIgnoreLighting, GLint samplers[SAMPLER_TYPE_COUNT][MAX_SAMPLERS_PER_TYPE])
+{
+	matModel = glGetUniformLocation(programID, "matModel");
+	matModelInverseTranspose = glGetUniformLocation(programID, "matModelInverseTranspose");
+	transparency = glGetUniformLocation(programID, "uTransparency");
+	colorOverride = glGetUniformLocation(programID, "colorOverride");
+	isOverrideColor = glGetUniformLocation(programID, "isOverrideColor");
+	isIgnoreLighting = glGetUniformLocation(programID, "isIgnoreLighting");
+
+	const char* samplerNames[SAMPLER_TYPE_COUNT] = { "texture_diffuse", "texture_specular" };
+	for (unsigned int type = 0; type < SAMPLER_TYPE_COUNT; type++)
+	{
+		for (unsigned int i = 0; i < MAX_SAMPLERS_PER_TYPE; i++)
+		{
+			samplers[type][i] = glGetUniformLocation(programID, (samplerNames[type] + std::to_string(i)).c_str());
+		}
+	}
+}
+
+void CommandListPlayer::Play(const std::vector<CommandList>& lists, const CompiledShader& shader)
+{
+	this->drawCount = 0;
+	this->stateChangeCount = 0;
+
+	// Other code may have set the samplers since the last frame
+	for (sProgramUniforms& program : this->programs)
+	{
+		for (unsigned int type = 0; type < SAMPLER_TYPE_COUNT; type++)
+		{
+			for (unsigned int i = 0; i < MAX_SAMPLERS_PER_TYPE; i++)
+			{
+				program.samplerUnits[type][i] = -1;
+			}
+		}
+	}
+
+	// Min heap of the next key of every list that has visible draws left, each list is sorted so popping it gives the
+	// lowest key left overall. Both only last the frame, so they come from the GL thread's frame arena.
+	typedef std::pair<uint64_t, unsigned int> HeapEntry;
+	FrameVector<HeapEntry> heap;
+	FrameVector<unsigned int> nextDraws(lists.size(), 0); // Per list, into its sortedDraws
+	heap.reserve(lists.size());
+	for (unsigned int i = 0; i < lists.size(); i++)
+	{
+		if (FindVisibleDraw(lists[i], nextDraws[i]))
+		{
+			heap.push_back(HeapEntry(lists[i].draws[lists[i].sortedDraws[nextDraws[i]]].sortKey, i));
+		}
+	}
+	std::make_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+
+	// Nothing is known about the GL state coming in
+	const CompiledShader* program = NULL;
+	sProgramUniforms* uniforms = NULL;
+	unsigned int currentVariant = ~0u;
+	int currentWireframe = -1;
+	unsigned int currentAttributes = ~0u;
+	bool isVAOKnown = false;
+	GLuint currentVAO = 0;
+	GLuint boundTextures[MAX_DRAW_TEXTURES] = { 0 }; // Every frame unbinds its textures at the end, so nothing is bound to start with
+
+	while (!heap.empty())
+	{
+		std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+		unsigned int listIndex = heap.back().second;
+		heap.pop_back();
+
+		const CommandList& list = lists[listIndex];
+		unsigned int& next = nextDraws[listIndex];
+		const CommandList::sDraw& draw = list.draws[list.sortedDraws[next++]];
+		if (FindVisibleDraw(list, next))
+		{
+			heap.push_back(HeapEntry(list.draws[list.sortedDraws[next]].sortKey, listIndex));
+			std::push_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+		}
+
+		if (draw.variantFlags != currentVariant)
+		{
+			program = &shader.GetVariant(draw.variantFlags);
+			uniforms = &this->programs[draw.variantFlags % ShaderManager::VARIANT_COUNT];
+			if (uniforms->programID != program->ID)
+			{
+				uniforms->programID = program->ID;
+				LoadProgramUniforms(program->ID, uniforms->matModel, uniforms->matModelInverseTranspose, uniforms->transparency, uniforms->colorOverride, uniforms->isOverrideColor, uniforms->isIgnoreLighting, uniforms->samplers);
+			}
+
+			glUseProgram(program->ID);
+			currentVariant = draw.variantFlags;
+			this->stateChangeCount++;
+		}
+
+		glUniformMatrix4fv(uniforms->matModel, 1, GL_FALSE, glm::value_ptr(draw.data.matModel));
+		glUniformMatrix4fv(uniforms->matModelInverseTranspose, 1, GL_FALSE, glm::value_ptr(draw.data.matInvTransposeModel));
+		// The base program stands in for variants that failed to build, it has every uniform and takes the toggles
+		bool isFallback = program->variantFlags != draw.variantFlags;
+		if (isFallback || !(program->variantFlags & ShaderManager::VARIANT_OPAQUE))
+		{
+			glUniform1f(uniforms->transparency, draw.data.transparency);
+		}
+		if (isFallback || (program->variantFlags & ShaderManager::VARIANT_OVERRIDE_COLOR))
+		{
+			glUniform4fv(uniforms->colorOverride, 1, glm::value_ptr(draw.data.colorOverride));
+		}
+		if (isFallback)
+		{
+			glUniform1f(uniforms->isOverrideColor, (draw.variantFlags & ShaderManager::VARIANT_OVERRIDE_COLOR) ? (float) GL_TRUE : (float) GL_FALSE);
+			glUniform1f(uniforms->isIgnoreLighting, (draw.variantFlags & ShaderManager::VARIANT_UNLIT) ? (float) GL_TRUE : (float) GL_FALSE);
+		}
+
+		// Units past this draw's textures are unbound
+		for (unsigned int unit = 0; unit < MAX_DRAW_TEXTURES; unit++)
+		{
+			GLuint texture = unit < draw.textureCount ? list.textures[draw.firstTexture + unit].texture : 0;
+			if (boundTextures[unit] != texture)
+			{
+				glActiveTexture(GL_TEXTURE0 + unit);
+				glBindTexture(GL_TEXTURE_2D, texture);
+				boundTextures[unit] = texture;
+				this->stateChangeCount++;
+			}
+		}
+
+		for (unsigned int unit = 0; unit < draw.textureCount; unit++)
+		{
+			const CommandList::sTextureBinding& binding = list.textures[draw.firstTexture + unit];
+			GLint& samplerUnit = uniforms->samplerUnits[binding.type][binding.typeIndex];
+			if (samplerUnit != (GLint) unit)
+			{
+				glUniform1i(uniforms->samplers[binding.type][binding.typeIndex], unit);
+				samplerUnit = unit;
+			}
+		}
+
+		if (draw.vertexAttributes != currentAttributes)
+		{
+			SetMissingVertexAttributes(draw.vertexAttributes);
+			currentAttributes = draw.vertexAttributes;
+		}
+
+		if ((int) draw.isWireframe != currentWireframe)
+		{
+			glPolygonMode(GL_FRONT_AND_BACK, draw.isWireframe ? GL_LINE : GL_FILL);
+			currentWireframe = draw.isWireframe;
+			this->stateChangeCount++;
+		}
+
+		if (!isVAOKnown || draw.vao != currentVAO)
+		{
+			glBindVertexArray(draw.vao);
+			currentVAO = draw.vao;
+			isVAOKnown = true;
+			this->stateChangeCount++;
+		}
+
+		glDrawElements(GL_TRIANGLES, draw.indexCount, draw.indexType, 0);
+		this->drawCount++;
+	}
+
+	glBindVertexArray(0);
+	for (unsigned int unit = 0; unit < MAX_DRAW_TEXTURES; unit++)
+	{
+		if (boundTextures[unit] != 0)
+		{
+			glActiveTexture(GL_TEXTURE0 + unit);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+	}
+}
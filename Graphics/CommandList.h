@@ -0,0 +1,164 @@
+#pragma once
+
+#include "GLCommon.h"
+#include "CompiledShader.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+
+// Texture units a single draw can use, texture_diffuse0-3 and texture_specular0-3 in the shader
+const unsigned int MAX_DRAW_TEXTURES = 8;
+const unsigned int MAX_SAMPLERS_PER_TYPE = 4;
+
+enum eSamplerType
+{
+	SAMPLER_DIFFUSE,
+	SAMPLER_SPECULAR,
+	SAMPLER_TYPE_COUNT
+};
+
+// Draws are replayed in the order of their keys (see CommandListPlayer). Opaque ones are grouped by program, texture
+// and VAO so the state changes between them are few, transparent ones come after them in the order they were added.
+// order is the draw's position in the frame, it keeps the keys unique and the transparent draws in order.
+uint64_t MakeSortKey(bool isTransparent, unsigned int variantFlags, GLuint firstTexture, GLuint vao, unsigned int order);
+
+// Draws recorded away from GL, so jobs can each build one for their part of the scene (see RenderQueue::Prepare).
+// Works like a small state machine: bind a program, set textures and per-draw data, then Draw captures all of it.
+// Nothing here touches GL, the lists are played back on the GL thread by CommandListPlayer. A recorded list can be
+// kept and played again, patching the draws whose data or visibility changed in the meantime.
+class CommandList
+{
+public:
+	CommandList();
+
+	// Keeps the memory for the next frame
+	void Clear();
+
+	// ShaderManager::eShaderVariant flags, the player picks that variant of the shader it's given
+	void BindProgram(unsigned int variantFlags);
+
+	void SetPolygonMode(bool isWireframe);
+
+	// Binds the texture to the next unit for the next Draw, named after its type and how many of that type came before it.
+	// Ignored past MAX_SAMPLERS_PER_TYPE of a type or MAX_DRAW_TEXTURES in total.
+	void BindTexture(GLuint texture, eSamplerType type);
+
+	void SetDrawData(const glm::mat4& matModel, const glm::mat4& matInvTransposeModel, float transparency, const glm::vec4& colorOverride);
+
+	// Records a draw with everything set so far. The textures start over after it, the rest carries on to the next draw.
+	// Draws are numbered in the order they were recorded, Sort doesn't change that.
+	void Draw(uint64_t sortKey, GLuint vao, GLsizei indexCount, GLenum indexType, unsigned int vertexAttributes);
+
+	// Orders the draws by key, which CommandListPlayer relies on to merge lists
+	void Sort();
+
+	// Changes a recorded draw. Nothing in its sort key may change, record the list again for that.
+	void PatchDrawData(unsigned int draw, const glm::mat4& matModel, const glm::mat4& matInvTransposeModel, float transparency);
+
+	// Hidden draws stay in the list but aren't played. Draws are visible when recorded.
+	void SetVisible(unsigned int draw, bool isVisible);
+
+	inline unsigned int GetDrawCount() const
+	{
+		return (unsigned int) this->draws.size();
+	}
+
+	inline unsigned int GetVisibleCount() const
+	{
+		return this->visibleCount;
+	}
+
+private:
+	friend class CommandListPlayer;
+
+	struct sTextureBinding
+	{
+		GLuint texture;
+		eSamplerType type;
+		unsigned int typeIndex; // texture_diffuse<typeIndex>
+	};
+
+	struct sDrawData
+	{
+		glm::mat4 matModel;
+		glm::mat4 matInvTransposeModel;
+		glm::vec4 colorOverride;
+		float transparency;
+	};
+
+	// A draw and the state it was recorded with
+	struct sDraw
+	{
+		uint64_t sortKey;
+		sDrawData data;
+		GLuint vao;
+		GLsizei indexCount;
+		GLenum indexType;
+		unsigned int vertexAttributes;
+		unsigned int variantFlags;
+		bool isWireframe;
+		unsigned int firstTexture; // In textures
+		unsigned int textureCount;
+		bool isVisible;
+	};
+
+	std::vector<sDraw> draws;
+	std::vector<unsigned int> sortedDraws; // Into draws, by key
+	std::vector<sTextureBinding> textures;
+	unsigned int visibleCount;
+
+	// What the next Draw records
+	unsigned int variantFlags;
+	bool isWireframe;
+	sDrawData data;
+	unsigned int firstTexture;
+	unsigned int samplerCounts[SAMPLER_TYPE_COUNT];
+};
+
+// Plays command lists back on the GL thread, merged into one stream by sort key, only changing the GL state that
+// differs from the draw before. Keeps the uniform locations of the programs it used, so keep one around between frames.
+class CommandListPlayer
+{
+public:
+	CommandListPlayer();
+
+	// Every list has to be sorted (see CommandList::Sort). Hidden draws are skipped.
+	void Play(const std::vector<CommandList>& lists, const CompiledShader& shader);
+
+	// What the last Play did, to see how much the sorting saves
+	inline unsigned int GetDrawCount() const
+	{
+		return this->drawCount;
+	}
+
+	inline unsigned int GetStateChangeCount() const
+	{
+		return this->stateChangeCount;
+	}
+
+private:
+	// Locations of the uniforms every draw sets, looked up again if the program changed (e.g. a hot reload)
+	struct sProgramUniforms
+	{
+		GLuint programID;
+		GLint matModel;
+		GLint matModelInverseTranspose;
+		GLint transparency;
+		GLint colorOverride;
+		GLint isOverrideColor;		// Only the base program has these two
+		GLint isIgnoreLighting;
+		GLint samplers[SAMPLER_TYPE_COUNT][MAX_SAMPLERS_PER_TYPE];
+		GLint samplerUnits[SAMPLER_TYPE_COUNT][MAX_SAMPLERS_PER_TYPE]; // What the samplers were last set to this frame, -1 if unknown
+	};
+
+	std::vector<sProgramUniforms> programs; // Per variant flags
+
+	unsigned int drawCount;
+	unsigned int stateChangeCount;
+
+	// Moves next past the list's hidden draws, false if there are no visible ones left
+	static bool FindVisibleDraw(const CommandList& list, unsigned int& next);
+};
@@ -1,4 +1,7 @@
 #include "CompiledShader.h"
+#include "ShaderManager.h"
+
+#include <vector>
 
 
 CompiledShader::CompiledShader()
@@ -33,7 +36,54 @@ bool CompiledShader::LoadUniformLocation(std::string variableName)
 	return true;
 }
 
+void CompiledShader::LoadAllUniformLocations()
+{
+	this->mapUniformName_to_UniformLocation.clear();
+
+	GLint uniformCount = 0;
+	glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+
+	GLint maxNameLength = 0;
+	glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	if (maxNameLength <= 0)
+	{
+		return;
+	}
+
+	std::vector<char> name(maxNameLength);
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei nameLength = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(this->ID, i, maxNameLength, &nameLength, &size, &type, name.data());
+
+		std::string uniformName(name.data(), nameLength);
+		GLint uniLocation = glGetUniformLocation(this->ID, uniformName.c_str());
+		if (uniLocation != -1) // Uniforms inside blocks don't have a location
+		{
+			this->mapUniformName_to_UniformLocation[uniformName] = uniLocation;
+		}
+	}
+}
+
 void CompiledShader::Bind() const
 {
 	glUseProgram(this->ID);
+}
+
+const CompiledShader& CompiledShader::GetVariant(unsigned int variantFlags) const
+{
+	if (variantFlags == this->variantFlags || !this->pOwner)
+	{
+		return *this;
+	}
+
+	CompiledShader* variant = this->pOwner->pGetShaderVariant(this->friendlyName, variantFlags);
+	if (!variant)
+	{
+		return *this;
+	}
+
+	return *variant;
 }
\ No newline at end of file
@@ -5,12 +5,16 @@
 
 #include <map>
 
+class ShaderManager;
+
 // Represents a shader that as been compiled successfully
 class CompiledShader
 {
 public:
 	GLuint ID = 0;
 	std::string friendlyName;
+	unsigned int variantFlags = 0; // ShaderManager::eShaderVariant flags this program was compiled with
+	ShaderManager* pOwner = NULL;
 
 	CompiledShader();
 
@@ -21,6 +25,13 @@ public:
 
 	// Look up the uniform location and save it.
 	bool LoadUniformLocation(std::string variableName);
+
+	// Replaces the saved locations with every active uniform of the program
+	void LoadAllUniformLocations();
 	
 	void Bind() const;
+
+	// Returns the specialized program of this shader for the given ShaderManager::eShaderVariant flags (compiled on first use).
+	// Falls back to this program if the variant couldn't be made.
+	const CompiledShader& GetVariant(unsigned int variantFlags) const;
 };
\ No newline at end of file
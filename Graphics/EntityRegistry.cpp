@@ -0,0 +1,358 @@
+#include "EntityRegistry.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+#include "LightManager.h"
+#include "Mesh.h"
+#include "Model.h"
+#include "ModelManager.h"
+#include "PanelAnimator.h"
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <glm/glm.hpp>
+
+// Entities a job culls at a time, each is one box against six planes
+static const unsigned int CULL_BATCH_SIZE = 256;
+
+// Moved entities a job rebuilds the bounds of, each is a few matrices per mesh
+static const unsigned int BOUNDS_BATCH_SIZE = 32;
+
+static bool IsSameTransform(const sTransformComponent& a, const sTransformComponent& b)
+{
+	return a.position == b.position && a.xRot == b.xRot && a.yRot == b.yRot && a.zRot == b.zRot && a.scale == b.scale;
+}
+
+EntityRegistry::EntityRegistry()
+	: entityCount(0), renderableCount(0), visibleCount(0)
+{
+
+}
+
+EntityHandle EntityRegistry::CreateEntity()
+{
+	EntityHandle entity;
+	if (!this->freeIndices.empty())
+	{
+		entity.index = this->freeIndices.back();
+		this->freeIndices.pop_back();
+	}
+	else
+	{
+		entity.index = (unsigned int) this->generations.size();
+		this->generations.push_back(1);
+		this->isDirty.push_back(0);
+	}
+
+	entity.generation = this->generations[entity.index];
+	this->entityCount++;
+	return entity;
+}
+
+void EntityRegistry::DestroyEntity(EntityHandle entity)
+{
+	if (!this->IsValid(entity))
+	{
+		return;
+	}
+
+	this->LeaveRenderables(entity.index);
+	this->transforms.Remove(entity.index);
+	this->renderables.Remove(entity.index);
+	this->bounds.Remove(entity.index);
+	this->lights.Remove(entity.index);
+	this->panelAnimations.Remove(entity.index);
+
+	// 0 is never handed out, so wrapping around skips it
+	unsigned int& generation = this->generations[entity.index];
+	generation = generation + 1 == 0 ? 1 : generation + 1;
+	this->freeIndices.push_back(entity.index);
+	this->entityCount--;
+}
+
+bool EntityRegistry::IsValid(EntityHandle entity) const
+{
+	return entity.index < this->generations.size() && entity.generation != 0 && this->generations[entity.index] == entity.generation;
+}
+
+bool EntityRegistry::AddTransform(EntityHandle entity, const sTransformComponent& transform)
+{
+	if (!this->IsValid(entity))
+	{
+		return false;
+	}
+
+	this->transforms.Add(entity.index, transform);
+	this->MarkDirty(entity.index);
+	this->JoinRenderables(entity.index);
+	return true;
+}
+
+bool EntityRegistry::AddRenderable(EntityHandle entity, const sRenderableComponent& renderable)
+{
+	if (!this->IsValid(entity))
+	{
+		return false;
+	}
+
+	this->renderables.Add(entity.index, renderable);
+	this->MarkDirty(entity.index); // The bounds are the model's
+	this->JoinRenderables(entity.index);
+	return true;
+}
+
+bool EntityRegistry::AddBounds(EntityHandle entity)
+{
+	if (!this->IsValid(entity))
+	{
+		return false;
+	}
+
+	sBoundsComponent entityBounds;
+	entityBounds.center = glm::vec3(0.0f);
+	entityBounds.halfExtent = glm::vec3(0.0f);
+	entityBounds.hasBounds = false;
+	entityBounds.isVisible = true;
+	this->bounds.Add(entity.index, entityBounds);
+	this->MarkDirty(entity.index);
+	this->JoinRenderables(entity.index);
+	return true;
+}
+
+bool EntityRegistry::AddLight(EntityHandle entity, const sLightComponent& light)
+{
+	if (!this->IsValid(entity))
+	{
+		return false;
+	}
+
+	this->lights.Add(entity.index, light);
+	this->MarkDirty(entity.index);
+	return true;
+}
+
+bool EntityRegistry::AddPanelAnimation(EntityHandle entity, const sPanelAnimationComponent& panelAnimation)
+{
+	if (!this->IsValid(entity))
+	{
+		return false;
+	}
+
+	this->panelAnimations.Add(entity.index, panelAnimation);
+	return true;
+}
+
+const sTransformComponent* EntityRegistry::GetTransform(EntityHandle entity) const
+{
+	return this->IsValid(entity) && this->transforms.Has(entity.index) ? &this->transforms.Get(entity.index) : NULL;
+}
+
+const sBoundsComponent* EntityRegistry::GetBounds(EntityHandle entity) const
+{
+	return this->IsValid(entity) && this->bounds.Has(entity.index) ? &this->bounds.Get(entity.index) : NULL;
+}
+
+void EntityRegistry::SetTransform(EntityHandle entity, const sTransformComponent& transform)
+{
+	if (!this->IsValid(entity) || !this->transforms.Has(entity.index))
+	{
+		return;
+	}
+
+	sTransformComponent& current = this->transforms.Get(entity.index);
+	if (!IsSameTransform(current, transform))
+	{
+		current = transform;
+		this->MarkDirty(entity.index);
+	}
+}
+
+void EntityRegistry::UpdateLights()
+{
+	// UpdateTransforms writes the entity's position into the light as it is, so a light only differs here if something
+	// else moved it and this never feeds back on itself
+	const sLightComponent* lights = this->lights.GetData();
+	for (unsigned int i = 0; i < this->lights.GetCount(); i++)
+	{
+		unsigned int entity = this->lights.GetEntity(i);
+		const Light* light = LightManager::GetInstance()->GetLight(lights[i].light);
+		if (!light || !this->transforms.Has(entity))
+		{
+			continue;
+		}
+
+		sTransformComponent& transform = this->transforms.Get(entity);
+		glm::vec3 position = glm::vec3(light->GetPosition());
+		if (transform.position != position)
+		{
+			transform.position = position;
+			this->MarkDirty(entity);
+		}
+	}
+}
+
+void EntityRegistry::UpdatePanels(const PanelAnimator& panels, float alpha)
+{
+	const sPanelAnimationComponent* panelAnimations = this->panelAnimations.GetData();
+	for (unsigned int i = 0; i < this->panelAnimations.GetCount(); i++)
+	{
+		unsigned int entity = this->panelAnimations.GetEntity(i);
+		if (panelAnimations[i].panel >= panels.GetPanelCount() || !this->transforms.Has(entity))
+		{
+			continue;
+		}
+
+		sTransformComponent& transform = this->transforms.Get(entity);
+		glm::vec3 position = panels.GetPosition(panelAnimations[i].panel, alpha);
+		if (transform.position != position)
+		{
+			transform.position = position;
+			this->MarkDirty(entity);
+		}
+	}
+}
+
+void EntityRegistry::UpdateTransforms()
+{
+	// Every moved entity only writes its own bounds
+	JobSystem::GetInstance()->ParallelFor((unsigned int) this->dirtyEntities.size(), BOUNDS_BATCH_SIZE, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			unsigned int entity = this->dirtyEntities[i];
+			if (this->transforms.Has(entity) && this->renderables.Has(entity) && this->bounds.Has(entity))
+			{
+				BuildBounds(this->transforms.Get(entity), this->renderables.Get(entity).model, this->bounds.Get(entity));
+			}
+		}
+	});
+
+	// Lights aren't safe to edit from the jobs, and there are only a few of them
+	for (unsigned int entity : this->dirtyEntities)
+	{
+		if (this->lights.Has(entity) && this->transforms.Has(entity))
+		{
+			Light* light = LightManager::GetInstance()->GetLight(this->lights.Get(entity).light);
+			if (light)
+			{
+				const glm::vec3& position = this->transforms.Get(entity).position;
+				light->EditPosition(position.x, position.y, position.z, light->GetPosition().w);
+			}
+		}
+
+		this->isDirty[entity] = 0;
+	}
+	this->dirtyEntities.clear();
+}
+
+void EntityRegistry::Cull(const glm::mat4& viewProjection)
+{
+	sFrustum frustum = GetFrustum(viewProjection);
+	sBoundsComponent* entityBounds = this->bounds.GetData();
+	std::atomic<unsigned int> visibleCount(0);
+	JobSystem::GetInstance()->ParallelFor(this->renderableCount, CULL_BATCH_SIZE, [&](unsigned int begin, unsigned int end)
+	{
+		unsigned int batchVisible = 0;
+		for (unsigned int i = begin; i < end; i++)
+		{
+			sBoundsComponent& bounds = entityBounds[i];
+			bounds.isVisible = !bounds.hasBounds || IsBoxInFrustum(frustum, bounds.center, bounds.halfExtent);
+			batchVisible += bounds.isVisible ? 1 : 0;
+		}
+		visibleCount += batchVisible;
+	});
+
+	this->visibleCount = visibleCount;
+}
+
+void EntityRegistry::Submit(RenderQueue& queue) const
+{
+	const sTransformComponent* transforms = this->transforms.GetData();
+	const sRenderableComponent* renderables = this->renderables.GetData();
+	const sBoundsComponent* entityBounds = this->bounds.GetData();
+	for (unsigned int i = 0; i < this->renderableCount; i++)
+	{
+		const sTransformComponent& transform = transforms[i];
+		queue.Add(renderables[i].model, transform.position, transform.xRot, transform.yRot, transform.zRot, transform.scale, renderables[i].transparency, entityBounds[i].isVisible);
+	}
+}
+
+void EntityRegistry::JoinRenderables(unsigned int entity)
+{
+	if (!this->transforms.Has(entity) || !this->renderables.Has(entity) || !this->bounds.Has(entity))
+	{
+		return;
+	}
+
+	// Everything that isn't in yet is after the ones that are, in all three pools
+	if (this->transforms.GetIndex(entity) < this->renderableCount)
+	{
+		return;
+	}
+
+	this->transforms.Swap(this->transforms.GetIndex(entity), this->renderableCount);
+	this->renderables.Swap(this->renderables.GetIndex(entity), this->renderableCount);
+	this->bounds.Swap(this->bounds.GetIndex(entity), this->renderableCount);
+	this->renderableCount++;
+}
+
+void EntityRegistry::LeaveRenderables(unsigned int entity)
+{
+	if (!this->transforms.Has(entity) || !this->renderables.Has(entity) || !this->bounds.Has(entity))
+	{
+		return;
+	}
+
+	if (this->transforms.GetIndex(entity) >= this->renderableCount)
+	{
+		return;
+	}
+
+	this->renderableCount--;
+	this->transforms.Swap(this->transforms.GetIndex(entity), this->renderableCount);
+	this->renderables.Swap(this->renderables.GetIndex(entity), this->renderableCount);
+	this->bounds.Swap(this->bounds.GetIndex(entity), this->renderableCount);
+}
+
+void EntityRegistry::MarkDirty(unsigned int entity)
+{
+	if (!this->isDirty[entity])
+	{
+		this->isDirty[entity] = 1;
+		this->dirtyEntities.push_back(entity);
+	}
+}
+
+void EntityRegistry::BuildBounds(const sTransformComponent& transform, ModelHandle model, sBoundsComponent& bounds)
+{
+	const Model* pModel = ModelManager::GetInstance()->GetModel(model);
+	bounds.hasBounds = pModel && !pModel->meshes.empty();
+	if (!bounds.hasBounds)
+	{
+		return;
+	}
+
+	glm::vec3 low(0.0f);
+	glm::vec3 high(0.0f);
+	for (unsigned int meshIndex = 0; meshIndex < pModel->meshes.size(); meshIndex++)
+	{
+		const Mesh& mesh = pModel->meshes[meshIndex];
+		glm::mat4 matModel;
+		glm::mat4 matInvTransposeModel;
+		mesh.BuildTransform(transform.position, transform.xRot, transform.yRot, transform.zRot, transform.scale, matModel, matInvTransposeModel);
+
+		glm::vec3 center;
+		glm::vec3 halfExtent;
+		if (!mesh.GetWorldBounds(matModel, center, halfExtent))
+		{
+			bounds.hasBounds = false;
+			return;
+		}
+
+		low = meshIndex == 0 ? center - halfExtent : glm::min(low, center - halfExtent);
+		high = meshIndex == 0 ? center + halfExtent : glm::max(high, center + halfExtent);
+	}
+
+	bounds.center = (low + high) * 0.5f;
+	bounds.halfExtent = (high - low) * 0.5f;
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+#include "ResourceHandle.h"
+
+#include <utility>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+class PanelAnimator;
+class RenderQueue;
+
+struct sEntityTag;
+typedef ResourceHandle<sEntityTag> EntityHandle;
+
+// Where an entity is, the same axes RenderQueue::Add takes
+struct sTransformComponent
+{
+	glm::vec3 position;
+	glm::vec3 xRot;
+	glm::vec3 yRot;
+	glm::vec3 zRot;
+	glm::vec3 scale;
+};
+
+struct sRenderableComponent
+{
+	ModelHandle model;
+	float transparency;
+};
+
+// World space box around every mesh of the entity's model, kept up to date by UpdateTransforms
+struct sBoundsComponent
+{
+	glm::vec3 center;
+	glm::vec3 halfExtent;
+	bool hasBounds;		// False if a mesh has none, the entity is never culled then
+	bool isVisible;		// As of the last Cull
+};
+
+// The entity follows the light if something else moved it (see EntityRegistry::UpdateLights), and moving the entity
+// moves the light
+struct sLightComponent
+{
+	LightHandle light;
+};
+
+// The entity is moved to wherever the panel is
+struct sPanelAnimationComponent
+{
+	unsigned int panel; // In the PanelAnimator passed to UpdatePanels
+};
+
+// One component type of every entity that has it, packed. The dense arrays hold the components and their entities'
+// indices back to back, sparse maps an entity's index to its place in them.
+template <class T>
+class ComponentPool
+{
+public:
+	static constexpr unsigned int NONE = 0xFFFFFFFF;
+
+	inline bool Has(unsigned int entity) const
+	{
+		return entity < this->sparse.size() && this->sparse[entity] != NONE;
+	}
+
+	// Where the entity's component is in GetData, NONE if it doesn't have one
+	inline unsigned int GetIndex(unsigned int entity) const
+	{
+		return entity < this->sparse.size() ? this->sparse[entity] : NONE;
+	}
+
+	inline T& Get(unsigned int entity)
+	{
+		return this->components[this->sparse[entity]];
+	}
+
+	inline const T& Get(unsigned int entity) const
+	{
+		return this->components[this->sparse[entity]];
+	}
+
+	// Replaces the component if the entity already has one
+	void Add(unsigned int entity, const T& component)
+	{
+		if (this->Has(entity))
+		{
+			this->Get(entity) = component;
+			return;
+		}
+
+		if (entity >= this->sparse.size())
+		{
+			this->sparse.resize(entity + 1, NONE);
+		}
+		this->sparse[entity] = (unsigned int) this->components.size();
+		this->components.push_back(component);
+		this->entities.push_back(entity);
+	}
+
+	// The last component is swapped into its place, so only that one moves and the pool's order isn't kept
+	void Remove(unsigned int entity)
+	{
+		if (!this->Has(entity))
+		{
+			return;
+		}
+
+		unsigned int index = this->sparse[entity];
+		this->Swap(index, (unsigned int) this->components.size() - 1);
+		this->components.pop_back();
+		this->entities.pop_back();
+		this->sparse[entity] = NONE;
+	}
+
+	// Swaps two components by their place in the dense arrays
+	void Swap(unsigned int a, unsigned int b)
+	{
+		if (a == b)
+		{
+			return;
+		}
+
+		std::swap(this->components[a], this->components[b]);
+		std::swap(this->entities[a], this->entities[b]);
+		this->sparse[this->entities[a]] = a;
+		this->sparse[this->entities[b]] = b;
+	}
+
+	inline unsigned int GetCount() const
+	{
+		return (unsigned int) this->components.size();
+	}
+
+	inline T* GetData()
+	{
+		return this->components.data();
+	}
+
+	inline const T* GetData() const
+	{
+		return this->components.data();
+	}
+
+	// The entity index of the component at index
+	inline unsigned int GetEntity(unsigned int index) const
+	{
+		return this->entities[index];
+	}
+
+private:
+	std::vector<T> components;
+	std::vector<unsigned int> entities;
+	std::vector<unsigned int> sparse;
+};
+
+// The scene's objects as entities with components, each component type packed in its own ComponentPool. Entities
+// with a transform, a renderable and bounds are kept at the front of those three pools, in the same order in each, so
+// the systems below go straight down the arrays in parallel without looking anything up.
+// Per frame: UpdateLights and UpdatePanels, then UpdateTransforms, then Cull, then Submit. Only the entities whose transform changed
+// get their bounds and lights updated, and Submit adds them in the same order every frame so the queue only patches
+// what moved (see RenderQueue).
+class EntityRegistry
+{
+public:
+	EntityRegistry();
+
+	EntityHandle CreateEntity();
+
+	// Removes the entity and all its components. The handle and any copies of it stop being valid.
+	void DestroyEntity(EntityHandle entity);
+
+	bool IsValid(EntityHandle entity) const;
+
+	// Adding a component the entity already has replaces it. These return false if the handle isn't valid.
+	bool AddTransform(EntityHandle entity, const sTransformComponent& transform);
+	bool AddRenderable(EntityHandle entity, const sRenderableComponent& renderable);
+	bool AddBounds(EntityHandle entity);
+	bool AddLight(EntityHandle entity, const sLightComponent& light);
+	bool AddPanelAnimation(EntityHandle entity, const sPanelAnimationComponent& panelAnimation);
+
+	// The components are moved around as others are added and removed, so don't hold on to these
+	const sTransformComponent* GetTransform(EntityHandle entity) const;
+	const sBoundsComponent* GetBounds(EntityHandle entity) const;
+
+	// Marks the entity for UpdateTransforms, if it moved
+	void SetTransform(EntityHandle entity, const sTransformComponent& transform);
+
+	// Moves the light entities to where their lights are, for lights moved by other code (e.g. PropertyAnimator)
+	void UpdateLights();
+
+	// Moves the panel animated entities to where their panels are, alpha like PanelAnimator::GetPosition
+	void UpdatePanels(const PanelAnimator& panels, float alpha);
+
+	// Rebuilds the bounds and moves the lights of the entities whose transforms changed since the last call
+	void UpdateTransforms();
+
+	// Sets every renderable entity's isVisible for this view, across the job system
+	void Cull(const glm::mat4& viewProjection);
+
+	// Adds every renderable entity to the queue, the ones Cull didn't see as hidden
+	void Submit(RenderQueue& queue) const;
+
+	inline unsigned int GetEntityCount() const
+	{
+		return this->entityCount;
+	}
+
+	// Renderable entities with bounds, the ones the systems draw
+	inline unsigned int GetRenderableCount() const
+	{
+		return this->renderableCount;
+	}
+
+	// As of the last Cull
+	inline unsigned int GetVisibleCount() const
+	{
+		return this->visibleCount;
+	}
+
+private:
+	std::vector<unsigned int> generations;	// Per entity index, bumped when it's destroyed
+	std::vector<unsigned int> freeIndices;
+	unsigned int entityCount;
+
+	ComponentPool<sTransformComponent> transforms;
+	ComponentPool<sRenderableComponent> renderables;
+	ComponentPool<sBoundsComponent> bounds;
+	ComponentPool<sLightComponent> lights;
+	ComponentPool<sPanelAnimationComponent> panelAnimations;
+
+	// The first renderableCount of transforms, renderables and bounds are the same entities in the same order
+	unsigned int renderableCount;
+
+	std::vector<unsigned int> dirtyEntities;	// Moved since the last UpdateTransforms
+	std::vector<unsigned char> isDirty;			// Per entity index
+
+	unsigned int visibleCount;
+
+	// Moves the entity into or out of the front of the transform, renderable and bounds pools, for when it gains or
+	// loses one of them
+	void JoinRenderables(unsigned int entity);
+	void LeaveRenderables(unsigned int entity);
+
+	void MarkDirty(unsigned int entity);
+
+	// The model's world space bounds at transform
+	static void BuildBounds(const sTransformComponent& transform, ModelHandle model, sBoundsComponent& bounds);
+};
@@ -0,0 +1,66 @@
+#include "FrameAllocator.h"
+
+#include <algorithm>
+#include <cstdint>
+
+// The next address from pointer on that's a multiple of alignment (a power of two)
+static char* AlignUp(char* pointer, size_t alignment)
+{
+	return (char*) (((uintptr_t) pointer + alignment - 1) & ~(uintptr_t) (alignment - 1));
+}
+
+FrameArena::FrameArena(size_t capacity)
+	: memory(new char[capacity]), capacity(capacity), offset(0), overflowSize(0), highWater(0)
+{
+
+}
+
+FrameArena::~FrameArena()
+{
+	this->Reset();
+	delete[] this->memory;
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	char* pointer = AlignUp(this->memory + this->offset, alignment);
+	if (pointer + size <= this->memory + this->capacity)
+	{
+		this->offset = (pointer + size) - this->memory;
+		this->highWater = std::max(this->highWater, this->offset + this->overflowSize);
+		return pointer;
+	}
+
+	// Doesn't fit, keep going on the heap until Reset makes room
+	char* block = new char[size + alignment];
+	this->overflowBlocks.push_back(block);
+	this->overflowSize += size + alignment;
+	this->highWater = std::max(this->highWater, this->offset + this->overflowSize);
+	return AlignUp(block, alignment);
+}
+
+void FrameArena::Reset()
+{
+	for (char* block : this->overflowBlocks)
+	{
+		delete[] block;
+	}
+	this->overflowBlocks.clear();
+
+	if (this->overflowSize > 0)
+	{
+		// Room for the biggest frame yet, so this one's the last to overflow unless frames keep growing
+		this->capacity = std::max(this->capacity * 2, this->highWater);
+		delete[] this->memory;
+		this->memory = new char[this->capacity];
+		this->overflowSize = 0;
+	}
+
+	this->offset = 0;
+}
+
+FrameArena& FrameArena::GetThreadArena()
+{
+	static thread_local FrameArena arena;
+	return arena;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for data that only lives for one frame: allocating bumps an offset, nothing is freed on its own and
+// Reset hands everything back at once. Every thread has its own (see GetThreadArena) and resets it at its frame
+// boundary, the main thread before it builds a frame and the render thread after it drew one.
+// Allocations that don't fit go to the heap for the rest of the frame, then Reset grows the arena so they fit next time.
+class FrameArena
+{
+public:
+	static const size_t DEFAULT_CAPACITY = 64 * 1024;
+
+	explicit FrameArena(size_t capacity = DEFAULT_CAPACITY);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	// Everything allocated since the last Reset is gone after this
+	void Reset();
+
+	inline size_t GetCapacity() const
+	{
+		return this->capacity;
+	}
+
+	// Most bytes a frame used so far, including what didn't fit
+	inline size_t GetHighWater() const
+	{
+		return this->highWater;
+	}
+
+	// The calling thread's arena, made the first time it's asked for
+	static FrameArena& GetThreadArena();
+
+private:
+	char* memory;
+	size_t capacity;
+	size_t offset;
+	std::vector<char*> overflowBlocks;	// This frame's allocations that didn't fit
+	size_t overflowSize;
+	size_t highWater;
+};
+
+// Lets the standard containers allocate from a FrameArena, the calling thread's unless one is given.
+// Deallocating does nothing, so a container using it must not be kept past its arena's Reset. One kept as a member
+// has to be given up (assigned an empty one) before then, which also moves it onto the assigning thread's arena.
+template <class T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	FrameAllocator()
+		: arena(&FrameArena::GetThreadArena())
+	{
+
+	}
+
+	explicit FrameAllocator(FrameArena& arena)
+		: arena(&arena)
+	{
+
+	}
+
+	template <class U>
+	FrameAllocator(const FrameAllocator<U>& other)
+		: arena(other.arena)
+	{
+
+	}
+
+	T* allocate(size_t count)
+	{
+		return (T*) this->arena->Allocate(count * sizeof(T), alignof(T));
+	}
+
+	void deallocate(T* pointer, size_t count)
+	{
+
+	}
+
+	template <class U>
+	bool operator==(const FrameAllocator<U>& other) const
+	{
+		return this->arena == other.arena;
+	}
+
+	template <class U>
+	bool operator!=(const FrameAllocator<U>& other) const
+	{
+		return this->arena != other.arena;
+	}
+
+private:
+	template <class U>
+	friend class FrameAllocator;
+
+	FrameArena* arena;
+};
+
+template <class T>
+using FrameVector = std::vector<T, FrameAllocator<T> >;
+
+typedef std::basic_string<char, std::char_traits<char>, FrameAllocator<char> > FrameString;
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// The 6 planes of the view frustum (Gribb and Hartmann), pointing in. Not normalized, only the sign is used.
+struct sFrustum
+{
+	glm::vec4 planes[6];
+};
+
+inline sFrustum GetFrustum(const glm::mat4& viewProjection)
+{
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row]);
+	}
+
+	sFrustum frustum;
+	frustum.planes[0] = rows[3] + rows[0]; // Left
+	frustum.planes[1] = rows[3] - rows[0]; // Right
+	frustum.planes[2] = rows[3] + rows[1]; // Bottom
+	frustum.planes[3] = rows[3] - rows[1]; // Top
+	frustum.planes[4] = rows[3] + rows[2]; // Near
+	frustum.planes[5] = rows[3] - rows[2]; // Far
+	return frustum;
+}
+
+// False if the box is completely behind one of the planes
+inline bool IsBoxInFrustum(const sFrustum& frustum, const glm::vec3& center, const glm::vec3& halfExtent)
+{
+	for (const glm::vec4& plane : frustum.planes)
+	{
+		glm::vec3 normal(plane);
+		if (glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), halfExtent) < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,679 @@
+#include "GlbLoader.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+static const uint32_t GLB_MAGIC = 0x46546C67;		// "glTF"
+static const uint32_t GLB_VERSION = 2;
+static const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;	// "JSON"
+static const uint32_t GLB_CHUNK_BIN = 0x004E4942;	// "BIN\0"
+static const int GLB_MODE_TRIANGLES = 4;
+static const int MAX_JSON_DEPTH = 64;				// glTF never nests anywhere near this, it only stops a bad file overflowing the stack
+
+struct sGlbHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t length;
+};
+
+struct sGlbChunkHeader
+{
+	uint32_t length;
+	uint32_t type;
+};
+
+// Just enough JSON for a glTF header. Objects keep their members in order, lookups are linear (they're small).
+struct sJsonValue
+{
+	enum eType
+	{
+		JSON_NULL,
+		JSON_BOOL,
+		JSON_NUMBER,
+		JSON_STRING,
+		JSON_ARRAY,
+		JSON_OBJECT
+	};
+
+	eType type = JSON_NULL;
+	double number = 0.0;				// Bools are 0 or 1
+	std::string string;
+	std::vector<sJsonValue> elements;	// Array elements, or object members
+	std::vector<std::string> keys;		// Objects only, keys[i] goes with elements[i]
+
+	const sJsonValue* Find(const char* key) const
+	{
+		for (size_t i = 0; i < this->keys.size(); i++)
+		{
+			if (this->keys[i] == key)
+			{
+				return &this->elements[i];
+			}
+		}
+		return NULL;
+	}
+
+	// NULL unless the member is there and of that type
+	const sJsonValue* Find(const char* key, eType memberType) const
+	{
+		const sJsonValue* member = this->Find(key);
+		return member && member->type == memberType ? member : NULL;
+	}
+
+	double GetNumber(const char* key, double fallback) const
+	{
+		const sJsonValue* member = this->Find(key, JSON_NUMBER);
+		return member ? member->number : fallback;
+	}
+
+	// For indices and enums, fallback unless it's a whole number that fits
+	int GetInt(const char* key, int fallback) const
+	{
+		double number = this->GetNumber(key, fallback);
+		return number >= -2147483647.0 && number <= 2147483647.0 && number == std::floor(number) ? (int) number : fallback;
+	}
+
+	// Element index of the array member key, NULL if any of that isn't there
+	const sJsonValue* GetElement(const char* key, int index, eType elementType) const
+	{
+		const sJsonValue* array = this->Find(key, JSON_ARRAY);
+		if (!array || index < 0 || (size_t) index >= array->elements.size() || array->elements[index].type != elementType)
+		{
+			return NULL;
+		}
+		return &array->elements[index];
+	}
+};
+
+static void SkipJsonWhitespace(const char*& cursor, const char* end)
+{
+	while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r'))
+	{
+		cursor++;
+	}
+}
+
+static bool MatchJsonLiteral(const char*& cursor, const char* end, const char* literal)
+{
+	size_t length = strlen(literal);
+	if ((size_t) (end - cursor) < length || memcmp(cursor, literal, length) != 0)
+	{
+		return false;
+	}
+	cursor += length;
+	return true;
+}
+
+static void AppendUtf8(std::string& string, uint32_t codePoint)
+{
+	if (codePoint < 0x80)
+	{
+		string += (char) codePoint;
+	}
+	else if (codePoint < 0x800)
+	{
+		string += (char) (0xC0 | (codePoint >> 6));
+		string += (char) (0x80 | (codePoint & 0x3F));
+	}
+	else if (codePoint < 0x10000)
+	{
+		string += (char) (0xE0 | (codePoint >> 12));
+		string += (char) (0x80 | ((codePoint >> 6) & 0x3F));
+		string += (char) (0x80 | (codePoint & 0x3F));
+	}
+	else
+	{
+		string += (char) (0xF0 | (codePoint >> 18));
+		string += (char) (0x80 | ((codePoint >> 12) & 0x3F));
+		string += (char) (0x80 | ((codePoint >> 6) & 0x3F));
+		string += (char) (0x80 | (codePoint & 0x3F));
+	}
+}
+
+static bool ParseJsonHex4(const char*& cursor, const char* end, uint32_t& value)
+{
+	if (end - cursor < 4)
+	{
+		return false;
+	}
+
+	value = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		char c = *cursor++;
+		value <<= 4;
+		if (c >= '0' && c <= '9') value |= (uint32_t) (c - '0');
+		else if (c >= 'a' && c <= 'f') value |= (uint32_t) (c - 'a' + 10);
+		else if (c >= 'A' && c <= 'F') value |= (uint32_t) (c - 'A' + 10);
+		else return false;
+	}
+	return true;
+}
+
+// cursor is just past the opening quote
+static bool ParseJsonString(const char*& cursor, const char* end, std::string& string)
+{
+	string.clear();
+	while (cursor < end)
+	{
+		char c = *cursor++;
+		if (c == '"')
+		{
+			return true;
+		}
+		if (c != '\\')
+		{
+			string += c;
+			continue;
+		}
+
+		if (cursor >= end)
+		{
+			return false;
+		}
+		char escape = *cursor++;
+		switch (escape)
+		{
+		case '"': case '\\': case '/': string += escape; break;
+		case 'b': string += '\b'; break;
+		case 'f': string += '\f'; break;
+		case 'n': string += '\n'; break;
+		case 'r': string += '\r'; break;
+		case 't': string += '\t'; break;
+		case 'u':
+		{
+			uint32_t codePoint;
+			if (!ParseJsonHex4(cursor, end, codePoint))
+			{
+				return false;
+			}
+
+			uint32_t low;
+			const char* lowStart = cursor;
+			if (codePoint >= 0xD800 && codePoint < 0xDC00 && MatchJsonLiteral(cursor, end, "\\u") && ParseJsonHex4(cursor, end, low) && low >= 0xDC00 && low < 0xE000)
+			{
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00); // Surrogate pair
+			}
+			else if (codePoint >= 0xD800 && codePoint < 0xDC00)
+			{
+				cursor = lowStart; // Unpaired, keep it as it is
+			}
+			AppendUtf8(string, codePoint);
+			break;
+		}
+		default:
+			return false;
+		}
+	}
+
+	return false;
+}
+
+static bool ParseJsonNumber(const char*& cursor, const char* end, double& number)
+{
+	// strtod wants a terminated string and the chunk isn't one
+	char text[64];
+	size_t length = 0;
+	while (cursor < end && length < sizeof(text) - 1 && (isdigit((unsigned char) *cursor) || *cursor == '-' || *cursor == '+' || *cursor == '.' || *cursor == 'e' || *cursor == 'E'))
+	{
+		text[length++] = *cursor++;
+	}
+	text[length] = '\0';
+
+	char* parsedEnd = NULL;
+	number = strtod(text, &parsedEnd);
+	return length > 0 && parsedEnd == text + length;
+}
+
+static bool ParseJsonValue(const char*& cursor, const char* end, sJsonValue& value, int depth)
+{
+	SkipJsonWhitespace(cursor, end);
+	if (cursor >= end || depth > MAX_JSON_DEPTH)
+	{
+		return false;
+	}
+
+	char c = *cursor;
+	if (c == '{' || c == '[')
+	{
+		bool isObject = c == '{';
+		char closing = isObject ? '}' : ']';
+		value.type = isObject ? sJsonValue::JSON_OBJECT : sJsonValue::JSON_ARRAY;
+		cursor++;
+
+		SkipJsonWhitespace(cursor, end);
+		if (cursor < end && *cursor == closing)
+		{
+			cursor++;
+			return true;
+		}
+
+		while (true)
+		{
+			if (isObject)
+			{
+				SkipJsonWhitespace(cursor, end);
+				std::string key;
+				if (cursor >= end || *cursor++ != '"' || !ParseJsonString(cursor, end, key))
+				{
+					return false;
+				}
+				SkipJsonWhitespace(cursor, end);
+				if (cursor >= end || *cursor++ != ':')
+				{
+					return false;
+				}
+				value.keys.push_back(key);
+			}
+
+			value.elements.emplace_back();
+			if (!ParseJsonValue(cursor, end, value.elements.back(), depth + 1))
+			{
+				return false;
+			}
+
+			SkipJsonWhitespace(cursor, end);
+			if (cursor >= end)
+			{
+				return false;
+			}
+			char separator = *cursor++;
+			if (separator == closing)
+			{
+				return true;
+			}
+			if (separator != ',')
+			{
+				return false;
+			}
+		}
+	}
+
+	if (c == '"')
+	{
+		value.type = sJsonValue::JSON_STRING;
+		cursor++;
+		return ParseJsonString(cursor, end, value.string);
+	}
+
+	if (MatchJsonLiteral(cursor, end, "true"))
+	{
+		value.type = sJsonValue::JSON_BOOL;
+		value.number = 1.0;
+		return true;
+	}
+
+	if (MatchJsonLiteral(cursor, end, "false"))
+	{
+		value.type = sJsonValue::JSON_BOOL;
+		value.number = 0.0;
+		return true;
+	}
+
+	if (MatchJsonLiteral(cursor, end, "null"))
+	{
+		value.type = sJsonValue::JSON_NULL;
+		return true;
+	}
+
+	value.type = sJsonValue::JSON_NUMBER;
+	return ParseJsonNumber(cursor, end, value.number);
+}
+
+static unsigned int GlbComponentSize(int componentType)
+{
+	switch (componentType)
+	{
+	case GLB_COMPONENT_BYTE: case GLB_COMPONENT_UNSIGNED_BYTE: return 1;
+	case GLB_COMPONENT_SHORT: case GLB_COMPONENT_UNSIGNED_SHORT: return 2;
+	case GLB_COMPONENT_UNSIGNED_INT: case GLB_COMPONENT_FLOAT: return 4;
+	default: return 0;
+	}
+}
+
+static unsigned int GlbComponentCount(const std::string& type)
+{
+	if (type == "SCALAR") return 1;
+	if (type == "VEC2") return 2;
+	if (type == "VEC3") return 3;
+	if (type == "VEC4") return 4;
+	return 0; // Matrices, nothing we'd read
+}
+
+// Resolves accessor index down to the bytes in the binary chunk, and checks every element is inside it
+static bool ReadGlbAccessor(const sJsonValue& root, int index, const unsigned char* binary, size_t binarySize, sGlbAccessor& accessor, std::string& error)
+{
+	const sJsonValue* json = root.GetElement("accessors", index, sJsonValue::JSON_OBJECT);
+	if (!json)
+	{
+		error = "accessor " + std::to_string(index) + " doesn't exist";
+		return false;
+	}
+	if (json->Find("sparse"))
+	{
+		error = "sparse accessors aren't supported";
+		return false;
+	}
+
+	const sJsonValue* type = json->Find("type", sJsonValue::JSON_STRING);
+	int componentType = json->GetInt("componentType", 0);
+	double count = json->GetNumber("count", -1.0);
+	double byteOffset = json->GetNumber("byteOffset", 0.0);
+	accessor.bufferView = json->GetInt("bufferView", -1);
+	accessor.componentCount = type ? GlbComponentCount(type->string) : 0;
+	unsigned int componentSize = GlbComponentSize(componentType);
+	if (accessor.componentCount == 0 || componentSize == 0 || count < 0.0 || count > 0xFFFFFFFFu || byteOffset < 0.0)
+	{
+		error = "accessor " + std::to_string(index) + " isn't valid";
+		return false;
+	}
+
+	const sJsonValue* view = root.GetElement("bufferViews", accessor.bufferView, sJsonValue::JSON_OBJECT);
+	if (!view) // Without a buffer view it's all zeros, which is never a mesh worth loading
+	{
+		error = "accessor " + std::to_string(index) + " has no buffer view";
+		return false;
+	}
+
+	// Only the GLB's own binary chunk, buffer 0 without a uri
+	int buffer = view->GetInt("buffer", -1);
+	const sJsonValue* bufferJson = root.GetElement("buffers", buffer, sJsonValue::JSON_OBJECT);
+	if (buffer != 0 || !bufferJson || bufferJson->Find("uri") || !binary)
+	{
+		error = "only the GLB binary chunk is supported as a buffer";
+		return false;
+	}
+
+	double viewOffset = view->GetNumber("byteOffset", 0.0);
+	double viewLength = view->GetNumber("byteLength", -1.0);
+	double viewStride = view->GetNumber("byteStride", 0.0);
+	if (viewOffset < 0.0 || viewLength < 0.0 || viewOffset + viewLength > (double) binarySize || viewStride < 0.0 || viewStride > 252.0)
+	{
+		error = "buffer view " + std::to_string(accessor.bufferView) + " is outside the binary chunk";
+		return false;
+	}
+
+	unsigned int elementSize = accessor.componentCount * componentSize;
+	unsigned int stride = viewStride > 0.0 ? (unsigned int) viewStride : elementSize;
+	if (byteOffset > viewLength || (count > 0.0 && byteOffset + (double) stride * (count - 1.0) + elementSize > viewLength))
+	{
+		error = "accessor " + std::to_string(index) + " runs past its buffer view";
+		return false;
+	}
+
+	accessor.count = (unsigned int) count;
+	accessor.componentType = (eGlbComponentType) componentType;
+	accessor.normalized = json->Find("normalized", sJsonValue::JSON_BOOL) && json->Find("normalized")->number != 0.0;
+	accessor.stride = stride;
+	accessor.byteOffset = (size_t) byteOffset;
+	accessor.viewData = binary + (size_t) viewOffset;
+	accessor.viewSize = (size_t) viewLength;
+	accessor.data = accessor.viewData + accessor.byteOffset;
+
+	const sJsonValue* minValues = json->Find("min", sJsonValue::JSON_ARRAY);
+	const sJsonValue* maxValues = json->Find("max", sJsonValue::JSON_ARRAY);
+	if (minValues && maxValues && accessor.componentCount == 3 && minValues->elements.size() == 3 && maxValues->elements.size() == 3)
+	{
+		accessor.hasBounds = true;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			accessor.minValues[axis] = (float) minValues->elements[axis].number;
+			accessor.maxValues[axis] = (float) maxValues->elements[axis].number;
+		}
+	}
+
+	return true;
+}
+
+// An accessor we can read, or false with error set if it's there but not something we can
+static bool ReadGlbAttribute(const sJsonValue& root, const sJsonValue& attributes, const char* name, const unsigned char* binary, size_t binarySize, sGlbAccessor& accessor, std::string& error)
+{
+	if (!attributes.Find(name))
+	{
+		return true;
+	}
+	return ReadGlbAccessor(root, attributes.GetInt(name, -1), binary, binarySize, accessor, error);
+}
+
+static bool IsNormalizedOrFloat(const sGlbAccessor& accessor)
+{
+	return accessor.componentType == GLB_COMPONENT_FLOAT ||
+		(accessor.normalized && (accessor.componentType == GLB_COMPONENT_UNSIGNED_BYTE || accessor.componentType == GLB_COMPONENT_UNSIGNED_SHORT));
+}
+
+// File name of the image behind the material's base color texture, only for images that are files of their own
+static std::string GetGlbDiffuseTexture(const sJsonValue& root, int materialIndex)
+{
+	const sJsonValue* material = root.GetElement("materials", materialIndex, sJsonValue::JSON_OBJECT);
+	const sJsonValue* pbr = material ? material->Find("pbrMetallicRoughness", sJsonValue::JSON_OBJECT) : NULL;
+	const sJsonValue* textureInfo = pbr ? pbr->Find("baseColorTexture", sJsonValue::JSON_OBJECT) : NULL;
+	const sJsonValue* texture = textureInfo ? root.GetElement("textures", textureInfo->GetInt("index", -1), sJsonValue::JSON_OBJECT) : NULL;
+	const sJsonValue* image = texture ? root.GetElement("images", texture->GetInt("source", -1), sJsonValue::JSON_OBJECT) : NULL;
+	const sJsonValue* uri = image ? image->Find("uri", sJsonValue::JSON_STRING) : NULL;
+	if (!uri || uri->string.compare(0, 5, "data:") == 0)
+	{
+		return "";
+	}
+
+	return uri->string.substr(uri->string.find_last_of("\\/") + 1);
+}
+
+static bool ReadGlbPrimitive(const sJsonValue& root, const sJsonValue& json, const unsigned char* binary, size_t binarySize, sGlbPrimitive& primitive, std::string& error)
+{
+	const sJsonValue* attributes = json.Find("attributes", sJsonValue::JSON_OBJECT);
+	if (!attributes || !attributes->Find("POSITION", sJsonValue::JSON_NUMBER))
+	{
+		error = "a primitive has no positions";
+		return false;
+	}
+
+	if (!ReadGlbAttribute(root, *attributes, "POSITION", binary, binarySize, primitive.position, error) ||
+		!ReadGlbAttribute(root, *attributes, "NORMAL", binary, binarySize, primitive.normal, error) ||
+		!ReadGlbAttribute(root, *attributes, "COLOR_0", binary, binarySize, primitive.color, error) ||
+		!ReadGlbAttribute(root, *attributes, "TEXCOORD_0", binary, binarySize, primitive.texCoord, error))
+	{
+		return false;
+	}
+
+	bool isIndexed = json.Find("indices") != NULL;
+	if (isIndexed && !ReadGlbAccessor(root, json.GetInt("indices", -1), binary, binarySize, primitive.indices, error))
+	{
+		return false;
+	}
+
+	// The types the spec allows for each, anything else is a broken file
+	unsigned int vertexCount = primitive.position.count;
+	bool isValid = primitive.position.componentType == GLB_COMPONENT_FLOAT && primitive.position.componentCount == 3;
+	isValid &= primitive.normal.count == 0 || (primitive.normal.count == vertexCount && primitive.normal.componentType == GLB_COMPONENT_FLOAT && primitive.normal.componentCount == 3);
+	isValid &= primitive.color.count == 0 || (primitive.color.count == vertexCount && IsNormalizedOrFloat(primitive.color) && primitive.color.componentCount >= 3);
+	isValid &= primitive.texCoord.count == 0 || (primitive.texCoord.count == vertexCount && IsNormalizedOrFloat(primitive.texCoord) && primitive.texCoord.componentCount == 2);
+	isValid &= !isIndexed || (primitive.indices.componentCount == 1 &&
+		(primitive.indices.componentType == GLB_COMPONENT_UNSIGNED_BYTE || primitive.indices.componentType == GLB_COMPONENT_UNSIGNED_SHORT || primitive.indices.componentType == GLB_COMPONENT_UNSIGNED_INT));
+	if (!isValid)
+	{
+		error = "a primitive has attributes of the wrong type or count";
+		return false;
+	}
+
+	primitive.diffuseTexture = GetGlbDiffuseTexture(root, json.GetInt("material", -1));
+	return true;
+}
+
+bool IsGlbFile(const unsigned char* data, size_t size)
+{
+	uint32_t magic;
+	if (!data || size < sizeof(sGlbHeader))
+	{
+		return false;
+	}
+	memcpy(&magic, data, sizeof(magic));
+	return magic == GLB_MAGIC;
+}
+
+bool LoadGlb(const unsigned char* data, size_t size, sGlbFile& file, std::string& error)
+{
+	file.primitives.clear();
+	if (!IsGlbFile(data, size))
+	{
+		error = "not a GLB file";
+		return false;
+	}
+
+	sGlbHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (header.version != GLB_VERSION || header.length > size)
+	{
+		error = "unsupported GLB version or the file is cut short";
+		return false;
+	}
+
+	// The JSON chunk comes first, then an optional binary chunk. Anything after that is an extension's, skip it.
+	const char* json = NULL;
+	size_t jsonSize = 0;
+	const unsigned char* binary = NULL;
+	size_t binarySize = 0;
+	size_t offset = sizeof(sGlbHeader);
+	while (offset + sizeof(sGlbChunkHeader) <= header.length)
+	{
+		sGlbChunkHeader chunk;
+		memcpy(&chunk, data + offset, sizeof(chunk));
+		offset += sizeof(chunk);
+		if (chunk.length > header.length - offset)
+		{
+			error = "a GLB chunk runs past the end of the file";
+			return false;
+		}
+
+		if (chunk.type == GLB_CHUNK_JSON && !json)
+		{
+			json = reinterpret_cast<const char*>(data + offset);
+			jsonSize = chunk.length;
+		}
+		else if (chunk.type == GLB_CHUNK_BIN && !binary)
+		{
+			binary = data + offset;
+			binarySize = chunk.length;
+		}
+		offset += (chunk.length + 3) & ~3u;
+	}
+
+	sJsonValue root;
+	const char* cursor = json;
+	if (!json || !ParseJsonValue(cursor, json + jsonSize, root, 0) || root.type != sJsonValue::JSON_OBJECT)
+	{
+		error = "the GLB has no valid JSON chunk";
+		return false;
+	}
+
+	const sJsonValue* extensions = root.Find("extensionsRequired", sJsonValue::JSON_ARRAY);
+	if (extensions && !extensions->elements.empty())
+	{
+		error = "the GLB requires extension " + extensions->elements[0].string;
+		return false;
+	}
+
+	const sJsonValue* meshes = root.Find("meshes", sJsonValue::JSON_ARRAY);
+	if (!meshes)
+	{
+		return true; // Valid, just nothing to draw
+	}
+
+	for (const sJsonValue& mesh : meshes->elements)
+	{
+		const sJsonValue* primitives = mesh.Find("primitives", sJsonValue::JSON_ARRAY);
+		if (mesh.type != sJsonValue::JSON_OBJECT || !primitives)
+		{
+			error = "a mesh has no primitives";
+			return false;
+		}
+
+		for (const sJsonValue& primitiveJson : primitives->elements)
+		{
+			if (primitiveJson.type != sJsonValue::JSON_OBJECT)
+			{
+				error = "a primitive isn't an object";
+				return false;
+			}
+			if (primitiveJson.GetInt("mode", GLB_MODE_TRIANGLES) != GLB_MODE_TRIANGLES) // Points and lines, like the assimp path skips them
+			{
+				continue;
+			}
+
+			file.primitives.emplace_back();
+			if (!ReadGlbPrimitive(root, primitiveJson, binary, binarySize, file.primitives.back(), error))
+			{
+				file.primitives.clear();
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void ReadGlbElement(const sGlbAccessor& accessor, unsigned int index, float* values)
+{
+	const unsigned char* element = accessor.data + (size_t) index * accessor.stride;
+	for (unsigned int i = 0; i < accessor.componentCount; i++)
+	{
+		switch (accessor.componentType)
+		{
+		case GLB_COMPONENT_FLOAT:
+			memcpy(&values[i], element + i * sizeof(float), sizeof(float));
+			break;
+		case GLB_COMPONENT_UNSIGNED_BYTE:
+			values[i] = accessor.normalized ? element[i] / 255.0f : (float) element[i];
+			break;
+		case GLB_COMPONENT_BYTE:
+		{
+			float value = (float) (signed char) element[i];
+			values[i] = accessor.normalized ? (value / 127.0f < -1.0f ? -1.0f : value / 127.0f) : value;
+			break;
+		}
+		case GLB_COMPONENT_UNSIGNED_SHORT:
+		{
+			uint16_t value;
+			memcpy(&value, element + i * sizeof(value), sizeof(value));
+			values[i] = accessor.normalized ? value / 65535.0f : (float) value;
+			break;
+		}
+		case GLB_COMPONENT_SHORT:
+		{
+			int16_t value;
+			memcpy(&value, element + i * sizeof(value), sizeof(value));
+			values[i] = accessor.normalized ? (value / 32767.0f < -1.0f ? -1.0f : value / 32767.0f) : (float) value;
+			break;
+		}
+		case GLB_COMPONENT_UNSIGNED_INT:
+		{
+			uint32_t value;
+			memcpy(&value, element + i * sizeof(value), sizeof(value));
+			values[i] = (float) value;
+			break;
+		}
+		}
+	}
+}
+
+unsigned int ReadGlbIndex(const sGlbAccessor& accessor, unsigned int index)
+{
+	const unsigned char* element = accessor.data + (size_t) index * accessor.stride;
+	if (accessor.componentType == GLB_COMPONENT_UNSIGNED_BYTE)
+	{
+		return element[0];
+	}
+	if (accessor.componentType == GLB_COMPONENT_UNSIGNED_SHORT)
+	{
+		uint16_t value;
+		memcpy(&value, element, sizeof(value));
+		return value;
+	}
+
+	uint32_t value;
+	memcpy(&value, element, sizeof(value));
+	return value;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// glTF's componentType values, the same numbers as the GL enums
+enum eGlbComponentType
+{
+	GLB_COMPONENT_BYTE = 5120,
+	GLB_COMPONENT_UNSIGNED_BYTE = 5121,
+	GLB_COMPONENT_SHORT = 5122,
+	GLB_COMPONENT_UNSIGNED_SHORT = 5123,
+	GLB_COMPONENT_UNSIGNED_INT = 5125,
+	GLB_COMPONENT_FLOAT = 5126
+};
+
+// One accessor of a GLB file, pointing into its binary chunk. count is 0 if the primitive doesn't have it.
+struct sGlbAccessor
+{
+	const unsigned char* data = NULL;	// First element
+	unsigned int count = 0;
+	eGlbComponentType componentType = GLB_COMPONENT_FLOAT;
+	unsigned int componentCount = 0;	// 1 for SCALAR up to 4 for VEC4
+	bool normalized = false;
+	unsigned int stride = 0;			// The buffer view's byteStride, or the element size if it's tightly packed
+
+	// Where it is in its buffer view, so callers can tell which attributes are interleaved together
+	int bufferView = -1;
+	size_t byteOffset = 0;
+	const unsigned char* viewData = NULL;
+	size_t viewSize = 0;
+
+	bool hasBounds = false;				// glTF requires min/max on positions, but not everything writes them
+	float minValues[3] = { 0.0f, 0.0f, 0.0f };
+	float maxValues[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+// A triangle list primitive, every accessor already checked to lie inside the file
+struct sGlbPrimitive
+{
+	sGlbAccessor position;			// VEC3 float
+	sGlbAccessor normal;			// VEC3 float
+	sGlbAccessor color;				// COLOR_0, VEC3 or VEC4, float or normalized 8/16 bit
+	sGlbAccessor texCoord;			// TEXCOORD_0, VEC2, float or normalized 8/16 bit
+	sGlbAccessor indices;			// 8, 16 or 32 bit, data is NULL for a primitive that isn't indexed
+	std::string diffuseTexture;		// File name of the base color texture's image, empty if there isn't one (or it's embedded)
+};
+
+// What LoadGlb got out of a file
+struct sGlbFile
+{
+	std::vector<sGlbPrimitive> primitives; // Every triangle primitive of every mesh, in order. Node transforms are ignored, like the assimp path does.
+};
+
+// glTF 2.0 binary (.glb) reader. Parses the JSON chunk and resolves the accessors, but leaves the geometry where it is
+// so the caller decides whether it needs converting at all (see CookModel). Only the GLB's own binary chunk is
+// supported. Sparse accessors, external buffers and required extensions (Draco, meshopt) return false so the caller
+// can fall back to assimp.
+bool LoadGlb(const unsigned char* data, size_t size, sGlbFile& file, std::string& error);
+
+// True if data starts with the GLB header
+bool IsGlbFile(const unsigned char* data, size_t size);
+
+// Element index of an accessor as floats (normalized integers mapped to 0-1 or -1-1). Writes componentCount values.
+void ReadGlbElement(const sGlbAccessor& accessor, unsigned int index, float* values);
+
+unsigned int ReadGlbIndex(const sGlbAccessor& accessor, unsigned int index);
@@ -0,0 +1,423 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+JobSystem* JobSystem::instance = NULL;
+
+static thread_local int tWorkerIndex = -1;
+
+// Threads that aren't workers still get somewhere to create jobs, Run just runs them right away there
+static thread_local std::unique_ptr<sJob[]> tExternalJobs;
+static thread_local unsigned int tNextExternalJob = 0;
+
+// Rounds of looking for work (yielding in between) before a worker goes to sleep. Frames hand out work in bursts,
+// so a worker that just ran out usually gets more a few microseconds later.
+static const unsigned int SPIN_ROUNDS = 64;
+
+static uint64_t GetElapsedNanoseconds(std::chrono::steady_clock::time_point start)
+{
+	return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+JobSystem::JobDeque::JobDeque()
+	: top(0), bottom(0)
+{
+	for (unsigned int i = 0; i < MAX_JOB_COUNT; i++)
+	{
+		this->entries[i].store(NULL, std::memory_order_relaxed);
+	}
+}
+
+// Everything is sequentially consistent, the fences of the original paper don't buy much on x86 and this is easier to get right
+bool JobSystem::JobDeque::Push(sJob* job)
+{
+	int64_t bottom = this->bottom.load(std::memory_order_relaxed);
+	if (bottom - this->top.load() >= (int64_t) MAX_JOB_COUNT)
+	{
+		return false;
+	}
+
+	this->entries[bottom & (MAX_JOB_COUNT - 1)].store(job, std::memory_order_relaxed);
+	this->bottom.store(bottom + 1);
+	return true;
+}
+
+sJob* JobSystem::JobDeque::Pop()
+{
+	int64_t bottom = this->bottom.load(std::memory_order_relaxed) - 1;
+	this->bottom.store(bottom); // Claims the bottom job before looking at top, so a thief can't take it as well
+	int64_t top = this->top.load();
+	if (top > bottom) // Empty
+	{
+		this->bottom.store(bottom + 1, std::memory_order_relaxed);
+		return NULL;
+	}
+
+	sJob* job = this->entries[bottom & (MAX_JOB_COUNT - 1)].load(std::memory_order_relaxed);
+	if (top == bottom) // Last job, a thief could be taking it right now so it comes down to who moves top first
+	{
+		if (!this->top.compare_exchange_strong(top, top + 1))
+		{
+			job = NULL;
+		}
+		this->bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+sJob* JobSystem::JobDeque::Steal()
+{
+	int64_t top = this->top.load();
+	int64_t bottom = this->bottom.load();
+	if (top >= bottom)
+	{
+		return NULL;
+	}
+
+	sJob* job = this->entries[top & (MAX_JOB_COUNT - 1)].load(std::memory_order_relaxed);
+	if (!this->top.compare_exchange_strong(top, top + 1)) // The worker popped it or another thief got it
+	{
+		return NULL;
+	}
+
+	return job;
+}
+
+JobSystem::JobSystem()
+	: isShuttingDown(false), queuedJobs(0), sleepingWorkers(0)
+{
+	unsigned int workerCount = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		sWorker* worker = new sWorker();
+		worker->jobs = new sJob[MAX_JOB_COUNT];
+		for (unsigned int job = 0; job < MAX_JOB_COUNT; job++)
+		{
+			worker->jobs[job].unfinishedJobs.store(0, std::memory_order_relaxed);
+		}
+		worker->nextJob = 0;
+		worker->nextVictim = (i + 1) % workerCount;
+		this->workers.push_back(worker);
+	}
+
+	this->ResetStats();
+
+	// The thread creating us is worker 0, the rest get their own
+	tWorkerIndex = 0;
+	for (unsigned int i = 1; i < workerCount; i++)
+	{
+		this->threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->sleepMutex);
+		this->isShuttingDown = true;
+	}
+	this->sleepCondition.notify_all();
+
+	for (std::thread& thread : this->threads)
+	{
+		thread.join();
+	}
+
+	for (sWorker* worker : this->workers)
+	{
+		delete[] worker->jobs;
+		delete worker;
+	}
+
+	if (tWorkerIndex == 0)
+	{
+		tWorkerIndex = -1;
+	}
+	JobSystem::instance = NULL;
+}
+
+JobSystem* JobSystem::GetInstance()
+{
+	if (JobSystem::instance == NULL)
+	{
+		JobSystem::instance = new JobSystem();
+	}
+
+	return instance;
+}
+
+int JobSystem::GetWorkerIndex()
+{
+	return tWorkerIndex;
+}
+
+sJob* JobSystem::CreateJob(void (*function)(sJob& job), sJob* parent)
+{
+	sJob* job = NULL;
+	int workerIndex = tWorkerIndex;
+	if (workerIndex >= 0)
+	{
+		sWorker& worker = *this->workers[workerIndex];
+		job = &worker.jobs[worker.nextJob++ & (MAX_JOB_COUNT - 1)];
+
+		// The ring came all the way around to a job that's still running, help out until it's done
+		while (job->unfinishedJobs.load(std::memory_order_acquire) > 0)
+		{
+			sJob* other = this->FindJob(worker);
+			if (other)
+			{
+				this->Execute(other);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+	else
+	{
+		if (!tExternalJobs)
+		{
+			tExternalJobs.reset(new sJob[MAX_JOB_COUNT]);
+		}
+		job = &tExternalJobs[tNextExternalJob++ & (MAX_JOB_COUNT - 1)];
+	}
+
+	job->function = function;
+	job->parent = parent;
+	job->unfinishedJobs.store(1, std::memory_order_relaxed);
+	if (parent)
+	{
+		parent->unfinishedJobs.fetch_add(1, std::memory_order_relaxed); // The parent is still running, it's the one creating us
+	}
+
+	return job;
+}
+
+void JobSystem::Run(sJob* job)
+{
+	int workerIndex = tWorkerIndex;
+	if (workerIndex < 0)
+	{
+		this->Execute(job);
+		return;
+	}
+
+	this->queuedJobs.fetch_add(1);
+	if (!this->workers[workerIndex]->deque.Push(job)) // Full, this thread will have to do it
+	{
+		this->queuedJobs.fetch_sub(1);
+		this->Execute(job);
+		return;
+	}
+
+	// queuedJobs went up before this check, and sleeping workers check it after saying they're asleep, so one of us sees the other
+	if (this->sleepingWorkers.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(this->sleepMutex);
+		this->sleepCondition.notify_one();
+	}
+}
+
+void JobSystem::Wait(const sJob* job)
+{
+	int workerIndex = tWorkerIndex;
+	if (workerIndex < 0) // Run already ran it
+	{
+		while (job->unfinishedJobs.load(std::memory_order_acquire) > 0)
+		{
+			std::this_thread::yield();
+		}
+		return;
+	}
+
+	sWorker& worker = *this->workers[workerIndex];
+	bool isIdle = false;
+	std::chrono::steady_clock::time_point idleStart;
+	while (job->unfinishedJobs.load(std::memory_order_acquire) > 0)
+	{
+		sJob* other = this->FindJob(worker);
+		if (other)
+		{
+			if (isIdle)
+			{
+				worker.idleNanoseconds.fetch_add(GetElapsedNanoseconds(idleStart), std::memory_order_relaxed);
+				isIdle = false;
+			}
+			this->Execute(other);
+		}
+		else
+		{
+			if (!isIdle) // Everything left is running on other workers
+			{
+				idleStart = std::chrono::steady_clock::now();
+				isIdle = true;
+			}
+			std::this_thread::yield();
+		}
+	}
+
+	if (isIdle)
+	{
+		worker.idleNanoseconds.fetch_add(GetElapsedNanoseconds(idleStart), std::memory_order_relaxed);
+	}
+}
+
+sJob* JobSystem::FindJob(sWorker& worker)
+{
+	sJob* job = worker.deque.Pop();
+	if (job)
+	{
+		this->queuedJobs.fetch_sub(1);
+		return job;
+	}
+
+	// Try everyone else once, starting with whoever we last stole from since they probably still have more
+	unsigned int workerCount = (unsigned int) this->workers.size();
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		unsigned int victim = (worker.nextVictim + i) % workerCount;
+		if (this->workers[victim] == &worker)
+		{
+			continue;
+		}
+
+		job = this->workers[victim]->deque.Steal();
+		if (job)
+		{
+			worker.nextVictim = victim;
+			worker.steals.fetch_add(1, std::memory_order_relaxed);
+			this->queuedJobs.fetch_sub(1);
+			return job;
+		}
+
+		worker.failedSteals.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return NULL;
+}
+
+void JobSystem::Execute(sJob* job)
+{
+	job->function(*job);
+	this->Finish(job);
+
+	int workerIndex = tWorkerIndex;
+	if (workerIndex >= 0)
+	{
+		this->workers[workerIndex]->jobsRun.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void JobSystem::Finish(sJob* job)
+{
+	sJob* parent = job->parent; // Read first, the job can be reused as soon as it's finished
+	if (job->unfinishedJobs.fetch_sub(1, std::memory_order_acq_rel) == 1 && parent)
+	{
+		this->Finish(parent);
+	}
+}
+
+void JobSystem::ParallelForJob(sJob& job)
+{
+	sParallelForData data = job.GetData<sParallelForData>();
+
+	// Hand off the second half until what's left is one batch. Thieves take from the top of the deque, so they get the
+	// biggest halves and split those up themselves.
+	while (data.count > data.batchSize)
+	{
+		sParallelForData second = data;
+		second.begin += data.count / 2;
+		second.count -= data.count / 2;
+		data.count /= 2;
+
+		JobSystem::GetInstance()->Run(JobSystem::GetInstance()->CreateJob(&JobSystem::ParallelForJob, second, &job));
+	}
+
+	data.invoke(data.function, data.begin, data.begin + data.count);
+}
+
+void JobSystem::WorkerLoop(unsigned int workerIndex)
+{
+	tWorkerIndex = (int) workerIndex;
+	sWorker& worker = *this->workers[workerIndex];
+
+	while (!this->isShuttingDown.load(std::memory_order_relaxed))
+	{
+		sJob* job = this->FindJob(worker);
+		if (!job)
+		{
+			std::chrono::steady_clock::time_point idleStart = std::chrono::steady_clock::now();
+			for (unsigned int round = 0; round < SPIN_ROUNDS && !job; round++)
+			{
+				std::this_thread::yield();
+				job = this->FindJob(worker);
+			}
+
+			if (!job)
+			{
+				std::unique_lock<std::mutex> lock(this->sleepMutex);
+				this->sleepingWorkers.fetch_add(1);
+				this->sleepCondition.wait(lock, [this]() { return this->queuedJobs.load() > 0 || this->isShuttingDown.load(); });
+				this->sleepingWorkers.fetch_sub(1);
+			}
+
+			worker.idleNanoseconds.fetch_add(GetElapsedNanoseconds(idleStart), std::memory_order_relaxed);
+		}
+
+		if (job)
+		{
+			this->Execute(job);
+		}
+	}
+}
+
+void JobSystem::GetStats(std::vector<sJobWorkerStats>& stats) const
+{
+	stats.resize(this->workers.size());
+	for (unsigned int i = 0; i < this->workers.size(); i++)
+	{
+		const sWorker& worker = *this->workers[i];
+		stats[i].jobsRun = worker.jobsRun.load(std::memory_order_relaxed);
+		stats[i].steals = worker.steals.load(std::memory_order_relaxed);
+		stats[i].failedSteals = worker.failedSteals.load(std::memory_order_relaxed);
+		stats[i].idleSeconds = worker.idleNanoseconds.load(std::memory_order_relaxed) / 1e9;
+	}
+}
+
+void JobSystem::ResetStats()
+{
+	for (sWorker* worker : this->workers)
+	{
+		worker->jobsRun.store(0, std::memory_order_relaxed);
+		worker->steals.store(0, std::memory_order_relaxed);
+		worker->failedSteals.store(0, std::memory_order_relaxed);
+		worker->idleNanoseconds.store(0, std::memory_order_relaxed);
+	}
+}
+
+void JobSystem::PrintStats() const
+{
+	std::vector<sJobWorkerStats> stats;
+	this->GetStats(stats);
+
+	uint64_t totalJobs = 0;
+	uint64_t totalSteals = 0;
+	for (const sJobWorkerStats& worker : stats)
+	{
+		totalJobs += worker.jobsRun;
+		totalSteals += worker.steals;
+	}
+
+	std::cout << "Jobs: " << totalJobs << " on " << stats.size() << " workers, " << totalSteals << " stolen" << std::endl;
+	for (unsigned int i = 0; i < stats.size(); i++)
+	{
+		uint64_t attempts = stats[i].steals + stats[i].failedSteals;
+		std::cout << "  Worker " << i << ": " << stats[i].jobsRun << " jobs (" << stats[i].jobsRun * 100.0 / std::max<uint64_t>(totalJobs, 1) << "%), "
+			<< stats[i].steals << "/" << attempts << " steals succeeded, idle " << stats[i].idleSeconds * 1000.0 << " ms" << std::endl;
+	}
+}
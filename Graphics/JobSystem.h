@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A job: a function, a few bytes of arguments, and a counter of itself plus its unfinished children.
+// A job only counts as finished once every job created with it as the parent has finished too, so waiting on one job
+// waits on everything it fanned out into.
+struct alignas(64) sJob
+{
+	static const size_t DATA_SIZE = 40;
+
+	void (*function)(sJob& job);
+	sJob* parent;
+	std::atomic<int> unfinishedJobs;
+	unsigned char data[DATA_SIZE];
+
+	// The arguments CreateJob copied in
+	template <class TData>
+	inline const TData& GetData() const
+	{
+		return *reinterpret_cast<const TData*>(this->data);
+	}
+};
+
+// Per worker counters, see JobSystem::GetStats
+struct sJobWorkerStats
+{
+	uint64_t jobsRun;
+	uint64_t steals;			// Jobs taken from another worker's deque
+	uint64_t failedSteals;		// Deques that were empty (or another thief got there first)
+	double idleSeconds;			// Looking for work without finding any, spinning or asleep
+};
+
+// Work stealing job system for the per-frame CPU work (see RenderQueue). Every worker has its own deque: it pushes and
+// pops its jobs at the bottom (newest first, still in its cache) and idle workers steal from the top of the others
+// (oldest first, usually the biggest piece of a ParallelFor). The thread that first calls GetInstance is worker 0 and
+// runs jobs while it waits, the others are one thread per remaining core.
+// Only that thread and the workers can run jobs. Anything else calling Run just runs the job right away.
+class JobSystem
+{
+public:
+	~JobSystem();
+
+	static JobSystem* GetInstance();
+
+	// The job lives in a per worker ring of MAX_JOB_COUNT, so it has to be finished before that many more are created
+	// on the same thread. parent (if any) isn't finished until this one is.
+	sJob* CreateJob(void (*function)(sJob& job), sJob* parent = NULL);
+
+	// Same thing with arguments, copied into the job (job.GetData<TData>() in the function)
+	template <class TData>
+	sJob* CreateJob(void (*function)(sJob& job), const TData& data, sJob* parent = NULL)
+	{
+		static_assert(sizeof(TData) <= sJob::DATA_SIZE, "Job arguments don't fit in sJob::data, pass a pointer to them instead");
+		static_assert(std::is_trivially_copyable<TData>::value, "Job arguments are copied with memcpy");
+
+		sJob* job = this->CreateJob(function, parent);
+		memcpy(job->data, &data, sizeof(TData));
+		return job;
+	}
+
+	// Queues the job on this thread's deque
+	void Run(sJob* job);
+
+	// Runs other jobs until this one (and its children) finished
+	void Wait(const sJob* job);
+
+	// Calls function(begin, end) on ranges of [0, count) at most batchSize long, spread over every worker, and waits for all of them.
+	// The ranges are split in halves as they're taken so thieves get big pieces. function has to be safe to call on any thread.
+	// Batches grow past batchSize if there would be more than MAX_PARALLEL_FOR_BATCHES, so it never needs more jobs than the ring has.
+	template <class TFunction>
+	void ParallelFor(unsigned int count, unsigned int batchSize, const TFunction& function)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		sParallelForData data;
+		data.invoke = &JobSystem::InvokeRange<TFunction>;
+		data.function = &function;
+		data.begin = 0;
+		data.count = count;
+		data.batchSize = std::max(std::max(batchSize, 1u), (count + MAX_PARALLEL_FOR_BATCHES - 1) / MAX_PARALLEL_FOR_BATCHES);
+
+		sJob* job = this->CreateJob(&JobSystem::ParallelForJob, data);
+		this->Run(job);
+		this->Wait(job);
+	}
+
+	// Threads running jobs, including worker 0
+	inline unsigned int GetWorkerCount() const
+	{
+		return (unsigned int) this->workers.size();
+	}
+
+	// Index of the calling thread in [0, GetWorkerCount()), or -1 if it isn't one of them. For per worker data.
+	static int GetWorkerIndex();
+
+	// Counters since the last ResetStats, one per worker
+	void GetStats(std::vector<sJobWorkerStats>& stats) const;
+
+	void ResetStats();
+
+	// Prints how many jobs every worker ran, how many it stole and how long it sat idle since the last ResetStats
+	void PrintStats() const;
+
+	static const unsigned int MAX_JOB_COUNT = 4096; // Per worker, a power of 2
+	static const unsigned int MAX_PARALLEL_FOR_BATCHES = 512;
+
+private:
+	JobSystem();
+
+	// Chase-Lev deque. Only its worker pushes and pops (at the bottom), anyone can steal (at the top).
+	class JobDeque
+	{
+	public:
+		JobDeque();
+
+		// False if it's full
+		bool Push(sJob* job);
+		sJob* Pop();
+		sJob* Steal();
+
+	private:
+		std::atomic<int64_t> top;
+		std::atomic<int64_t> bottom;
+		std::atomic<sJob*> entries[MAX_JOB_COUNT];
+	};
+
+	struct alignas(64) sWorker
+	{
+		JobDeque deque;
+		sJob* jobs; // Ring of MAX_JOB_COUNT, see CreateJob
+		unsigned int nextJob;
+		unsigned int nextVictim; // Where this worker starts looking for jobs to steal
+
+		std::atomic<uint64_t> jobsRun;
+		std::atomic<uint64_t> steals;
+		std::atomic<uint64_t> failedSteals;
+		std::atomic<uint64_t> idleNanoseconds;
+	};
+
+	struct sParallelForData
+	{
+		void (*invoke)(const void* function, unsigned int begin, unsigned int end);
+		const void* function;
+		unsigned int begin;
+		unsigned int count;
+		unsigned int batchSize;
+	};
+
+	template <class TFunction>
+	static void InvokeRange(const void* function, unsigned int begin, unsigned int end)
+	{
+		(*static_cast<const TFunction*>(function))(begin, end);
+	}
+
+	static void ParallelForJob(sJob& job);
+
+	static JobSystem* instance;
+
+	std::vector<sWorker*> workers;
+	std::vector<std::thread> threads;
+	std::atomic<bool> isShuttingDown;
+
+	// Workers that found nothing to do sleep on this, Run wakes one up
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	std::atomic<int> queuedJobs; // Pushed but not popped or stolen yet
+	std::atomic<int> sleepingWorkers;
+
+	// Pops a job off this worker's deque, or steals one. NULL if there's nothing anywhere.
+	sJob* FindJob(sWorker& worker);
+
+	void Execute(sJob* job);
+	void Finish(sJob* job);
+
+	void WorkerLoop(unsigned int workerIndex);
+};
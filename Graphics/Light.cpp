@@ -18,14 +18,6 @@ Light::Light(int index) :
 	state(true)
 {
 	this->lightType = POINT;
-
-	this->positionLocation = 0;
-	this->diffuseLocation = 0;
-	this->specularLocation = 0;
-	this->attenuationLocation = 0;
-	this->directionLocation = 0;
-	this->param1Location = 0;
-	this->param2Location = 0;
 }
 
 Light::~Light()
@@ -36,31 +28,26 @@ Light::~Light()
 void Light::EditPosition(float x, float y, float z, float w)
 {
 	this->position = glm::vec4(x, y, z, w);
-	glUniform4f(this->positionLocation, this->position.x, this->position.y, this->position.z, this->position.w);
 }
 
 void Light::EditDiffuse(float x, float y, float z, float w)
 {
 	this->diffuse = glm::vec4(x, y, z, w);
-	glUniform4f(this->diffuseLocation, this->diffuse.x, this->diffuse.y, this->diffuse.z, this->diffuse.w);
 }
 
 void Light::EditSpecular(float r, float g, float b, float power)
 {
 	this->specular = glm::vec4(r, g, b, power);
-	glUniform4f(this->specularLocation, this->specular.x, this->specular.y, this->specular.z, this->specular.w);
 }
 
 void Light::EditAttenuation(float constant, float linear, float quadratic, float distanceCutOff)
 {
 	this->attenuation = glm::vec4(constant, linear, quadratic, distanceCutOff);
-	glUniform4f(this->attenuationLocation, this->attenuation.x, this->attenuation.y, this->attenuation.z, this->attenuation.w);
 }
 
 void Light::EditDirection(float x, float y, float z, float w)
 {
 	this->direction = glm::vec4(x, y, z, w);
-	glUniform4f(this->directionLocation, this->direction.x, this->direction.y, this->direction.z, this->direction.w);
 }
 
 void Light::EditLightType(LightType lightType, float innerAngle, float outerAngle)
@@ -68,70 +55,99 @@ void Light::EditLightType(LightType lightType, float innerAngle, float outerAngl
 	this->lightType = lightType;
 	this->innerAngle = innerAngle;
 	this->outerAngle = outerAngle;
-	glUniform4f(this->param1Location, (float)this->lightType, this->innerAngle, this->outerAngle, 1.0f);
 }
 
 void Light::EditState(bool on)
 {
 	this->state = on;
-	glUniform4f(this->param2Location, on ? (float) GL_TRUE : (float) GL_FALSE, 1.0f, 1.0f, 1.0f);
 }
 
-void Light::SendToShader()
+sLightUniforms Light::GetUniforms() const
+{
+	sLightUniforms uniforms;
+	uniforms.position = this->position;
+	uniforms.diffuse = this->diffuse;
+	uniforms.specular = this->specular;
+	uniforms.attenuation = this->attenuation;
+	uniforms.direction = this->direction;
+	uniforms.param1 = glm::vec4((float) this->lightType, this->innerAngle, this->outerAngle, 1.0f);
+	uniforms.param2 = glm::vec4(this->state ? (float) GL_TRUE : (float) GL_FALSE, 1.0f, 1.0f, 1.0f);
+	return uniforms;
+}
+
+void Light::SendToShader(const sLightUniforms& uniforms) const
 {	
-	glUniform4f(this->positionLocation, this->position.x, this->position.y, this->position.z, this->position.w);
-	glUniform4f(this->diffuseLocation, this->diffuse.x, this->diffuse.y, this->diffuse.z, this->diffuse.w);
-	glUniform4f(this->specularLocation, this->specular.x, this->specular.y, this->specular.z, this->specular.w);
-	glUniform4f(this->attenuationLocation, this->attenuation.x, this->attenuation.y, this->attenuation.z, this->attenuation.w);
-	glUniform4f(this->directionLocation, this->direction.x, this->direction.y, this->direction.z, this->direction.w);
-	glUniform4f(this->param1Location, (float)this->lightType, this->innerAngle, this->outerAngle, 1.0f);
-
-	if (this->state)
+	for (const sUniformLocations& locations : this->uniformLocations)
 	{
-		glUniform4f(this->param2Location, (float) GL_TRUE, 1.0f, 1.0f, 1.0f);
+		glProgramUniform4fv(locations.programID, locations.positionLocation, 1, &uniforms.position.x);
+		glProgramUniform4fv(locations.programID, locations.diffuseLocation, 1, &uniforms.diffuse.x);
+		glProgramUniform4fv(locations.programID, locations.specularLocation, 1, &uniforms.specular.x);
+		glProgramUniform4fv(locations.programID, locations.attenuationLocation, 1, &uniforms.attenuation.x);
+		glProgramUniform4fv(locations.programID, locations.directionLocation, 1, &uniforms.direction.x);
+		glProgramUniform4fv(locations.programID, locations.param1Location, 1, &uniforms.param1.x);
+		glProgramUniform4fv(locations.programID, locations.param2Location, 1, &uniforms.param2.x);
 	}
-	else
+}
+
+void Light::RemoveUniforms(GLuint shaderID)
+{
+	for (std::vector<sUniformLocations>::iterator it = this->uniformLocations.begin(); it != this->uniformLocations.end(); it++)
 	{
-		glUniform4f(this->param2Location, (float) GL_FALSE, 1.0f, 1.0f, 1.0f);
+		if (it->programID == shaderID)
+		{
+			this->uniformLocations.erase(it);
+			return;
+		}
 	}
 }
 
-void Light::SetupUniforms(const CompiledShader& shader)
+void Light::SetupUniforms(GLuint shaderID)
 {
-	GLuint shaderID = shader.ID;
+	for (const sUniformLocations& locations : this->uniformLocations)
+	{
+		if (locations.programID == shaderID) // Already setup for this program
+		{
+			return;
+		}
+	}
+
+	sUniformLocations locations;
+	locations.programID = shaderID;
 	{
 		std::stringstream ss;
 		ss << "lightArray[" << this->index << "].position";
-		this->positionLocation = glGetUniformLocation(shaderID, ss.str().c_str());
+		locations.positionLocation = glGetUniformLocation(shaderID, ss.str().c_str());
 	}
 	{
 		std::stringstream ss;
 		ss << "lightArray[" << this->index << "].diffuse";
-		this->diffuseLocation = glGetUniformLocation(shaderID, ss.str().c_str());
+		locations.diffuseLocation = glGetUniformLocation(shaderID, ss.str().c_str());
 	}
 	{
 		std::stringstream ss;
 		ss << "lightArray[" << this->index << "].specular";
-		this->specularLocation = glGetUniformLocation(shaderID, ss.str().c_str());
+		locations.specularLocation = glGetUniformLocation(shaderID, ss.str().c_str());
 	}
 	{
 		std::stringstream ss;
 		ss << "lightArray[" << this->index << "].attenuation";
-		this->attenuationLocation = glGetUniformLocation(shaderID, ss.str().c_str());
+		locations.attenuationLocation = glGetUniformLocation(shaderID, ss.str().c_str());
 	}
 	{
 		std::stringstream ss;
 		ss << "lightArray[" << this->index << "].direction";
-		this->directionLocation = glGetUniformLocation(shaderID, ss.str().c_str());
+		locations.directionLocation = glGetUniformLocation(shaderID, ss.str().c_str());
 	}
 	{
 		std::stringstream ss;
 		ss << "lightArray[" << this->index << "].param1";
-		this->param1Location = glGetUniformLocation(shaderID, ss.str().c_str());
+		locations.param1Location = glGetUniformLocation(shaderID, ss.str().c_str());
 	}
 	{
 		std::stringstream ss;
 		ss << "lightArray[" << this->index << "].param2";
-		this->param2Location = glGetUniformLocation(shaderID, ss.str().c_str());
+		locations.param2Location = glGetUniformLocation(shaderID, ss.str().c_str());
 	}
+
+	this->uniformLocations.push_back(locations);
 }
\ No newline at end of file
@@ -6,7 +6,33 @@
 #include <glm/glm.hpp>
 #include <glm/vec3.hpp> 
 #include <glm/vec4.hpp> 
+#include <vector>
 
+// What a light sends to the shader's lightArray, see LightManager::SendLights
+struct sLightUniforms
+{
+	glm::vec4 position;
+	glm::vec4 diffuse;
+	glm::vec4 specular;
+	glm::vec4 attenuation;
+	glm::vec4 direction;
+	glm::vec4 param1; // vec4(lightType, innerAngle, outerAngle, 1)
+	glm::vec4 param2; // vec4(isLightOn, 1, 1, 1)
+
+	inline bool operator==(const sLightUniforms& other) const
+	{
+		return position == other.position && diffuse == other.diffuse && specular == other.specular && attenuation == other.attenuation
+			&& direction == other.direction && param1 == other.param1 && param2 == other.param2;
+	}
+
+	inline bool operator!=(const sLightUniforms& other) const
+	{
+		return !(*this == other);
+	}
+};
+
+// The Edit functions only change the light, they don't touch GL, so the simulation can run on a different thread than
+// the one drawing. The changes reach the shaders with the next LightManager::SendLights.
 class Light
 {
 public:
@@ -38,8 +64,8 @@ public:
 	// Modifies if the light is on or off
 	void EditState(bool on);
 
-	// Will copy this light's information to the shader (WARNING: Make sure you call SetupUniforms() before calling this to ensure that this object's uniform locations are set.)
-	void SendToShader();
+	// What this light looks like to the shader right now
+	sLightUniforms GetUniforms() const;
 
 	inline glm::vec4 GetPosition() const
 	{
@@ -104,14 +130,25 @@ private:
 	float outerAngle;
 	bool state;
 
-	// Uniforms
-	GLuint positionLocation;
-	GLuint diffuseLocation;
-	GLuint specularLocation;
-	GLuint attenuationLocation;
-	GLuint directionLocation;
-	GLuint param1Location; // vec4(lightType, innerAngle, outerAngle, ???)
-	GLuint param2Location; // vec4(isLightOn, ???, ???, ???)
+	// Uniforms (one set per shader program this light is sent to, since every shader variant has its own locations)
+	struct sUniformLocations
+	{
+		GLuint programID;
+		GLuint positionLocation;
+		GLuint diffuseLocation;
+		GLuint specularLocation;
+		GLuint attenuationLocation;
+		GLuint directionLocation;
+		GLuint param1Location; // vec4(lightType, innerAngle, outerAngle, ???)
+		GLuint param2Location; // vec4(isLightOn, ???, ???, ???)
+	};
+	std::vector<sUniformLocations> uniformLocations;
+
+	void SetupUniforms(GLuint shaderID);
+
+	// Copies the uniforms to every shader the light was setup with (see SetupUniforms). GL thread only.
+	void SendToShader(const sLightUniforms& uniforms) const;
 
-	void SetupUniforms(const CompiledShader& shader);
+	// Stops sending this light to a program (e.g. it was deleted by a shader reload)
+	void RemoveUniforms(GLuint shaderID);
 };
\ No newline at end of file
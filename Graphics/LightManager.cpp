@@ -1,11 +1,16 @@
 #include "LightManager.h"
 
 #include <iostream>
+#include <algorithm>
 LightManager* LightManager::instance = NULL;
 
 LightManager::LightManager()
+	: lightIndex(0)
 {
-
+	for (unsigned int i = 0; i < MAX_LIGHTS; i++)
+	{
+		this->lights[i] = NULL;
+	}
 }
 
 LightManager* LightManager::GetInstance()
@@ -28,55 +33,106 @@ Light* LightManager::GetLight(unsigned int index)
 	return this->lights[index];
 }
 
-Light* LightManager::GetLight(std::string lightName)
+Light* LightManager::GetLight(const std::string& lightName)
 {
-	std::map<std::string, Light*>::iterator it = this->friendlyNameToLights.find(lightName);
+	return this->lightSlots.Get(this->GetLightHandle(lightName));
+}
+
+LightHandle LightManager::GetLightHandle(const std::string& lightName)
+{
+	std::map<std::string, LightHandle>::iterator it = this->friendlyNameToLights.find(lightName);
 	if (it != this->friendlyNameToLights.end())
 	{
 		return it->second;
 	}
 
-	return NULL;
+	return LightHandle();
 }
 
-void LightManager::AddLight(const CompiledShader& shader, std::string friendlyName, glm::vec3 position)
+LightHandle LightManager::AddLight(const CompiledShader& shader, const std::string& friendlyName, glm::vec3 position)
 {
 	if (this->lightIndex >= this->MAX_LIGHTS)
 	{
 		std::cout << "The maximum number of lights has been reached. You must increase the MAX_LIGHTS value in LightManager.h AND the fragment shader to inccrease the number of lights." << std::endl;
-		return;
+		return LightHandle();
 	}
 
-	std::map<std::string, Light*>::iterator lightIt = this->friendlyNameToLights.find(friendlyName);
+	std::map<std::string, LightHandle>::iterator lightIt = this->friendlyNameToLights.find(friendlyName);
 	if (lightIt != this->friendlyNameToLights.end())
 	{
 		std::cout << "Friendly name '" << friendlyName << "' already exists in the light map." << std::endl;
-		return;
+		return LightHandle();
 	}
 
 	unsigned int lightIndex = this->lightIndex++;
 	Light* light = new Light(lightIndex);
 	light->position = glm::vec4(position, 1.0f);
 
-	shader.Bind();
-	light->SetupUniforms(shader); // Make sure we setup uniform locations so that we can pass light related info to the GPU
-	light->SendToShader();
+	this->AddShader(shader);
+	for (GLuint shaderID : this->shaderIDs)
+	{
+		light->SetupUniforms(shaderID); // Make sure we setup uniform locations so that we can pass light related info to the GPU
+	}
 
 	this->lights[lightIndex] = light;
-	this->friendlyNameToLights.insert(std::make_pair(friendlyName, light));
+
+	LightHandle handle = this->lightSlots.Add(light);
+	this->friendlyNameToLights.insert(std::make_pair(friendlyName, handle));
+	return handle;
 }
 
-std::vector<Light*> LightManager::GetLights()
+void LightManager::AddShader(const CompiledShader& shader)
 {
-	std::vector<Light*> lights;
+	if (std::find(this->shaderIDs.begin(), this->shaderIDs.end(), shader.ID) != this->shaderIDs.end())
+	{
+		return;
+	}
 
-	for (int i = 0; i < MAX_LIGHTS; i++)
+	this->shaderIDs.push_back(shader.ID);
+
+	// The next SendLights brings the new program up to date with the lights we already have
+	for (unsigned int i = 0; i < this->lightIndex; i++)
 	{
-		if (this->lights[i] != NULL)
+		this->lights[i]->SetupUniforms(shader.ID);
+	}
+	this->sentUniforms.clear();
+}
+
+void LightManager::ReplaceShader(GLuint oldShaderID, const CompiledShader& shader)
+{
+	std::vector<GLuint>::iterator it = std::find(this->shaderIDs.begin(), this->shaderIDs.end(), oldShaderID);
+	if (it != this->shaderIDs.end())
+	{
+		this->shaderIDs.erase(it);
+	}
+
+	for (unsigned int i = 0; i < this->lightIndex; i++)
+	{
+		this->lights[i]->RemoveUniforms(oldShaderID);
+	}
+
+	this->AddShader(shader);
+}
+
+void LightManager::GetLightUniforms(std::vector<sLightUniforms>& uniforms) const
+{
+	uniforms.resize(this->lightIndex);
+	for (unsigned int i = 0; i < this->lightIndex; i++)
+	{
+		uniforms[i] = this->lights[i]->GetUniforms();
+	}
+}
+
+void LightManager::SendLights(const std::vector<sLightUniforms>& uniforms)
+{
+	bool sendAll = this->sentUniforms.size() != uniforms.size();
+	this->sentUniforms.resize(uniforms.size());
+	for (unsigned int i = 0; i < uniforms.size() && i < this->lightIndex; i++)
+	{
+		if (sendAll || uniforms[i] != this->sentUniforms[i])
 		{
-			lights.push_back(this->lights[i]);
+			this->lights[i]->SendToShader(uniforms[i]);
+			this->sentUniforms[i] = uniforms[i];
 		}
 	}
-	
-	return lights;
-}
\ No newline at end of file
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Light.h"
+#include "ResourceHandle.h"
 
 #include <map>
 #include <string>
@@ -12,13 +13,34 @@ class LightManager
 public:
 	static LightManager* GetInstance();
 
-	void AddLight(const CompiledShader& shader, std::string friendlyName, glm::vec3 position);
+	// Load time, on the GL thread
+	LightHandle AddLight(const CompiledShader& shader, const std::string& friendlyName, glm::vec3 position);
+
+	// Makes every light (current and future) also send its uniforms to this shader. Used for shader variants, which each have their own uniform state.
+	// GL thread only, like ReplaceShader.
+	void AddShader(const CompiledShader& shader);
+
+	// Moves the lights over to a shader that was recompiled into a new program
+	void ReplaceShader(GLuint oldShaderID, const CompiledShader& shader);
 
 	Light* GetLight(unsigned int index);
 
-	Light* GetLight(std::string lightName);
+	// Name lookups, meant for load time. Resolve a handle once and use that every frame.
+	Light* GetLight(const std::string& lightName);
+
+	LightHandle GetLightHandle(const std::string& lightName);
+
+	// O(1), returns NULL if the handle isn't valid
+	inline Light* GetLight(LightHandle handle) const
+	{
+		return this->lightSlots.Get(handle);
+	}
+
+	// Every light's uniforms in shader order, a snapshot for the render thread (see RenderThread)
+	void GetLightUniforms(std::vector<sLightUniforms>& uniforms) const;
 
-	std::vector<Light*> GetLights();
+	// Sends the lights whose uniforms changed since the last call to every program. GL thread only.
+	void SendLights(const std::vector<sLightUniforms>& uniforms);
 
 private:
 	LightManager();
@@ -29,5 +51,8 @@ private:
 	unsigned int lightIndex;
 	Light* lights[MAX_LIGHTS];
 
-	std::map<std::string, Light*> friendlyNameToLights;
+	std::map<std::string, LightHandle> friendlyNameToLights;
+	HandleSlots<Light> lightSlots;
+	std::vector<GLuint> shaderIDs; // Programs the lights are sent to
+	std::vector<sLightUniforms> sentUniforms; // What SendLights last sent, cleared when a program needs all of them again
 };
\ No newline at end of file
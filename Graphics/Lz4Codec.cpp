@@ -0,0 +1,215 @@
+#include "Lz4Codec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+static const unsigned int HASH_BITS = 12;
+static const size_t MIN_MATCH = 4;
+static const size_t LAST_LITERALS = 5;		// The format's rules: the last 5 bytes are always literals,
+static const size_t MATCH_FIND_LIMIT = 12;	// and no match starts in the last 12
+static const size_t MAX_OFFSET = 65535;
+
+static inline uint32_t Read32(const unsigned char* bytes)
+{
+	uint32_t value;
+	memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+static inline uint32_t HashSequence(uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Lengths of 15 or more spill into extra bytes after the token, 255 at a time
+static inline unsigned char* WriteExtraLength(unsigned char* output, size_t length)
+{
+	while (length >= 255)
+	{
+		*output++ = 255;
+		length -= 255;
+	}
+	*output++ = (unsigned char) length;
+	return output;
+}
+
+static inline unsigned char* WriteSequence(unsigned char* output, const unsigned char* literals, size_t literalLength, size_t offset, size_t matchLength)
+{
+	unsigned char* token = output++;
+	*token = (unsigned char) (std::min<size_t>(literalLength, 15) << 4);
+	if (literalLength >= 15)
+	{
+		output = WriteExtraLength(output, literalLength - 15);
+	}
+	if (literalLength > 0)
+	{
+		memcpy(output, literals, literalLength);
+		output += literalLength;
+	}
+
+	if (offset == 0) // The last sequence is literals only
+	{
+		return output;
+	}
+
+	matchLength -= MIN_MATCH;
+	*token |= (unsigned char) std::min<size_t>(matchLength, 15);
+	*output++ = (unsigned char) (offset & 0xFF);
+	*output++ = (unsigned char) (offset >> 8);
+	if (matchLength >= 15)
+	{
+		output = WriteExtraLength(output, matchLength - 15);
+	}
+
+	return output;
+}
+
+size_t Lz4Compress(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationCapacity)
+{
+	if (destinationCapacity < Lz4CompressBound(sourceSize))
+	{
+		return 0;
+	}
+
+	const unsigned char* end = source + sourceSize;
+	const unsigned char* anchor = source; // Start of the literals not written yet
+	unsigned char* output = destination;
+
+	if (sourceSize > MATCH_FIND_LIMIT)
+	{
+		uint32_t positions[1 << HASH_BITS]; // Last position each hashed 4 bytes were seen at
+		memset(positions, 0, sizeof(positions));
+
+		const unsigned char* matchLimit = end - LAST_LITERALS;
+		const unsigned char* searchLimit = end - MATCH_FIND_LIMIT;
+		const unsigned char* input = source;
+		unsigned int misses = 0;
+		while (input < searchLimit)
+		{
+			uint32_t sequence = Read32(input);
+			uint32_t hash = HashSequence(sequence);
+			const unsigned char* candidate = source + positions[hash];
+			positions[hash] = (uint32_t) (input - source);
+
+			if (candidate >= input || (size_t) (input - candidate) > MAX_OFFSET || Read32(candidate) != sequence)
+			{
+				input += 1 + (misses++ >> 6); // Skip ahead faster through data that doesn't compress
+				continue;
+			}
+			misses = 0;
+
+			// Grow the match backwards into the pending literals, then forwards as far as it goes
+			while (input > anchor && candidate > source && input[-1] == candidate[-1])
+			{
+				input--;
+				candidate--;
+			}
+
+			const unsigned char* matchEnd = input + MIN_MATCH;
+			const unsigned char* reference = candidate + MIN_MATCH;
+			while (matchEnd < matchLimit && *matchEnd == *reference)
+			{
+				matchEnd++;
+				reference++;
+			}
+
+			output = WriteSequence(output, anchor, (size_t) (input - anchor), (size_t) (input - candidate), (size_t) (matchEnd - input));
+			input = matchEnd;
+			anchor = input;
+		}
+	}
+
+	output = WriteSequence(output, anchor, (size_t) (end - anchor), 0, 0);
+	return (size_t) (output - destination);
+}
+
+// Reads the extra bytes of a length, false if the block ends first
+static inline bool ReadExtraLength(const unsigned char*& input, const unsigned char* inputEnd, size_t& length)
+{
+	unsigned char byte;
+	do
+	{
+		if (input >= inputEnd)
+		{
+			return false;
+		}
+		byte = *input++;
+		length += byte;
+	} while (byte == 255);
+
+	return true;
+}
+
+bool Lz4Decompress(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize)
+{
+	const unsigned char* input = source;
+	const unsigned char* inputEnd = source + sourceSize;
+	unsigned char* output = destination;
+	unsigned char* outputEnd = destination + destinationSize;
+
+	while (input < inputEnd)
+	{
+		unsigned char token = *input++;
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15 && !ReadExtraLength(input, inputEnd, literalLength))
+		{
+			return false;
+		}
+		if (literalLength > (size_t) (inputEnd - input) || literalLength > (size_t) (outputEnd - output))
+		{
+			return false;
+		}
+		if (literalLength > 0)
+		{
+			memcpy(output, input, literalLength);
+			input += literalLength;
+			output += literalLength;
+		}
+
+		if (input == inputEnd) // The last sequence has no match
+		{
+			break;
+		}
+
+		if (inputEnd - input < 2)
+		{
+			return false;
+		}
+		size_t offset = (size_t) input[0] | ((size_t) input[1] << 8);
+		input += 2;
+		if (offset == 0 || offset > (size_t) (output - destination))
+		{
+			return false;
+		}
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !ReadExtraLength(input, inputEnd, matchLength))
+		{
+			return false;
+		}
+		matchLength += MIN_MATCH;
+		if (matchLength > (size_t) (outputEnd - output))
+		{
+			return false;
+		}
+
+		// Matches can overlap what they're writing (offset < length repeats a pattern), so byte by byte unless they can't
+		const unsigned char* match = output - offset;
+		if (offset >= matchLength)
+		{
+			memcpy(output, match, matchLength);
+			output += matchLength;
+		}
+		else
+		{
+			for (size_t i = 0; i < matchLength; i++)
+			{
+				*output++ = *match++;
+			}
+		}
+	}
+
+	return output == outputEnd;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+// The LZ4 block format (lz4/doc/lz4_Block_format.md), the same bytes LZ4_compress_default/LZ4_decompress_safe produce and take.
+// Only blocks, cooked models split their streams into chunks themselves (see ModelCooker.h). Nothing here is shared
+// between calls, so any number of threads can decode at once.
+
+// The most Lz4Compress can write for sourceSize bytes
+inline size_t Lz4CompressBound(size_t sourceSize)
+{
+	return sourceSize + sourceSize / 255 + 16;
+}
+
+// Greedy single pass compression. destinationCapacity has to be at least Lz4CompressBound(sourceSize), returns the compressed size (0 if it isn't).
+size_t Lz4Compress(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationCapacity);
+
+// Returns false unless the block is valid and decodes to exactly destinationSize bytes. Never reads or writes out of bounds.
+bool Lz4Decompress(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize);
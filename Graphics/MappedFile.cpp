@@ -0,0 +1,192 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	this->data = NULL;
+	this->size = 0;
+	this->isOpen = false;
+#ifdef _WIN32
+	this->fileHandle = NULL;
+	this->mappingHandle = NULL;
+#else
+	this->fileDescriptor = -1;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	this->Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: MappedFile()
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		this->Close();
+
+		this->data = other.data;
+		this->size = other.size;
+		this->isOpen = other.isOpen;
+#ifdef _WIN32
+		this->fileHandle = other.fileHandle;
+		this->mappingHandle = other.mappingHandle;
+		other.fileHandle = NULL;
+		other.mappingHandle = NULL;
+#else
+		this->fileDescriptor = other.fileDescriptor;
+		other.fileDescriptor = -1;
+#endif
+		other.data = NULL;
+		other.size = 0;
+		other.isOpen = false;
+	}
+
+	return *this;
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+	this->Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	this->fileHandle = file;
+	this->size = (size_t) fileSize.QuadPart;
+	this->isOpen = true;
+	if (this->size == 0) // Can't map an empty file
+	{
+		return true;
+	}
+
+	this->mappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (this->mappingHandle == NULL)
+	{
+		this->Close();
+		return false;
+	}
+
+	this->data = (const unsigned char*) MapViewOfFile(this->mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (this->data == NULL)
+	{
+		this->Close();
+		return false;
+	}
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+	{
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	this->fileDescriptor = fd;
+	this->size = (size_t) fileStat.st_size;
+	this->isOpen = true;
+	if (this->size == 0) // Can't map an empty file
+	{
+		return true;
+	}
+
+	void* mapping = mmap(NULL, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapping == MAP_FAILED)
+	{
+		this->Close();
+		return false;
+	}
+
+	madvise(mapping, this->size, MADV_SEQUENTIAL); // Loaders read front to back
+	this->data = (const unsigned char*) mapping;
+#endif
+
+	return true;
+}
+
+void MappedFile::Prefetch() const
+{
+	if (!this->data)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+#if _WIN32_WINNT >= 0x0602 // PrefetchVirtualMemory is Windows 8+
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = (PVOID) this->data;
+	range.NumberOfBytes = this->size;
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+	madvise((void*) this->data, this->size, MADV_WILLNEED);
+#endif
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (this->data)
+	{
+		UnmapViewOfFile(this->data);
+	}
+	if (this->mappingHandle)
+	{
+		CloseHandle(this->mappingHandle);
+	}
+	if (this->fileHandle)
+	{
+		CloseHandle(this->fileHandle);
+	}
+	this->fileHandle = NULL;
+	this->mappingHandle = NULL;
+#else
+	if (this->data)
+	{
+		munmap((void*) this->data, this->size);
+	}
+	if (this->fileDescriptor != -1)
+	{
+		close(this->fileDescriptor);
+	}
+	this->fileDescriptor = -1;
+#endif
+
+	this->data = NULL;
+	this->size = 0;
+	this->isOpen = false;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// A read-only file mapped into memory, so loaders can parse straight out of the page cache instead of copying it into a buffer first
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Maps the whole file, returns false if it couldn't be opened. Empty files open fine with no data.
+	bool Open(const std::string& path);
+	void Close();
+
+	// Asks the OS to start reading the whole file in now, in one sequential pass, instead of page by page as it's touched
+	void Prefetch() const;
+
+	inline bool IsOpen() const
+	{
+		return this->isOpen;
+	}
+
+	inline const unsigned char* GetData() const
+	{
+		return this->data;
+	}
+
+	inline size_t GetSize() const
+	{
+		return this->size;
+	}
+
+private:
+	const unsigned char* data;
+	size_t size;
+	bool isOpen;
+
+#ifdef _WIN32
+	void* fileHandle;		// HANDLE, kept as void* so this header doesn't need windows.h
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+};
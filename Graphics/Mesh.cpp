@@ -1,27 +1,242 @@
 #include "Mesh.h"
 #include "Texture.h"
+#include "TextureManager.h"
+#include "ShaderManager.h"
 
-#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
-#include <sstream>
 
-Mesh::Mesh(std::vector<sColoredVertex> vertices, std::vector<sTriangle> faces)
-	: offset(0.0f, 0.0f, 0.0f), orientation(0.0f, 0.0f, 0.0f), textures(textures), colorOverride(1.0f, 1.0f, 1.0f, 1.0f)
+Mesh::Mesh(const sCookedMeshView& cooked)
 {
-	this->vertices = vertices;
-	this->faces = faces;
+	sVertexFormatInfo formatInfo;
+	if (!GetVertexFormatInfo(cooked.vertexFormat, formatInfo) || formatInfo.stride != cooked.vertexStride)
+	{
+		std::cout << "Cooked mesh has an unknown vertex format " << cooked.vertexFormat << ", skipping it" << std::endl;
+		this->Initialize(0, 0, 0, VERTEX_FORMAT_NONE, 0);
+		return;
+	}
+
+	this->Initialize(cooked.vertexCount, cooked.indexCount / 3, cooked.vertexStride, cooked.vertexFormat, formatInfo.attributes);
+	this->indexType = cooked.indexSize == sizeof(unsigned short) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; // The cooker already picked
+	this->indexSize = cooked.indexSize;
+	this->hasBounds = true;
+	this->boundsCenter = cooked.boundsCenter;
+	this->boundsHalfExtent = cooked.boundsHalfExtent;
+	this->packingError = cooked.packingError;
+
+	size_t vertexBytes = cooked.vertexStream.rawSize;
+	size_t indexBytes = cooked.indexStream.rawSize;
+
+	glGenVertexArrays(1, &this->VAO);
+	glBindVertexArray(this->VAO);
+
+	glGenBuffers(1, &this->VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertexBytes, NULL, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &this->EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, NULL, GL_STATIC_DRAW);
+
+	formatInfo.setupAttributes();
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	// Write only and invalidated, so the driver can hand out fresh memory without waiting on or copying anything.
+	// Mapped by name so the element buffer doesn't have to be bound (that would change whatever VAO is bound).
+	if (vertexBytes > 0)
+	{
+		this->mappedVertices = (unsigned char*) glMapNamedBufferRange(this->VBO, 0, vertexBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	}
+	if (indexBytes > 0)
+	{
+		this->mappedIndices = (unsigned char*) glMapNamedBufferRange(this->EBO, 0, indexBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	}
+}
+
+bool Mesh::FinishCookedUpload(const sCookedMeshView& cooked, bool keepCPUData)
+{
+	// A buffer that couldn't be mapped got nothing decoded into it, so it's uploaded below like a lost mapping
+	bool isMappingLost = (cooked.vertexStream.rawSize > 0 && !this->mappedVertices) || (cooked.indexStream.rawSize > 0 && !this->mappedIndices);
+	if (this->mappedVertices)
+	{
+		isMappingLost |= glUnmapNamedBuffer(this->VBO) == GL_FALSE;
+		this->mappedVertices = NULL;
+	}
+	if (this->mappedIndices)
+	{
+		isMappingLost |= glUnmapNamedBuffer(this->EBO) == GL_FALSE;
+		this->mappedIndices = NULL;
+	}
+
+	if (!isMappingLost && !keepCPUData)
+	{
+		return true;
+	}
+
+	std::vector<unsigned char> vertices(cooked.vertexStream.rawSize);
+	std::vector<unsigned char> indices(cooked.indexStream.rawSize);
+	std::vector<sStreamDecode> decodes;
+	decodes.push_back({ &cooked.vertexStream, vertices.data() });
+	decodes.push_back({ &cooked.indexStream, indices.data() });
+	if (!DecodeCookedStreams(decodes))
+	{
+		return false;
+	}
+
+	if (isMappingLost) // Rare (e.g. the display mode changed while it was mapped, or out of address space), the contents are undefined now
+	{
+		glNamedBufferSubData(this->VBO, 0, vertices.size(), vertices.data());
+		glNamedBufferSubData(this->EBO, 0, indices.size(), indices.data());
+	}
 
+	if (keepCPUData)
+	{
+		this->faces.resize(cooked.indexCount / 3);
+		const unsigned short* shortIndices = reinterpret_cast<const unsigned short*>(indices.data());
+		const unsigned int* intIndices = reinterpret_cast<const unsigned int*>(indices.data());
+		for (size_t i = 0; i < this->faces.size(); i++)
+		{
+			for (size_t j = 0; j < 3; j++)
+			{
+				this->faces[i].vertIndex[j] = cooked.indexSize == sizeof(unsigned short) ? shortIndices[i * 3 + j] : intIndices[i * 3 + j];
+			}
+		}
+
+		this->FinishUpload(vertices.data(), vertices.size(), cooked.vertexFormat, true);
+	}
+
+	return true;
+}
+
+void Mesh::Initialize(unsigned int vertexCount, unsigned int faceCount, unsigned int vertexStride, eVertexFormat vertexFormat, unsigned int vertexAttributes)
+{
+	this->cpuVertexFormat = VERTEX_FORMAT_NONE;
+
+	this->VAO = 0;
+	this->VBO = 0;
+	this->EBO = 0;
+	this->mappedVertices = NULL;
+	this->mappedIndices = NULL;
+	this->vertexCount = vertexCount;
+	this->indexCount = (GLsizei) faceCount * 3;
+	this->vertexStride = vertexStride;
+	this->vertexFormat = vertexFormat;
+	this->vertexAttributes = vertexAttributes;
+	this->indexType = GL_UNSIGNED_INT;
+	this->indexSize = sizeof(unsigned int);
+
+	this->isPacked = vertexFormat == VERTEX_FORMAT_PACKED_COLORED;
+	this->hasBounds = false;
+	this->boundsCenter = glm::vec3(0.0f);
+	this->boundsHalfExtent = glm::vec3(1.0f);
+	this->packingError.maxPositionError = 0.0f;
+	this->packingError.maxNormalErrorDegrees = 0.0f;
+	this->packingError.maxColorError = 0.0f;
+
+	this->offset = glm::vec3(0.0f, 0.0f, 0.0f);
+	this->orientation = glm::vec3(0.0f, 0.0f, 0.0f);
 	this->scale = 1.0f;
 	this->isWireframe = false;
 	this->ignoreLighting = false;
 	this->isOverrideColor = false;
+	this->colorOverride = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+}
 
-	this->SetupMesh();
+void Mesh::FinishUpload(const void* vertexData, size_t vertexBytes, eVertexFormat format, bool keepCPUData)
+{
+	if (keepCPUData)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(vertexData);
+		this->cpuVertices.assign(bytes, bytes + vertexBytes);
+		this->cpuVertexFormat = format;
+	}
+	else // The GPU has its own copy now
+	{
+		std::vector<sTriangle>().swap(this->faces);
+	}
+}
+
+Mesh::~Mesh()
+{
+	// Moved-from meshes have 0 here, and glDelete* ignores 0
+	glDeleteVertexArrays(1, &this->VAO);
+	glDeleteBuffers(1, &this->VBO);
+	glDeleteBuffers(1, &this->EBO);
+}
+
+Mesh::Mesh(Mesh&& other) noexcept
+	: cpuVertices(std::move(other.cpuVertices)), cpuVertexFormat(other.cpuVertexFormat), faces(std::move(other.faces)), textures(std::move(other.textures)),
+	VAO(other.VAO), VBO(other.VBO), EBO(other.EBO), mappedVertices(other.mappedVertices), mappedIndices(other.mappedIndices),
+	vertexCount(other.vertexCount), indexCount(other.indexCount), vertexStride(other.vertexStride),
+	vertexFormat(other.vertexFormat), vertexAttributes(other.vertexAttributes), indexType(other.indexType), indexSize(other.indexSize),
+	isPacked(other.isPacked), hasBounds(other.hasBounds), boundsCenter(other.boundsCenter), boundsHalfExtent(other.boundsHalfExtent), packingError(other.packingError),
+	offset(other.offset), orientation(other.orientation), scale(other.scale),
+	isWireframe(other.isWireframe), ignoreLighting(other.ignoreLighting), isOverrideColor(other.isOverrideColor), colorOverride(other.colorOverride)
+{
+	other.VAO = 0;
+	other.VBO = 0;
+	other.EBO = 0;
+	other.mappedVertices = NULL;
+	other.mappedIndices = NULL;
+	other.vertexCount = 0;
+	other.indexCount = 0;
+}
+
+Mesh& Mesh::operator=(Mesh&& other) noexcept
+{
+	if (this != &other)
+	{
+		glDeleteVertexArrays(1, &this->VAO);
+		glDeleteBuffers(1, &this->VBO);
+		glDeleteBuffers(1, &this->EBO);
+
+		this->cpuVertices = std::move(other.cpuVertices);
+		this->cpuVertexFormat = other.cpuVertexFormat;
+		this->faces = std::move(other.faces);
+		this->textures = std::move(other.textures);
+		this->VAO = other.VAO;
+		this->VBO = other.VBO;
+		this->EBO = other.EBO;
+		this->mappedVertices = other.mappedVertices;
+		this->mappedIndices = other.mappedIndices;
+		this->vertexCount = other.vertexCount;
+		this->indexCount = other.indexCount;
+		this->vertexStride = other.vertexStride;
+		this->vertexFormat = other.vertexFormat;
+		this->vertexAttributes = other.vertexAttributes;
+		this->indexType = other.indexType;
+		this->indexSize = other.indexSize;
+		this->isPacked = other.isPacked;
+		this->hasBounds = other.hasBounds;
+		this->boundsCenter = other.boundsCenter;
+		this->boundsHalfExtent = other.boundsHalfExtent;
+		this->packingError = other.packingError;
+		this->offset = other.offset;
+		this->orientation = other.orientation;
+		this->scale = other.scale;
+		this->isWireframe = other.isWireframe;
+		this->ignoreLighting = other.ignoreLighting;
+		this->isOverrideColor = other.isOverrideColor;
+		this->colorOverride = other.colorOverride;
+
+		other.VAO = 0;
+		other.VBO = 0;
+		other.EBO = 0;
+		other.mappedVertices = NULL;
+		other.mappedIndices = NULL;
+		other.vertexCount = 0;
+		other.indexCount = 0;
+	}
+
+	return *this;
 }
 
-void Mesh::Draw(const CompiledShader& shader, const glm::vec3& position, const glm::vec3& xRot, const glm::vec3& yRot, const glm::vec3& zRot, const glm::vec3& scale, float transparency)
+void Mesh::BuildTransform(const glm::vec3& position, const glm::vec3& xRot, const glm::vec3& yRot, const glm::vec3& zRot, const glm::vec3& scale, glm::mat4& matModel, glm::mat4& matInvTransposeModel) const
 {
-	glm::mat4 matModel = glm::mat4(1.0f);
+	matModel = glm::mat4(1.0f);
 
 	glm::vec3 meshPosition = position + this->offset;
 	glm::mat4 matTranslate = glm::translate(glm::mat4(1.0f), meshPosition); // Translation matrix
@@ -32,89 +247,72 @@ void Mesh::Draw(const CompiledShader& shader, const glm::vec3& position, const g
 	matModel[1] = glm::vec4(yRot.x, yRot.y, yRot.z, 0.0f) * scale.y; // Y axis rotation
 	matModel[2] = glm::vec4(zRot.x, zRot.y, zRot.z, 0.0f) * scale.z; // Z axis rotation
 
-	glm::mat4 matInvTransposeModel = glm::inverse(glm::transpose(matModel));
-
-	glUseProgram(shader.ID);
-
-	glUniformMatrix4fv(glGetUniformLocation(shader.ID, "matModel"), 1, GL_FALSE, glm::value_ptr(matModel)); // Tell shader the model matrix (AKA: Position orientation and scale)
-	glUniformMatrix4fv(glGetUniformLocation(shader.ID, "matModelInverseTranspose"), 1, GL_FALSE, glm::value_ptr(matInvTransposeModel));
-
-	glUniform1f(glGetUniformLocation(shader.ID, "uTransparency"), transparency);
+	matInvTransposeModel = glm::inverse(glm::transpose(matModel));
 
-	if (this->isOverrideColor)
+	// Packed positions are in [-1, 1] of the mesh bounds. Scaling them back up is folded into the model matrix, the normals
+	// keep using the inverse transpose of the real model matrix so the bounds scale doesn't skew them.
+	if (this->isPacked)
 	{
-		glUniform1f(glGetUniformLocation(shader.ID, "isOverrideColor"), (float) GL_TRUE);
-		glUniform4f(glGetUniformLocation(shader.ID, "colorOverride"), this->colorOverride.r, this->colorOverride.b, this->colorOverride.g, this->colorOverride.a);
+		matModel = glm::translate(matModel, this->boundsCenter);
+		matModel = glm::scale(matModel, this->boundsHalfExtent);
 	}
-	else
+}
+
+bool Mesh::GetWorldBounds(const glm::mat4& matModel, glm::vec3& center, glm::vec3& halfExtent) const
+{
+	if (!this->hasBounds)
 	{
-		glUniform1f(glGetUniformLocation(shader.ID, "isOverrideColor"), (float) GL_FALSE);
+		return false;
 	}
 
-	glUniform1f(glGetUniformLocation(shader.ID, "isIgnoreLighting"), this->ignoreLighting ? (float)GL_TRUE : (float)GL_FALSE);
+	// Packed meshes already have the bounds folded into matModel (see BuildTransform), so theirs are the [-1, 1] cube
+	glm::vec3 localCenter = this->isPacked ? glm::vec3(0.0f) : this->boundsCenter;
+	glm::vec3 localHalfExtent = this->isPacked ? glm::vec3(1.0f) : this->boundsHalfExtent;
+
+	center = glm::vec3(matModel * glm::vec4(localCenter, 1.0f));
+	halfExtent = glm::abs(glm::vec3(matModel[0])) * localHalfExtent.x + glm::abs(glm::vec3(matModel[1])) * localHalfExtent.y + glm::abs(glm::vec3(matModel[2])) * localHalfExtent.z;
+	return true;
+}
 
-	if (this->isWireframe)
+unsigned int Mesh::GetVariantFlags(float transparency) const
+{
+	// Pick the program specialized for this mesh, so the shader doesn't branch on uniforms for every fragment
+	unsigned int variantFlags = ShaderManager::VARIANT_DEFAULT;
+	if (this->ignoreLighting)
 	{
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		variantFlags |= ShaderManager::VARIANT_UNLIT;
 	}
-	else
+	if (this->isOverrideColor)
 	{
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		variantFlags |= ShaderManager::VARIANT_OVERRIDE_COLOR;
 	}
-
-	// Draw the mesh
-	glBindVertexArray(this->VAO);
-	glDrawElements(GL_TRIANGLES, this->faces.size() * 3, GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
-
-	// Unbind textures
-	for (unsigned int i = 0; i < this->textures.size(); i++)
+	if (transparency >= 1.0f)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		variantFlags |= ShaderManager::VARIANT_OPAQUE;
 	}
+
+	return variantFlags;
 }
 
-void Mesh::SetupMesh()
+void Mesh::RecordDraw(CommandList& list, const glm::mat4& matModel, const glm::mat4& matInvTransposeModel, float transparency, unsigned int order) const
 {
-	// Generate IDs for our VAO, VBO and EBO
-	glGenVertexArrays(1, &this->VAO);
-	glBindVertexArray(this->VAO);
-
-	// Tell open GL where to look for for vertex data
-	glGenBuffers(1, &this->VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-	glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(sColoredVertex), (GLvoid*)&this->vertices[0], GL_STATIC_DRAW);
-
-	// Tell open GL where our index buffer begins (AKA: where to look for faces)
-	glGenBuffers(1, &this->EBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->faces.size() * sizeof(sTriangle), (GLvoid*)&this->faces[0], GL_STATIC_DRAW);
-
-	// Now ANY state that is related to vertex or index buffer
-	//	and vertex attribute layout, is stored in the 'state' 
-	//	of the VAO... 
-
-	// Set the vertex attributes for this shader
-	// Layout information can be found in the vertex shader, currently:
-	// 0 = position
-	// 1 = normals
-	// 2 = color
-	glEnableVertexAttribArray(0);	    // position
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(sColoredVertex), (GLvoid*) offsetof(sColoredVertex, x));
-
-	glEnableVertexAttribArray(1);	    // normal
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(sColoredVertex), (GLvoid*) offsetof(sColoredVertex, nx));
-
-	glEnableVertexAttribArray(2);	    // color
-	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(sColoredVertex), (GLvoid*) offsetof(sColoredVertex, r));
+	unsigned int variantFlags = this->GetVariantFlags(transparency);
+	list.BindProgram(variantFlags);
+	list.SetPolygonMode(this->isWireframe);
+	GLuint firstTexture = 0;
+	const TextureManager* textureManager = TextureManager::GetInstance();
+	for (TextureHandle handle : this->textures)
+	{
+		const Texture* texture = textureManager->GetTexture(handle);
+		if (!texture)
+		{
+			continue;
+		}
 
-	// Now that all the parts are set up, unbind buffers
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		firstTexture = firstTexture == 0 ? texture->GetID() : firstTexture;
+		list.BindTexture(texture->GetID(), texture->GetType() == "texture_specular" ? SAMPLER_SPECULAR : SAMPLER_DIFFUSE);
+	}
+	list.SetDrawData(matModel, matInvTransposeModel, transparency, this->colorOverride);
 
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
-	glDisableVertexAttribArray(2);
-}
\ No newline at end of file
+	list.Draw(MakeSortKey(transparency < 1.0f, variantFlags, firstTexture, this->VAO, order), this->VAO, this->indexCount, this->indexType, this->vertexAttributes);
+}
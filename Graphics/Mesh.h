@@ -1,23 +1,108 @@
 #pragma once
 
 #include "VertexInformation.h"
-#include "CompiledShader.h"
+#include "VertexLayout.h"
+#include "ModelCooker.h"
+#include "CommandList.h"
+#include "ResourceHandle.h"
 
 #include <vector>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
 
 class Texture;
 class Mesh 
 {
+public:
+	// Creates and maps the buffers for a cooked mesh (see ModelCooker.h). Its streams get decoded straight into the mappings
+	// (see DecodeCookedStreams), then FinishCookedUpload unmaps them. Only the model loading code in ModelManager does this.
+	explicit Mesh(const sCookedMeshView& cooked);
+	~Mesh();
+
+	// Meshes own GL buffers, so they can be moved but never copied
+	Mesh(Mesh&& other) noexcept;
+	Mesh& operator=(Mesh&& other) noexcept;
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+
+	// Bytes the geometry takes on the GPU, and how much of it is still held on the CPU
+	inline size_t GetGPUBytes() const
+	{
+		return this->vertexCount * this->vertexStride + this->indexCount * this->indexSize;
+	}
+
+	inline size_t GetCPUBytes() const
+	{
+		return this->cpuVertices.capacity() + this->faces.capacity() * sizeof(sTriangle);
+	}
+
+	// Layout of the vertices on the GPU
+	inline eVertexFormat GetVertexFormat() const
+	{
+		return this->vertexFormat;
+	}
+
+	// The vertices kept on the CPU, NULL if they weren't kept or aren't TVertex (packed meshes keep the sPackedColoredVertex)
+	template <class TVertex>
+	inline const TVertex* GetCPUVertices() const
+	{
+		if (this->cpuVertices.empty() || this->cpuVertexFormat != VertexLayout<TVertex>::format)
+		{
+			return NULL;
+		}
+
+		return reinterpret_cast<const TVertex*>(this->cpuVertices.data());
+	}
+
+	inline bool IsPacked() const
+	{
+		return this->isPacked;
+	}
+
+	inline const sPackingError& GetPackingError() const
+	{
+		return this->packingError;
+	}
+
+	inline bool HasShortIndices() const
+	{
+		return this->indexType == GL_UNSIGNED_SHORT;
+	}
+
+	inline glm::vec3 GetBoundsHalfExtent() const
+	{
+		return this->boundsHalfExtent;
+	}
+
 private:
 	friend class ModelManager;
 	friend class Model;
-	std::vector<sColoredVertex> vertices;
+	friend class RenderQueue;
+	friend class EntityRegistry;
+	std::vector<unsigned char> cpuVertices; // Only kept after upload if the model asked for it (e.g. for picking), see GetCPUVertices
+	eVertexFormat cpuVertexFormat;
 	std::vector<sTriangle> faces;
-	std::vector<Texture*> textures;
+	std::vector<TextureHandle> textures; // Resolved through TextureManager every draw, ones that were removed are skipped
 
 	GLuint VAO, VBO, EBO;
+	unsigned char* mappedVertices; // Only between the cooked mesh constructor and FinishCookedUpload
+	unsigned char* mappedIndices;
+	unsigned int vertexCount;
+	GLsizei indexCount;
+	unsigned int vertexStride;
+	eVertexFormat vertexFormat;
+	unsigned int vertexAttributes; // eVertexAttributeBits
+	GLenum indexType; // GL_UNSIGNED_SHORT when every index fits, GL_UNSIGNED_INT otherwise
+	unsigned int indexSize;
+
+	// Packed positions are stored relative to the bounds, BuildTransform folds this back into the model matrix.
+	// Every cooked mesh has its bounds, hasBounds is only false for ones made from vertices directly.
+	bool isPacked;
+	bool hasBounds;
+	glm::vec3 boundsCenter;
+	glm::vec3 boundsHalfExtent;
+	sPackingError packingError;
 
 	glm::vec3 offset;
 	glm::vec3 orientation;
@@ -29,10 +114,27 @@ private:
 
 	glm::vec4 colorOverride;
 
-	Mesh(std::vector<sColoredVertex> vertices, std::vector<sTriangle> faces);
+	// Shared by the constructors, sets everything to its default
+	void Initialize(unsigned int vertexCount, unsigned int faceCount, unsigned int vertexStride, eVertexFormat vertexFormat, unsigned int vertexAttributes);
+
+	// Keeps a copy of the vertices if asked to, otherwise frees the faces since the GPU has its own copy now
+	void FinishUpload(const void* vertexData, size_t vertexBytes, eVertexFormat format, bool keepCPUData);
+
+	// Unmaps the buffers once the cooked streams are decoded into them. The streams get decoded again on this thread and
+	// uploaded with glNamedBufferSubData if a buffer couldn't be mapped or the driver lost the mapping, or for the CPU copy
+	// if keepCPUData is set. Returns false if they're corrupt.
+	bool FinishCookedUpload(const sCookedMeshView& cooked, bool keepCPUData);
+
+	// The model matrices for drawing the mesh there. Doesn't touch GL, so RenderQueue does it on the job system.
+	void BuildTransform(const glm::vec3& position, const glm::vec3& xRot, const glm::vec3& yRot, const glm::vec3& zRot, const glm::vec3& scale, glm::mat4& matModel, glm::mat4& matInvTransposeModel) const;
+
+	// Records the mesh's draw with those matrices into a command list (see RenderQueue). order is where the draw is in
+	// the frame, transparent draws are played back in that order.
+	void RecordDraw(CommandList& list, const glm::mat4& matModel, const glm::mat4& matInvTransposeModel, float transparency, unsigned int order) const;
 
-	void SetupMesh();
+	// ShaderManager::eShaderVariant flags of the program this mesh is drawn with
+	unsigned int GetVariantFlags(float transparency) const;
 
-	// Draws this mesh to the screen
-	void Draw(const CompiledShader& shader, const glm::vec3& position, const glm::vec3& xRot, const glm::vec3& yRot, const glm::vec3& zRot, const glm::vec3& scale, float transparency);
+	// World space box around the mesh drawn with matModel (from BuildTransform). False if the mesh doesn't know its bounds.
+	bool GetWorldBounds(const glm::mat4& matModel, glm::vec3& center, glm::vec3& halfExtent) const;
 };
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+unsigned int CountCacheMisses(const std::vector<sTriangle>& faces, unsigned int vertexCount, unsigned int cacheSize)
+{
+	// A vertex is still in the FIFO if fewer than cacheSize vertices were added to it since it was
+	std::vector<unsigned int> addedAt(vertexCount, 0);
+	unsigned int time = cacheSize + 1;
+	unsigned int misses = 0;
+
+	for (const sTriangle& face : faces)
+	{
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			unsigned int vertex = face.vertIndex[i];
+			if (time - addedAt[vertex] > cacheSize)
+			{
+				addedAt[vertex] = time++;
+				misses++;
+			}
+		}
+	}
+
+	return misses;
+}
+
+bool CountIndexBufferCacheMisses(const unsigned char* indices, unsigned int indexSize, unsigned int indexCount, unsigned int vertexCount, unsigned int& misses, unsigned int cacheSize)
+{
+	std::vector<unsigned int> addedAt(vertexCount, 0);
+	unsigned int time = cacheSize + 1;
+	misses = 0;
+
+	for (unsigned int i = 0; i < indexCount; i++)
+	{
+		unsigned int vertex;
+		if (indexSize == sizeof(unsigned short))
+		{
+			unsigned short shortIndex;
+			memcpy(&shortIndex, indices + i * sizeof(shortIndex), sizeof(shortIndex));
+			vertex = shortIndex;
+		}
+		else
+		{
+			memcpy(&vertex, indices + i * sizeof(vertex), sizeof(vertex));
+		}
+
+		if (vertex >= vertexCount)
+		{
+			return false;
+		}
+		if (time - addedAt[vertex] > cacheSize)
+		{
+			addedAt[vertex] = time++;
+			misses++;
+		}
+	}
+
+	return true;
+}
+
+// Forsyth's scoring, see "Linear-Speed Vertex Cache Optimisation". The LRU cache it models is bigger than the
+// real one on purpose, it only decides the order.
+static const int FORSYTH_CACHE_SIZE = 32;
+
+static float ForsythVertexScore(int cachePosition, unsigned int remainingTriangles)
+{
+	if (remainingTriangles == 0) // Nothing left to draw with this vertex
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		if (cachePosition < 3) // Used by the last triangle, a fixed score so it doesn't just keep fanning around one vertex
+		{
+			score = 0.75f;
+		}
+		else
+		{
+			float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+			score = std::pow(1.0f - (cachePosition - 3) * scaler, 1.5f);
+		}
+	}
+
+	// Vertices with few triangles left get a boost, so we finish them off instead of leaving lone triangles for later
+	score += 2.0f / std::sqrt((float) remainingTriangles);
+	return score;
+}
+
+void OptimizeVertexCache(std::vector<sTriangle>& faces, unsigned int vertexCount)
+{
+	size_t triangleCount = faces.size();
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// Which triangles use each vertex, the first remainingTriangles[v] of a vertex's list are the ones not drawn yet
+	std::vector<unsigned int> remainingTriangles(vertexCount, 0);
+	for (const sTriangle& face : faces)
+	{
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			remainingTriangles[face.vertIndex[i]]++;
+		}
+	}
+
+	std::vector<unsigned int> triangleOffsets(vertexCount + 1, 0);
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		triangleOffsets[v + 1] = triangleOffsets[v] + remainingTriangles[v];
+	}
+
+	std::vector<unsigned int> vertexTriangles(triangleCount * 3);
+	std::vector<unsigned int> fillPosition(triangleOffsets.begin(), triangleOffsets.end() - 1);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			vertexTriangles[fillPosition[faces[t].vertIndex[i]]++] = (unsigned int) t;
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		vertexScore[v] = ForsythVertexScore(-1, remainingTriangles[v]);
+	}
+
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> triangleAdded(triangleCount, false);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		triangleScore[t] = vertexScore[faces[t].vertIndex[0]] + vertexScore[faces[t].vertIndex[1]] + vertexScore[faces[t].vertIndex[2]];
+	}
+
+	std::vector<sTriangle> optimizedFaces;
+	optimizedFaces.reserve(triangleCount);
+
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> newCache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+	// Rescores a vertex and passes the difference on to the triangles it still has to draw
+	auto updateVertexScore = [&](unsigned int vertex)
+	{
+		float score = ForsythVertexScore(cachePosition[vertex], remainingTriangles[vertex]);
+		float delta = score - vertexScore[vertex];
+		vertexScore[vertex] = score;
+
+		for (unsigned int i = 0; i < remainingTriangles[vertex]; i++)
+		{
+			triangleScore[vertexTriangles[triangleOffsets[vertex] + i]] += delta;
+		}
+	};
+
+	size_t scanPosition = 0;
+	long long bestTriangle = 0; // The first triangle is as good as any to start with
+	while (optimizedFaces.size() < triangleCount)
+	{
+		if (bestTriangle < 0)
+		{
+			// Nothing in the cache has triangles left. Forsyth takes the next one in the original order, searching
+			// for the best score here would make the whole thing quadratic.
+			while (triangleAdded[scanPosition])
+			{
+				scanPosition++;
+			}
+			bestTriangle = (long long) scanPosition;
+		}
+
+		const sTriangle face = faces[(size_t) bestTriangle];
+		triangleAdded[(size_t) bestTriangle] = true;
+		optimizedFaces.push_back(face);
+
+		// Take it out of its vertices' remaining triangles
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			unsigned int vertex = face.vertIndex[i];
+			unsigned int* triangles = &vertexTriangles[triangleOffsets[vertex]];
+			for (unsigned int j = 0; j < remainingTriangles[vertex]; j++)
+			{
+				if (triangles[j] == (unsigned int) bestTriangle)
+				{
+					triangles[j] = triangles[remainingTriangles[vertex] - 1];
+					remainingTriangles[vertex]--;
+					break;
+				}
+			}
+		}
+
+		// Its vertices go to the front of the LRU cache, everything else moves back
+		newCache.clear();
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			if (std::find(newCache.begin(), newCache.end(), face.vertIndex[i]) == newCache.end()) // Degenerate triangles repeat vertices
+			{
+				newCache.push_back(face.vertIndex[i]);
+			}
+		}
+		for (unsigned int vertex : cache)
+		{
+			if (vertex != face.vertIndex[0] && vertex != face.vertIndex[1] && vertex != face.vertIndex[2])
+			{
+				newCache.push_back(vertex);
+			}
+		}
+
+		for (size_t i = FORSYTH_CACHE_SIZE; i < newCache.size(); i++) // Fell out of the cache
+		{
+			cachePosition[newCache[i]] = -1;
+			updateVertexScore(newCache[i]);
+		}
+		if (newCache.size() > FORSYTH_CACHE_SIZE)
+		{
+			newCache.resize(FORSYTH_CACHE_SIZE);
+		}
+		cache.swap(newCache);
+
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			cachePosition[cache[i]] = (int) i;
+			updateVertexScore(cache[i]);
+		}
+
+		// The next triangle is the best one that touches the cache
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (unsigned int vertex : cache)
+		{
+			for (unsigned int i = 0; i < remainingTriangles[vertex]; i++)
+			{
+				unsigned int triangle = vertexTriangles[triangleOffsets[vertex] + i];
+				if (triangleScore[triangle] > bestScore)
+				{
+					bestScore = triangleScore[triangle];
+					bestTriangle = triangle;
+				}
+			}
+		}
+	}
+
+	faces.swap(optimizedFaces);
+}
+
+void OptimizeVertexFetch(std::vector<sTriangle>& faces, unsigned int vertexCount, std::vector<unsigned int>& remap)
+{
+	remap.assign(vertexCount, UINT_MAX);
+	unsigned int nextVertex = 0;
+
+	for (sTriangle& face : faces)
+	{
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			unsigned int& vertex = face.vertIndex[i];
+			if (remap[vertex] == UINT_MAX)
+			{
+				remap[vertex] = nextVertex++;
+			}
+
+			vertex = remap[vertex];
+		}
+	}
+
+	// Vertices no face uses go at the end, so the vertex count doesn't change
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] == UINT_MAX)
+		{
+			remap[v] = nextVertex++;
+		}
+	}
+}
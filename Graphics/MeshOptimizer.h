@@ -0,0 +1,38 @@
+#pragma once
+
+#include "VertexInformation.h"
+
+#include <vector>
+
+// Import time reordering of mesh data so the GPU does less work drawing it.
+// None of this changes what the mesh looks like, only the order triangles and vertices are stored in.
+
+// Size of the post-transform cache CountCacheMisses simulates. Real hardware varies, 16 entry FIFO is the usual yardstick.
+const unsigned int VERTEX_CACHE_SIZE = 16;
+
+// How many vertices a FIFO post-transform cache of cacheSize entries would have to transform to draw the faces in order.
+// Divide by the triangle count for the ACMR (average cache miss ratio, 0.5 is the best possible, 3 is no reuse at all).
+unsigned int CountCacheMisses(const std::vector<sTriangle>& faces, unsigned int vertexCount, unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// Same for indices that are already a GPU index buffer (16 or 32 bit), e.g. straight out of a file.
+// Returns false if any of them is vertexCount or more, which a loader has to catch before uploading them.
+bool CountIndexBufferCacheMisses(const unsigned char* indices, unsigned int indexSize, unsigned int indexCount, unsigned int vertexCount, unsigned int& misses, unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// Reorders the triangles so vertices get reused while they're still in the post-transform cache (Tom Forsyth's linear-speed algorithm)
+void OptimizeVertexCache(std::vector<sTriangle>& faces, unsigned int vertexCount);
+
+// Renumbers the vertices in the order the faces first use them, so vertex fetches walk the buffer front to back.
+// Fills remap with the new index of every old vertex, apply it to the vertices with RemapVertices.
+void OptimizeVertexFetch(std::vector<sTriangle>& faces, unsigned int vertexCount, std::vector<unsigned int>& remap);
+
+template <class TVertex>
+void RemapVertices(std::vector<TVertex>& vertices, const std::vector<unsigned int>& remap)
+{
+	std::vector<TVertex> remapped(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		remapped[remap[i]] = vertices[i];
+	}
+
+	vertices.swap(remapped);
+}
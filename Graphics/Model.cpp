@@ -10,16 +10,53 @@
 #include <assimp/postprocess.h> // Post processing flags
 
 Model::Model()
+	: colorOverride(1.0f, 1.0f, 1.0f, 1.0f)
 {
 	this->isWireframe = false;
+	this->ignoreLighting = false;
+	this->isOverrideColor = false;
+	this->keepCPUData = false;
+	this->packVertices = false;
+	this->triangleCount = 0;
+	this->cacheMissesBefore = 0;
+	this->cacheMissesAfter = 0;
 }
 
-void Model::Draw(const CompiledShader& shader, const glm::vec3& position, const glm::vec3& xRot, const glm::vec3& yRot, const glm::vec3& zRot, const glm::vec3& scale, float transparency)
+Model::~Model()
 {
-	for (unsigned int i = 0; i < this->meshes.size(); i++)
+
+}
+
+bool Model::HasCPUData() const
+{
+	return this->keepCPUData;
+}
+
+bool Model::HasPackedVertices() const
+{
+	return this->packVertices;
+}
+
+size_t Model::GetGPUBytes() const
+{
+	size_t bytes = 0;
+	for (const Mesh& mesh : this->meshes)
+	{
+		bytes += mesh.GetGPUBytes();
+	}
+
+	return bytes;
+}
+
+size_t Model::GetCPUBytes() const
+{
+	size_t bytes = 0;
+	for (const Mesh& mesh : this->meshes)
 	{
-		this->meshes[i].Draw(shader, position, xRot, yRot, zRot, scale, transparency);
+		bytes += mesh.GetCPUBytes();
 	}
+
+	return bytes;
 }
 
 std::string Model::GetFullPath() const
@@ -1,6 +1,5 @@
 #pragma once
 
-#include "CompiledShader.h"
 
 #include <string>
 #include <vector>
@@ -20,11 +19,34 @@ public:
 	void SetIgnoreLighting(bool ignoreLighting);
 	void SetIsOverrideColor(bool isOverride);
 	void SetColorOverride(glm::vec4 colorOverride);
+
+	// True if the meshes kept their vertices/faces on the CPU after uploading them (see ModelManager::LoadModel)
+	bool HasCPUData() const;
+
+	// True if the untextured meshes were uploaded as sPackedColoredVertex
+	bool HasPackedVertices() const;
+
+	size_t GetGPUBytes() const;
+	size_t GetCPUBytes() const;
+
+	// Models own their meshes (and their GL buffers), so they can't be copied
+	Model(const Model&) = delete;
+	Model& operator=(const Model&) = delete;
+	~Model();
 private:
 	friend class ModelManager;
+	friend class RenderQueue;
+	friend class EntityRegistry;
 	std::vector<Mesh> meshes; // Holds meshes that are part of this model
 	std::string directory;
 	std::string fileName;
+	bool keepCPUData;
+	bool packVertices;
+
+	// Post-transform cache misses of all the meshes, in the file's triangle order and after optimizing it
+	unsigned int triangleCount;
+	unsigned int cacheMissesBefore;
+	unsigned int cacheMissesAfter;
 
 	bool isWireframe;
 	bool ignoreLighting;
@@ -32,7 +54,4 @@ private:
 	glm::vec4 colorOverride;
 
 	Model();
-
-	// Draw this model
-	void Draw(const CompiledShader& shader, const glm::vec3& position, const glm::vec3& xRot, const glm::vec3& yRot, const glm::vec3& zRot, const glm::vec3& scale, float transparency);
 };
\ No newline at end of file
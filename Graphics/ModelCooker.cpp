@@ -0,0 +1,1124 @@
+#include "ModelCooker.h"
+#include "GlbLoader.h"
+#include "JobSystem.h"
+#include "Lz4Codec.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "PlyLoader.h"
+#include "VirtualFileSystem.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <atomic>
+
+#include <glm/glm.hpp>
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h> // Post processing flags
+
+static const char COOKED_MODEL_MAGIC[4] = { 'C', 'M', 'D', 'L' };
+static const size_t COOKED_DATA_ALIGNMENT = 16;
+
+// Chunks a decode job takes at a time, each is up to COOKED_CHUNK_SIZE of LZ4
+static const unsigned int DECODE_BATCH_SIZE = 1;
+
+// Where a thread decodes chunks before copying them out, kept between decodes so it's only allocated once per thread
+static thread_local std::vector<unsigned char> tDecodeScratch;
+
+struct sCookedModelHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t cookFlags;
+	uint32_t meshCount;
+};
+
+struct sCookedStreamHeader
+{
+	uint64_t dataOffset;		// From the start of the blob
+	uint64_t storedSize;
+	uint64_t rawSize;
+	uint64_t chunkTableOffset;	// chunkCount uint32_t stored sizes
+	uint32_t encoding;			// eCookedEncoding
+	uint32_t elementSize;
+	uint32_t chunkRawSize;
+	uint32_t chunkCount;
+};
+
+struct sCookedMeshHeader
+{
+	uint32_t vertexFormat;		// eVertexFormat
+	uint32_t vertexStride;
+	uint32_t vertexCount;
+	uint32_t indexSize;
+	uint32_t indexCount;
+	float boundsCenter[3];
+	float boundsHalfExtent[3];
+	float packingError[3];		// Position, normal (degrees), color
+	uint32_t cacheMissesBefore;
+	uint32_t cacheMissesAfter;
+	uint32_t textureCount;
+	uint32_t reserved;
+	sCookedStreamHeader vertexStream;
+	sCookedStreamHeader indexStream;
+};
+
+// Our own assets are all PLY, those go through LoadPly instead of assimp. So do vendor GLB files, through LoadGlb.
+static bool HasExtension(const std::string& path, const char* extension)
+{
+	size_t length = strlen(extension);
+	if (path.length() < length)
+	{
+		return false;
+	}
+
+	std::string pathExtension = path.substr(path.length() - length);
+	std::transform(pathExtension.begin(), pathExtension.end(), pathExtension.begin(), ::tolower);
+	return pathExtension == extension;
+}
+
+static size_t GetChunkRawSize(unsigned int elementSize)
+{
+	return std::max<size_t>(1, COOKED_CHUNK_SIZE / elementSize) * elementSize;
+}
+
+static sCookedStreamView GetRawStreamView(const unsigned char* data, size_t size, unsigned int elementSize)
+{
+	sCookedStreamView stream;
+	stream.data = data;
+	stream.storedSize = size;
+	stream.rawSize = size;
+	stream.encoding = COOKED_ENCODING_RAW;
+	stream.elementSize = std::max(1u, elementSize);
+	stream.chunkRawSize = GetChunkRawSize(stream.elementSize);
+	stream.chunkCount = (unsigned int) ((stream.rawSize + stream.chunkRawSize - 1) / stream.chunkRawSize);
+	stream.chunkSizes = NULL;
+	stream.indexLimit = 0;
+	return stream;
+}
+
+// Reorders the triangles for the post-transform cache, then the vertices for fetch locality
+template <class TVertex>
+static void OptimizeMeshOrder(std::vector<TVertex>& vertices, std::vector<sTriangle>& faces, sCookedMesh& mesh)
+{
+	unsigned int vertexCount = (unsigned int) vertices.size();
+	mesh.cacheMissesBefore = CountCacheMisses(faces, vertexCount);
+
+	OptimizeVertexCache(faces, vertexCount);
+
+	std::vector<unsigned int> remap;
+	OptimizeVertexFetch(faces, vertexCount, remap);
+	RemapVertices(vertices, remap);
+
+	mesh.cacheMissesAfter = CountCacheMisses(faces, vertexCount);
+}
+
+template <class TVertex>
+static void SetCookedVertices(const std::vector<TVertex>& vertices, sCookedMesh& mesh)
+{
+	mesh.vertexFormat = VertexLayout<TVertex>::format;
+	mesh.vertexStride = sizeof(TVertex);
+	mesh.vertexCount = (unsigned int) vertices.size();
+
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(vertices.data());
+	mesh.vertices.assign(bytes, bytes + vertices.size() * sizeof(TVertex));
+}
+
+// 16 bit indices when every vertex fits, which halves the index buffer
+static void SetCookedIndices(const std::vector<sTriangle>& faces, sCookedMesh& mesh)
+{
+	mesh.indexCount = (unsigned int) faces.size() * 3;
+	if (mesh.vertexCount <= 65536)
+	{
+		mesh.indexSize = sizeof(unsigned short);
+		mesh.indices.resize(mesh.indexCount * sizeof(unsigned short));
+		unsigned short* indices = reinterpret_cast<unsigned short*>(mesh.indices.data());
+		for (size_t i = 0; i < faces.size(); i++)
+		{
+			indices[i * 3 + 0] = (unsigned short) faces[i].vertIndex[0];
+			indices[i * 3 + 1] = (unsigned short) faces[i].vertIndex[1];
+			indices[i * 3 + 2] = (unsigned short) faces[i].vertIndex[2];
+		}
+	}
+	else
+	{
+		mesh.indexSize = sizeof(unsigned int);
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(faces.data());
+		mesh.indices.assign(bytes, bytes + faces.size() * sizeof(sTriangle));
+	}
+}
+
+// Center and half extent of a box, see sCookedMesh::boundsHalfExtent
+static void SetBounds(const glm::vec3& minBounds, const glm::vec3& maxBounds, glm::vec3& boundsCenter, glm::vec3& boundsHalfExtent)
+{
+	boundsCenter = (minBounds + maxBounds) * 0.5f;
+	boundsHalfExtent = (maxBounds - minBounds) * 0.5f;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (boundsHalfExtent[axis] <= 0.0f) // Flat on this axis, anything but 0 works
+		{
+			boundsHalfExtent[axis] = 1.0f;
+		}
+	}
+}
+
+template <class TVertex>
+static void ComputeBounds(const std::vector<TVertex>& vertices, glm::vec3& boundsCenter, glm::vec3& boundsHalfExtent)
+{
+	if (vertices.empty())
+	{
+		return;
+	}
+
+	glm::vec3 minBounds(vertices[0].x, vertices[0].y, vertices[0].z);
+	glm::vec3 maxBounds = minBounds;
+	for (const TVertex& vertex : vertices)
+	{
+		minBounds = glm::min(minBounds, glm::vec3(vertex.x, vertex.y, vertex.z));
+		maxBounds = glm::max(maxBounds, glm::vec3(vertex.x, vertex.y, vertex.z));
+	}
+
+	SetBounds(minBounds, maxBounds, boundsCenter, boundsHalfExtent);
+}
+
+// Picks the layout for an untextured mesh (see ModelManager::LoadModel)
+static void CookColoredMesh(std::vector<sColoredVertex>&& vertices, std::vector<sTriangle>& faces, bool hasVertexColors, unsigned int cookFlags, sCookedMesh& mesh)
+{
+	ComputeBounds(vertices, mesh.boundsCenter, mesh.boundsHalfExtent); // PackColoredVertices uses the same bounds
+
+	bool useVertexColors = hasVertexColors && !(cookFlags & COOK_NO_VERTEX_COLORS);
+	if (useVertexColors || (cookFlags & COOK_PACKED_VERTICES)) // Packed vertices are smaller than sPositionNormalVertex even with a color we don't need
+	{
+		if (!useVertexColors) // Ignored colors end up white, like they would without a color stream
+		{
+			for (sColoredVertex& vertex : vertices)
+			{
+				vertex.r = vertex.g = vertex.b = vertex.a = 1.0f;
+			}
+		}
+
+		OptimizeMeshOrder(vertices, faces, mesh);
+
+		if (cookFlags & COOK_PACKED_VERTICES)
+		{
+			std::vector<sPackedColoredVertex> packedVertices;
+			PackColoredVertices(vertices, packedVertices, mesh.boundsCenter, mesh.boundsHalfExtent, mesh.packingError);
+			SetCookedVertices(packedVertices, mesh);
+		}
+		else
+		{
+			SetCookedVertices(vertices, mesh);
+		}
+	}
+	else
+	{
+		std::vector<sPositionNormalVertex> positionNormals(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			positionNormals[i].x = vertices[i].x;
+			positionNormals[i].y = vertices[i].y;
+			positionNormals[i].z = vertices[i].z;
+			positionNormals[i].nx = vertices[i].nx;
+			positionNormals[i].ny = vertices[i].ny;
+			positionNormals[i].nz = vertices[i].nz;
+		}
+		std::vector<sColoredVertex>().swap(vertices);
+
+		OptimizeMeshOrder(positionNormals, faces, mesh);
+		SetCookedVertices(positionNormals, mesh);
+	}
+
+	SetCookedIndices(faces, mesh);
+}
+
+static void CookTexturedMesh(std::vector<sVertex>& vertices, std::vector<sTriangle>& faces, sCookedMesh& mesh)
+{
+	ComputeBounds(vertices, mesh.boundsCenter, mesh.boundsHalfExtent);
+	OptimizeMeshOrder(vertices, faces, mesh);
+	SetCookedVertices(vertices, mesh);
+	SetCookedIndices(faces, mesh);
+}
+
+// Texture files are looked for in the directory of the model + /Textures/, in a mounted archive or on disk
+static bool TextureExists(const std::string& path)
+{
+	sFileView view;
+	if (VirtualFileSystem::GetInstance()->Find(path, view))
+	{
+		return true;
+	}
+
+	std::ifstream file(path.c_str(), std::ios::binary);
+	return file.is_open();
+}
+
+static void CookAssimpMesh(const aiMesh* assimpMesh, const aiScene* scene, const std::string& directory, unsigned int cookFlags, sCookedMesh& mesh)
+{
+	std::vector<sTriangle> faces;
+	faces.reserve(assimpMesh->mNumFaces);
+	for (unsigned int i = 0; i < assimpMesh->mNumFaces; i++)
+	{
+		const aiFace& assimpFace = assimpMesh->mFaces[i];
+		if (assimpFace.mNumIndices != 3) // Points and lines left over after aiProcess_Triangulate
+		{
+			continue;
+		}
+
+		sTriangle face;
+		face.vertIndex[0] = assimpFace.mIndices[0];
+		face.vertIndex[1] = assimpFace.mIndices[1];
+		face.vertIndex[2] = assimpFace.mIndices[2];
+		faces.push_back(face);
+	}
+
+	// Pick the smallest layout that has everything this mesh uses
+	if (assimpMesh->HasTextureCoords(0) && scene->mMaterials)
+	{
+		const aiMaterial* material = scene->mMaterials[assimpMesh->mMaterialIndex];
+		for (unsigned int i = 0; i < material->GetTextureCount(aiTextureType_DIFFUSE); i++)
+		{
+			aiString str;
+			material->GetTexture(aiTextureType_DIFFUSE, i, &str);
+			std::string filePath(str.C_Str());
+			std::string fileName = filePath.substr(filePath.find_last_of("\\/") + 1, filePath.length());
+			if (TextureExists(directory + "Textures\\" + fileName))
+			{
+				mesh.diffuseTextures.push_back(fileName);
+			}
+		}
+	}
+
+	if (!mesh.diffuseTextures.empty() && (!assimpMesh->HasVertexColors(0) || (cookFlags & COOK_NO_VERTEX_COLORS)))
+	{
+		std::vector<sVertex> vertices;
+		ConvertAssimpVertices(assimpMesh, vertices);
+		CookTexturedMesh(vertices, faces, mesh);
+		return;
+	}
+
+	std::vector<sColoredVertex> vertices;
+	ConvertAssimpVertices(assimpMesh, vertices);
+	CookColoredMesh(std::move(vertices), faces, assimpMesh->HasVertexColors(0), cookFlags, mesh);
+}
+
+static void CookAssimpNode(const aiNode* node, const aiScene* scene, const std::string& directory, unsigned int cookFlags, sCookedModel& model)
+{
+	for (unsigned int i = 0; i < node->mNumMeshes; i++)
+	{
+		model.meshes.emplace_back();
+		CookAssimpMesh(scene->mMeshes[node->mMeshes[i]], scene, directory, cookFlags, model.meshes.back());
+	}
+
+	// Recursivley processes child nodes
+	for (unsigned int i = 0; i < node->mNumChildren; i++)
+	{
+		CookAssimpNode(node->mChildren[i], scene, directory, cookFlags, model);
+	}
+}
+
+// Accessor is the float field at offset of a vertex struct stride bytes long, interleaved with the positions
+static bool IsGlbVertexField(const sGlbAccessor& accessor, const sGlbAccessor& position, unsigned int componentCount, size_t offset, unsigned int stride)
+{
+	return accessor.count == position.count && accessor.bufferView == position.bufferView && accessor.stride == stride &&
+		accessor.componentType == GLB_COMPONENT_FLOAT && accessor.componentCount == componentCount && accessor.byteOffset == offset;
+}
+
+// True if the positions' buffer view already is an array of the format's vertex struct, so it can be uploaded as it is.
+// Never for textured meshes: glTF's v runs top down and ours bottom up, so UVs always need flipping (assimp does it too).
+static bool IsGlbVertexFormat(const sGlbPrimitive& primitive, eVertexFormat format, unsigned int& stride)
+{
+	const sGlbAccessor& position = primitive.position;
+	bool matches = false;
+	switch (format)
+	{
+	case VERTEX_FORMAT_POSITION_NORMAL:
+		stride = sizeof(sPositionNormalVertex);
+		matches = IsGlbVertexField(position, position, 3, offsetof(sPositionNormalVertex, x), stride) &&
+			IsGlbVertexField(primitive.normal, position, 3, offsetof(sPositionNormalVertex, nx), stride);
+		break;
+	case VERTEX_FORMAT_COLORED:
+		stride = sizeof(sColoredVertex);
+		matches = IsGlbVertexField(position, position, 3, offsetof(sColoredVertex, x), stride) &&
+			IsGlbVertexField(primitive.normal, position, 3, offsetof(sColoredVertex, nx), stride) &&
+			IsGlbVertexField(primitive.color, position, 4, offsetof(sColoredVertex, r), stride);
+		break;
+	default:
+		break;
+	}
+
+	return matches && position.viewSize >= (size_t) position.count * stride; // The padding after the last vertex too
+}
+
+// A mesh whose vertex and index buffers are straight out of the file, see COOK_DIRECT_UPLOAD.
+// The triangles stay in the file's order, reordering them would mean copying.
+static bool GetDirectGlbMesh(const sGlbPrimitive& primitive, eVertexFormat format, sCookedMeshView& view)
+{
+	const sGlbAccessor& position = primitive.position;
+	const sGlbAccessor& indices = primitive.indices;
+	unsigned int indexSize = indices.componentType == GLB_COMPONENT_UNSIGNED_SHORT ? sizeof(unsigned short) : indices.componentType == GLB_COMPONENT_UNSIGNED_INT ? sizeof(unsigned int) : 0;
+	unsigned int stride = 0;
+	if (!indices.data || indexSize == 0 || indices.stride != indexSize || indices.count % 3 != 0 || !IsGlbVertexFormat(primitive, format, stride))
+	{
+		return false;
+	}
+
+	// One pass over the indices, which it needs anyway to make sure none of them are out of range before they reach the GPU
+	if (!CountIndexBufferCacheMisses(indices.data, indexSize, indices.count, position.count, view.cacheMissesBefore))
+	{
+		return false;
+	}
+	view.cacheMissesAfter = view.cacheMissesBefore;
+
+	view.vertexFormat = format;
+	view.vertexStride = stride;
+	view.vertexCount = position.count;
+	view.indexSize = indexSize;
+	view.indexCount = indices.count;
+	view.vertexStream = GetRawStreamView(position.viewData, (size_t) position.count * stride, stride);
+	view.indexStream = GetRawStreamView(indices.data, (size_t) indices.count * indexSize, indexSize);
+	view.packingError = { 0.0f, 0.0f, 0.0f };
+
+	// glTF requires min/max on positions, so the bounds don't have to touch the vertices either
+	glm::vec3 minBounds(position.minValues[0], position.minValues[1], position.minValues[2]);
+	glm::vec3 maxBounds(position.maxValues[0], position.maxValues[1], position.maxValues[2]);
+	if (!position.hasBounds && position.count > 0)
+	{
+		float values[3];
+		ReadGlbElement(position, 0, values);
+		minBounds = maxBounds = glm::vec3(values[0], values[1], values[2]);
+		for (unsigned int i = 1; i < position.count; i++)
+		{
+			ReadGlbElement(position, i, values);
+			minBounds = glm::min(minBounds, glm::vec3(values[0], values[1], values[2]));
+			maxBounds = glm::max(maxBounds, glm::vec3(values[0], values[1], values[2]));
+		}
+	}
+	SetBounds(minBounds, maxBounds, view.boundsCenter, view.boundsHalfExtent);
+	return true;
+}
+
+// glTF says a primitive without normals gets flat ones, but assimp's aiProcess_GenSmoothNormals makes smooth ones.
+// Smooth (area weighted), so a GLB looks the same whichever path loads it.
+static void GenerateSmoothNormals(std::vector<sColoredVertex>& vertices, const std::vector<sTriangle>& faces)
+{
+	std::vector<glm::vec3> normals(vertices.size(), glm::vec3(0.0f));
+	for (const sTriangle& face : faces)
+	{
+		const sColoredVertex& a = vertices[face.vertIndex[0]];
+		const sColoredVertex& b = vertices[face.vertIndex[1]];
+		const sColoredVertex& c = vertices[face.vertIndex[2]];
+		glm::vec3 normal = glm::cross(glm::vec3(b.x - a.x, b.y - a.y, b.z - a.z), glm::vec3(c.x - a.x, c.y - a.y, c.z - a.z));
+		for (int corner = 0; corner < 3; corner++)
+		{
+			normals[face.vertIndex[corner]] += normal;
+		}
+	}
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		float length = glm::length(normals[i]);
+		glm::vec3 normal = length > 0.0f ? normals[i] / length : glm::vec3(0.0f, 1.0f, 0.0f);
+		vertices[i].nx = normal.x;
+		vertices[i].ny = normal.y;
+		vertices[i].nz = normal.z;
+	}
+}
+
+static bool CookGlbPrimitive(const sGlbPrimitive& primitive, const std::string& directory, unsigned int cookFlags, sCookedModel& model, std::string& error)
+{
+	std::vector<std::string> diffuseTextures;
+	if (primitive.texCoord.count > 0 && !primitive.diffuseTexture.empty() && TextureExists(directory + "Textures\\" + primitive.diffuseTexture))
+	{
+		diffuseTextures.push_back(primitive.diffuseTexture);
+	}
+
+	// The same layout choice CookAssimpMesh and CookColoredMesh make
+	bool hasVertexColors = primitive.color.count > 0;
+	bool useVertexColors = hasVertexColors && !(cookFlags & COOK_NO_VERTEX_COLORS);
+	bool isTextured = !diffuseTextures.empty() && !useVertexColors;
+	if ((cookFlags & COOK_DIRECT_UPLOAD) && !isTextured && !(cookFlags & COOK_PACKED_VERTICES))
+	{
+		sCookedMeshView view;
+		if (GetDirectGlbMesh(primitive, useVertexColors ? VERTEX_FORMAT_COLORED : VERTEX_FORMAT_POSITION_NORMAL, view))
+		{
+			model.directMeshOrder.push_back((unsigned int) (model.meshes.size() + model.directMeshes.size()));
+			model.directMeshes.push_back(view);
+			return true;
+		}
+	}
+
+	// Anything else is converted like any other format
+	unsigned int vertexCount = primitive.position.count;
+	unsigned int indexCount = primitive.indices.data ? primitive.indices.count : vertexCount;
+	std::vector<sTriangle> faces;
+	faces.reserve(indexCount / 3);
+	for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+	{
+		sTriangle face;
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			face.vertIndex[corner] = primitive.indices.data ? ReadGlbIndex(primitive.indices, i + corner) : i + corner;
+			if (face.vertIndex[corner] >= vertexCount)
+			{
+				error = "a GLB primitive has an index out of range";
+				return false;
+			}
+		}
+		faces.push_back(face);
+	}
+
+	std::vector<sColoredVertex> vertices(vertexCount);
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		sColoredVertex& vertex = vertices[i];
+		float values[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		ReadGlbElement(primitive.position, i, values);
+		vertex.x = values[0];
+		vertex.y = values[1];
+		vertex.z = values[2];
+
+		if (primitive.normal.count > 0)
+		{
+			ReadGlbElement(primitive.normal, i, values);
+			vertex.nx = values[0];
+			vertex.ny = values[1];
+			vertex.nz = values[2];
+		}
+
+		values[0] = values[1] = values[2] = values[3] = 1.0f; // An RGB color keeps alpha 1
+		if (hasVertexColors)
+		{
+			ReadGlbElement(primitive.color, i, values);
+		}
+		vertex.r = values[0];
+		vertex.g = values[1];
+		vertex.b = values[2];
+		vertex.a = values[3];
+	}
+
+	if (primitive.normal.count == 0)
+	{
+		GenerateSmoothNormals(vertices, faces);
+	}
+
+	model.meshes.emplace_back();
+	sCookedMesh& mesh = model.meshes.back();
+	mesh.diffuseTextures = diffuseTextures;
+	if (isTextured)
+	{
+		std::vector<sVertex> texturedVertices(vertexCount);
+		for (unsigned int i = 0; i < vertexCount; i++)
+		{
+			float uv[2];
+			ReadGlbElement(primitive.texCoord, i, uv);
+			texturedVertices[i].x = vertices[i].x;
+			texturedVertices[i].y = vertices[i].y;
+			texturedVertices[i].z = vertices[i].z;
+			texturedVertices[i].nx = vertices[i].nx;
+			texturedVertices[i].ny = vertices[i].ny;
+			texturedVertices[i].nz = vertices[i].nz;
+			texturedVertices[i].u0 = uv[0];
+			texturedVertices[i].v0 = 1.0f - uv[1];
+		}
+		CookTexturedMesh(texturedVertices, faces, mesh);
+	}
+	else
+	{
+		CookColoredMesh(std::move(vertices), faces, hasVertexColors, cookFlags, mesh);
+	}
+
+	return true;
+}
+
+static bool CookGlb(const unsigned char* data, size_t size, const std::string& directory, unsigned int cookFlags, sCookedModel& model, std::string& error)
+{
+	sGlbFile file;
+	if (!LoadGlb(data, size, file, error))
+	{
+		return false;
+	}
+
+	model.meshes.reserve(file.primitives.size());
+	for (const sGlbPrimitive& primitive : file.primitives)
+	{
+		if (!CookGlbPrimitive(primitive, directory, cookFlags, model, error))
+		{
+			model.meshes.clear();
+			model.directMeshes.clear();
+			model.directMeshOrder.clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool CookModel(const std::string& path, const unsigned char* data, size_t size, unsigned int cookFlags, sCookedModel& model, std::string& error)
+{
+	model.cookFlags = cookFlags & COOK_RESULT_FLAGS;
+	model.importer = COOK_IMPORTER_ASSIMP;
+	model.meshes.clear();
+	model.directMeshes.clear();
+	model.directMeshOrder.clear();
+
+	std::string directory = path.substr(0, path.find_last_of("\\/") + 1);
+
+	if (!(cookFlags & COOK_FORCE_ASSIMP) && HasExtension(path, ".ply"))
+	{
+		sPlyMesh plyMesh;
+		if (data ? LoadPly(data, size, plyMesh) : LoadPly(path, plyMesh))
+		{
+			model.meshes.emplace_back();
+			CookColoredMesh(std::move(plyMesh.vertices), plyMesh.faces, plyMesh.hasVertexColors, cookFlags, model.meshes.back());
+			model.importer = COOK_IMPORTER_PLY;
+			return true;
+		}
+	}
+
+	if (!(cookFlags & COOK_FORCE_ASSIMP) && HasExtension(path, ".glb"))
+	{
+		// Mapped just for this if it isn't in memory already, so nothing can point into it afterwards
+		MappedFile file;
+		const unsigned char* glbData = data;
+		size_t glbSize = size;
+		unsigned int glbCookFlags = cookFlags;
+		if (!glbData && file.Open(path))
+		{
+			glbData = file.GetData();
+			glbSize = file.GetSize();
+			glbCookFlags &= ~COOK_DIRECT_UPLOAD;
+		}
+
+		std::string glbError; // Whatever LoadGlb doesn't handle (e.g. Draco) is assimp's problem
+		if (glbData && CookGlb(glbData, glbSize, directory, glbCookFlags, model, glbError))
+		{
+			model.importer = COOK_IMPORTER_GLB;
+			return true;
+		}
+	}
+
+	// Anything LoadPly doesn't handle
+	Assimp::Importer importer;
+
+	unsigned int flags = 0;
+	flags |= aiProcess_Triangulate; // Triangulates the faces (AKA: if there are models with faces > 3, it will turn them into triangles for us)
+	flags |= aiProcess_JoinIdenticalVertices; // Joins identical vertex data
+	flags |= aiProcess_GenSmoothNormals; // Generates smooth normals for all vertices in the mesh
+
+	const aiScene* scene = NULL;
+	if (data)
+	{
+		std::string extension = path.substr(path.find_last_of('.') + 1); // Assimp picks the importer from this
+		scene = importer.ReadFileFromMemory(data, size, flags, extension.c_str());
+	}
+	else
+	{
+		scene = importer.ReadFile(path, flags);
+	}
+
+	if (!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+	{
+		error = importer.GetErrorString();
+		return false;
+	}
+
+	model.meshes.reserve(scene->mNumMeshes); // Nodes can share meshes so this is only a guess, but it's almost always exact
+	CookAssimpNode(scene->mRootNode, scene, directory, cookFlags, model);
+	return true;
+}
+
+// Maps [-1, 1] to a signed normalized integer with the given number of bits
+static int QuantizeSigned(float value, int bits)
+{
+	float maxValue = (float) ((1 << (bits - 1)) - 1);
+	value = std::max(-1.0f, std::min(1.0f, value));
+	return (int) std::floor(value * maxValue + 0.5f);
+}
+
+// GL's rule for normalized signed integers (GL 4.2+): max(q / maxValue, -1)
+static float DequantizeSigned(int value, int bits)
+{
+	float maxValue = (float) ((1 << (bits - 1)) - 1);
+	return std::max((float) value / maxValue, -1.0f);
+}
+
+void PackColoredVertices(const std::vector<sColoredVertex>& vertices, std::vector<sPackedColoredVertex>& packedVertices, glm::vec3& boundsCenter, glm::vec3& boundsHalfExtent, sPackingError& packingError)
+{
+	packedVertices.resize(vertices.size());
+	packingError.maxPositionError = 0.0f;
+	packingError.maxNormalErrorDegrees = 0.0f;
+	packingError.maxColorError = 0.0f;
+	if (vertices.empty())
+	{
+		return;
+	}
+
+	ComputeBounds(vertices, boundsCenter, boundsHalfExtent);
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const sColoredVertex& vertex = vertices[i];
+		sPackedColoredVertex& packed = packedVertices[i];
+
+		glm::vec3 position = (glm::vec3(vertex.x, vertex.y, vertex.z) - boundsCenter) / boundsHalfExtent;
+		packed.x = (short) QuantizeSigned(position.x, 16);
+		packed.y = (short) QuantizeSigned(position.y, 16);
+		packed.z = (short) QuantizeSigned(position.z, 16);
+		packed.w = 0;
+
+		glm::vec3 normal(vertex.nx, vertex.ny, vertex.nz);
+		float normalLength = glm::length(normal);
+		normal = normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f, 1.0f, 0.0f);
+		int nx = QuantizeSigned(normal.x, 10);
+		int ny = QuantizeSigned(normal.y, 10);
+		int nz = QuantizeSigned(normal.z, 10);
+		packed.normal = ((unsigned int) nx & 0x3FF) | (((unsigned int) ny & 0x3FF) << 10) | (((unsigned int) nz & 0x3FF) << 20) | (1u << 30); // w = 1, like the float path gives
+
+		packed.r = (unsigned char) std::floor(std::max(0.0f, std::min(1.0f, vertex.r)) * 255.0f + 0.5f);
+		packed.g = (unsigned char) std::floor(std::max(0.0f, std::min(1.0f, vertex.g)) * 255.0f + 0.5f);
+		packed.b = (unsigned char) std::floor(std::max(0.0f, std::min(1.0f, vertex.b)) * 255.0f + 0.5f);
+		packed.a = (unsigned char) std::floor(std::max(0.0f, std::min(1.0f, vertex.a)) * 255.0f + 0.5f);
+
+		// Decode it again the way the GPU will, so we can report how far off it is
+		glm::vec3 decodedPosition = boundsCenter + glm::vec3(DequantizeSigned(packed.x, 16), DequantizeSigned(packed.y, 16), DequantizeSigned(packed.z, 16)) * boundsHalfExtent;
+		packingError.maxPositionError = std::max(packingError.maxPositionError, glm::distance(decodedPosition, glm::vec3(vertex.x, vertex.y, vertex.z)));
+
+		glm::vec3 decodedNormal = glm::normalize(glm::vec3(DequantizeSigned(nx, 10), DequantizeSigned(ny, 10), DequantizeSigned(nz, 10)));
+		float cosAngle = std::max(-1.0f, std::min(1.0f, glm::dot(decodedNormal, normal)));
+		packingError.maxNormalErrorDegrees = std::max(packingError.maxNormalErrorDegrees, glm::degrees(std::acos(cosAngle)));
+
+		packingError.maxColorError = std::max(packingError.maxColorError, std::fabs(packed.r / 255.0f - std::max(0.0f, std::min(1.0f, vertex.r))));
+		packingError.maxColorError = std::max(packingError.maxColorError, std::fabs(packed.g / 255.0f - std::max(0.0f, std::min(1.0f, vertex.g))));
+		packingError.maxColorError = std::max(packingError.maxColorError, std::fabs(packed.b / 255.0f - std::max(0.0f, std::min(1.0f, vertex.b))));
+		packingError.maxColorError = std::max(packingError.maxColorError, std::fabs(packed.a / 255.0f - std::max(0.0f, std::min(1.0f, vertex.a))));
+	}
+}
+
+static void AppendBytes(std::vector<unsigned char>& output, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	output.insert(output.end(), bytes, bytes + size);
+}
+
+static void AppendPadding(std::vector<unsigned char>& output, size_t alignment)
+{
+	output.resize((output.size() + alignment - 1) / alignment * alignment, 0);
+}
+
+// Groups byte i of every element together and delta codes each group, see COOKED_ENCODING_LZ4_DELTA_PLANES
+static void EncodeDeltaPlanes(const unsigned char* source, size_t size, unsigned int elementSize, unsigned char* destination)
+{
+	size_t elementCount = size / elementSize;
+	for (unsigned int byte = 0; byte < elementSize; byte++)
+	{
+		unsigned char* plane = destination + byte * elementCount;
+		unsigned char previous = 0;
+		for (size_t i = 0; i < elementCount; i++)
+		{
+			unsigned char value = source[i * elementSize + byte];
+			plane[i] = (unsigned char) (value - previous);
+			previous = value;
+		}
+	}
+}
+
+static void DecodeDeltaPlanes(const unsigned char* source, size_t size, unsigned int elementSize, unsigned char* destination)
+{
+	size_t elementCount = size / elementSize;
+	for (unsigned int byte = 0; byte < elementSize; byte++)
+	{
+		const unsigned char* plane = source + byte * elementCount;
+		unsigned char value = 0;
+		for (size_t i = 0; i < elementCount; i++)
+		{
+			value = (unsigned char) (value + plane[i]);
+			destination[i * elementSize + byte] = value;
+		}
+	}
+}
+
+// Encodes every chunk of a stream, returns the stored size (chunks that don't get smaller are stored as they are)
+static size_t EncodeStream(const std::vector<unsigned char>& raw, unsigned int elementSize, eCookedEncoding encoding, std::vector<uint32_t>& chunkSizes, std::vector<unsigned char>& data)
+{
+	size_t chunkRawSize = GetChunkRawSize(elementSize);
+	std::vector<unsigned char> planes(chunkRawSize);
+	std::vector<unsigned char> compressed(Lz4CompressBound(chunkRawSize));
+
+	chunkSizes.clear();
+	data.clear();
+	for (size_t offset = 0; offset < raw.size(); offset += chunkRawSize)
+	{
+		size_t size = std::min(chunkRawSize, raw.size() - offset);
+		const unsigned char* chunk = raw.data() + offset;
+
+		size_t compressedSize = 0;
+		if (encoding == COOKED_ENCODING_LZ4_DELTA_PLANES)
+		{
+			EncodeDeltaPlanes(chunk, size, elementSize, planes.data());
+			compressedSize = Lz4Compress(planes.data(), size, compressed.data(), compressed.size());
+		}
+		else if (encoding == COOKED_ENCODING_LZ4)
+		{
+			compressedSize = Lz4Compress(chunk, size, compressed.data(), compressed.size());
+		}
+
+		if (compressedSize > 0 && compressedSize < size)
+		{
+			chunkSizes.push_back((uint32_t) compressedSize);
+			AppendBytes(data, compressed.data(), compressedSize);
+		}
+		else
+		{
+			chunkSizes.push_back((uint32_t) size | COOKED_CHUNK_STORED);
+			AppendBytes(data, chunk, size);
+		}
+	}
+
+	return data.size();
+}
+
+static void WriteStream(std::vector<unsigned char>& output, const std::vector<unsigned char>& raw, unsigned int elementSize, bool compress, sCookedStreamHeader& header)
+{
+	eCookedEncoding encoding = COOKED_ENCODING_RAW;
+	std::vector<uint32_t> chunkSizes;
+	std::vector<unsigned char> data;
+	EncodeStream(raw, elementSize, encoding, chunkSizes, data);
+
+	if (compress) // Whichever comes out smaller
+	{
+		const eCookedEncoding candidates[2] = { COOKED_ENCODING_LZ4, COOKED_ENCODING_LZ4_DELTA_PLANES };
+		std::vector<uint32_t> candidateChunkSizes;
+		std::vector<unsigned char> candidateData;
+		for (eCookedEncoding candidate : candidates)
+		{
+			if (EncodeStream(raw, elementSize, candidate, candidateChunkSizes, candidateData) < data.size())
+			{
+				encoding = candidate;
+				chunkSizes.swap(candidateChunkSizes);
+				data.swap(candidateData);
+			}
+		}
+	}
+
+	header.encoding = (uint32_t) encoding;
+	header.elementSize = elementSize;
+	header.chunkRawSize = (uint32_t) GetChunkRawSize(elementSize);
+	header.chunkCount = (uint32_t) chunkSizes.size();
+	header.rawSize = raw.size();
+	header.storedSize = data.size();
+
+	AppendPadding(output, alignof(uint32_t));
+	header.chunkTableOffset = output.size();
+	AppendBytes(output, chunkSizes.data(), chunkSizes.size() * sizeof(uint32_t));
+
+	AppendPadding(output, COOKED_DATA_ALIGNMENT);
+	header.dataOffset = output.size();
+	AppendBytes(output, data.data(), data.size());
+}
+
+void WriteCookedModel(const sCookedModel& model, std::vector<unsigned char>& output, bool compress)
+{
+	output.clear();
+
+	sCookedModelHeader modelHeader;
+	memcpy(modelHeader.magic, COOKED_MODEL_MAGIC, sizeof(COOKED_MODEL_MAGIC));
+	modelHeader.version = COOKED_MODEL_VERSION;
+	modelHeader.cookFlags = model.cookFlags;
+	modelHeader.meshCount = (uint32_t) model.meshes.size();
+	AppendBytes(output, &modelHeader, sizeof(modelHeader));
+
+	// Headers and names first, the streams get filled in once they're placed
+	std::vector<sCookedMeshHeader> meshHeaders(model.meshes.size());
+	std::vector<size_t> headerPositions;
+	for (size_t i = 0; i < model.meshes.size(); i++)
+	{
+		const sCookedMesh& mesh = model.meshes[i];
+		AppendPadding(output, alignof(sCookedMeshHeader));
+		headerPositions.push_back(output.size());
+
+		sCookedMeshHeader& meshHeader = meshHeaders[i];
+		memset(&meshHeader, 0, sizeof(meshHeader));
+		meshHeader.vertexFormat = (uint32_t) mesh.vertexFormat;
+		meshHeader.vertexStride = mesh.vertexStride;
+		meshHeader.vertexCount = mesh.vertexCount;
+		meshHeader.indexSize = mesh.indexSize;
+		meshHeader.indexCount = mesh.indexCount;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			meshHeader.boundsCenter[axis] = mesh.boundsCenter[axis];
+			meshHeader.boundsHalfExtent[axis] = mesh.boundsHalfExtent[axis];
+		}
+		meshHeader.packingError[0] = mesh.packingError.maxPositionError;
+		meshHeader.packingError[1] = mesh.packingError.maxNormalErrorDegrees;
+		meshHeader.packingError[2] = mesh.packingError.maxColorError;
+		meshHeader.cacheMissesBefore = mesh.cacheMissesBefore;
+		meshHeader.cacheMissesAfter = mesh.cacheMissesAfter;
+		meshHeader.textureCount = (uint32_t) mesh.diffuseTextures.size();
+		AppendBytes(output, &meshHeader, sizeof(meshHeader));
+
+		for (const std::string& texture : mesh.diffuseTextures)
+		{
+			uint32_t length = (uint32_t) texture.size();
+			AppendBytes(output, &length, sizeof(length));
+			AppendBytes(output, texture.data(), texture.size());
+		}
+	}
+
+	for (size_t i = 0; i < model.meshes.size(); i++)
+	{
+		const sCookedMesh& mesh = model.meshes[i];
+		WriteStream(output, mesh.vertices, std::max(1u, mesh.vertexStride), compress, meshHeaders[i].vertexStream);
+		WriteStream(output, mesh.indices, std::max(1u, mesh.indexSize), compress, meshHeaders[i].indexStream);
+		memcpy(output.data() + headerPositions[i], &meshHeaders[i], sizeof(sCookedMeshHeader)); // Appending moves the buffer, so only now
+	}
+}
+
+bool IsCookedModel(const unsigned char* data, size_t size)
+{
+	return data && size >= sizeof(sCookedModelHeader) && memcmp(data, COOKED_MODEL_MAGIC, sizeof(COOKED_MODEL_MAGIC)) == 0;
+}
+
+// Checks the stream lies inside the blob and its chunk table adds up, and fills in the view
+static bool ReadStream(const unsigned char* data, size_t size, const sCookedStreamHeader& header, uint64_t expectedRawSize, sCookedStreamView& stream)
+{
+	if (header.encoding > COOKED_ENCODING_LZ4_DELTA_PLANES || header.elementSize == 0 || header.rawSize != expectedRawSize ||
+		header.chunkRawSize == 0 || header.chunkRawSize > COOKED_CHUNK_SIZE || header.chunkRawSize % header.elementSize != 0 ||
+		header.chunkCount != (header.rawSize + header.chunkRawSize - 1) / header.chunkRawSize ||
+		header.dataOffset > size || header.storedSize > size - header.dataOffset ||
+		header.chunkTableOffset % alignof(uint32_t) != 0 || header.chunkTableOffset > size || (uint64_t) header.chunkCount * sizeof(uint32_t) > size - header.chunkTableOffset)
+	{
+		return false;
+	}
+
+	const uint32_t* chunkSizes = reinterpret_cast<const uint32_t*>(data + header.chunkTableOffset);
+	uint64_t storedSize = 0;
+	for (uint32_t i = 0; i < header.chunkCount; i++)
+	{
+		uint64_t rawSize = std::min<uint64_t>(header.chunkRawSize, header.rawSize - (uint64_t) i * header.chunkRawSize);
+		if ((chunkSizes[i] & COOKED_CHUNK_STORED) && (chunkSizes[i] & ~COOKED_CHUNK_STORED) != rawSize)
+		{
+			return false;
+		}
+		storedSize += chunkSizes[i] & ~COOKED_CHUNK_STORED;
+	}
+	if (storedSize != header.storedSize)
+	{
+		return false;
+	}
+
+	stream.data = data + header.dataOffset;
+	stream.storedSize = (size_t) header.storedSize;
+	stream.rawSize = (size_t) header.rawSize;
+	stream.encoding = (eCookedEncoding) header.encoding;
+	stream.elementSize = header.elementSize;
+	stream.chunkRawSize = header.chunkRawSize;
+	stream.chunkCount = header.chunkCount;
+	stream.chunkSizes = chunkSizes;
+	stream.indexLimit = 0;
+	return true;
+}
+
+bool ReadCookedModel(const unsigned char* data, size_t size, unsigned int& cookFlags, std::vector<sCookedMeshView>& meshes)
+{
+	meshes.clear();
+	if (!IsCookedModel(data, size))
+	{
+		return false;
+	}
+
+	const sCookedModelHeader* modelHeader = reinterpret_cast<const sCookedModelHeader*>(data);
+	if (modelHeader->version != COOKED_MODEL_VERSION)
+	{
+		return false;
+	}
+	cookFlags = modelHeader->cookFlags;
+
+	size_t offset = sizeof(sCookedModelHeader);
+	meshes.reserve(modelHeader->meshCount);
+	for (uint32_t i = 0; i < modelHeader->meshCount; i++)
+	{
+		offset = (offset + alignof(sCookedMeshHeader) - 1) / alignof(sCookedMeshHeader) * alignof(sCookedMeshHeader);
+		if (offset + sizeof(sCookedMeshHeader) > size)
+		{
+			return false;
+		}
+
+		const sCookedMeshHeader* meshHeader = reinterpret_cast<const sCookedMeshHeader*>(data + offset);
+		offset += sizeof(sCookedMeshHeader);
+
+		sCookedMeshView view;
+		if (!ReadStream(data, size, meshHeader->vertexStream, (uint64_t) meshHeader->vertexCount * meshHeader->vertexStride, view.vertexStream) ||
+			!ReadStream(data, size, meshHeader->indexStream, (uint64_t) meshHeader->indexCount * meshHeader->indexSize, view.indexStream) ||
+			(meshHeader->indexSize != sizeof(unsigned short) && meshHeader->indexSize != sizeof(unsigned int)) ||
+			meshHeader->indexCount % 3 != 0 || (meshHeader->indexCount > 0 && meshHeader->vertexCount == 0))
+		{
+			return false;
+		}
+		view.indexStream.indexLimit = meshHeader->vertexCount; // The indices are compressed, DecodeChunk checks them
+
+		view.vertexFormat = (eVertexFormat) meshHeader->vertexFormat;
+		view.vertexStride = meshHeader->vertexStride;
+		view.vertexCount = meshHeader->vertexCount;
+		view.indexSize = meshHeader->indexSize;
+		view.indexCount = meshHeader->indexCount;
+		view.boundsCenter = glm::vec3(meshHeader->boundsCenter[0], meshHeader->boundsCenter[1], meshHeader->boundsCenter[2]);
+		view.boundsHalfExtent = glm::vec3(meshHeader->boundsHalfExtent[0], meshHeader->boundsHalfExtent[1], meshHeader->boundsHalfExtent[2]);
+		view.packingError.maxPositionError = meshHeader->packingError[0];
+		view.packingError.maxNormalErrorDegrees = meshHeader->packingError[1];
+		view.packingError.maxColorError = meshHeader->packingError[2];
+		view.cacheMissesBefore = meshHeader->cacheMissesBefore;
+		view.cacheMissesAfter = meshHeader->cacheMissesAfter;
+
+		for (uint32_t j = 0; j < meshHeader->textureCount; j++)
+		{
+			uint32_t length = 0;
+			if (offset + sizeof(length) > size)
+			{
+				return false;
+			}
+			memcpy(&length, data + offset, sizeof(length));
+			offset += sizeof(length);
+
+			if (length > size - offset)
+			{
+				return false;
+			}
+			view.diffuseTextures.push_back(std::string((const char*) data + offset, length));
+			offset += length;
+		}
+
+		meshes.push_back(view);
+	}
+
+	return true;
+}
+
+sCookedMeshView GetCookedMeshView(const sCookedMesh& mesh)
+{
+	sCookedMeshView view;
+	view.vertexFormat = mesh.vertexFormat;
+	view.vertexStride = mesh.vertexStride;
+	view.vertexCount = mesh.vertexCount;
+	view.indexSize = mesh.indexSize;
+	view.indexCount = mesh.indexCount;
+	view.vertexStream = GetRawStreamView(mesh.vertices.data(), mesh.vertices.size(), mesh.vertexStride);
+	view.indexStream = GetRawStreamView(mesh.indices.data(), mesh.indices.size(), mesh.indexSize);
+	view.boundsCenter = mesh.boundsCenter;
+	view.boundsHalfExtent = mesh.boundsHalfExtent;
+	view.packingError = mesh.packingError;
+	view.cacheMissesBefore = mesh.cacheMissesBefore;
+	view.cacheMissesAfter = mesh.cacheMissesAfter;
+	view.diffuseTextures = mesh.diffuseTextures;
+	return view;
+}
+
+struct sDecodeChunk
+{
+	const sCookedStreamView* stream;
+	const unsigned char* source;
+	size_t storedSize;
+	bool isStored;
+	unsigned char* destination;
+	size_t rawSize;
+};
+
+// Whether every index of a decoded chunk is below limit, so a corrupt file can't make the GPU read past the vertices
+static bool AreIndicesBelow(const unsigned char* indices, size_t size, unsigned int indexSize, unsigned int limit)
+{
+	if (indexSize == sizeof(unsigned short))
+	{
+		unsigned short maxIndex = 0;
+		for (size_t offset = 0; offset < size; offset += sizeof(unsigned short))
+		{
+			unsigned short index;
+			memcpy(&index, indices + offset, sizeof(index));
+			maxIndex = std::max(maxIndex, index);
+		}
+		return size == 0 || maxIndex < limit;
+	}
+
+	unsigned int maxIndex = 0;
+	for (size_t offset = 0; offset < size; offset += sizeof(unsigned int))
+	{
+		unsigned int index;
+		memcpy(&index, indices + offset, sizeof(index));
+		maxIndex = std::max(maxIndex, index);
+	}
+	return size == 0 || maxIndex < limit;
+}
+
+static bool DecodeChunk(const sDecodeChunk& chunk, std::vector<unsigned char>& scratch)
+{
+	unsigned int indexLimit = chunk.stream->indexLimit;
+	if (chunk.isStored || chunk.stream->encoding == COOKED_ENCODING_RAW)
+	{
+		if (indexLimit > 0 && !AreIndicesBelow(chunk.source, chunk.rawSize, chunk.stream->elementSize, indexLimit))
+		{
+			return false;
+		}
+
+		memcpy(chunk.destination, chunk.source, chunk.rawSize);
+		return true;
+	}
+
+	// Decode into scratch first, LZ4 reads back what it wrote for every match and the destination is usually a write only
+	// GPU mapping. Then it goes out in one sequential copy, which is what write combined memory wants.
+	scratch.resize(chunk.rawSize * 2);
+	if (!Lz4Decompress(chunk.source, chunk.storedSize, scratch.data(), chunk.rawSize))
+	{
+		return false;
+	}
+
+	const unsigned char* decoded = scratch.data();
+	if (chunk.stream->encoding == COOKED_ENCODING_LZ4_DELTA_PLANES)
+	{
+		DecodeDeltaPlanes(scratch.data(), chunk.rawSize, chunk.stream->elementSize, scratch.data() + chunk.rawSize);
+		decoded = scratch.data() + chunk.rawSize;
+	}
+
+	if (indexLimit > 0 && !AreIndicesBelow(decoded, chunk.rawSize, chunk.stream->elementSize, indexLimit))
+	{
+		return false;
+	}
+
+	memcpy(chunk.destination, decoded, chunk.rawSize);
+	return true;
+}
+
+bool DecodeCookedStreams(const std::vector<sStreamDecode>& decodes)
+{
+	std::vector<sDecodeChunk> chunks;
+	for (const sStreamDecode& decode : decodes)
+	{
+		const sCookedStreamView& stream = *decode.stream;
+		size_t sourceOffset = 0;
+		for (unsigned int i = 0; i < stream.chunkCount; i++)
+		{
+			sDecodeChunk chunk;
+			chunk.stream = &stream;
+			chunk.rawSize = std::min(stream.chunkRawSize, stream.rawSize - i * stream.chunkRawSize);
+			chunk.storedSize = stream.chunkSizes ? (stream.chunkSizes[i] & ~COOKED_CHUNK_STORED) : chunk.rawSize;
+			chunk.isStored = !stream.chunkSizes || (stream.chunkSizes[i] & COOKED_CHUNK_STORED);
+			chunk.source = stream.data + sourceOffset;
+			chunk.destination = decode.destination + i * stream.chunkRawSize;
+			sourceOffset += chunk.storedSize;
+			chunks.push_back(chunk);
+		}
+	}
+
+	std::atomic<bool> failed(false);
+	JobSystem::GetInstance()->ParallelFor((unsigned int) chunks.size(), DECODE_BATCH_SIZE, [&chunks, &failed](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			if (!DecodeChunk(chunks[i], tDecodeScratch))
+			{
+				failed = true;
+			}
+		}
+	});
+
+	return !failed;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include "VertexLayout.h"
+#include "VertexInformation.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/vec3.hpp>
+
+// Everything ModelManager does to a model file before it can go on the GPU, without touching GL, so the asset
+// cooker (Tools/AssetCooker) can do it offline and the runtime only has to upload the result.
+// Models that weren't cooked go through the same code at load time.
+
+enum eCookFlags
+{
+	COOK_DEFAULT = 0,
+	COOK_PACKED_VERTICES = 1 << 0,		// Untextured meshes become sPackedColoredVertex
+	COOK_NO_VERTEX_COLORS = 1 << 1,		// Skip the file's vertex colors
+	COOK_FORCE_ASSIMP = 1 << 2,			// Don't use our own PLY and GLB loaders
+	COOK_DIRECT_UPLOAD = 1 << 3			// GLB meshes already in one of our layouts aren't copied or reordered, they end up in
+										// sCookedModel::directMeshes pointing into the file. Only for callers that keep it around until they're uploaded.
+};
+
+// The flags that change what comes out of the cooker, the rest only change how it gets there
+const unsigned int COOK_RESULT_FLAGS = COOK_PACKED_VERTICES | COOK_NO_VERTEX_COLORS;
+
+// Which loader read the source file
+enum eCookImporter
+{
+	COOK_IMPORTER_PLY,
+	COOK_IMPORTER_GLB,
+	COOK_IMPORTER_ASSIMP
+};
+
+// Worst difference between the packed vertices and the originals (all 0 if the mesh isn't packed)
+struct sPackingError
+{
+	float maxPositionError;			// In model units
+	float maxNormalErrorDegrees;
+	float maxColorError;			// In 0-1 color units
+};
+
+// A mesh ready to upload: vertices in their final layout and order, faces reordered for the vertex caches.
+// Indices are already 16 bit where every vertex fits (see Mesh), so both can be copied into GPU buffers as they are.
+struct sCookedMesh
+{
+	eVertexFormat vertexFormat = VERTEX_FORMAT_NONE;
+	unsigned int vertexStride = 0;
+	unsigned int vertexCount = 0;
+	std::vector<unsigned char> vertices;
+	unsigned int indexSize = sizeof(unsigned int);
+	unsigned int indexCount = 0;
+	std::vector<unsigned char> indices;
+
+	glm::vec3 boundsCenter = glm::vec3(0.0f);
+	glm::vec3 boundsHalfExtent = glm::vec3(1.0f); // Packed positions are relative to these
+	sPackingError packingError = { 0.0f, 0.0f, 0.0f };
+
+	// Post-transform cache misses (see MeshOptimizer.h) in the file's triangle order and after optimizing it
+	unsigned int cacheMissesBefore = 0;
+	unsigned int cacheMissesAfter = 0;
+
+	std::vector<std::string> diffuseTextures; // File names, looked for in the Textures folder next to the model
+};
+
+// How a stream of a cooked blob is stored. Every chunk is compressed on its own so they can be decoded in parallel.
+enum eCookedEncoding
+{
+	COOKED_ENCODING_RAW,
+	COOKED_ENCODING_LZ4,
+	COOKED_ENCODING_LZ4_DELTA_PLANES	// Byte i of every element grouped together and delta coded before LZ4 (like meshoptimizer's vertex codec),
+										// which turns vertex data that barely compresses into long runs of small values
+};
+
+// Raw bytes per chunk, rounded down to whole elements. Small enough to spread a single mesh over every core.
+const size_t COOKED_CHUNK_SIZE = 64 * 1024;
+
+// Chunk sizes with this bit set are stored uncompressed (didn't get any smaller), like the LZ4 frame format does it
+const uint32_t COOKED_CHUNK_STORED = 0x80000000u;
+
+struct sCookedStreamView
+{
+	const unsigned char* data;
+	size_t storedSize;
+	size_t rawSize;
+	eCookedEncoding encoding;
+	unsigned int elementSize;		// Vertex stride or index size
+	size_t chunkRawSize;
+	unsigned int chunkCount;
+	const uint32_t* chunkSizes;		// Stored size of every chunk, NULL for a raw stream in memory (see GetCookedMeshView)
+	unsigned int indexLimit;		// Index streams read from a file: the mesh's vertex count, every index is checked against it
+									// as it's decoded. 0 for vertex streams and our own cooker's output, which aren't checked.
+};
+
+// Same thing as sCookedMesh, pointing into a cooked blob (see ReadCookedModel) instead of owning the data
+struct sCookedMeshView
+{
+	eVertexFormat vertexFormat;
+	unsigned int vertexStride;
+	unsigned int vertexCount;
+	unsigned int indexSize;
+	unsigned int indexCount;
+	sCookedStreamView vertexStream;
+	sCookedStreamView indexStream;
+
+	glm::vec3 boundsCenter;
+	glm::vec3 boundsHalfExtent;
+	sPackingError packingError;
+	unsigned int cacheMissesBefore;
+	unsigned int cacheMissesAfter;
+
+	std::vector<std::string> diffuseTextures;
+};
+
+struct sCookedModel
+{
+	unsigned int cookFlags = COOK_DEFAULT;
+	eCookImporter importer = COOK_IMPORTER_ASSIMP;
+	std::vector<sCookedMesh> meshes;
+	std::vector<sCookedMeshView> directMeshes; // See COOK_DIRECT_UPLOAD, raw streams into the data CookModel was given
+	std::vector<unsigned int> directMeshOrder; // Where each of directMeshes goes among all the meshes, in the file's order
+};
+
+// Bump this whenever the cooked format or anything the cooker does to a mesh changes, so old cooked data gets rebuilt
+const uint32_t COOKED_MODEL_VERSION = 3;
+
+// Imports the model (PLY fast path, GLB loader or assimp, see LoadPly and LoadGlb), picks the smallest vertex layout for each mesh
+// (see ModelManager::LoadModel), optimizes it for the vertex caches and packs it if asked to.
+// Parses data if it isn't NULL, otherwise reads the file at path (COOK_DIRECT_UPLOAD needs data then).
+// Returns false and fills in error if it fails.
+bool CookModel(const std::string& path, const unsigned char* data, size_t size, unsigned int cookFlags, sCookedModel& model, std::string& error);
+
+// Quantizes the vertices into sPackedColoredVertex relative to their bounds, and measures how far off they are
+void PackColoredVertices(const std::vector<sColoredVertex>& vertices, std::vector<sPackedColoredVertex>& packedVertices, glm::vec3& boundsCenter, glm::vec3& boundsHalfExtent, sPackingError& packingError);
+
+// Cooked blob layout, little endian:
+//	header: "CMDL", version, cook flags, mesh count
+//	per mesh: sCookedMeshHeader, texture names (length + chars each)
+//	per mesh: the vertex and index streams, each a chunk size table and the chunks
+// The archive aligns every entry, so raw streams can be uploaded straight out of the mapping.
+// compress picks the smaller of the LZ4 encodings for every stream, otherwise they're written raw.
+void WriteCookedModel(const sCookedModel& model, std::vector<unsigned char>& output, bool compress);
+
+// True if data starts like a cooked blob (any version)
+bool IsCookedModel(const unsigned char* data, size_t size);
+
+// Zero copy, the views point into data. Returns false if it's not a cooked blob of this version or it's cut short.
+bool ReadCookedModel(const unsigned char* data, size_t size, unsigned int& cookFlags, std::vector<sCookedMeshView>& meshes);
+
+// A view of an in memory cooked mesh, its streams are raw
+sCookedMeshView GetCookedMeshView(const sCookedMesh& mesh);
+
+struct sStreamDecode
+{
+	const sCookedStreamView* stream;
+	unsigned char* destination;	// rawSize bytes, e.g. a mapped GPU buffer (written only, never read)
+};
+
+// Decodes every chunk of every stream across the job system (see JobSystem::ParallelFor).
+// Returns false if any chunk is corrupt, what's in the destinations is undefined then.
+bool DecodeCookedStreams(const std::vector<sStreamDecode>& decodes);
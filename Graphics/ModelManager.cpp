@@ -1,16 +1,18 @@
 #include "ModelManager.h"
 #include "VertexInformation.h"
 #include "Mesh.h"
+#include "ModelCooker.h"
+#include "AssetReader.h"
 #include "SOIL2.H"
 
 #include <iostream>
-
-#include <assimp/Importer.hpp>
-#include <assimp/postprocess.h> // Post processing flags
+#include <algorithm>
+#include <chrono>
 
 ModelManager* ModelManager::instance = NULL;
 
 ModelManager::ModelManager()
+	: cpuBytesReleased(0)
 {
 
 }
@@ -32,25 +34,43 @@ ModelManager* ModelManager::GetInstance()
 
 void ModelManager::CleanUp()
 {
-	std::map<std::string, Model*>::iterator it;
+	std::map<std::string, ModelHandle>::iterator it;
 	for (it = this->models.begin(); it != this->models.end(); it++)
 	{
-		delete it->second;
+		delete this->modelSlots.Get(it->second);
 	}
 
 	this->models.clear();
+	this->modelSlots.Clear();
 }
 
-void ModelManager::Draw(std::string friendlyName, const CompiledShader& shader, const glm::vec3& position, const glm::vec3& xRot, const glm::vec3& yRot, const glm::vec3& zRot, const glm::vec3& scale, float transparency)
+// What the load flags mean to the cooker
+static unsigned int GetCookFlags(unsigned int loadFlags)
 {
-	Model* model = this->GetModel(friendlyName);
-	if (model)
+	unsigned int cookFlags = COOK_DEFAULT;
+	if (loadFlags & ModelManager::LOAD_PACKED_VERTICES)
+	{
+		cookFlags |= COOK_PACKED_VERTICES;
+	}
+	if (loadFlags & ModelManager::LOAD_NO_VERTEX_COLORS)
 	{
-		model->Draw(shader, position, xRot, yRot, zRot, scale, transparency);
+		cookFlags |= COOK_NO_VERTEX_COLORS;
 	}
+	if (loadFlags & ModelManager::LOAD_FORCE_ASSIMP)
+	{
+		cookFlags |= COOK_FORCE_ASSIMP;
+	}
+
+	return cookFlags;
 }
 
-Model* ModelManager::LoadModel(std::string path, std::string friendlyName)
+// Where a mesh's texture is, the cooker only looks for them in the directory of the model + /Textures/
+static std::string GetTexturePath(const std::string& modelDirectory, const std::string& fileName)
+{
+	return modelDirectory + "Textures\\" + fileName;
+}
+
+Model* ModelManager::LoadModel(const std::string& path, const std::string& friendlyName, unsigned int loadFlags)
 {
 	if (this->models.find(friendlyName) != this->models.end())
 	{
@@ -58,125 +78,338 @@ Model* ModelManager::LoadModel(std::string path, std::string friendlyName)
 		return NULL;
 	}
 
-	Assimp::Importer importer;
+	std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
 
-	unsigned int flags = 0;
-	flags |= aiProcess_Triangulate; // Triangulates the faces (AKA: if there are models with faces > 3, it will turn them into triangles for us)
-	flags |= aiProcess_JoinIdenticalVertices; // Joins identical vertex data
-	flags |= aiProcess_GenSmoothNormals; // Generates smooth normals for all vertices in the mesh
+	Model* model = new Model();
+	model->directory = path.substr(0, path.find_last_of('\\')) + "\\";
+	model->fileName = path.substr(path.find_last_of('\\') + 1, path.length());
+	model->keepCPUData = (loadFlags & LOAD_KEEP_CPU_DATA) != 0;
+	model->packVertices = (loadFlags & LOAD_PACKED_VERTICES) != 0;
+	unsigned int cookFlags = GetCookFlags(loadFlags);
+
+	// Parse from memory if the file was read ahead of time (see LoadQueuedModels) or is in a mounted archive
+	sFileView preloadedView;
+	bool isPreloaded = AssetReader::GetInstance()->GetFile(path, preloadedView);
+
+	// Cooked archives (see Tools/AssetCooker) hold the finished meshes under the source file's name, those only need uploading
+	std::vector<sCookedMeshView> meshViews;
+	bool isCooked = isPreloaded && IsCookedModel(preloadedView.data, preloadedView.size);
+	if (isCooked)
+	{
+		unsigned int cookedFlags = 0;
+		if (!ReadCookedModel(preloadedView.data, preloadedView.size, cookedFlags, meshViews) || cookedFlags != (cookFlags & COOK_RESULT_FLAGS))
+		{
+			std::cout << "Cooked '" << model->fileName << "' is out of date or was cooked with other flags, loading the source file" << std::endl;
+			meshViews.clear();
+			isCooked = false;
+
+			// What's in memory is the cooked data. The source is in an archive mounted before the cooked one, or on disk.
+			sFileView sourceView;
+			isPreloaded = VirtualFileSystem::GetInstance()->FindUnder(path, preloadedView, sourceView) && !IsCookedModel(sourceView.data, sourceView.size);
+			if (isPreloaded)
+			{
+				preloadedView = sourceView;
+			}
+		}
+	}
 
-	const aiScene* scene = importer.ReadFile(path, flags);
+	// Anything that wasn't cooked goes through the same code the cooker uses. What's in memory stays there until the
+	// meshes are uploaded, so GLB buffers that are already in our layouts can go to the GPU straight from it.
+	sCookedModel cookedModel;
+	if (!isCooked)
+	{
+		std::string error;
+		if (!CookModel(path, isPreloaded ? preloadedView.data : NULL, isPreloaded ? preloadedView.size : 0, isPreloaded ? cookFlags | COOK_DIRECT_UPLOAD : cookFlags, cookedModel, error))
+		{
+			std::cout << "Failed to load model! " << error << std::endl;
+			delete model;
+			return NULL;
+		}
+
+		// The direct meshes go back between the converted ones where they were in the file
+		size_t meshCount = cookedModel.meshes.size() + cookedModel.directMeshes.size();
+		size_t convertedIndex = 0;
+		size_t directIndex = 0;
+		for (size_t i = 0; i < meshCount; i++)
+		{
+			if (directIndex < cookedModel.directMeshes.size() && cookedModel.directMeshOrder[directIndex] == i)
+			{
+				meshViews.push_back(cookedModel.directMeshes[directIndex++]);
+				continue;
+			}
+
+			const sCookedMesh& mesh = cookedModel.meshes[convertedIndex++];
+			meshViews.push_back(GetCookedMeshView(mesh));
+			if (!model->keepCPUData) // Only these had a CPU copy, direct and cooked meshes go from the file to the GPU
+			{
+				this->cpuBytesReleased += mesh.vertices.size() + mesh.indices.size();
+			}
+		}
+	}
 
-	if (!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+	// Read the textures the meshes use in one batch too, LoadTexture decodes them from memory (see AddCookedMesh)
+	AssetReader* reader = AssetReader::GetInstance();
+	std::vector<std::string> texturePaths;
+	for (const sCookedMeshView& meshView : meshViews)
 	{
-		std::cout << "Failed to load model!" << std::endl;
-		return NULL;
+		for (const std::string& fileName : meshView.diffuseTextures)
+		{
+			std::string texturePath = GetTexturePath(model->directory, fileName);
+			sFileView textureView;
+			if (!TextureManager::GetInstance()->GetTextureFromPath(texturePath) && !reader->GetFile(texturePath, textureView)
+				&& std::find(texturePaths.begin(), texturePaths.end(), texturePath) == texturePaths.end())
+			{
+				reader->Request(texturePath);
+				texturePaths.push_back(texturePath);
+			}
+		}
+	}
+	if (!texturePaths.empty())
+	{
+		reader->ReadRequested(); // Any that can't be read are loaded from disk as before, and fail there
 	}
 
-	Model* model = new Model();
-	model->directory = path.substr(0, path.find_last_of('\\')) + "\\";
-	model->fileName = path.substr(path.find_last_of('\\') + 1, path.length());
+	model->meshes.reserve(meshViews.size()); // The meshes can't move while they're mapped
+	std::vector<sStreamDecode> decodes;
+	size_t storedBytes = 0;
+	for (const sCookedMeshView& meshView : meshViews)
+	{
+		Mesh& mesh = this->AddCookedMesh(model, meshView);
+		if (mesh.mappedVertices)
+		{
+			decodes.push_back({ &meshView.vertexStream, mesh.mappedVertices });
+		}
+		if (mesh.mappedIndices)
+		{
+			decodes.push_back({ &meshView.indexStream, mesh.mappedIndices });
+		}
+		storedBytes += meshView.vertexStream.storedSize + meshView.indexStream.storedSize;
+	}
+
+	for (const std::string& texturePath : texturePaths)
+	{
+		reader->Release(texturePath);
+	}
 
-	this->LoadAssimpNode(model, scene->mRootNode, scene);
+	// Every chunk of every mesh at once, across the job system, straight into the mapped buffers
+	std::chrono::steady_clock::time_point decodeStart = std::chrono::steady_clock::now();
+	bool isDecoded = DecodeCookedStreams(decodes);
+	double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeStart).count();
 
-	if (model)
+	for (size_t i = 0; i < model->meshes.size(); i++)
 	{
-		this->models.insert(std::make_pair(friendlyName, model));
-		return model;
+		isDecoded &= model->meshes[i].FinishCookedUpload(meshViews[i], model->keepCPUData);
 	}
 
-	return NULL;
+	if (!isDecoded)
+	{
+		std::cout << "Cooked '" << model->fileName << "' is corrupt!" << std::endl;
+		delete model;
+		return NULL;
+	}
+
+	double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+	sLoadTimes& loadTimes = isCooked ? this->cookedLoadTimes
+		: cookedModel.importer == COOK_IMPORTER_PLY ? this->plyLoadTimes
+		: cookedModel.importer == COOK_IMPORTER_GLB ? this->glbLoadTimes
+		: this->assimpLoadTimes;
+	loadTimes.modelCount++;
+	loadTimes.directMeshCount += (unsigned int) cookedModel.directMeshes.size();
+	loadTimes.triangleCount += model->triangleCount;
+	loadTimes.seconds += loadSeconds;
+	loadTimes.storedBytes += storedBytes;
+	for (const sStreamDecode& decode : decodes)
+	{
+		loadTimes.decodedBytes += decode.stream->rawSize;
+	}
+	loadTimes.decodeSeconds += decodeSeconds;
+
+	this->models.insert(std::make_pair(friendlyName, this->modelSlots.Add(model)));
+	return model;
 }
 
+void ModelManager::QueueModel(const std::string& path, const std::string& friendlyName, unsigned int loadFlags)
+{
+	sQueuedModel queued;
+	queued.path = path;
+	queued.friendlyName = friendlyName;
+	queued.loadFlags = loadFlags;
+	this->queuedModels.push_back(queued);
+}
 
-void ModelManager::LoadAssimpNode(Model* model, aiNode* node, const aiScene* scene)
+bool ModelManager::LoadQueuedModels()
 {
-	// Process assimp meshes
-	for (unsigned int i = 0; i < node->mNumMeshes; i++)
+	// Read every file in one batch so the disk latency overlaps, then parse them one by one from memory
+	AssetReader* reader = AssetReader::GetInstance();
+	for (const sQueuedModel& queued : this->queuedModels)
 	{
-		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		model->meshes.push_back(this->LoadAssimpMesh(model, mesh, scene));
+		reader->Request(queued.path);
 	}
+	reader->ReadRequested();
+	reader->PrintLastBatchReport();
 
-	// Recursivley processes child nodes
-	for (unsigned int i = 0; i < node->mNumChildren; i++)
+	bool success = true;
+	for (const sQueuedModel& queued : this->queuedModels)
 	{
-		this->LoadAssimpNode(model, node->mChildren[i], scene);
+		success &= this->LoadModel(queued.path, queued.friendlyName, queued.loadFlags) != NULL;
 	}
+
+	for (const sQueuedModel& queued : this->queuedModels) // After all of them, models can share files
+	{
+		reader->Release(queued.path);
+	}
+
+	this->queuedModels.clear();
+	return success;
 }
 
-Model* ModelManager::GetModel(std::string friendlyName)
+void ModelManager::PrintMemoryReport() const
 {
-	std::map<std::string, Model*>::iterator it = this->models.find(friendlyName);
-	if (it != this->models.end())
+	size_t gpuBytes = 0;
+	size_t cpuBytesKept = 0;
+	unsigned int modelsKeepingData = 0;
+
+	std::map<std::string, ModelHandle>::const_iterator it;
+	for (it = this->models.begin(); it != this->models.end(); it++)
 	{
-		return it->second;
+		const Model* model = this->modelSlots.Get(it->second);
+		gpuBytes += model->GetGPUBytes();
+		cpuBytesKept += model->GetCPUBytes();
+		if (model->HasCPUData())
+		{
+			modelsKeepingData++;
+		}
 	}
 
-	return NULL;
+	std::cout << "Geometry memory for " << this->models.size() << " models:" << std::endl;
+	std::cout << "  GPU: " << gpuBytes / 1024 << " KB" << std::endl;
+	std::cout << "  CPU copies released after upload: " << this->cpuBytesReleased / 1024 << " KB" << std::endl;
+	std::cout << "  CPU copies kept (" << modelsKeepingData << " models): " << cpuBytesKept / 1024 << " KB" << std::endl;
 }
 
-Mesh ModelManager::LoadAssimpMesh(Model* model, aiMesh* mesh, const aiScene* scene)
+void ModelManager::PrintPackingReport() const
 {
-	std::vector<sColoredVertex> vertices;
-	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+	std::map<std::string, ModelHandle>::const_iterator it;
+	for (it = this->models.begin(); it != this->models.end(); it++)
 	{
-		sColoredVertex vertex;
-		vertex.x = mesh->mVertices[i].x;
-		vertex.y = mesh->mVertices[i].y;
-		vertex.z = mesh->mVertices[i].z;
+		const Model* model = this->modelSlots.Get(it->second);
+		if (!model->HasPackedVertices())
+		{
+			continue;
+		}
+
+		// Worst mesh of the model, position error also as a fraction of the mesh size since that's what you'd actually see
+		sPackingError worst = { 0.0f, 0.0f, 0.0f };
+		float worstRelativePositionError = 0.0f;
+		for (const Mesh& mesh : model->meshes)
+		{
+			if (!mesh.IsPacked()) // Textured meshes keep their own layout
+			{
+				continue;
+			}
+
+			const sPackingError& error = mesh.GetPackingError();
+			worst.maxPositionError = std::max(worst.maxPositionError, error.maxPositionError);
+			worst.maxNormalErrorDegrees = std::max(worst.maxNormalErrorDegrees, error.maxNormalErrorDegrees);
+			worst.maxColorError = std::max(worst.maxColorError, error.maxColorError);
+
+			glm::vec3 halfExtent = mesh.GetBoundsHalfExtent();
+			float size = std::max(halfExtent.x, std::max(halfExtent.y, halfExtent.z)) * 2.0f;
+			worstRelativePositionError = std::max(worstRelativePositionError, error.maxPositionError / size);
+		}
+
+		std::cout << "Packed '" << it->first << "' (" << sizeof(sColoredVertex) << " -> " << sizeof(sPackedColoredVertex) << " bytes a vertex): "
+			<< "position error " << worst.maxPositionError << " (" << worstRelativePositionError * 100.0f << "% of its size), "
+			<< "normal error " << worst.maxNormalErrorDegrees << " degrees, "
+			<< "color error " << worst.maxColorError * 255.0f << "/255" << std::endl;
+	}
+}
 
-		vertex.nx = mesh->mNormals[i].x;
-		vertex.ny = mesh->mNormals[i].y;
-		vertex.nz = mesh->mNormals[i].z;
+void ModelManager::PrintLoadReport() const
+{
+	const sLoadTimes* loadTimes[4] = { &this->cookedLoadTimes, &this->plyLoadTimes, &this->glbLoadTimes, &this->assimpLoadTimes };
+	const char* names[4] = { "Cooked", "PLY fast path", "GLB", "Assimp" };
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		if (loadTimes[i]->modelCount == 0)
+		{
+			continue;
+		}
 
-		vertex.r = mesh->mColors[0][i].r;
-		vertex.g = mesh->mColors[0][i].g;
-		vertex.b = mesh->mColors[0][i].b;
-		vertex.a = mesh->mColors[0][i].a;
+		std::cout << names[i] << ": " << loadTimes[i]->modelCount << " models, " << loadTimes[i]->triangleCount << " triangles in "
+			<< loadTimes[i]->seconds * 1000.0 << " ms (" << loadTimes[i]->seconds * 1000000.0 / std::max(1u, loadTimes[i]->triangleCount) << " us a triangle)" << std::endl;
 
-		vertices.push_back(vertex);
+		// Decoding into the mapped buffers, for cooked models this is the part that used to be bound by the disk
+		double decodedMB = loadTimes[i]->decodedBytes / (1024.0 * 1024.0);
+		std::cout << "  " << decodedMB << " MB of geometry from " << loadTimes[i]->storedBytes / (1024.0 * 1024.0) << " MB stored, decoded in "
+			<< loadTimes[i]->decodeSeconds * 1000.0 << " ms (" << decodedMB / std::max(loadTimes[i]->decodeSeconds, 1e-9) << " MB/s)" << std::endl;
+		if (loadTimes[i]->directMeshCount > 0)
+		{
+			std::cout << "  " << loadTimes[i]->directMeshCount << " meshes uploaded straight from the file, no conversion" << std::endl;
+		}
 	}
+}
 
-	std::vector<sTriangle> faces;
-	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+void ModelManager::PrintVertexCacheReport() const
+{
+	std::map<std::string, ModelHandle>::const_iterator it;
+	for (it = this->models.begin(); it != this->models.end(); it++)
 	{
-		sTriangle face;
-		aiFace assimpFace = mesh->mFaces[i];
-		if (assimpFace.mNumIndices != 3)
+		const Model* model = this->modelSlots.Get(it->second);
+		if (model->triangleCount == 0)
 		{
-			std::cout << "Face is not a triangle!" << std::endl;
+			continue;
 		}
 
-		for (unsigned int j = 0; j < assimpFace.mNumIndices; j++)
+		unsigned int shortIndexMeshes = 0;
+		for (const Mesh& mesh : model->meshes)
 		{
-			face.vertIndex[j] = assimpFace.mIndices[j];
+			if (mesh.HasShortIndices())
+			{
+				shortIndexMeshes++;
+			}
 		}
 
-		faces.push_back(face);
+		std::cout << "Vertex cache '" << it->first << "' (" << model->triangleCount << " triangles): ACMR "
+			<< (float) model->cacheMissesBefore / model->triangleCount << " -> " << (float) model->cacheMissesAfter / model->triangleCount
+			<< ", 16 bit indices on " << shortIndexMeshes << "/" << model->meshes.size() << " meshes" << std::endl;
 	}
-
-	return Mesh(vertices, faces);
 }
 
-std::vector<Texture*> ModelManager::LoadAssimpMaterialTextures(aiMaterial* material, aiTextureType type, TextureManager::TextureType textureType, const std::string& rootPath)
+Model* ModelManager::GetModel(const std::string& friendlyName)
 {
-	std::vector<Texture*> textures;
+	return this->modelSlots.Get(this->GetModelHandle(friendlyName));
+}
 
-	for (unsigned int i = 0; i < material->GetTextureCount(type); i++)
+ModelHandle ModelManager::GetModelHandle(const std::string& friendlyName)
+{
+	std::map<std::string, ModelHandle>::iterator it = this->models.find(friendlyName);
+	if (it != this->models.end())
 	{
-		aiString str;
-		material->GetTexture(type, i, &str);
-		std::string filePath(str.C_Str());
-		std::string fileName = filePath.substr(filePath.find_last_of("\\") + 1, filePath.length());
+		return it->second;
+	}
 
-		std::string lookForPath = rootPath + "Textures\\" + fileName; // Look for the texture file in the directory of the model + /Textures/
-		Texture* texture = TextureManager::GetInstance()->LoadTexture(lookForPath, textureType, fileName);
-		if (texture)
+	return ModelHandle();
+}
+
+Mesh& ModelManager::AddCookedMesh(Model* model, const sCookedMeshView& cooked)
+{
+	model->triangleCount += cooked.indexCount / 3;
+	model->cacheMissesBefore += cooked.cacheMissesBefore;
+	model->cacheMissesAfter += cooked.cacheMissesAfter;
+
+	model->meshes.emplace_back(cooked);
+
+	// The cooker only kept the textures it found
+	Mesh& mesh = model->meshes.back();
+	for (const std::string& fileName : cooked.diffuseTextures)
+	{
+		TextureHandle texture = TextureManager::GetInstance()->LoadTexture(GetTexturePath(model->directory, fileName), TextureManager::Diffuse, fileName);
+		if (texture.IsValid())
 		{
-			textures.push_back(texture);
+			mesh.textures.push_back(texture);
 		}
 	}
 
-	return textures;
+	return mesh;
 }
\ No newline at end of file
@@ -3,11 +3,11 @@
 #include "Model.h"
 #include "Texture.h"
 #include "TextureManager.h"
+#include "ResourceHandle.h"
+#include "ModelCooker.h"
 
 #include <map>
 #include <string>
-#include <assimp/scene.h>
-#include <assimp/material.h>
 
 class ModelManager
 {
@@ -16,27 +16,93 @@ public:
 
 	static ModelManager* GetInstance();
 
-	// Loads the model from file
-	Model* LoadModel(std::string path, std::string friendlyName);
+	enum LoadFlags
+	{
+		LOAD_DEFAULT = 0,
+		LOAD_KEEP_CPU_DATA = 1 << 0,	// Keep the vertices/faces on the CPU after uploading them (e.g. the model is used for picking)
+		LOAD_PACKED_VERTICES = 1 << 1,	// Upload sPackedColoredVertex instead of sColoredVertex (16 bytes a vertex instead of 40)
+		LOAD_NO_VERTEX_COLORS = 1 << 2,	// Skip the file's vertex colors, for models that are always drawn with a color override
+		LOAD_FORCE_ASSIMP = 1 << 3		// Don't use the PLY fast path or the GLB loader (e.g. to compare load times)
+	};
 
-	Model* GetModel(std::string friendlyName);
+	// Loads the model from file. The vertices/faces are freed once they're on the GPU unless LOAD_KEEP_CPU_DATA is set.
+	// If a mounted archive has it cooked (see Tools/AssetCooker) with the same flags, the cooked meshes are uploaded as they are.
+	// Otherwise it's cooked now (see ModelCooker.h): PLY files go through LoadPly (see PlyLoader.h), GLB files through LoadGlb
+	// (see GlbLoader.h), anything those can't read and every other format goes through assimp.
+	// GLB meshes whose buffers already are sPositionNormalVertex or sColoredVertex are uploaded straight from the file
+	// when it's in memory (queued or in an archive), without converting or reordering them.
+	// Each mesh is loaded into the smallest layout it needs (see VertexLayout.h):
+	//	sColoredVertex (or sPackedColoredVertex) if it has vertex colors,
+	//	sVertex if it has UVs and a diffuse texture but no colors,
+	//	sPositionNormalVertex otherwise (packed meshes use sPackedColoredVertex here too, it's still smaller).
+	// The triangles and vertices are reordered for the vertex caches, and uploaded with 16 bit indices where they fit.
+	Model* LoadModel(const std::string& path, const std::string& friendlyName, unsigned int loadFlags = LOAD_DEFAULT);
 
-	void Draw(std::string friendlyName, const CompiledShader& shader, const glm::vec3& position, const glm::vec3& xRot, const glm::vec3& yRot, const glm::vec3& zRot, const glm::vec3& scale, float transparency);
+	// Queues a model for LoadQueuedModels
+	void QueueModel(const std::string& path, const std::string& friendlyName, unsigned int loadFlags = LOAD_DEFAULT);
+
+	// Reads the files of every queued model in one batch (see AssetReader), then loads them like LoadModel.
+	// Returns false if any of them failed to load.
+	bool LoadQueuedModels();
+
+	// Name lookups, meant for load time. Resolve a handle once and use that when drawing.
+	Model* GetModel(const std::string& friendlyName);
+
+	ModelHandle GetModelHandle(const std::string& friendlyName);
+
+	// O(1), returns NULL if the handle is no longer valid
+	inline Model* GetModel(ModelHandle handle) const
+	{
+		return this->modelSlots.Get(handle);
+	}
 
 	void CleanUp();
 
-private:
-	// Loads an assimp node
-	void LoadAssimpNode(Model* model, aiNode* node, const aiScene* scene);
+	// Prints how much geometry is on the GPU, and how much CPU memory was freed by not keeping copies of it
+	void PrintMemoryReport() const;
+
+	// Prints how long cooked models, the PLY fast path, the GLB loader and assimp took for the models each of them loaded,
+	// and how fast their geometry was decoded into the GPU buffers
+	void PrintLoadReport() const;
 
-	// Loads a mesh from assimp
-	Mesh LoadAssimpMesh(Model* model, aiMesh* mesh, const aiScene* scene);
+	// Prints the ACMR (average cache miss ratio, see MeshOptimizer.h) of every model before and after reordering it on load
+	void PrintVertexCacheReport() const;
 
-	// Loads assimp material textures int our texture struct
-	std::vector<Texture*> LoadAssimpMaterialTextures(aiMaterial* material, aiTextureType type, TextureManager::TextureType textureType, const std::string& rootPath);
+	// Prints how far the packed vertices of every packed model are from the originals
+	void PrintPackingReport() const;
+
+private:
+	// Adds a cooked mesh to the model's mesh list with its buffers mapped (see Mesh), and loads its textures
+	Mesh& AddCookedMesh(Model* model, const sCookedMeshView& cooked);
 
 	ModelManager();
 
 	static ModelManager* instance;
-	std::map<std::string, Model*> models;
+	std::map<std::string, ModelHandle> models;
+	HandleSlots<Model> modelSlots;
+
+	size_t cpuBytesReleased; // Geometry we didn't keep on the CPU after uploading it
+
+	struct sLoadTimes
+	{
+		unsigned int modelCount = 0;
+		unsigned int triangleCount = 0;
+		double seconds = 0.0;
+		size_t storedBytes = 0;
+		size_t decodedBytes = 0;
+		double decodeSeconds = 0.0;
+		unsigned int directMeshCount = 0; // See COOK_DIRECT_UPLOAD
+	};
+	struct sQueuedModel
+	{
+		std::string path;
+		std::string friendlyName;
+		unsigned int loadFlags;
+	};
+	std::vector<sQueuedModel> queuedModels;
+
+	sLoadTimes cookedLoadTimes;
+	sLoadTimes plyLoadTimes;
+	sLoadTimes glbLoadTimes;
+	sLoadTimes assimpLoadTimes;
 };
\ No newline at end of file
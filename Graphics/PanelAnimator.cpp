@@ -0,0 +1,206 @@
+#include "PanelAnimator.h"
+#include "SimdLevel.h"
+
+#include <algorithm>
+#include <glm/glm.hpp>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PANEL_ANIMATOR_X86
+#include <immintrin.h>
+#endif
+
+// Like VertexConversion, GCC and Clang only compile intrinsics in functions marked for them
+#if defined(_MSC_VER)
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// offset = max(offset + rate * deltaTime, 0) for panels first to count-1, keeping the old offset. Reference for the
+// SIMD paths, and what they leave over at the end.
+static void AdvanceOffsetsScalar(float* offsets, float* previousOffsets, const float* rates, float deltaTime, unsigned int first, unsigned int count)
+{
+	for (unsigned int i = first; i < count; i++)
+	{
+		previousOffsets[i] = offsets[i];
+		offsets[i] = std::max(offsets[i] + rates[i] * deltaTime, 0.0f);
+	}
+}
+
+#ifdef PANEL_ANIMATOR_X86
+TARGET_SSE2 static unsigned int AdvanceOffsetsSse2(float* offsets, float* previousOffsets, const float* rates, float deltaTime, unsigned int count)
+{
+	__m128 step = _mm_set1_ps(deltaTime);
+	__m128 zero = _mm_setzero_ps();
+	unsigned int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 offset = _mm_loadu_ps(offsets + i);
+		_mm_storeu_ps(previousOffsets + i, offset);
+		offset = _mm_add_ps(offset, _mm_mul_ps(_mm_loadu_ps(rates + i), step));
+		_mm_storeu_ps(offsets + i, _mm_max_ps(offset, zero));
+	}
+
+	return i;
+}
+
+TARGET_AVX2 static unsigned int AdvanceOffsetsAvx2(float* offsets, float* previousOffsets, const float* rates, float deltaTime, unsigned int count)
+{
+	__m256 step = _mm256_set1_ps(deltaTime);
+	__m256 zero = _mm256_setzero_ps();
+	unsigned int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 offset = _mm256_loadu_ps(offsets + i);
+		_mm256_storeu_ps(previousOffsets + i, offset);
+		offset = _mm256_add_ps(offset, _mm256_mul_ps(_mm256_loadu_ps(rates + i), step));
+		_mm256_storeu_ps(offsets + i, _mm256_max_ps(offset, zero));
+	}
+
+	return i;
+}
+#endif
+
+PanelAnimator::PanelAnimator()
+{
+
+}
+
+unsigned int PanelAnimator::AddLine(const glm::vec3& openDirection, float speed, eSequence sequence)
+{
+	sLine line;
+	line.openDirection = glm::normalize(openDirection);
+	line.speed = speed;
+	line.sequence = sequence;
+	line.state = LINE_IDLE;
+	line.firstPanel = (unsigned int) this->offsets.size();
+	line.panelCount = 0;
+	line.openingStep = 0;
+	this->lines.push_back(line);
+	return (unsigned int) this->lines.size() - 1;
+}
+
+unsigned int PanelAnimator::AddPanel(const glm::vec3& closedPosition, float openedDistance)
+{
+	this->lines.back().panelCount++;
+
+	this->offsets.push_back(0.0f);
+	this->previousOffsets.push_back(0.0f);
+	this->rates.push_back(0.0f);
+	this->openedDistances.push_back(openedDistance);
+	this->closedPositions.push_back(closedPosition);
+	this->panelLines.push_back((unsigned int) this->lines.size() - 1);
+	return (unsigned int) this->offsets.size() - 1;
+}
+
+void PanelAnimator::Open(unsigned int lineIndex)
+{
+	sLine& line = this->lines[lineIndex];
+	line.state = LINE_OPENING;
+
+	// Carry on from the first panel that isn't open yet
+	line.openingStep = 0;
+	this->SkipOpenedPanels(line);
+	this->SetLineRates(line);
+}
+
+void PanelAnimator::Close(unsigned int lineIndex)
+{
+	sLine& line = this->lines[lineIndex];
+	line.state = LINE_CLOSING;
+	this->SetLineRates(line);
+}
+
+void PanelAnimator::Update(float deltaTime)
+{
+	this->events.clear();
+
+	float* offsets = this->offsets.data();
+	float* previousOffsets = this->previousOffsets.data();
+	const float* rates = this->rates.data();
+	unsigned int count = (unsigned int) this->offsets.size();
+	unsigned int done = 0;
+#ifdef PANEL_ANIMATOR_X86
+	eSimdLevel level = GetSimdLevel();
+	if (level == SIMD_AVX2)
+	{
+		done = AdvanceOffsetsAvx2(offsets, previousOffsets, rates, deltaTime, count);
+	}
+	else if (level == SIMD_SSE2)
+	{
+		done = AdvanceOffsetsSse2(offsets, previousOffsets, rates, deltaTime, count);
+	}
+#endif
+	AdvanceOffsetsScalar(offsets, previousOffsets, rates, deltaTime, done, count);
+
+	// Only the panel each moving line is waiting on gets looked at
+	for (unsigned int lineIndex = 0; lineIndex < this->lines.size(); lineIndex++)
+	{
+		sLine& line = this->lines[lineIndex];
+		if (line.state == LINE_OPENING)
+		{
+			unsigned int openingStep = line.openingStep;
+			this->SkipOpenedPanels(line);
+
+			if (line.openingStep == line.panelCount)
+			{
+				line.state = LINE_IDLE;
+				this->events.push_back({ lineIndex, PANEL_LINE_OPENED });
+			}
+
+			if (line.openingStep != openingStep)
+			{
+				this->SetLineRates(line);
+			}
+		}
+		else if (line.state == LINE_CLOSING)
+		{
+			// The first panel in the sequence slid the furthest, the rest are closed by the time it is
+			if (line.panelCount == 0 || this->offsets[this->GetSequencePanel(line, 0)] <= 0.0f)
+			{
+				line.state = LINE_IDLE;
+				this->SetLineRates(line);
+				this->events.push_back({ lineIndex, PANEL_LINE_CLOSED });
+			}
+		}
+	}
+}
+
+unsigned int PanelAnimator::GetSequencePanel(const sLine& line, unsigned int step) const
+{
+	return line.sequence == SEQUENCE_FORWARD ? line.firstPanel + step : line.firstPanel + line.panelCount - 1 - step;
+}
+
+void PanelAnimator::SkipOpenedPanels(sLine& line) const
+{
+	while (line.openingStep < line.panelCount)
+	{
+		unsigned int panel = this->GetSequencePanel(line, line.openingStep);
+		if (this->offsets[panel] < this->openedDistances[panel])
+		{
+			break;
+		}
+
+		line.openingStep++;
+	}
+}
+
+void PanelAnimator::SetLineRates(const sLine& line)
+{
+	for (unsigned int step = 0; step < line.panelCount; step++)
+	{
+		float rate = 0.0f;
+		if (line.state == LINE_OPENING && step <= line.openingStep && line.openingStep < line.panelCount)
+		{
+			rate = line.speed;
+		}
+		else if (line.state == LINE_CLOSING)
+		{
+			rate = -line.speed;
+		}
+
+		this->rates[this->GetSequencePanel(line, step)] = rate;
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <vector>
+#include <glm/vec3.hpp>
+
+enum ePanelEventType
+{
+	PANEL_LINE_OPENED,
+	PANEL_LINE_CLOSED
+};
+
+// A line that finished moving during the last Update
+struct sPanelEvent
+{
+	unsigned int line;
+	ePanelEventType type;
+};
+
+// Slides lines of wall panels open and shut, like the hangar doors. Opening is sequenced: the first panel slides until
+// it's open, then it and the next one slide together, and so on, so the panels end up stacked behind each other.
+// Closing slides every panel back at once. How far each panel is along its line is kept in flat arrays, so Update is
+// one SIMD pass over all of them however many lines there are, plus a check per line. Lines report finishing through
+// GetEvents instead of reaching into whatever should react.
+class PanelAnimator
+{
+public:
+	enum eSequence
+	{
+		SEQUENCE_FORWARD,	// The first panel added opens first
+		SEQUENCE_REVERSE	// The last panel added opens first
+	};
+
+	PanelAnimator();
+
+	// speed is in units a second along openDirection
+	unsigned int AddLine(const glm::vec3& openDirection, float speed, eSequence sequence);
+
+	// Panels go on the last line added, in order
+	unsigned int AddPanel(const glm::vec3& closedPosition, float openedDistance);
+
+	// Starts the line moving from wherever it is, turning around if it was going the other way
+	void Open(unsigned int line);
+	void Close(unsigned int line);
+
+	// Moves every panel and collects the events of the lines that finished
+	void Update(float deltaTime);
+
+	// What finished during the last Update
+	inline const std::vector<sPanelEvent>& GetEvents() const
+	{
+		return this->events;
+	}
+
+	// alpha is how far between the last two Updates, 0 is before the last one and 1 after it
+	inline glm::vec3 GetPosition(unsigned int panel, float alpha) const
+	{
+		float offset = this->previousOffsets[panel] + (this->offsets[panel] - this->previousOffsets[panel]) * alpha;
+		return this->closedPositions[panel] + this->lines[this->panelLines[panel]].openDirection * offset;
+	}
+
+	inline unsigned int GetPanelCount() const
+	{
+		return (unsigned int) this->offsets.size();
+	}
+
+	inline unsigned int GetLineCount() const
+	{
+		return (unsigned int) this->lines.size();
+	}
+
+private:
+	enum eLineState
+	{
+		LINE_IDLE,
+		LINE_OPENING,
+		LINE_CLOSING
+	};
+
+	struct sLine
+	{
+		glm::vec3 openDirection; // Normalized
+		float speed;
+		eSequence sequence;
+		eLineState state;
+		unsigned int firstPanel;
+		unsigned int panelCount;
+		unsigned int openingStep; // While opening, steps before this one are open and still sliding along
+	};
+
+	std::vector<sLine> lines;
+
+	// Per panel, the hot ones first. Offsets are how far the panel is from closed along its line.
+	std::vector<float> offsets;
+	std::vector<float> previousOffsets;
+	std::vector<float> rates;			// Offset a second, what Update adds
+	std::vector<float> openedDistances;
+	std::vector<glm::vec3> closedPositions;
+	std::vector<unsigned int> panelLines;
+
+	std::vector<sPanelEvent> events;
+
+	// The panel that opens at step of the line's sequence
+	unsigned int GetSequencePanel(const sLine& line, unsigned int step) const;
+
+	// Moves the line's openingStep past the panels that are open
+	void SkipOpenedPanels(sLine& line) const;
+
+	// Sets the rates of the line's panels for its state
+	void SetLineRates(const sLine& line);
+};
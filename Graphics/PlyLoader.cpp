@@ -0,0 +1,772 @@
+#include "PlyLoader.h"
+#include "MappedFile.h"
+#include "SimdLevel.h"
+
+#include <cstring>
+#include <cstdint>
+#include <sstream>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PLY_LOADER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// Like VertexConversion, GCC and Clang only compile intrinsics in functions marked for them
+#if defined(_MSC_VER)
+#define TARGET_SSE2
+#else
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#endif
+
+enum ePlyType
+{
+	PLY_INVALID,
+	PLY_INT8,
+	PLY_UINT8,
+	PLY_INT16,
+	PLY_UINT16,
+	PLY_INT32,
+	PLY_UINT32,
+	PLY_FLOAT32,
+	PLY_FLOAT64
+};
+
+enum ePlyFormat
+{
+	PLY_ASCII,
+	PLY_BINARY_LITTLE_ENDIAN,
+	PLY_BINARY_BIG_ENDIAN
+};
+
+// Where a vertex property goes in sColoredVertex
+enum ePlyTarget
+{
+	TARGET_SKIP = -1,
+	TARGET_X,
+	TARGET_Y,
+	TARGET_Z,
+	TARGET_NX,
+	TARGET_NY,
+	TARGET_NZ,
+	TARGET_R,
+	TARGET_G,
+	TARGET_B,
+	TARGET_A,
+	TARGET_COUNT
+};
+
+struct sPlyProperty
+{
+	ePlyType type;
+	bool isList;
+	ePlyType countType; // Only for lists
+	int target;			// ePlyTarget for vertices
+	bool isFaceIndices;	// The vertex_indices list of a face
+};
+
+struct sPlyElement
+{
+	std::string name;
+	size_t count;
+	std::vector<sPlyProperty> properties;
+};
+
+static ePlyType ParsePlyType(const std::string& name)
+{
+	if (name == "char" || name == "int8") return PLY_INT8;
+	if (name == "uchar" || name == "uint8") return PLY_UINT8;
+	if (name == "short" || name == "int16") return PLY_INT16;
+	if (name == "ushort" || name == "uint16") return PLY_UINT16;
+	if (name == "int" || name == "int32") return PLY_INT32;
+	if (name == "uint" || name == "uint32") return PLY_UINT32;
+	if (name == "float" || name == "float32") return PLY_FLOAT32;
+	if (name == "double" || name == "float64") return PLY_FLOAT64;
+	return PLY_INVALID;
+}
+
+static size_t PlyTypeSize(ePlyType type)
+{
+	switch (type)
+	{
+	case PLY_INT8: case PLY_UINT8: return 1;
+	case PLY_INT16: case PLY_UINT16: return 2;
+	case PLY_INT32: case PLY_UINT32: case PLY_FLOAT32: return 4;
+	case PLY_FLOAT64: return 8;
+	default: return 0;
+	}
+}
+
+// What an integer color channel of this type divides by to get 0-1 (assimp does the same)
+static float PlyColorScale(ePlyType type)
+{
+	switch (type)
+	{
+	case PLY_UINT8: return 1.0f / 255.0f;
+	case PLY_UINT16: return 1.0f / 65535.0f;
+	default: return 1.0f;
+	}
+}
+
+static int PlyVertexTarget(const std::string& name)
+{
+	static const char* names[TARGET_COUNT] = { "x", "y", "z", "nx", "ny", "nz", "red", "green", "blue", "alpha" };
+	for (int i = 0; i < TARGET_COUNT; i++)
+	{
+		if (name == names[i])
+		{
+			return i;
+		}
+	}
+
+	return TARGET_SKIP;
+}
+
+// Reads one binary value of the given type, swapping the bytes if the file's endianness isn't ours
+static double ReadPlyBinary(const unsigned char*& cursor, ePlyType type, bool swapBytes)
+{
+	unsigned char bytes[8];
+	size_t size = PlyTypeSize(type);
+	if (swapBytes)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			bytes[i] = cursor[size - 1 - i];
+		}
+	}
+	else
+	{
+		memcpy(bytes, cursor, size);
+	}
+	cursor += size;
+
+	switch (type)
+	{
+	case PLY_INT8: { int8_t value; memcpy(&value, bytes, 1); return value; }
+	case PLY_UINT8: return bytes[0];
+	case PLY_INT16: { int16_t value; memcpy(&value, bytes, 2); return value; }
+	case PLY_UINT16: { uint16_t value; memcpy(&value, bytes, 2); return value; }
+	case PLY_INT32: { int32_t value; memcpy(&value, bytes, 4); return value; }
+	case PLY_UINT32: { uint32_t value; memcpy(&value, bytes, 4); return value; }
+	case PLY_FLOAT32: { float value; memcpy(&value, bytes, 4); return value; }
+	case PLY_FLOAT64: { double value; memcpy(&value, bytes, 8); return value; }
+	default: return 0.0;
+	}
+}
+
+static const double POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+static const uint64_t INTEGER_POWERS_OF_TEN[] = { 1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+	1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull, 1000000000000000ull };
+
+#ifdef PLY_LOADER_X86
+static unsigned int CountTrailingZeros(unsigned int bits)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, bits);
+	return index;
+#else
+	return __builtin_ctz(bits);
+#endif
+}
+
+// How many of the 16 characters at text are digits before the first one that isn't, 16 if they all are
+TARGET_SSE2 static unsigned int CountDigitsSse2(const unsigned char* text)
+{
+	__m128i digits = _mm_sub_epi8(_mm_loadu_si128((const __m128i*) text), _mm_set1_epi8('0'));
+	__m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits); // Unsigned digit <= 9
+	return CountTrailingZeros(~(unsigned int) _mm_movemask_epi8(isDigit)); // Bit 16 up is always set
+}
+
+// The value of the length (1-15) digits that end at digitsEnd, which has at least 16 readable bytes before it.
+// Loads the 16 bytes ending there, zeroes the ones before the number and folds the digits together in pairs.
+TARGET_SSE2 static uint64_t ParseDigitsSse2(const unsigned char* digitsEnd, unsigned int length)
+{
+	__m128i digits = _mm_sub_epi8(_mm_loadu_si128((const __m128i*) (digitsEnd - 16)), _mm_set1_epi8('0'));
+	__m128i index = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	digits = _mm_and_si128(digits, _mm_cmpgt_epi8(index, _mm_set1_epi8((char) (15 - length))));
+
+	// Byte pairs to 0-99, the first byte of a pair is the tens
+	__m128i tens = _mm_and_si128(digits, _mm_set1_epi16(0x00FF));
+	__m128i ones = _mm_srli_epi16(digits, 8);
+	__m128i pairs = _mm_add_epi16(_mm_mullo_epi16(tens, _mm_set1_epi16(10)), ones);
+
+	// Pairs of those to 0-9999, then to 0-99999999
+	__m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00010064)); // * 100, * 1
+	__m128i octets = _mm_madd_epi16(_mm_packs_epi32(quads, quads), _mm_set1_epi32(0x00012710)); // * 10000, * 1
+
+	uint64_t high = (uint32_t) _mm_cvtsi128_si32(octets);
+	uint64_t low = (uint32_t) _mm_cvtsi128_si32(_mm_srli_si128(octets, 4));
+	return high * 100000000ull + low;
+}
+
+// The integer and fraction digits of the number at cursor (past its sign) as mantissa * 10^exponent, 16 bytes at a
+// time. False if the number is too long for it or too close to the end of the data, the scalar loop does those.
+TARGET_SSE2 static bool ReadPlyDigitsSse2(const unsigned char*& cursor, const unsigned char* end, uint64_t& mantissa, int& exponent)
+{
+	if (end - cursor < 16)
+	{
+		return false;
+	}
+
+	unsigned int integerLength = CountDigitsSse2(cursor);
+	if (integerLength == 16)
+	{
+		return false;
+	}
+
+	const unsigned char* fraction = cursor + integerLength;
+	unsigned int fractionLength = 0;
+	if (*fraction == '.')
+	{
+		fraction++;
+		if (end - fraction < 16)
+		{
+			return false;
+		}
+
+		fractionLength = CountDigitsSse2(fraction);
+		if (fractionLength == 16)
+		{
+			return false;
+		}
+	}
+
+	// No digits is an error the scalar loop reports, and past 19 digits the mantissa doesn't fit
+	if (integerLength + fractionLength == 0 || integerLength + fractionLength > 19)
+	{
+		return false;
+	}
+
+	uint64_t integer = integerLength > 0 ? ParseDigitsSse2(cursor + integerLength, integerLength) : 0;
+	uint64_t fractionDigits = fractionLength > 0 ? ParseDigitsSse2(fraction + fractionLength, fractionLength) : 0;
+	mantissa = integer * INTEGER_POWERS_OF_TEN[fractionLength] + fractionDigits;
+	exponent = -(int) fractionLength;
+	cursor = fraction + fractionLength;
+	return true;
+}
+#endif
+
+// The integer and fraction digits of the number at cursor (past its sign) as mantissa * 10^exponent, a digit at a time.
+// Past 19 significant digits only the magnitude is kept.
+static bool ReadPlyDigitsScalar(const unsigned char*& cursor, const unsigned char* end, uint64_t& mantissa, int& exponent)
+{
+	int digits = 0;
+	const unsigned char* start = cursor;
+	while (cursor < end && *cursor >= '0' && *cursor <= '9')
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*cursor - '0');
+			if (mantissa != 0)
+			{
+				digits++;
+			}
+		}
+		else
+		{
+			exponent++; // Past what fits, just keep the magnitude
+		}
+		cursor++;
+	}
+
+	if (cursor < end && *cursor == '.')
+	{
+		cursor++;
+		while (cursor < end && *cursor >= '0' && *cursor <= '9')
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*cursor - '0');
+				exponent--;
+				if (mantissa != 0)
+				{
+					digits++;
+				}
+			}
+			cursor++;
+		}
+	}
+
+	return cursor != start; // No digits, "nan", "inf" and such aren't in our assets
+}
+
+// Parses the next ASCII number, much faster than strtod/stringstream since it skips locales and only handles what PLY writers output.
+// Digits go into a 64 bit integer and get scaled by one power of ten at the end, exact for anything up to 19 significant digits.
+// useSimd reads the digits with SSE2, which also reads up to 16 bytes before the end of the number (see LoadPly).
+static bool ReadPlyAscii(const unsigned char*& cursor, const unsigned char* end, double& value, bool useSimd)
+{
+	while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n'))
+	{
+		cursor++;
+	}
+	if (cursor >= end)
+	{
+		return false;
+	}
+
+	bool negative = false;
+	if (*cursor == '-' || *cursor == '+')
+	{
+		negative = *cursor == '-';
+		cursor++;
+	}
+
+	uint64_t mantissa = 0;
+	int exponent = 0;
+	bool isRead = false;
+	if (useSimd)
+	{
+#ifdef PLY_LOADER_X86
+		isRead = ReadPlyDigitsSse2(cursor, end, mantissa, exponent);
+#endif
+	}
+	if (!isRead && !ReadPlyDigitsScalar(cursor, end, mantissa, exponent))
+	{
+		return false;
+	}
+
+	if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+	{
+		cursor++;
+		bool negativeExponent = false;
+		if (cursor < end && (*cursor == '-' || *cursor == '+'))
+		{
+			negativeExponent = *cursor == '-';
+			cursor++;
+		}
+
+		int explicitExponent = 0;
+		while (cursor < end && *cursor >= '0' && *cursor <= '9')
+		{
+			explicitExponent = explicitExponent * 10 + (*cursor - '0');
+			cursor++;
+		}
+		exponent += negativeExponent ? -explicitExponent : explicitExponent;
+	}
+
+	value = (double) mantissa;
+	while (exponent > 22)
+	{
+		value *= 1e22;
+		exponent -= 22;
+	}
+	while (exponent < -22)
+	{
+		value /= 1e22;
+		exponent += 22;
+	}
+	value = exponent >= 0 ? value * POWERS_OF_TEN[exponent] : value / POWERS_OF_TEN[-exponent];
+
+	if (negative)
+	{
+		value = -value;
+	}
+
+	return true;
+}
+
+// The fewest bytes an entry of the element can take: a list's count or a value per property in binary,
+// a digit and a separator per property in ASCII (but the file's last one can end without a separator)
+static size_t PlyMinEntrySize(const sPlyElement& element, ePlyFormat format)
+{
+	size_t size = 0;
+	for (const sPlyProperty& property : element.properties)
+	{
+		if (format == PLY_ASCII)
+		{
+			size += 2;
+		}
+		else
+		{
+			size += PlyTypeSize(property.isList ? property.countType : property.type);
+		}
+	}
+
+	return format == PLY_ASCII && size > 0 ? size - 1 : size;
+}
+
+// Binary vertices without lists are all the same size, so the whole element can be bounds checked once and every
+// property read at a fixed offset. This is the path all our binary assets take.
+static bool ReadPlyBinaryVertices(const unsigned char*& cursor, const unsigned char* end, const sPlyElement& element, bool swapBytes, std::vector<sColoredVertex>& vertices)
+{
+	size_t stride = 0;
+	for (const sPlyProperty& property : element.properties)
+	{
+		stride += PlyTypeSize(property.type);
+	}
+
+	if ((size_t) (end - cursor) / stride < element.count)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < element.count; i++)
+	{
+		float values[TARGET_COUNT] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+
+		const unsigned char* property = cursor;
+		for (const sPlyProperty& propertyInfo : element.properties)
+		{
+			if (propertyInfo.target == TARGET_SKIP)
+			{
+				property += PlyTypeSize(propertyInfo.type);
+			}
+			else if (propertyInfo.type == PLY_FLOAT32 && !swapBytes)
+			{
+				memcpy(&values[propertyInfo.target], property, sizeof(float));
+				property += sizeof(float);
+			}
+			else
+			{
+				float value = (float) ReadPlyBinary(property, propertyInfo.type, swapBytes);
+				values[propertyInfo.target] = propertyInfo.target >= TARGET_R ? value * PlyColorScale(propertyInfo.type) : value;
+			}
+		}
+		cursor += stride;
+
+		sColoredVertex& vertex = vertices[i];
+		vertex.x = values[TARGET_X];
+		vertex.y = values[TARGET_Y];
+		vertex.z = values[TARGET_Z];
+		vertex.nx = values[TARGET_NX];
+		vertex.ny = values[TARGET_NY];
+		vertex.nz = values[TARGET_NZ];
+		vertex.r = values[TARGET_R];
+		vertex.g = values[TARGET_G];
+		vertex.b = values[TARGET_B];
+		vertex.a = values[TARGET_A];
+	}
+
+	return true;
+}
+
+// Splits the header into elements, leaves cursor at the first byte of data
+static bool ParsePlyHeader(const unsigned char*& cursor, const unsigned char* end, ePlyFormat& format, std::vector<sPlyElement>& elements)
+{
+	bool hasFormat = false;
+	bool isFirstLine = true;
+	while (cursor < end)
+	{
+		const unsigned char* lineEnd = (const unsigned char*) memchr(cursor, '\n', end - cursor);
+		if (!lineEnd)
+		{
+			return false;
+		}
+
+		std::string line((const char*) cursor, lineEnd - cursor);
+		cursor = lineEnd + 1;
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+
+		std::istringstream ss(line); // Only for the header, which is a few lines
+		std::string keyword;
+		ss >> keyword;
+
+		if (isFirstLine)
+		{
+			if (keyword != "ply")
+			{
+				return false;
+			}
+			isFirstLine = false;
+		}
+		else if (keyword == "format")
+		{
+			std::string formatName;
+			ss >> formatName;
+			if (formatName == "ascii") format = PLY_ASCII;
+			else if (formatName == "binary_little_endian") format = PLY_BINARY_LITTLE_ENDIAN;
+			else if (formatName == "binary_big_endian") format = PLY_BINARY_BIG_ENDIAN;
+			else return false;
+			hasFormat = true;
+		}
+		else if (keyword == "element")
+		{
+			sPlyElement element;
+			ss >> element.name >> element.count;
+			if (ss.fail())
+			{
+				return false;
+			}
+			elements.push_back(element);
+		}
+		else if (keyword == "property")
+		{
+			if (elements.empty())
+			{
+				return false;
+			}
+
+			sPlyElement& element = elements.back();
+			sPlyProperty property;
+			property.isList = false;
+			property.countType = PLY_INVALID;
+			property.target = TARGET_SKIP;
+			property.isFaceIndices = false;
+
+			std::string typeName, name;
+			ss >> typeName;
+			if (typeName == "list")
+			{
+				std::string countTypeName;
+				ss >> countTypeName >> typeName;
+				property.isList = true;
+				property.countType = ParsePlyType(countTypeName);
+				if (property.countType == PLY_INVALID)
+				{
+					return false;
+				}
+			}
+			ss >> name;
+
+			property.type = ParsePlyType(typeName);
+			if (property.type == PLY_INVALID)
+			{
+				return false;
+			}
+
+			if (element.name == "vertex" && !property.isList)
+			{
+				property.target = PlyVertexTarget(name);
+			}
+			else if (element.name == "face" && property.isList && (name == "vertex_indices" || name == "vertex_index"))
+			{
+				property.isFaceIndices = true;
+			}
+
+			element.properties.push_back(property);
+		}
+		else if (keyword == "end_header")
+		{
+			return hasFormat;
+		}
+		// comment, obj_info etc. are ignored
+	}
+
+	return false;
+}
+
+bool LoadPly(const std::string& path, sPlyMesh& mesh)
+{
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		return false;
+	}
+
+	return LoadPly(file.GetData(), file.GetSize(), mesh);
+}
+
+bool LoadPly(const unsigned char* data, size_t size, sPlyMesh& mesh)
+{
+	if (!data || size == 0)
+	{
+		return false;
+	}
+
+	const unsigned char* cursor = data;
+	const unsigned char* end = data + size;
+
+	ePlyFormat format = PLY_ASCII;
+	std::vector<sPlyElement> elements;
+	if (!ParsePlyHeader(cursor, end, format, elements))
+	{
+		return false;
+	}
+
+	// Check it's something we handle before reading any of it
+	const sPlyElement* vertexElement = NULL;
+	const sPlyElement* faceElement = NULL;
+	for (const sPlyElement& element : elements)
+	{
+		if (element.name == "vertex")
+		{
+			vertexElement = &element;
+		}
+		else if (element.name == "face")
+		{
+			faceElement = &element;
+		}
+	}
+
+	if (!vertexElement || !faceElement)
+	{
+		return false;
+	}
+
+	bool hasTarget[TARGET_COUNT] = {};
+	for (const sPlyProperty& property : vertexElement->properties)
+	{
+		if (property.target != TARGET_SKIP)
+		{
+			hasTarget[property.target] = true;
+		}
+	}
+
+	for (int target = TARGET_X; target <= TARGET_NZ; target++)
+	{
+		if (!hasTarget[target]) // No normals means assimp has to generate them
+		{
+			return false;
+		}
+	}
+
+	bool hasFaceIndices = false;
+	for (const sPlyProperty& property : faceElement->properties)
+	{
+		hasFaceIndices |= property.isFaceIndices;
+	}
+	if (!hasFaceIndices)
+	{
+		return false;
+	}
+
+	const uint16_t endianTest = 1;
+	bool isLittleEndian = *(const unsigned char*) &endianTest == 1;
+	bool swapBytes = (format == PLY_BINARY_LITTLE_ENDIAN && !isLittleEndian) || (format == PLY_BINARY_BIG_ENDIAN && isLittleEndian);
+
+	// The SIMD number reader loads the 16 bytes before the end of a number, the header always covers that for the first one
+	bool useSimd = GetSimdLevel() >= SIMD_SSE2 && cursor - data >= 16;
+
+	mesh.vertices.clear();
+	mesh.faces.clear();
+	mesh.hasVertexColors = hasTarget[TARGET_R] && hasTarget[TARGET_G] && hasTarget[TARGET_B];
+
+	std::vector<unsigned int> polygon;
+	for (const sPlyElement& element : elements)
+	{
+		// Don't trust the header's count with an allocation, every entry takes at least a byte per property
+		size_t minEntrySize = PlyMinEntrySize(element, format);
+		if (minEntrySize > 0 && element.count > (size_t) (end - cursor) / minEntrySize)
+		{
+			return false;
+		}
+
+		bool isVertex = &element == vertexElement;
+		bool isFace = &element == faceElement;
+		if (isVertex)
+		{
+			mesh.vertices.resize(element.count);
+
+			bool hasLists = false;
+			for (const sPlyProperty& property : element.properties)
+			{
+				hasLists |= property.isList;
+			}
+
+			if (format != PLY_ASCII && !hasLists)
+			{
+				if (!ReadPlyBinaryVertices(cursor, end, element, swapBytes, mesh.vertices))
+				{
+					return false;
+				}
+				continue;
+			}
+		}
+		else if (isFace)
+		{
+			mesh.faces.reserve(element.count); // Exact for triangles, which is all we export
+		}
+
+		for (size_t i = 0; i < element.count; i++)
+		{
+			float values[TARGET_COUNT] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+
+			for (const sPlyProperty& property : element.properties)
+			{
+				size_t valueCount = 1;
+				if (property.isList)
+				{
+					double count = 0.0;
+					if (format == PLY_ASCII)
+					{
+						if (!ReadPlyAscii(cursor, end, count, useSimd))
+						{
+							return false;
+						}
+					}
+					else
+					{
+						if (cursor + PlyTypeSize(property.countType) > end)
+						{
+							return false;
+						}
+						count = ReadPlyBinary(cursor, property.countType, swapBytes);
+					}
+					valueCount = (size_t) count;
+					polygon.clear();
+				}
+
+				if (format != PLY_ASCII && cursor + valueCount * PlyTypeSize(property.type) > end)
+				{
+					return false;
+				}
+
+				for (size_t j = 0; j < valueCount; j++)
+				{
+					double value = 0.0;
+					if (format == PLY_ASCII)
+					{
+						if (!ReadPlyAscii(cursor, end, value, useSimd))
+						{
+							return false;
+						}
+					}
+					else
+					{
+						value = ReadPlyBinary(cursor, property.type, swapBytes);
+					}
+
+					if (isVertex && property.target != TARGET_SKIP)
+					{
+						values[property.target] = property.target >= TARGET_R ? (float) value * PlyColorScale(property.type) : (float) value;
+					}
+					else if (isFace && property.isFaceIndices)
+					{
+						if (value < 0.0 || value >= (double) mesh.vertices.size())
+						{
+							return false;
+						}
+						polygon.push_back((unsigned int) value);
+					}
+				}
+
+				// Fan out polygons, like aiProcess_Triangulate would
+				if (isFace && property.isFaceIndices)
+				{
+					for (size_t j = 2; j < polygon.size(); j++)
+					{
+						sTriangle face;
+						face.vertIndex[0] = polygon[0];
+						face.vertIndex[1] = polygon[j - 1];
+						face.vertIndex[2] = polygon[j];
+						mesh.faces.push_back(face);
+					}
+				}
+			}
+
+			if (isVertex)
+			{
+				sColoredVertex& vertex = mesh.vertices[i];
+				vertex.x = values[TARGET_X];
+				vertex.y = values[TARGET_Y];
+				vertex.z = values[TARGET_Z];
+				vertex.nx = values[TARGET_NX];
+				vertex.ny = values[TARGET_NY];
+				vertex.nz = values[TARGET_NZ];
+				vertex.r = values[TARGET_R];
+				vertex.g = values[TARGET_G];
+				vertex.b = values[TARGET_B];
+				vertex.a = values[TARGET_A];
+			}
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "VertexInformation.h"
+
+#include <string>
+#include <vector>
+
+// What LoadPly got out of a file
+struct sPlyMesh
+{
+	std::vector<sColoredVertex> vertices;
+	std::vector<sTriangle> faces;
+	bool hasVertexColors; // Colors are white if the file doesn't have them
+};
+
+// Fast path for our *_xyz_n_rgba_uv.ply assets, skips assimp's generic importer and post processing.
+// Reads ASCII and binary (either endian) PLY straight from a memory mapped file into sColoredVertex/sTriangle.
+// Needs x, y, z, nx, ny, nz and a face list. Anything else it doesn't understand returns false so the caller can fall back to assimp.
+bool LoadPly(const std::string& path, sPlyMesh& mesh);
+
+// Same, for a file that's already in memory (e.g. read by AssetReader)
+bool LoadPly(const unsigned char* data, size_t size, sPlyMesh& mesh);
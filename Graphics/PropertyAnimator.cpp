@@ -0,0 +1,196 @@
+#include "PropertyAnimator.h"
+#include "JobSystem.h"
+#include "LightManager.h"
+#include "SceneFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+
+// Tracks a job evaluates at a time, each is a few multiplies or a short key search
+static const unsigned int EVALUATE_BATCH_SIZE = 64;
+
+PropertyAnimator::PropertyAnimator()
+{
+
+}
+
+PropertyAnimator::TrackID PropertyAnimator::AddTrack(const sAnimationTarget& target, eTrackType type)
+{
+	sTrack track;
+	track.target = target;
+	track.type = type;
+	track.isPlaying = false;
+	track.isStarting = false;
+	track.startTime = 0.0;
+	track.firstKey = 0;
+	track.keyCount = 0;
+	track.interpolation = INTERPOLATE_LINEAR;
+	track.isLooping = false;
+	track.oscillator = sOscillator();
+	track.lastValue = glm::vec4(0.0f);
+	track.hasValue = false;
+	this->tracks.push_back(track);
+	this->values.push_back(glm::vec4(0.0f));
+	this->changed.push_back(0);
+	return (TrackID) this->tracks.size() - 1;
+}
+
+PropertyAnimator::TrackID PropertyAnimator::AddKeyframeTrack(const sAnimationTarget& target, const std::vector<sKeyframe>& keys, eKeyframeInterpolation interpolation, bool isLooping)
+{
+	TrackID id = this->AddTrack(target, TRACK_KEYFRAMES);
+	sTrack& track = this->tracks[id];
+	track.firstKey = (unsigned int) this->keys.size();
+	track.keyCount = (unsigned int) keys.size();
+	track.interpolation = interpolation;
+	track.isLooping = isLooping;
+	this->keys.insert(this->keys.end(), keys.begin(), keys.end());
+	return id;
+}
+
+PropertyAnimator::TrackID PropertyAnimator::AddOscillatorTrack(const sAnimationTarget& target, const sOscillator& oscillator)
+{
+	TrackID id = this->AddTrack(target, TRACK_OSCILLATOR);
+	this->tracks[id].oscillator = oscillator;
+	return id;
+}
+
+void PropertyAnimator::Play(TrackID track)
+{
+	this->tracks[track].isPlaying = true;
+	this->tracks[track].isStarting = true;
+}
+
+void PropertyAnimator::Stop(TrackID track)
+{
+	this->tracks[track].isPlaying = false;
+}
+
+void PropertyAnimator::Update(double time, EntityRegistry& entities)
+{
+	for (sTrack& track : this->tracks)
+	{
+		if (track.isStarting)
+		{
+			track.startTime = time;
+			track.isStarting = false;
+		}
+	}
+
+	// Every track only reads itself and the keys, so they're evaluated independently
+	JobSystem::GetInstance()->ParallelFor((unsigned int) this->tracks.size(), EVALUATE_BATCH_SIZE, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			const sTrack& track = this->tracks[i];
+			if (!track.isPlaying)
+			{
+				this->changed[i] = 0;
+				continue;
+			}
+
+			this->values[i] = this->Evaluate(track, (float) (time - track.startTime));
+			this->changed[i] = !track.hasValue || this->values[i] != track.lastValue;
+		}
+	});
+
+	// The lights and transforms aren't safe to write from the jobs, several tracks can share one
+	for (unsigned int i = 0; i < this->tracks.size(); i++)
+	{
+		if (this->changed[i])
+		{
+			sTrack& track = this->tracks[i];
+			track.lastValue = this->values[i];
+			track.hasValue = true;
+			Apply(track, this->values[i], entities);
+		}
+	}
+}
+
+glm::vec4 PropertyAnimator::Evaluate(const sTrack& track, float localTime) const
+{
+	if (track.type == TRACK_OSCILLATOR)
+	{
+		const sOscillator& oscillator = track.oscillator;
+		glm::vec4 value;
+		for (int i = 0; i < 4; i++)
+		{
+			value[i] = oscillator.offset[i] + oscillator.amplitude[i] * std::sin(6.2831853f * oscillator.frequency[i] * localTime + oscillator.phase[i]);
+		}
+		return value;
+	}
+
+	if (track.keyCount == 0)
+	{
+		return glm::vec4(0.0f);
+	}
+
+	const sKeyframe* keys = &this->keys[track.firstKey];
+	float duration = keys[track.keyCount - 1].time;
+	if (track.isLooping && duration > 0.0f)
+	{
+		localTime = std::fmod(localTime, duration);
+	}
+
+	if (localTime <= keys[0].time)
+	{
+		return keys[0].value;
+	}
+	if (localTime >= duration)
+	{
+		return keys[track.keyCount - 1].value;
+	}
+
+	// The first key after localTime, there's one before it too
+	const sKeyframe* next = std::upper_bound(keys, keys + track.keyCount, localTime, [](float time, const sKeyframe& key) { return time < key.time; });
+	const sKeyframe* previous = next - 1;
+	if (track.interpolation == INTERPOLATE_STEP)
+	{
+		return previous->value;
+	}
+
+	float t = (localTime - previous->time) / (next->time - previous->time);
+	if (track.interpolation == INTERPOLATE_SMOOTH)
+	{
+		t = t * t * (3.0f - 2.0f * t);
+	}
+	return glm::mix(previous->value, next->value, t);
+}
+
+void PropertyAnimator::Apply(const sTrack& track, const glm::vec4& value, EntityRegistry& entities)
+{
+	const sAnimationTarget& target = track.target;
+	if (target.property <= ANIMATE_LIGHT_STATE) // The light ones
+	{
+		Light* light = LightManager::GetInstance()->GetLight(target.light);
+		if (!light)
+		{
+			return;
+		}
+
+		switch (target.property)
+		{
+		case ANIMATE_LIGHT_POSITION: light->EditPosition(value.x, value.y, value.z, value.w); break;
+		case ANIMATE_LIGHT_DIRECTION: light->EditDirection(value.x, value.y, value.z, value.w); break;
+		case ANIMATE_LIGHT_DIFFUSE: light->EditDiffuse(value.x, value.y, value.z, value.w); break;
+		default: light->EditState(value.x > 0.5f); break;
+		}
+		return;
+	}
+
+	const sTransformComponent* current = entities.GetTransform(target.entity);
+	if (!current)
+	{
+		return;
+	}
+
+	// The other tracks on the entity keep what they set
+	sTransformComponent transform = *current;
+	switch (target.property)
+	{
+	case ANIMATE_TRANSFORM_POSITION: transform.position = glm::vec3(value); break;
+	case ANIMATE_TRANSFORM_ROTATION: GetRotationAxes(glm::vec3(value), transform.xRot, transform.yRot, transform.zRot); break;
+	default: transform.scale = glm::vec3(value); break;
+	}
+	entities.SetTransform(target.entity, transform);
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "EntityRegistry.h"
+#include "ResourceHandle.h"
+
+#include <vector>
+#include <glm/vec4.hpp>
+
+// What the tracks of a PropertyAnimator can drive. Values are vec4s, each property uses what it needs of it. The
+// light properties come first.
+enum eAnimatedProperty
+{
+	ANIMATE_LIGHT_POSITION,		// xyzw, like Light::EditPosition
+	ANIMATE_LIGHT_DIRECTION,	// xyzw, like Light::EditDirection
+	ANIMATE_LIGHT_DIFFUSE,		// rgba
+	ANIMATE_LIGHT_STATE,		// On while x > 0.5
+	ANIMATE_TRANSFORM_POSITION,	// xyz
+	ANIMATE_TRANSFORM_ROTATION,	// xyz, degrees about x, then y, then z like the scene files
+	ANIMATE_TRANSFORM_SCALE		// xyz
+};
+
+enum eKeyframeInterpolation
+{
+	INTERPOLATE_STEP,	// Holds each key until the next one
+	INTERPOLATE_LINEAR,
+	INTERPOLATE_SMOOTH	// Eases in and out of every key
+};
+
+struct sAnimationTarget
+{
+	eAnimatedProperty property;
+	LightHandle light;		// For the light properties
+	EntityHandle entity;	// For the transform properties, needs a transform component
+};
+
+struct sKeyframe
+{
+	float time; // Seconds from the start of the track
+	glm::vec4 value;
+};
+
+// offset + amplitude * sin(2 pi frequency t + phase), per component. A circle is two components a quarter turn apart.
+struct sOscillator
+{
+	glm::vec4 offset;
+	glm::vec4 amplitude;
+	glm::vec4 frequency;	// Hz
+	glm::vec4 phase;		// Radians
+};
+
+// Drives light parameters and entity transforms from keyframe and oscillator tracks. Update evaluates every playing
+// track across the job system, then writes only the values that changed since the last Update. Transforms go through
+// EntityRegistry::SetTransform, so only the entities that moved are in its dirty set.
+// Tracks only depend on the time they're evaluated at, so Update is called once per frame with the simulation clock
+// advanced to where that frame falls between ticks, and fast tracks move smoothly at any tick rate.
+class PropertyAnimator
+{
+public:
+	typedef unsigned int TrackID;
+
+	PropertyAnimator();
+
+	// keys are sorted by time. Looping tracks start over after their last key, the others hold it.
+	TrackID AddKeyframeTrack(const sAnimationTarget& target, const std::vector<sKeyframe>& keys, eKeyframeInterpolation interpolation, bool isLooping);
+
+	TrackID AddOscillatorTrack(const sAnimationTarget& target, const sOscillator& oscillator);
+
+	// The track starts from its beginning at the next Update. Tracks don't play until this is called.
+	void Play(TrackID track);
+
+	// Leaves what the track drives where it is
+	void Stop(TrackID track);
+
+	inline bool IsPlaying(TrackID track) const
+	{
+		return this->tracks[track].isPlaying;
+	}
+
+	// Evaluates the playing tracks at time (seconds, any clock that only goes forward) and writes what changed, call it
+	// before entities.UpdateTransforms
+	void Update(double time, EntityRegistry& entities);
+
+private:
+	enum eTrackType
+	{
+		TRACK_KEYFRAMES,
+		TRACK_OSCILLATOR
+	};
+
+	struct sTrack
+	{
+		sAnimationTarget target;
+		eTrackType type;
+		bool isPlaying;
+		bool isStarting;	// Play was called, startTime is set by the next Update
+		double startTime;
+
+		// Keyframes
+		unsigned int firstKey;	// In keys
+		unsigned int keyCount;
+		eKeyframeInterpolation interpolation;
+		bool isLooping;
+
+		sOscillator oscillator;
+
+		glm::vec4 lastValue;	// What was last written
+		bool hasValue;
+	};
+
+	std::vector<sTrack> tracks;
+	std::vector<sKeyframe> keys;
+
+	// Per track, filled by the jobs in Update
+	std::vector<glm::vec4> values;
+	std::vector<unsigned char> changed;
+
+	TrackID AddTrack(const sAnimationTarget& target, eTrackType type);
+
+	glm::vec4 Evaluate(const sTrack& track, float localTime) const;
+
+	static void Apply(const sTrack& track, const glm::vec4& value, EntityRegistry& entities);
+};
@@ -0,0 +1,251 @@
+#include "RenderQueue.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "Model.h"
+#include "ModelManager.h"
+
+#include <algorithm>
+#include <glm/glm.hpp>
+
+// What goes into the draws' data, isVisible only matters to CullInstances
+static bool IsSameTransform(const sDrawInstance& a, const sDrawInstance& b)
+{
+	return a.position == b.position && a.xRot == b.xRot && a.yRot == b.yRot && a.zRot == b.zRot && a.scale == b.scale && a.transparency == b.transparency;
+}
+
+RenderQueue::RenderQueue()
+	: addedCount(0), isStructureChanged(true), lastViewProjection(1.0f), meshCount(0), visibleCount(0), wasRecorded(false), patchedCount(0)
+{
+
+}
+
+void RenderQueue::Clear()
+{
+	this->addedCount = 0;
+}
+
+void RenderQueue::Add(ModelHandle model, const glm::vec3& position, const glm::vec3& xRot, const glm::vec3& yRot, const glm::vec3& zRot, const glm::vec3& scale, float transparency, bool isVisible)
+{
+	sDrawInstance instance;
+	instance.model = model;
+	instance.position = position;
+	instance.xRot = xRot;
+	instance.yRot = yRot;
+	instance.zRot = zRot;
+	instance.scale = scale;
+	instance.transparency = transparency;
+	instance.isVisible = isVisible;
+
+	unsigned int index = this->addedCount++;
+	if (index >= this->instances.size())
+	{
+		this->instances.push_back(instance);
+		this->isStructureChanged = true;
+		return;
+	}
+
+	sDrawInstance& last = this->instances[index];
+	if (IsSameTransform(last, instance) && last.model == model)
+	{
+		// Nothing to patch, it only has to be culled again if it was shown or hidden
+		if (last.isVisible != isVisible)
+		{
+			last.isVisible = isVisible;
+			this->recullInstances.push_back(index);
+		}
+		return;
+	}
+
+	// Going in or out of transparent changes the program and where the draws sort, so it can't be patched
+	if (last.model != model || (last.transparency < 1.0f) != (transparency < 1.0f))
+	{
+		this->isStructureChanged = true;
+	}
+	else
+	{
+		this->dirtyInstances.push_back(index);
+	}
+
+	last = instance;
+}
+
+void RenderQueue::Prepare(const glm::mat4& viewProjection)
+{
+	if (this->instances.size() != this->addedCount)
+	{
+		this->instances.resize(this->addedCount);
+		this->isStructureChanged = true;
+	}
+
+	// The handles can be the same while the model behind them was unloaded
+	unsigned int instanceCount = this->addedCount;
+	for (unsigned int i = 0; i < instanceCount && !this->isStructureChanged; i++)
+	{
+		if (ModelManager::GetInstance()->GetModel(this->instances[i].model) != this->models[i])
+		{
+			this->isStructureChanged = true;
+		}
+	}
+
+	unsigned int listCount = (instanceCount + INSTANCES_PER_LIST - 1) / INSTANCES_PER_LIST;
+	if (this->isStructureChanged)
+	{
+		// The order of every instance's meshes in the frame, so draws that end up with the same state still come out in
+		// the order they were added, whichever list they were recorded into
+		this->models.resize(instanceCount);
+		this->firstMeshes.resize(instanceCount);
+		unsigned int meshCount = 0;
+		for (unsigned int i = 0; i < instanceCount; i++)
+		{
+			const Model* model = ModelManager::GetInstance()->GetModel(this->instances[i].model);
+			this->models[i] = model;
+			this->firstMeshes[i] = meshCount;
+			meshCount += model ? (unsigned int) model->meshes.size() : 0;
+		}
+		this->meshCount = meshCount;
+		this->meshBounds.resize(meshCount);
+		this->lists.resize(listCount);
+
+		// Each job records its own list, nothing is shared between them
+		JobSystem::GetInstance()->ParallelFor(listCount, 1, [&](unsigned int beginList, unsigned int endList)
+		{
+			for (unsigned int listIndex = beginList; listIndex < endList; listIndex++)
+			{
+				CommandList& list = this->lists[listIndex];
+				list.Clear();
+
+				unsigned int begin = listIndex * INSTANCES_PER_LIST;
+				unsigned int end = std::min(instanceCount, begin + INSTANCES_PER_LIST);
+				for (unsigned int i = begin; i < end; i++)
+				{
+					const sDrawInstance& instance = this->instances[i];
+					const Model* model = this->models[i];
+					if (!model)
+					{
+						continue;
+					}
+
+					for (unsigned int meshIndex = 0; meshIndex < model->meshes.size(); meshIndex++)
+					{
+						const Mesh& mesh = model->meshes[meshIndex];
+						glm::mat4 matModel;
+						glm::mat4 matInvTransposeModel;
+						mesh.BuildTransform(instance.position, instance.xRot, instance.yRot, instance.zRot, instance.scale, matModel, matInvTransposeModel);
+
+						sMeshBounds& bounds = this->meshBounds[this->firstMeshes[i] + meshIndex];
+						bounds.hasBounds = mesh.GetWorldBounds(matModel, bounds.center, bounds.halfExtent);
+						mesh.RecordDraw(list, matModel, matInvTransposeModel, instance.transparency, this->firstMeshes[i] + meshIndex);
+					}
+				}
+
+				list.Sort();
+				this->CullInstances(viewProjection, begin, end);
+			}
+		});
+
+		this->wasRecorded = true;
+		this->patchedCount = instanceCount;
+	}
+	else
+	{
+		for (unsigned int instance : this->dirtyInstances)
+		{
+			this->PatchInstance(instance);
+		}
+
+		if (viewProjection != this->lastViewProjection)
+		{
+			JobSystem::GetInstance()->ParallelFor(listCount, 1, [&](unsigned int beginList, unsigned int endList)
+			{
+				for (unsigned int listIndex = beginList; listIndex < endList; listIndex++)
+				{
+					unsigned int begin = listIndex * INSTANCES_PER_LIST;
+					this->CullInstances(viewProjection, begin, std::min(instanceCount, begin + INSTANCES_PER_LIST));
+				}
+			});
+		}
+		else
+		{
+			for (unsigned int instance : this->dirtyInstances)
+			{
+				this->CullInstances(viewProjection, instance, instance + 1);
+			}
+			for (unsigned int instance : this->recullInstances)
+			{
+				this->CullInstances(viewProjection, instance, instance + 1);
+			}
+		}
+
+		this->wasRecorded = false;
+		this->patchedCount = (unsigned int) this->dirtyInstances.size();
+	}
+
+	// Added and used up on the main thread within the frame, so they live in its arena until its next Reset
+	this->dirtyInstances = FrameVector<unsigned int>();
+	this->recullInstances = FrameVector<unsigned int>();
+	this->isStructureChanged = false;
+	this->lastViewProjection = viewProjection;
+
+	this->visibleCount = 0;
+	for (const CommandList& list : this->lists)
+	{
+		this->visibleCount += list.GetVisibleCount();
+	}
+}
+
+void RenderQueue::Submit(const CompiledShader& shader, CommandListPlayer& player) const
+{
+	player.Play(this->lists, shader);
+}
+
+void RenderQueue::PatchInstance(unsigned int instanceIndex)
+{
+	const sDrawInstance& instance = this->instances[instanceIndex];
+	const Model* model = this->models[instanceIndex];
+	if (!model)
+	{
+		return;
+	}
+
+	unsigned int listIndex = instanceIndex / INSTANCES_PER_LIST;
+	CommandList& list = this->lists[listIndex];
+	unsigned int firstDraw = this->firstMeshes[instanceIndex] - this->firstMeshes[listIndex * INSTANCES_PER_LIST];
+	for (unsigned int meshIndex = 0; meshIndex < model->meshes.size(); meshIndex++)
+	{
+		const Mesh& mesh = model->meshes[meshIndex];
+		glm::mat4 matModel;
+		glm::mat4 matInvTransposeModel;
+		mesh.BuildTransform(instance.position, instance.xRot, instance.yRot, instance.zRot, instance.scale, matModel, matInvTransposeModel);
+
+		sMeshBounds& bounds = this->meshBounds[this->firstMeshes[instanceIndex] + meshIndex];
+		bounds.hasBounds = mesh.GetWorldBounds(matModel, bounds.center, bounds.halfExtent);
+		list.PatchDrawData(firstDraw + meshIndex, matModel, matInvTransposeModel, instance.transparency);
+	}
+}
+
+void RenderQueue::CullInstances(const glm::mat4& viewProjection, unsigned int begin, unsigned int end)
+{
+	if (begin >= end)
+	{
+		return;
+	}
+
+	// Every mesh has a draw, so the meshes and the draws of a list line up
+	unsigned int listIndex = begin / INSTANCES_PER_LIST;
+	CommandList& list = this->lists[listIndex];
+	unsigned int listFirstMesh = this->firstMeshes[listIndex * INSTANCES_PER_LIST];
+	unsigned int endMesh = end < this->firstMeshes.size() ? this->firstMeshes[end] : this->meshCount;
+
+	sFrustum frustum = GetFrustum(viewProjection);
+	for (unsigned int i = begin; i < end; i++)
+	{
+		bool isInstanceVisible = this->instances[i].isVisible;
+		unsigned int instanceEndMesh = i + 1 < end ? this->firstMeshes[i + 1] : endMesh;
+		for (unsigned int mesh = this->firstMeshes[i]; mesh < instanceEndMesh; mesh++)
+		{
+			const sMeshBounds& bounds = this->meshBounds[mesh];
+			list.SetVisible(mesh - listFirstMesh, isInstanceVisible && (!bounds.hasBounds || IsBoxInFrustum(frustum, bounds.center, bounds.halfExtent)));
+		}
+	}
+}
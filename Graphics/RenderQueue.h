@@ -0,0 +1,110 @@
+#pragma once
+
+#include "CommandList.h"
+#include "CompiledShader.h"
+#include "FrameAllocator.h"
+#include "ResourceHandle.h"
+
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+class Model;
+
+// A model to draw this frame, where and how
+struct sDrawInstance
+{
+	ModelHandle model;
+	glm::vec3 position;
+	glm::vec3 xRot;
+	glm::vec3 yRot;
+	glm::vec3 zRot;
+	glm::vec3 scale;
+	float transparency;
+	bool isVisible; // False if the caller already culled the whole instance (see EntityRegistry::Cull)
+};
+
+// Collects the frame's draws and records them into command lists, one list per range of instances, each by its own job
+// (see JobSystem::ParallelFor). Submit merges the lists on the GL thread (see CommandListPlayer). Opaque meshes are
+// drawn sorted by state, transparent ones after them in the order they were added.
+// The lists are kept between frames. Add compares every instance with the one added in its place last time, and as
+// long as the same models come in the same order Prepare only patches the meshes of the instances that changed and
+// culls again if the camera moved. A scene that doesn't change costs a compare per instance.
+class RenderQueue
+{
+public:
+	RenderQueue();
+
+	// Starts a new frame. The last frame's draws are kept to compare the new ones against.
+	void Clear();
+
+	// Instances added as not visible keep their draws, hidden, so culling them doesn't change what gets recorded.
+	// The visible ones still have each of their meshes culled.
+	void Add(ModelHandle model, const glm::vec3& position, const glm::vec3& xRot, const glm::vec3& yRot, const glm::vec3& zRot, const glm::vec3& scale, float transparency, bool isVisible = true);
+
+	// Records, or patches, everything added since Clear and culls it
+	void Prepare(const glm::mat4& viewProjection);
+
+	// Plays the recorded lists back. GL thread only.
+	void Submit(const CompiledShader& shader, CommandListPlayer& player) const;
+
+	inline unsigned int GetInstanceCount() const
+	{
+		return this->addedCount;
+	}
+
+	// Meshes of every instance, before culling
+	inline unsigned int GetMeshCount() const
+	{
+		return this->meshCount;
+	}
+
+	inline unsigned int GetVisibleCount() const
+	{
+		return this->visibleCount;
+	}
+
+	// What the last Prepare had to do. A recorded frame patched every instance.
+	inline bool WasRecorded() const
+	{
+		return this->wasRecorded;
+	}
+
+	inline unsigned int GetPatchedCount() const
+	{
+		return this->patchedCount;
+	}
+
+	// Instances recorded into each command list. Small enough that every worker gets a few lists of a typical frame.
+	static const unsigned int INSTANCES_PER_LIST = 64;
+
+private:
+	// World space box of a mesh, kept to cull again without rebuilding its matrices
+	struct sMeshBounds
+	{
+		glm::vec3 center;
+		glm::vec3 halfExtent;
+		bool hasBounds;
+	};
+
+	std::vector<sDrawInstance> instances;		// What was added, the first addedCount are this frame's
+	std::vector<const Model*> models;			// Per instance, as of the last recording (NULL if the handle went stale)
+	std::vector<unsigned int> firstMeshes;		// Per instance, the order of its first mesh in the frame
+	std::vector<sMeshBounds> meshBounds;		// Per mesh, in frame order
+	std::vector<CommandList> lists;				// Per INSTANCES_PER_LIST instances, every mesh gets a draw
+	FrameVector<unsigned int> dirtyInstances;	// Changed since they were last added, Prepare gives both back to the frame arena
+	FrameVector<unsigned int> recullInstances;	// Only shown or hidden since they were last added
+	unsigned int addedCount;
+	bool isStructureChanged;					// Something was added that needs the lists recorded again
+	glm::mat4 lastViewProjection;
+	unsigned int meshCount;
+	unsigned int visibleCount;
+	bool wasRecorded;
+	unsigned int patchedCount;
+
+	// Rebuilds the instance's matrices and bounds and writes them into its draws
+	void PatchInstance(unsigned int instance);
+
+	// Culls the meshes of instances [begin, end), all in the same list
+	void CullInstances(const glm::mat4& viewProjection, unsigned int begin, unsigned int end);
+};
@@ -0,0 +1,128 @@
+#include "RenderThread.h"
+
+#include "FrameAllocator.h"
+#include "GLCommon.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+RenderThread::RenderThread()
+	: window(NULL), currentFrame(0), frameCount(0), isStopping(false), mainWaitSeconds(0.0), renderWaitSeconds(0.0), framesDrawn(0), arenaHighWater(0)
+{
+
+}
+
+RenderThread::~RenderThread()
+{
+	this->Stop();
+
+	for (sFrameData* frame : this->frames)
+	{
+		delete frame;
+	}
+}
+
+void RenderThread::Start(GLFWwindow* window, unsigned int maxFramesInFlight, const RenderFunction& render)
+{
+	this->window = window;
+	this->render = render;
+	this->isStopping = false;
+
+	unsigned int slotCount = std::max(1u, maxFramesInFlight) + 1;
+	this->freeFrames.reserve(slotCount);
+	this->queuedFrames.reserve(slotCount);
+	for (unsigned int i = 0; i < slotCount; i++)
+	{
+		this->frames.push_back(new sFrameData());
+		this->freeFrames.push_back(i);
+	}
+
+	glfwMakeContextCurrent(NULL); // A context can only be current on one thread
+	this->thread = std::thread(&RenderThread::ThreadLoop, this);
+}
+
+sFrameData& RenderThread::BeginFrame()
+{
+	std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->frameFreed.wait(lock, [this]() { return !this->freeFrames.empty(); });
+		this->currentFrame = this->freeFrames.back();
+		this->freeFrames.pop_back();
+	}
+	this->mainWaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+
+	sFrameData& frame = *this->frames[this->currentFrame];
+	frame.frameNumber = this->frameCount++;
+	return frame;
+}
+
+void RenderThread::EndFrame()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->queuedFrames.push_back(this->currentFrame);
+	}
+	this->frameQueued.notify_one();
+}
+
+void RenderThread::Stop()
+{
+	if (!this->thread.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->isStopping = true;
+	}
+	this->frameQueued.notify_one();
+	this->thread.join();
+
+	glfwMakeContextCurrent(this->window); // Everything still holding GL objects gets cleaned up on this thread
+}
+
+void RenderThread::PrintStats() const
+{
+	std::cout << "Render thread: " << this->framesDrawn << " frames, main thread waited " << this->mainWaitSeconds * 1000.0 << " ms for a free frame, render thread waited "
+		<< this->renderWaitSeconds * 1000.0 << " ms for a frame to draw, its frame arena peaked at " << this->arenaHighWater << " bytes" << std::endl;
+}
+
+void RenderThread::ThreadLoop()
+{
+	glfwMakeContextCurrent(this->window);
+
+	while (true)
+	{
+		unsigned int frameIndex = 0;
+		std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->frameQueued.wait(lock, [this]() { return !this->queuedFrames.empty() || this->isStopping; });
+			if (this->queuedFrames.empty()) // Stopping, and everything queued is drawn
+			{
+				break;
+			}
+
+			frameIndex = this->queuedFrames.front();
+			this->queuedFrames.erase(this->queuedFrames.begin());
+		}
+		this->renderWaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+
+		this->render(*this->frames[frameIndex]);
+		glfwSwapBuffers(this->window);
+		this->framesDrawn++;
+		this->arenaHighWater = FrameArena::GetThreadArena().GetHighWater();
+		FrameArena::GetThreadArena().Reset(); // Whatever render allocated for the frame
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->freeFrames.push_back(frameIndex);
+		}
+		this->frameFreed.notify_one();
+	}
+
+	glfwMakeContextCurrent(NULL);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Light.h"
+#include "RenderQueue.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+struct GLFWwindow;
+
+// Everything the render thread needs to draw a frame. The main thread fills it in between BeginFrame and EndFrame,
+// after that it belongs to the render thread until it's drawn, so neither side ever sees the other half written.
+struct sFrameData
+{
+	unsigned long long frameNumber = 0;
+	int width = 0;
+	int height = 0;
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec3 cameraPosition;
+	std::vector<sLightUniforms> lights;	// See LightManager::GetLightUniforms
+	RenderQueue queue;					// Already prepared, the render thread only submits it
+};
+
+// Owns the window's GL context and draws the frames the main thread hands it, so simulating frame N + 1 overlaps
+// submitting frame N. There's one frame slot more than maxFramesInFlight: the main thread fills one while up to
+// maxFramesInFlight wait for or are being drawn, and BeginFrame blocks when it gets that far ahead.
+class RenderThread
+{
+public:
+	// Called on the render thread for every frame, with the context current. The thread swaps the buffers after it.
+	typedef std::function<void(const sFrameData& frame)> RenderFunction;
+
+	RenderThread();
+	~RenderThread();
+
+	// Releases the window's context on this thread and makes it current on the render thread
+	void Start(GLFWwindow* window, unsigned int maxFramesInFlight, const RenderFunction& render);
+
+	// A free frame to fill in, waits for the render thread if every frame is in flight
+	sFrameData& BeginFrame();
+
+	// Hands the frame from BeginFrame over to the render thread
+	void EndFrame();
+
+	// Draws what's queued, stops the thread and makes the context current on this thread again
+	void Stop();
+
+	// Prints how many frames were drawn, how long each thread spent waiting on the other and how much frame arena drawing used
+	void PrintStats() const;
+
+private:
+	GLFWwindow* window;
+	RenderFunction render;
+	std::thread thread;
+
+	std::vector<sFrameData*> frames;
+	std::vector<unsigned int> freeFrames;
+	std::vector<unsigned int> queuedFrames;	// Oldest first. Start reserves it and freeFrames for every slot, so handing frames over never allocates
+	unsigned int currentFrame;	// The one between BeginFrame and EndFrame
+	unsigned long long frameCount;
+	bool isStopping;
+
+	std::mutex mutex;
+	std::condition_variable frameQueued;
+	std::condition_variable frameFreed;
+
+	// Only written by their own thread, and read after Stop
+	double mainWaitSeconds;
+	double renderWaitSeconds;
+	unsigned long long framesDrawn;
+	size_t arenaHighWater; // Of the render thread's frame arena
+
+	void ThreadLoop();
+};
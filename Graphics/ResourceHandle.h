@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// A generational handle to something owned by one of the managers.
+// The index goes straight into the manager's slot array, and the generation makes sure a handle to something that
+// has since been removed (and had its slot reused) doesn't resolve to the new thing.
+template <class Tag>
+struct ResourceHandle
+{
+	unsigned int index = 0;
+	unsigned int generation = 0; // 0 is never handed out, so a default constructed handle is always invalid
+
+	inline bool IsValid() const
+	{
+		return generation != 0;
+	}
+
+	inline bool operator==(const ResourceHandle& other) const
+	{
+		return index == other.index && generation == other.generation;
+	}
+
+	inline bool operator!=(const ResourceHandle& other) const
+	{
+		return !(*this == other);
+	}
+};
+
+class Model;
+class Light;
+class Texture;
+typedef ResourceHandle<Model> ModelHandle;
+typedef ResourceHandle<Light> LightHandle;
+typedef ResourceHandle<Texture> TextureHandle;
+
+// Slot array backing the handles. Doesn't own what it points to, the managers still delete their resources.
+template <class T>
+class HandleSlots
+{
+public:
+	typedef ResourceHandle<T> Handle;
+
+	Handle Add(T* item)
+	{
+		Handle handle;
+		if (!this->freeSlots.empty()) // Reuse a removed slot
+		{
+			handle.index = this->freeSlots.back();
+			this->freeSlots.pop_back();
+		}
+		else
+		{
+			handle.index = (unsigned int) this->slots.size();
+			this->slots.push_back(sSlot());
+		}
+
+		sSlot& slot = this->slots[handle.index];
+		slot.item = item;
+		handle.generation = slot.generation;
+		return handle;
+	}
+
+	// O(1), returns NULL if the handle is stale or was never valid
+	inline T* Get(Handle handle) const
+	{
+		if (handle.index >= this->slots.size())
+		{
+			return NULL;
+		}
+
+		const sSlot& slot = this->slots[handle.index];
+		return slot.generation == handle.generation ? slot.item : NULL;
+	}
+
+	void Remove(Handle handle)
+	{
+		if (this->Get(handle) == NULL)
+		{
+			return;
+		}
+
+		sSlot& slot = this->slots[handle.index];
+		slot.item = NULL;
+		slot.generation++; // Invalidates every handle still pointing here
+		if (slot.generation == 0)
+		{
+			slot.generation = 1;
+		}
+
+		this->freeSlots.push_back(handle.index);
+	}
+
+	void Clear()
+	{
+		for (unsigned int i = 0; i < this->slots.size(); i++)
+		{
+			if (this->slots[i].item != NULL)
+			{
+				Handle handle;
+				handle.index = i;
+				handle.generation = this->slots[i].generation;
+				this->Remove(handle);
+			}
+		}
+	}
+
+private:
+	struct sSlot
+	{
+		T* item = NULL;
+		unsigned int generation = 1;
+	};
+
+	std::vector<sSlot> slots;
+	std::vector<unsigned int> freeSlots;
+};
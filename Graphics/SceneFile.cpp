@@ -0,0 +1,523 @@
+#include "SceneFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <sstream>
+
+static const char COOKED_SCENE_MAGIC[4] = { 'C', 'S', 'C', 'N' };
+
+// Most instances one grid line can make, so a typo in the counts can't run the parser out of memory
+static const uint64_t MAX_GRID_INSTANCES = 1000000;
+
+// Followed by the models, instances, lights, panel lines, panels and strings, back to back. Every record is made of 4
+// byte fields, so they all stay aligned.
+struct sCookedSceneHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t modelCount;
+	uint32_t instanceCount;
+	uint32_t lightCount;
+	uint32_t panelLineCount;
+	uint32_t panelCount;
+	uint32_t stringSize;
+};
+
+static uint32_t AddString(sScene& scene, const std::string& text)
+{
+	uint32_t offset = (uint32_t) scene.strings.size();
+	scene.strings.insert(scene.strings.end(), text.begin(), text.end());
+	scene.strings.push_back('\0');
+	return offset;
+}
+
+static bool ReadVec3(std::istringstream& words, glm::vec3& value)
+{
+	return (bool) (words >> value.x >> value.y >> value.z);
+}
+
+static bool ReadVec4(std::istringstream& words, glm::vec4& value)
+{
+	return (bool) (words >> value.x >> value.y >> value.z >> value.w);
+}
+
+void GetRotationAxes(const glm::vec3& degrees, glm::vec3& xRot, glm::vec3& yRot, glm::vec3& zRot)
+{
+	const float toRadians = 3.14159265358979f / 180.0f;
+	float sa = std::sin(degrees.x * toRadians), ca = std::cos(degrees.x * toRadians);
+	float sb = std::sin(degrees.y * toRadians), cb = std::cos(degrees.y * toRadians);
+	float sc = std::sin(degrees.z * toRadians), cc = std::cos(degrees.z * toRadians);
+
+	xRot = glm::vec3(cc * cb, sc * cb, -sb);
+	yRot = glm::vec3(cc * sb * sa - sc * ca, sc * sb * sa + cc * ca, cb * sa);
+	zRot = glm::vec3(cc * sb * ca + sc * sa, sc * sb * ca - cc * sa, cb * ca);
+
+	glm::vec3* axes[3] = { &xRot, &yRot, &zRot };
+	for (glm::vec3* axis : axes)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			if (std::fabs((*axis)[i]) < 1e-6f)
+			{
+				(*axis)[i] = 0.0f;
+			}
+		}
+	}
+}
+
+// The options after an instance's (or grid's) position
+static bool ReadInstanceOptions(std::istringstream& words, sSceneInstance& instance, std::string& error)
+{
+	std::string option;
+	while (words >> option)
+	{
+		if (option == "rotate")
+		{
+			glm::vec3 degrees;
+			if (!ReadVec3(words, degrees))
+			{
+				error = "rotate needs x y z";
+				return false;
+			}
+			GetRotationAxes(degrees, instance.xRot, instance.yRot, instance.zRot);
+		}
+		else if (option == "scale")
+		{
+			if (!ReadVec3(words, instance.scale))
+			{
+				error = "scale needs x y z";
+				return false;
+			}
+		}
+		else if (option == "transparency")
+		{
+			if (!(words >> instance.transparency))
+			{
+				error = "transparency needs a value";
+				return false;
+			}
+		}
+		else if (option == "dynamic")
+		{
+			instance.flags &= ~SCENE_INSTANCE_STATIC;
+		}
+		else
+		{
+			error = "unknown option '" + option + "'";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool ReadLightOptions(std::istringstream& words, sSceneLight& light, std::string& error)
+{
+	std::string option;
+	while (words >> option)
+	{
+		bool isRead = true;
+		if (option == "direction")
+		{
+			glm::vec3 direction;
+			isRead = ReadVec3(words, direction);
+			light.direction = glm::vec4(direction, 1.0f);
+		}
+		else if (option == "diffuse")
+		{
+			isRead = ReadVec4(words, light.diffuse);
+		}
+		else if (option == "specular")
+		{
+			isRead = ReadVec4(words, light.specular);
+		}
+		else if (option == "attenuation")
+		{
+			isRead = ReadVec4(words, light.attenuation);
+		}
+		else if (option == "angles")
+		{
+			isRead = (bool) (words >> light.innerAngle >> light.outerAngle);
+		}
+		else if (option == "off")
+		{
+			light.isOn = 0;
+		}
+		else
+		{
+			error = "unknown option '" + option + "'";
+			return false;
+		}
+
+		if (!isRead)
+		{
+			error = option + " is missing values";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool ParseSceneLine(std::istringstream& words, const std::string& command, sScene& scene, std::map<std::string, uint32_t>& modelIndices, std::string& error)
+{
+	if (command == "model")
+	{
+		std::string name, path;
+		if (!(words >> name >> path))
+		{
+			error = "model needs a name and a path";
+			return false;
+		}
+		if (modelIndices.find(name) != modelIndices.end())
+		{
+			error = "model '" + name + "' already exists";
+			return false;
+		}
+
+		sSceneModel model;
+		model.name = AddString(scene, name);
+		model.path = AddString(scene, path);
+		model.flags = 0;
+		model.colorOverride = glm::vec4(1.0f);
+
+		std::string flag;
+		while (words >> flag)
+		{
+			if (flag == "packed")
+			{
+				model.flags |= SCENE_MODEL_PACKED_VERTICES;
+			}
+			else if (flag == "no_vertex_colors")
+			{
+				model.flags |= SCENE_MODEL_NO_VERTEX_COLORS;
+			}
+			else if (flag == "wireframe")
+			{
+				model.flags |= SCENE_MODEL_WIREFRAME;
+			}
+			else if (flag == "unlit")
+			{
+				model.flags |= SCENE_MODEL_IGNORE_LIGHTING;
+			}
+			else if (flag == "color")
+			{
+				model.flags |= SCENE_MODEL_OVERRIDE_COLOR;
+				if (!ReadVec4(words, model.colorOverride))
+				{
+					error = "color needs r g b a";
+					return false;
+				}
+			}
+			else
+			{
+				error = "unknown model flag '" + flag + "'";
+				return false;
+			}
+		}
+
+		modelIndices[name] = (uint32_t) scene.models.size();
+		scene.models.push_back(model);
+		return true;
+	}
+
+	if (command == "instance" || command == "grid" || command == "panels")
+	{
+		std::string modelName;
+		words >> modelName;
+		std::map<std::string, uint32_t>::const_iterator model = modelIndices.find(modelName);
+		if (model == modelIndices.end())
+		{
+			error = "no model called '" + modelName + "'";
+			return false;
+		}
+
+		if (command == "panels")
+		{
+			sScenePanelLine line;
+			line.model = model->second;
+			line.firstPanel = (uint32_t) scene.panels.size();
+			line.panelCount = 0;
+
+			std::string sequence;
+			if (!ReadVec3(words, line.openDirection) || !(words >> line.speed >> sequence) || (sequence != "forward" && sequence != "reverse"))
+			{
+				error = "panels needs an open direction, a speed and forward or reverse";
+				return false;
+			}
+			line.sequence = sequence == "forward" ? SCENE_PANELS_FORWARD : SCENE_PANELS_REVERSE;
+
+			// Same options as an instance, only the rotation means anything for a line
+			sSceneInstance options;
+			options.flags = 0;
+			GetRotationAxes(glm::vec3(0.0f), options.xRot, options.yRot, options.zRot);
+			if (!ReadInstanceOptions(words, options, error))
+			{
+				return false;
+			}
+			line.xRot = options.xRot;
+			line.yRot = options.yRot;
+			line.zRot = options.zRot;
+
+			scene.panelLines.push_back(line);
+			return true;
+		}
+
+		sSceneInstance instance;
+		instance.model = model->second;
+		instance.flags = SCENE_INSTANCE_STATIC;
+		GetRotationAxes(glm::vec3(0.0f), instance.xRot, instance.yRot, instance.zRot);
+		instance.scale = glm::vec3(1.0f);
+		instance.transparency = 1.0f;
+
+		unsigned int counts[3] = { 1, 1, 1 };
+		glm::vec3 step(0.0f);
+		if (!ReadVec3(words, instance.position)
+			|| (command == "grid" && (!(words >> counts[0] >> counts[1] >> counts[2]) || !ReadVec3(words, step))))
+		{
+			error = command == "grid" ? "grid needs a position, counts and a step" : "instance needs a position";
+			return false;
+		}
+		uint64_t rowCount = (uint64_t) counts[0] * counts[1]; // Checked first so the full product can't overflow
+		if (rowCount > MAX_GRID_INSTANCES || rowCount * counts[2] > MAX_GRID_INSTANCES)
+		{
+			error = "grid makes more than " + std::to_string(MAX_GRID_INSTANCES) + " instances";
+			return false;
+		}
+		if (!ReadInstanceOptions(words, instance, error))
+		{
+			return false;
+		}
+
+		glm::vec3 origin = instance.position;
+		for (unsigned int x = 0; x < counts[0]; x++)
+		{
+			for (unsigned int y = 0; y < counts[1]; y++)
+			{
+				for (unsigned int z = 0; z < counts[2]; z++)
+				{
+					instance.position = origin + step * glm::vec3((float) x, (float) y, (float) z);
+					scene.instances.push_back(instance);
+				}
+			}
+		}
+		return true;
+	}
+
+	if (command == "light")
+	{
+		std::string name, type;
+		sSceneLight light;
+		if (!(words >> name >> type) || !ReadVec3(words, light.position))
+		{
+			error = "light needs a name, a type and a position";
+			return false;
+		}
+
+		if (type == "point")
+		{
+			light.type = SCENE_LIGHT_POINT;
+		}
+		else if (type == "spot")
+		{
+			light.type = SCENE_LIGHT_SPOT;
+		}
+		else if (type == "directional")
+		{
+			light.type = SCENE_LIGHT_DIRECTIONAL;
+		}
+		else
+		{
+			error = "unknown light type '" + type + "'";
+			return false;
+		}
+
+		// What a new Light starts with
+		light.name = AddString(scene, name);
+		light.innerAngle = 0.0f;
+		light.outerAngle = 0.0f;
+		light.direction = glm::vec4(0.0f, -1.0f, 0.0f, 0.0f);
+		light.diffuse = glm::vec4(1.0f);
+		light.specular = glm::vec4(1.0f);
+		light.attenuation = glm::vec4(0.0f, 0.1f, 0.01f, 100000.0f);
+		light.isOn = 1;
+		if (!ReadLightOptions(words, light, error))
+		{
+			return false;
+		}
+
+		scene.lights.push_back(light);
+		return true;
+	}
+
+	if (command == "panel")
+	{
+		sScenePanel panel;
+		if (scene.panelLines.empty())
+		{
+			error = "panel before any panels line";
+			return false;
+		}
+		if (!ReadVec3(words, panel.closedPosition) || !(words >> panel.openedDistance))
+		{
+			error = "panel needs a position and an opened distance";
+			return false;
+		}
+
+		scene.panelLines.back().panelCount++;
+		scene.panels.push_back(panel);
+		return true;
+	}
+
+	error = "unknown record '" + command + "'";
+	return false;
+}
+
+bool ParseSceneText(const char* text, size_t size, sScene& scene, std::string& error)
+{
+	scene = sScene();
+	std::map<std::string, uint32_t> modelIndices;
+
+	std::istringstream lines(std::string(text, size));
+	std::string line;
+	unsigned int lineNumber = 0;
+	while (std::getline(lines, line))
+	{
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+
+		std::istringstream words(line);
+		std::string command;
+		if (!(words >> command))
+		{
+			continue;
+		}
+
+		if (!ParseSceneLine(words, command, scene, modelIndices, error))
+		{
+			error = "line " + std::to_string(lineNumber) + ": " + error;
+			return false;
+		}
+	}
+
+	std::stable_partition(scene.instances.begin(), scene.instances.end(), [](const sSceneInstance& instance)
+	{
+		return (instance.flags & SCENE_INSTANCE_STATIC) != 0;
+	});
+
+	return true;
+}
+
+template <class T>
+static void AppendArray(std::vector<unsigned char>& output, const std::vector<T>& values)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values.data());
+	output.insert(output.end(), bytes, bytes + values.size() * sizeof(T));
+}
+
+void WriteCookedScene(const sScene& scene, std::vector<unsigned char>& output)
+{
+	output.clear();
+
+	sCookedSceneHeader header;
+	memcpy(header.magic, COOKED_SCENE_MAGIC, sizeof(COOKED_SCENE_MAGIC));
+	header.version = COOKED_SCENE_VERSION;
+	header.modelCount = (uint32_t) scene.models.size();
+	header.instanceCount = (uint32_t) scene.instances.size();
+	header.lightCount = (uint32_t) scene.lights.size();
+	header.panelLineCount = (uint32_t) scene.panelLines.size();
+	header.panelCount = (uint32_t) scene.panels.size();
+	header.stringSize = (uint32_t) scene.strings.size();
+
+	const unsigned char* headerBytes = reinterpret_cast<const unsigned char*>(&header);
+	output.insert(output.end(), headerBytes, headerBytes + sizeof(header));
+	AppendArray(output, scene.models);
+	AppendArray(output, scene.instances);
+	AppendArray(output, scene.lights);
+	AppendArray(output, scene.panelLines);
+	AppendArray(output, scene.panels);
+	AppendArray(output, scene.strings);
+}
+
+bool IsCookedScene(const unsigned char* data, size_t size)
+{
+	return data && size >= sizeof(sCookedSceneHeader) && memcmp(data, COOKED_SCENE_MAGIC, sizeof(COOKED_SCENE_MAGIC)) == 0;
+}
+
+// Copies count records from data + offset and moves offset past them
+template <class T>
+static void CopyArray(const unsigned char* data, size_t& offset, uint32_t count, std::vector<T>& values)
+{
+	values.resize(count);
+	memcpy(values.data(), data + offset, count * sizeof(T));
+	offset += count * sizeof(T);
+}
+
+bool ReadCookedScene(const unsigned char* data, size_t size, sScene& scene)
+{
+	if (!IsCookedScene(data, size))
+	{
+		return false;
+	}
+
+	sCookedSceneHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (header.version != COOKED_SCENE_VERSION)
+	{
+		return false;
+	}
+
+	uint64_t expectedSize = sizeof(header) + (uint64_t) header.modelCount * sizeof(sSceneModel) + (uint64_t) header.instanceCount * sizeof(sSceneInstance)
+		+ (uint64_t) header.lightCount * sizeof(sSceneLight) + (uint64_t) header.panelLineCount * sizeof(sScenePanelLine)
+		+ (uint64_t) header.panelCount * sizeof(sScenePanel) + header.stringSize;
+	if (expectedSize != size)
+	{
+		return false;
+	}
+
+	size_t offset = sizeof(header);
+	CopyArray(data, offset, header.modelCount, scene.models);
+	CopyArray(data, offset, header.instanceCount, scene.instances);
+	CopyArray(data, offset, header.lightCount, scene.lights);
+	CopyArray(data, offset, header.panelLineCount, scene.panelLines);
+	CopyArray(data, offset, header.panelCount, scene.panels);
+	CopyArray(data, offset, header.stringSize, scene.strings);
+
+	// Only the indices and offsets are checked, whatever they point at is used as it is
+	if (!scene.strings.empty() && scene.strings.back() != '\0')
+	{
+		return false;
+	}
+	for (const sSceneModel& model : scene.models)
+	{
+		if (model.name >= header.stringSize || model.path >= header.stringSize)
+		{
+			return false;
+		}
+	}
+	for (const sSceneInstance& instance : scene.instances)
+	{
+		if (instance.model >= header.modelCount)
+		{
+			return false;
+		}
+	}
+	for (const sSceneLight& light : scene.lights)
+	{
+		if (light.name >= header.stringSize || light.type > SCENE_LIGHT_DIRECTIONAL)
+		{
+			return false;
+		}
+	}
+	for (const sScenePanelLine& line : scene.panelLines)
+	{
+		if (line.model >= header.modelCount || line.sequence > SCENE_PANELS_REVERSE || (uint64_t) line.firstPanel + line.panelCount > header.panelCount)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+// What goes in a scene: the models to load, where to draw them, the lights and the lines of sliding wall panels.
+// Scenes are written as text (see ParseSceneText for the format) and cooked to a binary blob by Tools/AssetCooker,
+// which is a header and then every array as it is in memory, so loading one is a single read and a copy per array.
+// Like ModelCooker nothing here touches GL, the caller creates the models and lights from the description.
+
+enum eSceneModelFlags
+{
+	SCENE_MODEL_PACKED_VERTICES = 1 << 0,	// ModelManager::LOAD_PACKED_VERTICES
+	SCENE_MODEL_NO_VERTEX_COLORS = 1 << 1,	// ModelManager::LOAD_NO_VERTEX_COLORS
+	SCENE_MODEL_WIREFRAME = 1 << 2,
+	SCENE_MODEL_IGNORE_LIGHTING = 1 << 3,
+	SCENE_MODEL_OVERRIDE_COLOR = 1 << 4		// Drawn in sSceneModel::colorOverride
+};
+
+enum eSceneInstanceFlags
+{
+	SCENE_INSTANCE_STATIC = 1 << 0			// Never moves. Static instances come first, so the ones that do can't shift them around a RenderQueue.
+};
+
+// Same values as Light::LightType
+enum eSceneLightType
+{
+	SCENE_LIGHT_POINT = 0,
+	SCENE_LIGHT_SPOT = 1,
+	SCENE_LIGHT_DIRECTIONAL = 2
+};
+
+// Same values as PanelAnimator::eSequence
+enum eScenePanelSequence
+{
+	SCENE_PANELS_FORWARD = 0,
+	SCENE_PANELS_REVERSE = 1
+};
+
+// The records are plain data of 4 byte fields, cooked scenes store them as they are. Names and paths are offsets
+// into sScene::strings.
+struct sSceneModel
+{
+	uint32_t name;
+	uint32_t path;			// Relative to the asset directory
+	uint32_t flags;			// eSceneModelFlags
+	glm::vec4 colorOverride;
+};
+
+struct sSceneInstance
+{
+	uint32_t model;			// In sScene::models
+	uint32_t flags;			// eSceneInstanceFlags
+	glm::vec3 position;
+	glm::vec3 xRot;			// Axes, like RenderQueue::Add takes them
+	glm::vec3 yRot;
+	glm::vec3 zRot;
+	glm::vec3 scale;
+	float transparency;
+};
+
+// Everything Light has, so creating one is a call per Edit function
+struct sSceneLight
+{
+	uint32_t name;
+	uint32_t type;			// eSceneLightType
+	float innerAngle;
+	float outerAngle;
+	glm::vec3 position;
+	glm::vec4 direction;
+	glm::vec4 diffuse;
+	glm::vec4 specular;		// rgb, power
+	glm::vec4 attenuation;	// constant, linear, quadratic, distance cut off
+	uint32_t isOn;
+};
+
+// A PanelAnimator line, its panels are the panelCount from firstPanel on
+struct sScenePanelLine
+{
+	uint32_t model;			// What every panel of the line is drawn with
+	uint32_t sequence;		// eScenePanelSequence
+	glm::vec3 openDirection;
+	float speed;
+	glm::vec3 xRot;
+	glm::vec3 yRot;
+	glm::vec3 zRot;
+	uint32_t firstPanel;
+	uint32_t panelCount;
+};
+
+struct sScenePanel
+{
+	glm::vec3 closedPosition;
+	float openedDistance;
+};
+
+struct sScene
+{
+	std::vector<sSceneModel> models;
+	std::vector<sSceneInstance> instances;
+	std::vector<sSceneLight> lights;
+	std::vector<sScenePanelLine> panelLines;
+	std::vector<sScenePanel> panels;
+	std::vector<char> strings; // Null terminated, back to back
+
+	inline const char* GetString(uint32_t offset) const
+	{
+		return this->strings.data() + offset;
+	}
+};
+
+// Bumped whenever the layout of a cooked scene changes, older ones fail to read
+const uint32_t COOKED_SCENE_VERSION = 1;
+
+// Parses a scene's text form. A line per record, # starts a comment, angles are in degrees:
+//	model <name> <path> [packed] [no_vertex_colors] [wireframe] [unlit] [color <r g b a>]
+//	instance <model> <x y z> [rotate <x y z>] [scale <x y z>] [transparency <t>] [dynamic]
+//	grid <model> <x y z> <count x y z> <step x y z> [same options as instance]
+//	light <name> point|spot|directional <x y z> [direction <x y z>] [diffuse <r g b a>] [specular <r g b power>]
+//		[attenuation <constant linear quadratic cutoff>] [angles <inner outer>] [off]
+//	panels <model> <open direction x y z> <speed> forward|reverse [rotate <x y z>]
+//	panel <x y z> <opened distance>
+// Rotations turn about x, then y, then z. Instances are static unless they're dynamic, panels go on the last panels line.
+// A grid makes at most a million instances.
+// Returns false and fills in error (with the line number) if the text isn't a valid scene.
+bool ParseSceneText(const char* text, size_t size, sScene& scene, std::string& error);
+
+void WriteCookedScene(const sScene& scene, std::vector<unsigned char>& output);
+
+// Whether data starts like a cooked scene, loose scene files are text
+bool IsCookedScene(const unsigned char* data, size_t size);
+
+// Copies the arrays out of a cooked scene. False if it's from another version, or anything in it is out of range.
+bool ReadCookedScene(const unsigned char* data, size_t size, sScene& scene);
+
+// The axes of rotating about x, then y, then z (degrees), as the scene's xRot, yRot and zRot. What's within rounding of
+// 0 is 0, so quarter turns come out exact.
+void GetRotationAxes(const glm::vec3& degrees, glm::vec3& xRot, glm::vec3& yRot, glm::vec3& zRot);
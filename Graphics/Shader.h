@@ -23,4 +23,5 @@ public:
 	std::vector<std::string> vecSource;
 	bool bSourceIsMultiLine;
 	std::string fileName;
+	std::vector<std::string> vecSourceFiles; // Full path of this file and every file it #includes, so we know when to reload it
 };
\ No newline at end of file
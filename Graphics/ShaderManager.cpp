@@ -1,5 +1,6 @@
 #include "ShaderManager.h"
 #include "Shader.h"
+#include "AssetReader.h"
 
 #include "GLCommon.h"
 
@@ -10,9 +11,24 @@
 #include <algorithm>
 #include <iterator>	
 #include <iostream>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1 // From GL_KHR_parallel_shader_compile, our glad is generated without extensions
+#endif
 
 ShaderManager::ShaderManager()
 {
+	this->m_parallelCompileChecked = false;
+	this->m_parallelCompileSupported = false;
+	this->m_hotReloadEnabled = false;
+	this->m_inotifyFD = -1;
 	return;
 }
 
@@ -26,6 +42,13 @@ ShaderManager::~ShaderManager()
 
 	this->m_ID_to_Shader.clear();
 	this->m_name_to_ID.clear();
+
+#ifdef __linux__
+	if (this->m_inotifyFD != -1)
+	{
+		close(this->m_inotifyFD);
+	}
+#endif
 }
 
 bool ShaderManager::useShaderProgram(unsigned int ID)
@@ -84,29 +107,176 @@ void ShaderManager::setBasePath(std::string basepath)
 	return;
 }
 
-bool ShaderManager::m_loadSourceFromFile(Shader& shader)
+// One spelling per file: forward slashes, no "." segments and every ".." that can be resolved folded into its parent.
+// The file watchers match changed files against these by name, and inotify hands out one watch per directory however
+// it was spelled.
+static std::string NormalizeShaderPath(const std::string& path)
 {
-	std::string fullFileName = this->m_basepath + shader.fileName;
+	std::vector<std::string> segments;
+	bool isAbsolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+	std::size_t start = 0;
+	while (start <= path.size())
+	{
+		std::size_t end = path.find_first_of("\\/", start);
+		if (end == std::string::npos)
+		{
+			end = path.size();
+		}
+
+		std::string segment = path.substr(start, end - start);
+		if (segment == "..")
+		{
+			if (!segments.empty() && segments.back() != "..")
+			{
+				segments.pop_back();
+			}
+			else if (!isAbsolute) // Above where the path started, keep it
+			{
+				segments.push_back(segment);
+			}
+		}
+		else if (!segment.empty() && segment != ".")
+		{
+			segments.push_back(segment);
+		}
+		start = end + 1;
+	}
 
-	std::ifstream theFile(fullFileName.c_str());
-	if (!theFile.is_open())
+	std::string normalized = isAbsolute ? "/" : "";
+	for (std::size_t i = 0; i < segments.size(); i++)
 	{
-		return false;
+		normalized += i == 0 ? segments[i] : "/" + segments[i];
 	}
+	return normalized;
+}
+
+bool ShaderManager::m_loadSourceFromFile(Shader& shader, bool fromDisk)
+{
+	std::string fullFileName = NormalizeShaderPath(this->m_basepath + shader.fileName);
 
 	shader.vecSource.clear();
+	shader.vecSourceFiles.clear();
+	return this->m_loadSourceLines(fullFileName, shader.vecSource, shader.vecSourceFiles, 0, fromDisk);
+}
+
+bool ShaderManager::m_loadSourceLines(const std::string& fullFileName, std::vector<std::string>& vecSource, std::vector<std::string>& vecSourceFiles, unsigned int depth, bool fromDisk)
+{
+	const unsigned int MAXINCLUDEDEPTH = 16; // Anything deeper than this is almost certainly an include cycle
+	if (depth > MAXINCLUDEDEPTH)
+	{
+		this->m_lastError = "Shader #include depth exceeded in " + fullFileName;
+		return false;
+	}
+
+	// Parse from memory if the file was read ahead of time or is packed. Reloads always come from disk, that's what was edited.
+	std::istringstream preloadedFile;
+	std::ifstream diskFile;
+	std::istream* theFile = &diskFile;
+	sFileView preloaded;
+	if (!fromDisk && AssetReader::GetInstance()->GetFile(fullFileName, preloaded))
+	{
+		preloadedFile.str(std::string((const char*) preloaded.data, preloaded.size));
+		theFile = &preloadedFile;
+	}
+	else
+	{
+		diskFile.open(fullFileName.c_str());
+		if (!diskFile.is_open())
+		{
+			this->m_lastError = "Could not open shader file " + fullFileName;
+			return false;
+		}
+	}
+
+	vecSourceFiles.push_back(fullFileName);
+
+	// Includes are relative to the file that includes them
+	std::string directory = "";
+	std::size_t slashIndex = fullFileName.find_last_of("\\/");
+	if (slashIndex != std::string::npos)
+	{
+		directory = fullFileName.substr(0, slashIndex + 1);
+	}
 
 	char pLineTemp[MAXLINELENGTH] = { 0 };
-	while (theFile.getline(pLineTemp, MAXLINELENGTH))
+	while (theFile->getline(pLineTemp, MAXLINELENGTH))
 	{
 		std::string tempString(pLineTemp);
-		shader.vecSource.push_back(tempString);
+		if (!tempString.empty() && tempString.back() == '\r') // Text mode strips these when reading from disk on Windows, memory keeps them
+		{
+			tempString.pop_back();
+		}
+
+		std::size_t firstChar = tempString.find_first_not_of(" \t");
+		if (firstChar != std::string::npos && tempString.compare(firstChar, 8, "#include") == 0)
+		{
+			std::size_t nameStart = tempString.find('"', firstChar);
+			std::size_t nameEnd = nameStart == std::string::npos ? std::string::npos : tempString.find('"', nameStart + 1);
+			if (nameEnd == std::string::npos)
+			{
+				this->m_lastError = "Malformed #include in " + fullFileName + ": " + tempString;
+				return false;
+			}
+
+			std::string includeFileName = NormalizeShaderPath(directory + tempString.substr(nameStart + 1, nameEnd - nameStart - 1));
+			if (!this->m_loadSourceLines(includeFileName, vecSource, vecSourceFiles, depth + 1, fromDisk))
+			{
+				return false;
+			}
+
+			continue;
+		}
+
+		vecSource.push_back(tempString);
 	}
 
-	theFile.close();
 	return true;
 }
 
+// Only a #version directive itself, not a comment or a string that mentions one
+static bool IsVersionDirective(const std::string& line)
+{
+	size_t start = line.find_first_not_of(" \t");
+	return start != std::string::npos && line.compare(start, 8, "#version") == 0;
+}
+
+void ShaderManager::m_addVariantDefines(const std::vector<std::string>& vecSource, unsigned int variantFlags, std::vector<std::string>& vecSourceOut)
+{
+	std::vector<std::string> vecDefines;
+	if (variantFlags & VARIANT_UNLIT)
+	{
+		vecDefines.push_back("#define UNLIT");
+	}
+	if (variantFlags & VARIANT_OVERRIDE_COLOR)
+	{
+		vecDefines.push_back("#define OVERRIDE_COLOR");
+	}
+	if (variantFlags & VARIANT_OPAQUE)
+	{
+		vecDefines.push_back("#define OPAQUE");
+	}
+
+	vecSourceOut.clear();
+	vecSourceOut.reserve(vecSource.size() + vecDefines.size());
+
+	// #version has to stay the first statement, so the defines go right after it (or at the top if there isn't one)
+	bool addedDefines = false;
+	for (const std::string& line : vecSource)
+	{
+		vecSourceOut.push_back(line);
+		if (!addedDefines && IsVersionDirective(line))
+		{
+			vecSourceOut.insert(vecSourceOut.end(), vecDefines.begin(), vecDefines.end());
+			addedDefines = true;
+		}
+	}
+
+	if (!addedDefines)
+	{
+		vecSourceOut.insert(vecSourceOut.begin(), vecDefines.begin(), vecDefines.end());
+	}
+}
+
 bool ShaderManager::m_wasThereACompileError(unsigned int shaderID, std::string& errorText)
 {
 	errorText = "";	
@@ -173,7 +343,12 @@ std::string ShaderManager::getLastError(void)
 
 bool ShaderManager::m_compileShaderFromSource(Shader& shader, std::string& error)
 {
-	error = "";
+	this->m_submitShaderSource(shader);
+	return this->m_checkShaderCompile(shader, error);
+}
+
+void ShaderManager::m_submitShaderSource(Shader& shader)
+{
 	const unsigned int MAXLINESIZE = 8 * 1024;	// About 8K PER LINE, which seems excessive
 	unsigned int numberOfLines = static_cast<unsigned int>(shader.vecSource.size());
 
@@ -222,6 +397,11 @@ bool ShaderManager::m_compileShaderFromSource(Shader& shader, std::string& error
 
 	// And delete the original char** array
 	delete[] arraySource;
+}
+
+bool ShaderManager::m_checkShaderCompile(Shader& shader, std::string& error)
+{
+	error = "";
 
 	// Did it work? 
 	std::string errorText = "";
@@ -241,65 +421,544 @@ bool ShaderManager::m_compileShaderFromSource(Shader& shader, std::string& error
 
 bool ShaderManager::createProgramFromFile(std::string friendlyName, Shader& vertexShad, Shader& fragShader)
 {
-	std::string errorText = "";
+	if (!this->submitProgramFromFile(friendlyName, vertexShad, fragShader))
+	{
+		return false;
+	}
 
-	// Shader loading happening before vertex buffer array
-	vertexShad.ID = glCreateShader(GL_VERTEX_SHADER);
+	// Blocking version, so finish it right away
+	return this->m_finishPendingProgram(friendlyName, VARIANT_DEFAULT, true) != NULL;
+}
+
+bool ShaderManager::submitProgramFromFile(std::string friendlyName, Shader& vertexShad, Shader& fragShader)
+{
 	vertexShad.shaderType = Shader::VERTEX_SHADER;
+	fragShader.shaderType = Shader::FRAGMENT_SHADER;
 
 	// Load some text from a file...
-	if (!this->m_loadSourceFromFile(vertexShad))
+	if (!this->m_loadSourceFromFile(vertexShad, false))
 	{
 		return false;
 	}
 
-	errorText = "";
-	if (!this->m_compileShaderFromSource(vertexShad, errorText))
+	if (!this->m_loadSourceFromFile(fragShader, false))
 	{
-		this->m_lastError = errorText;
 		return false;
 	}
 
+	sProgramSource source;
+	source.vertexShader = vertexShad;
+	source.fragmentShader = fragShader;
+	this->m_name_to_Source[friendlyName] = source;
 
-	fragShader.ID = glCreateShader(GL_FRAGMENT_SHADER); // Generate OpenGL Shader ID
-	fragShader.shaderType = Shader::FRAGMENT_SHADER;
+	this->m_submitProgram(friendlyName, source, VARIANT_DEFAULT);
+	return true;
+}
 
-	if (!this->m_loadSourceFromFile(fragShader))
+bool ShaderManager::submitShaderVariant(std::string friendlyName, unsigned int variantFlags)
+{
+	if (this->m_findPendingProgram(friendlyName, variantFlags) != this->m_pendingPrograms.end())
 	{
-		return false;
+		return true; // Already on its way
 	}
 
-	if (!this->m_compileShaderFromSource(fragShader, errorText))
+	std::map< std::string, std::map< unsigned int, CompiledShader*> >::iterator itVariants = this->m_name_to_Variants.find(friendlyName);
+	if (itVariants != this->m_name_to_Variants.end() && itVariants->second.find(variantFlags) != itVariants->second.end())
+	{
+		return itVariants->second[variantFlags] != NULL; // Already finished (or already failed)
+	}
+
+	std::map< std::string, sProgramSource>::iterator itSource = this->m_name_to_Source.find(friendlyName);
+	if (itSource == this->m_name_to_Source.end())
 	{
-		this->m_lastError = errorText;
 		return false;
 	}
 
+	this->m_submitProgram(friendlyName, itSource->second, variantFlags);
+	return true;
+}
 
-	CompiledShader* curProgram = new CompiledShader();
-	curProgram->ID = glCreateProgram(); // Create shader program
+CompiledShader* ShaderManager::pGetShaderVariant(std::string friendlyName, unsigned int variantFlags)
+{
+	std::map< std::string, std::map< unsigned int, CompiledShader*> >::iterator itVariants = this->m_name_to_Variants.find(friendlyName);
+	if (itVariants != this->m_name_to_Variants.end())
+	{
+		std::map< unsigned int, CompiledShader*>::iterator itVariant = itVariants->second.find(variantFlags);
+		if (itVariant != itVariants->second.end())
+		{
+			return itVariant->second;
+		}
+	}
+
+	// First time this variant was asked for, start compiling it from the cached source.
+	// We don't wait on the driver here, the caller gets NULL until the program is done (see pollPendingPrograms)
+	if (!this->submitShaderVariant(friendlyName, variantFlags))
+	{
+		return NULL;
+	}
+
+	return this->m_finishPendingProgram(friendlyName, variantFlags, false);
+}
+
+unsigned int ShaderManager::pollPendingPrograms(void)
+{
+	std::vector<sPendingProgram>::iterator it = this->m_pendingPrograms.begin();
+	while (it != this->m_pendingPrograms.end())
+	{
+		if (!this->m_isPendingProgramComplete(*it))
+		{
+			it++;
+			continue;
+		}
+
+		sPendingProgram pending = *it;
+		it = this->m_pendingPrograms.erase(it);
+		this->m_linkPendingProgram(pending);
+	}
+
+	return static_cast<unsigned int>(this->m_pendingPrograms.size());
+}
+
+bool ShaderManager::waitForPendingPrograms(void)
+{
+	bool allLinked = true;
+	while (!this->m_pendingPrograms.empty())
+	{
+		sPendingProgram pending = this->m_pendingPrograms.front();
+		this->m_pendingPrograms.erase(this->m_pendingPrograms.begin());
+		if (!this->m_linkPendingProgram(pending))
+		{
+			allLinked = false;
+		}
+	}
+
+	return allLinked;
+}
+
+bool ShaderManager::isParallelCompileSupported(void)
+{
+	this->m_initParallelCompile();
+	return this->m_parallelCompileSupported;
+}
+
+void ShaderManager::m_initParallelCompile(void)
+{
+	if (this->m_parallelCompileChecked)
+	{
+		return;
+	}
+
+	// Can't be done in the constructor, we're usually created before there is a GL context
+	this->m_parallelCompileChecked = true;
+	this->m_parallelCompileSupported = glfwExtensionSupported("GL_KHR_parallel_shader_compile") || glfwExtensionSupported("GL_ARB_parallel_shader_compile");
+	if (!this->m_parallelCompileSupported)
+	{
+		return;
+	}
+
+	typedef void (APIENTRYP PFNMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+	PFNMAXSHADERCOMPILERTHREADSPROC maxShaderCompilerThreads = (PFNMAXSHADERCOMPILERTHREADSPROC) glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+	if (!maxShaderCompilerThreads)
+	{
+		maxShaderCompilerThreads = (PFNMAXSHADERCOMPILERTHREADSPROC) glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+	}
+
+	if (maxShaderCompilerThreads)
+	{
+		maxShaderCompilerThreads(0xFFFFFFFF); // Let the driver use as many threads as it wants
+	}
+}
 
-	glAttachShader(curProgram->ID, vertexShad.ID);
-	glAttachShader(curProgram->ID, fragShader.ID);
-	glLinkProgram(curProgram->ID);
+void ShaderManager::m_submitProgram(std::string friendlyName, const sProgramSource& source, unsigned int variantFlags)
+{
+	this->m_initParallelCompile();
+
+	sPendingProgram pending;
+	pending.friendlyName = friendlyName;
+	pending.variantFlags = variantFlags;
+	pending.isReload = false;
+
+	// Shader loading happening before vertex buffer array
+	pending.vertexShader.fileName = source.vertexShader.fileName;
+	pending.vertexShader.shaderType = source.vertexShader.shaderType;
+	this->m_addVariantDefines(source.vertexShader.vecSource, variantFlags, pending.vertexShader.vecSource);
+	pending.vertexShader.ID = glCreateShader(GL_VERTEX_SHADER);
+	this->m_submitShaderSource(pending.vertexShader);
+	pending.vertexShader.vecSource.clear(); // The driver has its own copy now
+
+	pending.fragmentShader.fileName = source.fragmentShader.fileName;
+	pending.fragmentShader.shaderType = source.fragmentShader.shaderType;
+	this->m_addVariantDefines(source.fragmentShader.vecSource, variantFlags, pending.fragmentShader.vecSource);
+	pending.fragmentShader.ID = glCreateShader(GL_FRAGMENT_SHADER); // Generate OpenGL Shader ID
+	this->m_submitShaderSource(pending.fragmentShader);
+	pending.fragmentShader.vecSource.clear();
+
+	// Link straight away without asking how the compile went, asking would make us wait on the driver.
+	// If a shader failed to compile the link fails too, and we report the compile log when we finish.
+	pending.programID = glCreateProgram(); // Create shader program
+	glAttachShader(pending.programID, pending.vertexShader.ID);
+	glAttachShader(pending.programID, pending.fragmentShader.ID);
+	glLinkProgram(pending.programID);
+
+	this->m_pendingPrograms.push_back(pending);
+}
+
+std::vector<ShaderManager::sPendingProgram>::iterator ShaderManager::m_findPendingProgram(const std::string& friendlyName, unsigned int variantFlags)
+{
+	std::vector<sPendingProgram>::iterator it;
+	for (it = this->m_pendingPrograms.begin(); it != this->m_pendingPrograms.end(); it++)
+	{
+		if (it->variantFlags == variantFlags && it->friendlyName == friendlyName)
+		{
+			break;
+		}
+	}
+
+	return it;
+}
+
+bool ShaderManager::m_isPendingProgramComplete(const sPendingProgram& pending)
+{
+	if (!this->m_parallelCompileSupported)
+	{
+		return true; // No way to ask without blocking, so the status query in m_linkPendingProgram is where we'll wait
+	}
 
-	// Was there a link error? 
-	errorText = "";
-	if (this->m_wasThereALinkError(curProgram->ID, errorText))
+	GLint isComplete = GL_FALSE;
+	glGetProgramiv(pending.programID, GL_COMPLETION_STATUS_KHR, &isComplete);
+	return isComplete == GL_TRUE;
+}
+
+CompiledShader* ShaderManager::m_finishPendingProgram(const std::string& friendlyName, unsigned int variantFlags, bool block)
+{
+	std::vector<sPendingProgram>::iterator it = this->m_findPendingProgram(friendlyName, variantFlags);
+	if (it == this->m_pendingPrograms.end())
+	{
+		std::map< std::string, std::map< unsigned int, CompiledShader*> >::iterator itVariants = this->m_name_to_Variants.find(friendlyName);
+		if (itVariants == this->m_name_to_Variants.end() || itVariants->second.find(variantFlags) == itVariants->second.end())
+		{
+			return NULL;
+		}
+
+		return itVariants->second[variantFlags]; // Someone else already finished it
+	}
+
+	if (!block && !this->m_isPendingProgramComplete(*it))
+	{
+		return NULL;
+	}
+
+	sPendingProgram pending = *it;
+	this->m_pendingPrograms.erase(it);
+	return this->m_linkPendingProgram(pending);
+}
+
+CompiledShader* ShaderManager::m_linkPendingProgram(sPendingProgram& pending)
+{
+	std::string errorText = "";
+
+	bool compiled = this->m_checkShaderCompile(pending.vertexShader, errorText);
+	if (compiled)
+	{
+		compiled = this->m_checkShaderCompile(pending.fragmentShader, errorText);
+	}
+
+	if (!compiled)
+	{
+		this->m_lastError = errorText;
+	}
+	else if (this->m_wasThereALinkError(pending.programID, errorText)) // Was there a link error? 
 	{
 		std::stringstream ssError;
 		ssError << "Shader program link error: ";
 		ssError << errorText;
 		this->m_lastError = ssError.str();
-		return false;
+		compiled = false;
+	}
+
+	// The program keeps what it needs, the shader objects get freed along with it
+	glDeleteShader(pending.vertexShader.ID);
+	glDeleteShader(pending.fragmentShader.ID);
+
+	if (!compiled)
+	{
+		glDeleteProgram(pending.programID);
+		if (!pending.isReload)
+		{
+			this->m_name_to_Variants[pending.friendlyName][pending.variantFlags] = NULL; // Remember the failure so a broken variant isn't recompiled on every draw
+		}
+		return NULL;
+	}
+
+	if (pending.isReload)
+	{
+		CompiledShader* curProgram = this->m_name_to_Variants[pending.friendlyName][pending.variantFlags];
+		if (curProgram)
+		{
+			// Swap the program in place, so everyone holding on to this CompiledShader gets the new one
+			CompiledShader newProgram;
+			newProgram.ID = pending.programID;
+			newProgram.LoadAllUniformLocations();
+
+			sReloadedProgram reloaded;
+			reloaded.oldID = curProgram->ID;
+			reloaded.program = curProgram;
+
+			glDeleteProgram(curProgram->ID);
+			this->m_ID_to_Shader.erase(curProgram->ID);
+
+			curProgram->ID = newProgram.ID;
+			curProgram->mapUniformName_to_UniformLocation.swap(newProgram.mapUniformName_to_UniformLocation);
+
+			this->m_ID_to_Shader[curProgram->ID] = curProgram;
+			if (curProgram->variantFlags == VARIANT_DEFAULT)
+			{
+				this->m_name_to_ID[curProgram->friendlyName] = curProgram->ID;
+			}
+
+			this->m_reloadedPrograms.push_back(reloaded);
+			return curProgram;
+		}
 	}
 
 	// At this point, shaders are compiled and linked into a program
-	curProgram->friendlyName = friendlyName;
+	CompiledShader* curProgram = new CompiledShader();
+	curProgram->ID = pending.programID;
+	curProgram->friendlyName = pending.friendlyName;
+	curProgram->variantFlags = pending.variantFlags;
+	curProgram->pOwner = this;
+	curProgram->LoadAllUniformLocations();
 
 	// Add the shader to the maps
 	this->m_ID_to_Shader[curProgram->ID] = curProgram;
-	this->m_name_to_ID[curProgram->friendlyName] = curProgram->ID;
+	this->m_name_to_Variants[curProgram->friendlyName][curProgram->variantFlags] = curProgram;
+	if (curProgram->variantFlags == VARIANT_DEFAULT)
+	{
+		this->m_name_to_ID[curProgram->friendlyName] = curProgram->ID;
+	}
+
+	if (pending.isReload)
+	{
+		// A variant that failed before and works now, nobody has it yet so it's reported as new
+		sReloadedProgram reloaded;
+		reloaded.oldID = 0;
+		reloaded.program = curProgram;
+		this->m_reloadedPrograms.push_back(reloaded);
+	}
+
+	return curProgram;
+}
+
+bool ShaderManager::enableHotReload(void)
+{
+#ifdef __linux__
+	if (this->m_inotifyFD == -1)
+	{
+		this->m_inotifyFD = inotify_init1(IN_NONBLOCK);
+		if (this->m_inotifyFD == -1)
+		{
+			std::cout << "inotify unavailable, falling back to polling shader file times" << std::endl;
+		}
+	}
+#endif
 
+	this->m_hotReloadEnabled = true;
+	this->m_watchSourceFiles();
 	return true;
 }
+
+bool ShaderManager::updateHotReload(std::vector<sReloadedProgram>& vecReloadedOut)
+{
+	if (!this->m_hotReloadEnabled)
+	{
+		return true;
+	}
+
+	bool success = true;
+
+	std::vector<std::string> vecChangedFiles;
+	this->m_getChangedFiles(vecChangedFiles);
+
+	if (!vecChangedFiles.empty())
+	{
+		// Find every program that uses one of the changed files, either directly or through an #include
+		std::map< std::string, sProgramSource>::iterator itSource;
+		std::vector<std::string> vecChangedPrograms;
+		for (itSource = this->m_name_to_Source.begin(); itSource != this->m_name_to_Source.end(); itSource++)
+		{
+			const std::vector<std::string>& vertexFiles = itSource->second.vertexShader.vecSourceFiles;
+			const std::vector<std::string>& fragmentFiles = itSource->second.fragmentShader.vecSourceFiles;
+			for (const std::string& changedFile : vecChangedFiles)
+			{
+				if (std::find(vertexFiles.begin(), vertexFiles.end(), changedFile) != vertexFiles.end()
+					|| std::find(fragmentFiles.begin(), fragmentFiles.end(), changedFile) != fragmentFiles.end())
+				{
+					vecChangedPrograms.push_back(itSource->first);
+					break;
+				}
+			}
+		}
+
+		for (const std::string& friendlyName : vecChangedPrograms)
+		{
+			if (!this->m_reloadProgram(friendlyName))
+			{
+				success = false;
+			}
+		}
+
+		this->m_watchSourceFiles(); // In case an #include was added
+	}
+
+	// Finish whatever the driver is done with. The swaps happen here, so they never happen in the middle of a frame
+	std::size_t pendingCount = this->m_pendingPrograms.size();
+	std::vector<sPendingProgram>::iterator it = this->m_pendingPrograms.begin();
+	while (it != this->m_pendingPrograms.end())
+	{
+		if (!it->isReload || !this->m_isPendingProgramComplete(*it))
+		{
+			it++;
+			continue;
+		}
+
+		sPendingProgram pending = *it;
+		it = this->m_pendingPrograms.erase(it);
+		if (!this->m_linkPendingProgram(pending))
+		{
+			std::cout << "Failed to reload shader '" << pending.friendlyName << "', keeping the old one" << std::endl;
+			success = false;
+		}
+	}
+
+	vecReloadedOut.insert(vecReloadedOut.end(), this->m_reloadedPrograms.begin(), this->m_reloadedPrograms.end());
+	this->m_reloadedPrograms.clear();
+
+	return success;
+}
+
+bool ShaderManager::m_reloadProgram(const std::string& friendlyName)
+{
+	std::map< std::string, sProgramSource>::iterator itSource = this->m_name_to_Source.find(friendlyName);
+	if (itSource == this->m_name_to_Source.end())
+	{
+		return false;
+	}
+
+	// Read into a copy, if the files can't be read (editor still writing them, etc) we keep the old source
+	sProgramSource source = itSource->second;
+	if (!this->m_loadSourceFromFile(source.vertexShader, true) || !this->m_loadSourceFromFile(source.fragmentShader, true))
+	{
+		return false;
+	}
+
+	itSource->second = source;
+
+	std::map< unsigned int, CompiledShader*>& variants = this->m_name_to_Variants[friendlyName];
+	std::map< unsigned int, CompiledShader*>::iterator itVariant = variants.begin();
+	while (itVariant != variants.end())
+	{
+		unsigned int variantFlags = itVariant->first;
+
+		// A newer version of the file replaces anything that was still compiling
+		std::vector<sPendingProgram>::iterator itPending = this->m_findPendingProgram(friendlyName, variantFlags);
+		if (itPending != this->m_pendingPrograms.end())
+		{
+			this->m_discardPendingProgram(itPending);
+		}
+
+		// Variants that failed before (NULL) get another go too, they're added as new programs if they work now
+		this->m_submitProgram(friendlyName, source, variantFlags);
+		this->m_pendingPrograms.back().isReload = true;
+		itVariant++;
+	}
+
+	std::cout << "Reloading shader '" << friendlyName << "'" << std::endl;
+	return true;
+}
+
+void ShaderManager::m_discardPendingProgram(std::vector<sPendingProgram>::iterator itPending)
+{
+	glDeleteProgram(itPending->programID);
+	glDeleteShader(itPending->vertexShader.ID);
+	glDeleteShader(itPending->fragmentShader.ID);
+	this->m_pendingPrograms.erase(itPending);
+}
+
+void ShaderManager::m_watchSourceFiles(void)
+{
+	std::map< std::string, sProgramSource>::iterator itSource;
+	for (itSource = this->m_name_to_Source.begin(); itSource != this->m_name_to_Source.end(); itSource++)
+	{
+		std::vector<std::string> vecFiles = itSource->second.vertexShader.vecSourceFiles;
+		vecFiles.insert(vecFiles.end(), itSource->second.fragmentShader.vecSourceFiles.begin(), itSource->second.fragmentShader.vecSourceFiles.end());
+
+		for (const std::string& fileName : vecFiles)
+		{
+#ifdef __linux__
+			if (this->m_inotifyFD != -1)
+			{
+				// Watch the directory rather than the file, editors often save by replacing the file
+				std::size_t slashIndex = fileName.find_last_of("\\/");
+				std::string directory = slashIndex == std::string::npos ? "./" : fileName.substr(0, slashIndex + 1);
+				int watch = inotify_add_watch(this->m_inotifyFD, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+				if (watch != -1)
+				{
+					this->m_watch_to_Directory[watch] = slashIndex == std::string::npos ? "" : directory;
+				}
+				continue;
+			}
+#endif
+			if (this->m_file_to_WriteTime.find(fileName) == this->m_file_to_WriteTime.end())
+			{
+				struct stat fileStat;
+				this->m_file_to_WriteTime[fileName] = stat(fileName.c_str(), &fileStat) == 0 ? (long long) fileStat.st_mtime : 0;
+			}
+		}
+	}
+}
+
+void ShaderManager::m_getChangedFiles(std::vector<std::string>& vecChangedFiles)
+{
+#ifdef __linux__
+	if (this->m_inotifyFD != -1)
+	{
+		char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+		ssize_t length;
+		while ((length = read(this->m_inotifyFD, buffer, sizeof(buffer))) > 0)
+		{
+			for (char* pEvent = buffer; pEvent < buffer + length; pEvent += sizeof(struct inotify_event) + ((struct inotify_event*) pEvent)->len)
+			{
+				const struct inotify_event* event = (const struct inotify_event*) pEvent;
+				std::map< int, std::string>::iterator itWatch = this->m_watch_to_Directory.find(event->wd);
+				if (event->len == 0 || itWatch == this->m_watch_to_Directory.end())
+				{
+					continue;
+				}
+
+				std::string fileName = itWatch->second + event->name;
+				if (std::find(vecChangedFiles.begin(), vecChangedFiles.end(), fileName) == vecChangedFiles.end())
+				{
+					vecChangedFiles.push_back(fileName);
+				}
+			}
+		}
+		return;
+	}
+#endif
+
+	std::map< std::string, long long>::iterator itFile;
+	for (itFile = this->m_file_to_WriteTime.begin(); itFile != this->m_file_to_WriteTime.end(); itFile++)
+	{
+		struct stat fileStat;
+		if (stat(itFile->first.c_str(), &fileStat) != 0)
+		{
+			continue; // Probably in the middle of being saved, try again next time
+		}
+
+		if ((long long) fileStat.st_mtime != itFile->second)
+		{
+			itFile->second = (long long) fileStat.st_mtime;
+			vecChangedFiles.push_back(itFile->first);
+		}
+	}
+}
@@ -13,12 +13,43 @@ public:
 	ShaderManager();
 	~ShaderManager();
 
+	// Compile-time specializations of a program. Each flag is injected as a #define right after the #version line,
+	// so the GLSL can #ifdef away the branches that would otherwise be toggled by uniforms.
+	enum eShaderVariant
+	{
+		VARIANT_DEFAULT = 0,
+		VARIANT_UNLIT = 1 << 0,				// #define UNLIT (replaces the isIgnoreLighting uniform)
+		VARIANT_OVERRIDE_COLOR = 1 << 1,	// #define OVERRIDE_COLOR (replaces the isOverrideColor uniform)
+		VARIANT_OPAQUE = 1 << 2,			// #define OPAQUE (uTransparency is not used, alpha is 1.0)
+		VARIANT_COUNT = 1 << 3
+	};
+
 	bool useShaderProgram(unsigned int ID);
 
 	bool useShaderProgram(std::string friendlyName);
 
 	bool createProgramFromFile(std::string friendlyName, Shader& vertexShad, Shader& fragShader);
 
+	// Same as createProgramFromFile, but only hands the compile and link to the driver without waiting for it.
+	// The program shows up once pollPendingPrograms or waitForPendingPrograms finishes it.
+	bool submitProgramFromFile(std::string friendlyName, Shader& vertexShad, Shader& fragShader);
+
+	// Starts compiling a variant of a submitted program without waiting for it. Returns false if there is no such program.
+	bool submitShaderVariant(std::string friendlyName, unsigned int variantFlags);
+
+	// Returns the variant of a program, compiling it from the cached source the first time it is asked for.
+	// Never waits on the driver: returns NULL while the variant is still compiling, or if it failed to compile (see getLastError)
+	CompiledShader* pGetShaderVariant(std::string friendlyName, unsigned int variantFlags);
+
+	// Finishes every submitted program the driver is done with. Returns how many are still compiling.
+	unsigned int pollPendingPrograms(void);
+
+	// Blocks until every submitted program is finished. Returns false if any of them failed (see getLastError)
+	bool waitForPendingPrograms(void);
+
+	// True if the driver compiles in the background (GL_KHR_parallel_shader_compile), otherwise polling just finishes everything
+	bool isParallelCompileSupported(void);
+
 	void setBasePath(std::string basepath);
 
 	unsigned int getIDFromFriendlyName(std::string friendlyName);
@@ -26,6 +57,22 @@ public:
 	// Used to load the uniforms. Returns NULL if not found.
 	CompiledShader* pGetShaderProgramFromFriendlyName(std::string friendlyName);
 
+	// A program that was swapped for a freshly compiled one by updateHotReload
+	struct sReloadedProgram
+	{
+		unsigned int oldID;			// 0 if it's a variant that failed to build before, so it's a new program to set up
+		CompiledShader* program;
+	};
+
+	// Starts watching the source files (and #includes) of every program for changes
+	bool enableHotReload(void);
+
+	// Call between frames. Recompiles programs whose source files changed, and swaps in the ones that finished compiling.
+	// Swapped programs keep the same CompiledShader, only the ID and uniform locations change, and are added to vecReloadedOut.
+	// Every program a reload submits is finished here, variants that failed before are retried and added if they build.
+	// Returns false if a reload failed (see getLastError), in that case the old program stays in use.
+	bool updateHotReload(std::vector<sReloadedProgram>& vecReloadedOut);
+
 	// Clears last error
 	std::string getLastError(void);
 private:
@@ -34,11 +81,81 @@ private:
 	std::map< unsigned int, CompiledShader*> m_ID_to_Shader;
 	std::map< std::string, unsigned int> m_name_to_ID;
 
-	// Returns an empty string if it didn't work
-	bool m_loadSourceFromFile(Shader& shader);
+	// Include-expanded source of each program, kept so that variants can be compiled without touching the disk again
+	struct sProgramSource
+	{
+		Shader vertexShader;
+		Shader fragmentShader;
+	};
+	std::map< std::string, sProgramSource> m_name_to_Source;
+	std::map< std::string, std::map< unsigned int, CompiledShader*> > m_name_to_Variants;
+
+	// Returns an empty string if it didn't work. fromDisk skips preloaded and packed files (see AssetReader).
+	bool m_loadSourceFromFile(Shader& shader, bool fromDisk);
+
+	// Reads a file line by line, replacing any #include "file" line with the contents of that file (relative to the including file)
+	bool m_loadSourceLines(const std::string& fullFileName, std::vector<std::string>& vecSource, std::vector<std::string>& vecSourceFiles, unsigned int depth, bool fromDisk);
+
+	// Copies the source, adding the #defines for the variant flags after the #version line
+	void m_addVariantDefines(const std::vector<std::string>& vecSource, unsigned int variantFlags, std::vector<std::string>& vecSourceOut);
+
+	// A program that has been handed to the driver but not checked yet
+	struct sPendingProgram
+	{
+		std::string friendlyName;
+		unsigned int variantFlags;
+		unsigned int programID;
+		Shader vertexShader;
+		Shader fragmentShader;
+		bool isReload; // Replaces the existing program once it's done (added if the variant failed before), finished by updateHotReload
+	};
+	std::vector<sPendingProgram> m_pendingPrograms;
+	std::vector<sReloadedProgram> m_reloadedPrograms;
+
+	bool m_hotReloadEnabled;
+	int m_inotifyFD; // Only used on Linux
+	std::map< int, std::string> m_watch_to_Directory;
+	std::map< std::string, long long> m_file_to_WriteTime; // Used when inotify isn't available
+
+	// Adds the source files of every program to what we watch
+	void m_watchSourceFiles(void);
+
+	// Fills in the files that changed since we last asked
+	void m_getChangedFiles(std::vector<std::string>& vecChangedFiles);
+
+	// Rereads the source of a program and submits every variant of it again
+	bool m_reloadProgram(const std::string& friendlyName);
+
+	// Deletes a program that was submitted but never finished
+	void m_discardPendingProgram(std::vector<sPendingProgram>::iterator itPending);
+
+	bool m_parallelCompileChecked;
+	bool m_parallelCompileSupported;
+
+	void m_initParallelCompile(void);
+
+	// Compiles and links the variant of the given program source without checking the result
+	void m_submitProgram(std::string friendlyName, const sProgramSource& source, unsigned int variantFlags);
+
+	std::vector<sPendingProgram>::iterator m_findPendingProgram(const std::string& friendlyName, unsigned int variantFlags);
+
+	// Asks the driver with GL_COMPLETION_STATUS_KHR, always true without parallel compile support
+	bool m_isPendingProgramComplete(const sPendingProgram& pending);
+
+	// Links the pending program if it's done (or always when block is true). Returns NULL if it isn't done or failed
+	CompiledShader* m_finishPendingProgram(const std::string& friendlyName, unsigned int variantFlags, bool block);
+
+	// Checks the compile/link status and adds the program to the maps. Returns NULL on failure
+	CompiledShader* m_linkPendingProgram(sPendingProgram& pending);
 
 	bool m_compileShaderFromSource(Shader& shader, std::string& error);
 
+	// Hands the source to the driver and starts compiling, doesn't wait for it
+	void m_submitShaderSource(Shader& shader);
+
+	// Returns false (and fills error) if the shader didn't compile
+	bool m_checkShaderCompile(Shader& shader, std::string& error);
+
 	// returns false if no error
 	bool m_wasThereACompileError(unsigned int shaderID, std::string& errorText);
 
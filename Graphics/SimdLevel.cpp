@@ -0,0 +1,48 @@
+#include "SimdLevel.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_LEVEL_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+static eSimdLevel DetectSimdLevel()
+{
+#if !defined(SIMD_LEVEL_X86)
+	return SIMD_SCALAR;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	__cpuid(info, 1);
+	bool hasSse2 = (info[3] & (1 << 26)) != 0;
+	bool hasAvx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6; // And the OS saves the YMM registers
+	bool hasAvx2 = false;
+	if (hasAvx && maxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		hasAvx2 = (info[1] & (1 << 5)) != 0;
+	}
+	return hasAvx2 ? SIMD_AVX2 : hasSse2 ? SIMD_SSE2 : SIMD_SCALAR;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") ? SIMD_AVX2 : __builtin_cpu_supports("sse2") ? SIMD_SSE2 : SIMD_SCALAR;
+#endif
+}
+
+eSimdLevel GetSimdLevel()
+{
+	static const eSimdLevel level = DetectSimdLevel();
+	return level;
+}
+
+const char* GetSimdLevelName(eSimdLevel level)
+{
+	switch (level)
+	{
+	case SIMD_SSE2: return "SSE2";
+	case SIMD_AVX2: return "AVX2";
+	default: return "scalar";
+	}
+}
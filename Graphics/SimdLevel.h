@@ -0,0 +1,15 @@
+#pragma once
+
+// Which SIMD instruction sets the code paths that have them (see VertexConversion, PanelAnimator, PlyLoader) can use
+
+enum eSimdLevel
+{
+	SIMD_SCALAR,
+	SIMD_SSE2,
+	SIMD_AVX2
+};
+
+// The best level this CPU (and OS) supports, checked once
+eSimdLevel GetSimdLevel();
+
+const char* GetSimdLevelName(eSimdLevel level);
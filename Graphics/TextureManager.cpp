@@ -1,5 +1,6 @@
 #include "TextureManager.h"
 #include "SOIL2.H"
+#include "AssetReader.h"
 
 #include <iostream>
 
@@ -35,9 +36,12 @@ void TextureManager::CleanUp()
 
 	this->pathTextureMap.clear();
 	this->friendlyNameTextureMap.clear();
+	this->friendlyNameHandleMap.clear();
+	this->pathHandleMap.clear();
+	this->textureSlots.Clear();
 }
 
-Texture* TextureManager::GetTextureFromPath(std::string path)
+Texture* TextureManager::GetTextureFromPath(const std::string& path)
 {
 	std::map<std::string, Texture*>::iterator it = this->pathTextureMap.find(path);
 	if (it != this->pathTextureMap.end())
@@ -48,7 +52,7 @@ Texture* TextureManager::GetTextureFromPath(std::string path)
 	return NULL;
 }
 
-Texture* TextureManager::GetTextureFromFriendlyName(std::string name)
+Texture* TextureManager::GetTextureFromFriendlyName(const std::string& name)
 {
 	std::map<std::string, Texture*>::iterator it = this->friendlyNameTextureMap.find(name);
 	if (it != this->friendlyNameTextureMap.end())
@@ -59,26 +63,37 @@ Texture* TextureManager::GetTextureFromFriendlyName(std::string name)
 	return NULL;
 }
 
-Texture* TextureManager::LoadTexture(const std::string& path, TextureType type, const std::string& name)
+TextureHandle TextureManager::GetTextureHandle(const std::string& name)
 {
-	Texture* texture = this->GetTextureFromPath(path);
-	if (texture) // This texture was already loaded from here
+	std::map<std::string, TextureHandle>::iterator it = this->friendlyNameHandleMap.find(name);
+	if (it != this->friendlyNameHandleMap.end())
 	{
-		return texture;
+		return it->second;
+	}
+
+	return TextureHandle();
+}
+
+TextureHandle TextureManager::LoadTexture(const std::string& path, TextureType type, const std::string& name)
+{
+	std::map<std::string, TextureHandle>::iterator itPath = this->pathHandleMap.find(path);
+	if (itPath != this->pathHandleMap.end()) // This texture was already loaded from here
+	{
+		return itPath->second;
 	}
 
-	texture = this->GetTextureFromFriendlyName(name);
+	Texture* texture = this->GetTextureFromFriendlyName(name);
 	if (texture) // A texture already exists with this name
 	{
 		std::cout << "A texture already exists with friendly name '" << name << "'!" << std::endl;
-		return NULL;
+		return TextureHandle();
 	}
 
 	GLuint id;
 	id = this->LoadTextureFromFile(path.c_str());
 	if (id == 0)
 	{
-		return NULL;
+		return TextureHandle();
 	}
 
 	std::string typeString;
@@ -94,8 +109,11 @@ Texture* TextureManager::LoadTexture(const std::string& path, TextureType type,
 	texture = new Texture(id, path, typeString);
 	this->pathTextureMap.insert(std::make_pair(path, texture));
 	this->friendlyNameTextureMap.insert(std::make_pair(name, texture));
+	TextureHandle handle = this->textureSlots.Add(texture);
+	this->friendlyNameHandleMap.insert(std::make_pair(name, handle));
+	this->pathHandleMap.insert(std::make_pair(path, handle));
 
-	return texture;
+	return handle;
 }
 
 GLuint TextureManager::LoadTextureFromFile(const char* path)
@@ -103,7 +121,16 @@ GLuint TextureManager::LoadTextureFromFile(const char* path)
 	GLuint textureID = 0;
 
 	int width, height;
-	uint8_t* data = SOIL_load_image(path, &width, &height, 0, SOIL_LOAD_RGB); // Read image file
+	uint8_t* data = NULL;
+	sFileView preloaded;
+	if (AssetReader::GetInstance()->GetFile(path, preloaded)) // Already read or packed, just decode it
+	{
+		data = SOIL_load_image_from_memory(preloaded.data, (int) preloaded.size, &width, &height, 0, SOIL_LOAD_RGB);
+	}
+	else
+	{
+		data = SOIL_load_image(path, &width, &height, 0, SOIL_LOAD_RGB); // Read image file
+	}
 
 	if (data)
 	{
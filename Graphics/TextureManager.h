@@ -2,6 +2,7 @@
 
 #include "GLCommon.h"
 #include "Texture.h"
+#include "ResourceHandle.h"
 
 #include <string>
 #include <map>
@@ -19,11 +20,21 @@ public:
 
 	static TextureManager* GetInstance();
 
-	Texture* LoadTexture(const std::string& path, TextureType type, const std::string& name);
+	// Returns the handle of the texture already loaded from path if there is one, an invalid handle if it can't be loaded
+	TextureHandle LoadTexture(const std::string& path, TextureType type, const std::string& name);
 
-	Texture* GetTextureFromPath(std::string path);
+	// Name lookups, meant for load time. Resolve a handle once and use that when drawing.
+	Texture* GetTextureFromPath(const std::string& path);
 
-	Texture* GetTextureFromFriendlyName(std::string name);
+	Texture* GetTextureFromFriendlyName(const std::string& name);
+
+	TextureHandle GetTextureHandle(const std::string& name);
+
+	// O(1), returns NULL if the handle is no longer valid
+	inline Texture* GetTexture(TextureHandle handle) const
+	{
+		return this->textureSlots.Get(handle);
+	}
 
 	void CleanUp();
 
@@ -34,4 +45,7 @@ private:
 	static TextureManager* instance;
 	std::map<std::string, Texture*> pathTextureMap;
 	std::map<std::string, Texture*> friendlyNameTextureMap;
+	std::map<std::string, TextureHandle> friendlyNameHandleMap;
+	std::map<std::string, TextureHandle> pathHandleMap;
+	HandleSlots<Texture> textureSlots;
 };
\ No newline at end of file
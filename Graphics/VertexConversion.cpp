@@ -0,0 +1,222 @@
+#include "VertexConversion.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define VERTEX_CONVERSION_X86
+#include <immintrin.h>
+#endif
+
+// MSVC compiles any intrinsic anywhere, GCC and Clang need the functions using them marked (the CPU is checked before calling them)
+#if defined(_MSC_VER)
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// What each of our vertex structs has after the position and normal (floats 0-5)
+enum eVertexTail
+{
+	TAIL_NONE,		// sPositionNormalVertex
+	TAIL_COLOR,		// sColoredVertex, r g b a
+	TAIL_TEXCOORD	// sVertex, u0 v0
+};
+
+static constexpr unsigned int GetVertexFloats(int tail)
+{
+	return tail == TAIL_COLOR ? 10 : tail == TAIL_TEXCOORD ? 8 : 6;
+}
+
+static const float DEFAULT_NORMAL[3] = { 0.0f, 1.0f, 0.0f };
+static const float DEFAULT_COLOR[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+static const float DEFAULT_TEXCOORD[2] = { 0.0f, 0.0f };
+
+// Vertices first to count-1. Reference for the SIMD paths, and what they leave over at the end.
+template <int Tail, bool HasNormals, bool HasTail>
+static void InterleaveScalar(const sVertexStreams& streams, unsigned int first, float* vertices)
+{
+	const unsigned int stride = GetVertexFloats(Tail);
+	for (unsigned int i = first; i < streams.count; i++)
+	{
+		float* vertex = vertices + (size_t) i * stride;
+		const float* position = streams.positions + (size_t) i * 3;
+		const float* normal = HasNormals ? streams.normals + (size_t) i * 3 : DEFAULT_NORMAL;
+		vertex[0] = position[0];
+		vertex[1] = position[1];
+		vertex[2] = position[2];
+		vertex[3] = normal[0];
+		vertex[4] = normal[1];
+		vertex[5] = normal[2];
+
+		if (Tail == TAIL_COLOR)
+		{
+			const float* color = HasTail ? streams.colors + (size_t) i * 4 : DEFAULT_COLOR;
+			vertex[6] = color[0];
+			vertex[7] = color[1];
+			vertex[8] = color[2];
+			vertex[9] = color[3];
+		}
+		else if (Tail == TAIL_TEXCOORD)
+		{
+			const float* texCoord = HasTail ? streams.texCoords + (size_t) i * 3 : DEFAULT_TEXCOORD;
+			vertex[6] = texCoord[0];
+			vertex[7] = texCoord[1];
+		}
+	}
+}
+
+#ifdef VERTEX_CONVERSION_X86
+
+// The first 4 floats of every vertex, [px py pz nx], from position and normal loads of 4 floats each.
+// Works on both 128 bit lanes of the AVX version the same way.
+TARGET_SSE2 static inline __m128 InterleaveLow(__m128 position, __m128 normal)
+{
+	__m128 zx = _mm_shuffle_ps(position, normal, _MM_SHUFFLE(0, 0, 2, 2));	// [pz pz nx nx]
+	return _mm_shuffle_ps(position, zx, _MM_SHUFFLE(2, 0, 1, 0));
+}
+
+TARGET_AVX2 static inline __m256 InterleaveLow(__m256 position, __m256 normal)
+{
+	__m256 zx = _mm256_shuffle_ps(position, normal, _MM_SHUFFLE(0, 0, 2, 2));
+	return _mm256_shuffle_ps(position, zx, _MM_SHUFFLE(2, 0, 1, 0));
+}
+
+// One vertex at a time, returns where it stopped. Every 3 float attribute is loaded as 4 floats, which reads into the
+// next vertex, so the last one is left to the scalar loop.
+template <int Tail, bool HasNormals, bool HasTail>
+TARGET_SSE2 static unsigned int InterleaveSse2(const sVertexStreams& streams, unsigned int first, float* vertices)
+{
+	const unsigned int stride = GetVertexFloats(Tail);
+	const __m128 defaultNormal = _mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f);
+	const __m128 defaultTexCoord = _mm_setzero_ps();
+
+	unsigned int i = first;
+	for (; i + 1 < streams.count; i++)
+	{
+		float* vertex = vertices + (size_t) i * stride;
+		__m128 position = _mm_loadu_ps(streams.positions + (size_t) i * 3);
+		__m128 normal = HasNormals ? _mm_loadu_ps(streams.normals + (size_t) i * 3) : defaultNormal;
+		_mm_storeu_ps(vertex, InterleaveLow(position, normal));
+
+		if (Tail == TAIL_NONE)
+		{
+			_mm_storel_pi((__m64*) (vertex + 4), _mm_shuffle_ps(normal, normal, _MM_SHUFFLE(3, 3, 2, 1)));	// [ny nz]
+		}
+		else if (Tail == TAIL_TEXCOORD)
+		{
+			__m128 texCoord = HasTail ? _mm_loadu_ps(streams.texCoords + (size_t) i * 3) : defaultTexCoord;
+			_mm_storeu_ps(vertex + 4, _mm_shuffle_ps(normal, texCoord, _MM_SHUFFLE(1, 0, 2, 1)));			// [ny nz u v]
+		}
+	}
+
+	return i;
+}
+
+// A 3 float attribute of two vertices, one starting each 128 bit lane. Two loads instead of one load and a lane crossing
+// permute, which would compete with all the shuffles for the same port.
+TARGET_AVX2 static inline __m256 LoadVertexPair(const float* attribute)
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(attribute)), _mm_loadu_ps(attribute + 3), 1);
+}
+
+// Two vertices at a time, one in each 128 bit lane, so it's the SSE2 shuffles on both at once and two 32 byte stores.
+// The loads for vertex i + 1 read into vertex i + 2, so it stops 2 short of the end.
+template <int Tail, bool HasNormals, bool HasTail>
+TARGET_AVX2 static unsigned int InterleaveAvx2(const sVertexStreams& streams, unsigned int first, float* vertices)
+{
+	const unsigned int stride = GetVertexFloats(Tail);
+	const __m256 defaultNormal = _mm256_setr_ps(0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f);
+	const __m256 defaultTexCoord = _mm256_setzero_ps();
+
+	unsigned int i = first;
+	for (; i + 3 <= streams.count; i += 2)
+	{
+		float* vertex = vertices + (size_t) i * stride;
+		__m256 position = LoadVertexPair(streams.positions + (size_t) i * 3);
+		__m256 normal = HasNormals ? LoadVertexPair(streams.normals + (size_t) i * 3) : defaultNormal;
+		__m256 low = InterleaveLow(position, normal);
+
+		if (Tail == TAIL_NONE)
+		{
+			// Writes 2 floats past each vertex, which the next one overwrites (vertex i + 2 exists, see the loop)
+			__m256 high = _mm256_shuffle_ps(normal, normal, _MM_SHUFFLE(3, 3, 2, 1));
+			_mm256_storeu_ps(vertex, _mm256_permute2f128_ps(low, high, 0x20));
+			_mm256_storeu_ps(vertex + stride, _mm256_permute2f128_ps(low, high, 0x31));
+		}
+		else if (Tail == TAIL_TEXCOORD)
+		{
+			__m256 texCoord = HasTail ? LoadVertexPair(streams.texCoords + (size_t) i * 3) : defaultTexCoord;
+			__m256 high = _mm256_shuffle_ps(normal, texCoord, _MM_SHUFFLE(1, 0, 2, 1));
+			_mm256_storeu_ps(vertex, _mm256_permute2f128_ps(low, high, 0x20));
+			_mm256_storeu_ps(vertex + stride, _mm256_permute2f128_ps(low, high, 0x31));
+		}
+	}
+
+	return i;
+}
+
+#endif
+
+template <int Tail, bool HasNormals, bool HasTail>
+static void Interleave(const sVertexStreams& streams, float* vertices, eSimdLevel level)
+{
+	unsigned int i = 0;
+#ifdef VERTEX_CONVERSION_X86
+	// sColoredVertex's 10 floats take an extra store per vertex and the shuffles for them, which made the SIMD paths
+	// no faster than the scalar loop (0.8-1.0x), so that one is always scalar
+	if (Tail != TAIL_COLOR && level >= SIMD_AVX2)
+	{
+		i = InterleaveAvx2<Tail, HasNormals, HasTail>(streams, i, vertices);
+	}
+	if (Tail != TAIL_COLOR && level >= SIMD_SSE2)
+	{
+		i = InterleaveSse2<Tail, HasNormals, HasTail>(streams, i, vertices);
+	}
+#endif
+	InterleaveScalar<Tail, HasNormals, HasTail>(streams, i, vertices);
+}
+
+// Which channels are missing is decided once here, not per vertex
+template <int Tail>
+static void InterleaveWithDefaults(const sVertexStreams& streams, float* vertices, eSimdLevel level)
+{
+	level = std::min(level, GetSimdLevel());
+	bool hasTail = (Tail == TAIL_COLOR && streams.colors) || (Tail == TAIL_TEXCOORD && streams.texCoords);
+	if (streams.normals && hasTail)
+	{
+		Interleave<Tail, true, true>(streams, vertices, level);
+	}
+	else if (streams.normals)
+	{
+		Interleave<Tail, true, false>(streams, vertices, level);
+	}
+	else if (hasTail)
+	{
+		Interleave<Tail, false, true>(streams, vertices, level);
+	}
+	else
+	{
+		Interleave<Tail, false, false>(streams, vertices, level);
+	}
+}
+
+void InterleaveVertices(const sVertexStreams& streams, sPositionNormalVertex* vertices, eSimdLevel level)
+{
+	static_assert(sizeof(sPositionNormalVertex) == GetVertexFloats(TAIL_NONE) * sizeof(float), "sPositionNormalVertex isn't x y z nx ny nz");
+	InterleaveWithDefaults<TAIL_NONE>(streams, reinterpret_cast<float*>(vertices), level);
+}
+
+void InterleaveVertices(const sVertexStreams& streams, sColoredVertex* vertices, eSimdLevel level)
+{
+	static_assert(sizeof(sColoredVertex) == GetVertexFloats(TAIL_COLOR) * sizeof(float) && offsetof(sColoredVertex, r) == 6 * sizeof(float), "sColoredVertex isn't x y z nx ny nz r g b a");
+	InterleaveWithDefaults<TAIL_COLOR>(streams, reinterpret_cast<float*>(vertices), level);
+}
+
+void InterleaveVertices(const sVertexStreams& streams, sVertex* vertices, eSimdLevel level)
+{
+	static_assert(sizeof(sVertex) == GetVertexFloats(TAIL_TEXCOORD) * sizeof(float) && offsetof(sVertex, u0) == 6 * sizeof(float), "sVertex isn't x y z nx ny nz u v");
+	InterleaveWithDefaults<TAIL_TEXCOORD>(streams, reinterpret_cast<float*>(vertices), level);
+}
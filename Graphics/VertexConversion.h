@@ -0,0 +1,24 @@
+#pragma once
+
+#include "SimdLevel.h"
+#include "VertexInformation.h"
+
+// Interleaves separate attribute arrays (what assimp gives us, see ConvertAssimpVertices) into our vertex structs
+// in one pass over preallocated memory, using the widest SIMD the CPU has. Every path writes exactly the same bytes.
+
+// Attribute arrays of count vertices, the layouts of aiVector3D and aiColor4D.
+// Missing channels get the same defaults FromAssimp uses: (0, 1, 0) normals, white colors, (0, 0) UVs.
+struct sVertexStreams
+{
+	const float* positions;		// 3 floats a vertex
+	const float* normals;		// 3 floats a vertex, or NULL
+	const float* colors;		// 4 floats a vertex, or NULL
+	const float* texCoords;		// 3 floats a vertex (only u and v are used), or NULL
+	unsigned int count;
+};
+
+// vertices has room for streams.count. level is only lowered to what the CPU supports, never raised (for benchmarks).
+// sColoredVertex is always done by the scalar loop, SIMD didn't make it any faster.
+void InterleaveVertices(const sVertexStreams& streams, sPositionNormalVertex* vertices, eSimdLevel level = SIMD_AVX2);
+void InterleaveVertices(const sVertexStreams& streams, sColoredVertex* vertices, eSimdLevel level = SIMD_AVX2);
+void InterleaveVertices(const sVertexStreams& streams, sVertex* vertices, eSimdLevel level = SIMD_AVX2);
@@ -28,6 +28,21 @@ struct sColoredVertex
     float r, g, b, a;
 };
 
+// Just enough for lit, untextured meshes that get their color elsewhere (e.g. color override)
+struct sPositionNormalVertex
+{
+    float x, y, z;
+    float nx, ny, nz;
+};
+
+// Compact version of sColoredVertex, 16 bytes instead of 40
+struct sPackedColoredVertex
+{
+    short x, y, z, w;           // Position relative to the mesh bounds, normalized to [-1, 1] (w is padding)
+    unsigned int normal;        // GL_INT_2_10_10_10_REV, normalized
+    unsigned char r, g, b, a;   // Normalized
+};
+
 struct sTriangle
 {
     unsigned int vertIndex[3];
@@ -0,0 +1,351 @@
+#pragma once
+
+#include "GLCommon.h"
+#include "VertexInformation.h"
+#include "VertexConversion.h"
+
+#include <cstddef>
+#include <vector>
+#include <assimp/scene.h>
+
+// Attribute locations, these must match the layout in the vertex shader
+enum eVertexAttributeLocation
+{
+	ATTRIBUTE_LOCATION_POSITION = 0,
+	ATTRIBUTE_LOCATION_NORMAL = 1,
+	ATTRIBUTE_LOCATION_COLOR = 2,
+	ATTRIBUTE_LOCATION_UV = 3,
+	ATTRIBUTE_LOCATION_TANGENT = 4,
+	ATTRIBUTE_LOCATION_BINORMAL = 5
+};
+
+// Which attributes a vertex format has, as bits of (1 << eVertexAttributeLocation)
+enum eVertexAttributeBits
+{
+	ATTRIBUTE_POSITION = 1 << ATTRIBUTE_LOCATION_POSITION,
+	ATTRIBUTE_NORMAL = 1 << ATTRIBUTE_LOCATION_NORMAL,
+	ATTRIBUTE_COLOR = 1 << ATTRIBUTE_LOCATION_COLOR,
+	ATTRIBUTE_UV = 1 << ATTRIBUTE_LOCATION_UV,
+	ATTRIBUTE_TANGENT = 1 << ATTRIBUTE_LOCATION_TANGENT,
+	ATTRIBUTE_BINORMAL = 1 << ATTRIBUTE_LOCATION_BINORMAL
+};
+
+enum eVertexFormat
+{
+	VERTEX_FORMAT_NONE,
+	VERTEX_FORMAT_POSITION_NORMAL,		// sPositionNormalVertex
+	VERTEX_FORMAT_COLORED,				// sColoredVertex
+	VERTEX_FORMAT_PACKED_COLORED,		// sPackedColoredVertex
+	VERTEX_FORMAT_TEXTURED,				// sVertex
+	VERTEX_FORMAT_FULL					// sVertex_XYZW_RGBA_N_UV_T_B
+};
+
+// Describes a vertex struct at compile time: which attributes it has, how GL should read them, and how to fill it in from assimp.
+// Every vertex struct a Mesh can be built from needs a specialization of this.
+template <class TVertex>
+struct VertexLayout;
+
+// Enables one attribute of the currently bound VAO/VBO
+template <class TVertex>
+inline void SetupVertexAttribute(eVertexAttributeLocation location, GLint size, GLenum type, GLboolean normalized, size_t offset)
+{
+	glEnableVertexAttribArray(location);
+	glVertexAttribPointer(location, size, type, normalized, sizeof(TVertex), (GLvoid*) offset);
+}
+
+// What the shader gets for an attribute the vertex format doesn't have (GL's default is (0, 0, 0, 1), which would make colors black)
+inline void SetMissingVertexAttributes(unsigned int attributeBits)
+{
+	if (!(attributeBits & ATTRIBUTE_COLOR))
+	{
+		glVertexAttrib4f(ATTRIBUTE_LOCATION_COLOR, 1.0f, 1.0f, 1.0f, 1.0f);
+	}
+}
+
+template <>
+struct VertexLayout<sPositionNormalVertex>
+{
+	static const eVertexFormat format = VERTEX_FORMAT_POSITION_NORMAL;
+	static const unsigned int attributes = ATTRIBUTE_POSITION | ATTRIBUTE_NORMAL;
+
+	static void SetupAttributes()
+	{
+		SetupVertexAttribute<sPositionNormalVertex>(ATTRIBUTE_LOCATION_POSITION, 3, GL_FLOAT, GL_FALSE, offsetof(sPositionNormalVertex, x));
+		SetupVertexAttribute<sPositionNormalVertex>(ATTRIBUTE_LOCATION_NORMAL, 3, GL_FLOAT, GL_FALSE, offsetof(sPositionNormalVertex, nx));
+	}
+
+	static void FromAssimp(const aiMesh* mesh, unsigned int i, sPositionNormalVertex& vertex)
+	{
+		vertex.x = mesh->mVertices[i].x;
+		vertex.y = mesh->mVertices[i].y;
+		vertex.z = mesh->mVertices[i].z;
+
+		if (mesh->HasNormals())
+		{
+			vertex.nx = mesh->mNormals[i].x;
+			vertex.ny = mesh->mNormals[i].y;
+			vertex.nz = mesh->mNormals[i].z;
+		}
+		else
+		{
+			vertex.nx = vertex.nz = 0.0f;
+			vertex.ny = 1.0f;
+		}
+	}
+};
+
+template <>
+struct VertexLayout<sColoredVertex>
+{
+	static const eVertexFormat format = VERTEX_FORMAT_COLORED;
+	static const unsigned int attributes = ATTRIBUTE_POSITION | ATTRIBUTE_NORMAL | ATTRIBUTE_COLOR;
+
+	static void SetupAttributes()
+	{
+		SetupVertexAttribute<sColoredVertex>(ATTRIBUTE_LOCATION_POSITION, 3, GL_FLOAT, GL_FALSE, offsetof(sColoredVertex, x));
+		SetupVertexAttribute<sColoredVertex>(ATTRIBUTE_LOCATION_NORMAL, 3, GL_FLOAT, GL_FALSE, offsetof(sColoredVertex, nx));
+		SetupVertexAttribute<sColoredVertex>(ATTRIBUTE_LOCATION_COLOR, 4, GL_FLOAT, GL_FALSE, offsetof(sColoredVertex, r));
+	}
+
+	static void FromAssimp(const aiMesh* mesh, unsigned int i, sColoredVertex& vertex)
+	{
+		vertex.x = mesh->mVertices[i].x;
+		vertex.y = mesh->mVertices[i].y;
+		vertex.z = mesh->mVertices[i].z;
+
+		if (mesh->HasNormals())
+		{
+			vertex.nx = mesh->mNormals[i].x;
+			vertex.ny = mesh->mNormals[i].y;
+			vertex.nz = mesh->mNormals[i].z;
+		}
+		else
+		{
+			vertex.nx = vertex.nz = 0.0f;
+			vertex.ny = 1.0f;
+		}
+
+		if (mesh->HasVertexColors(0))
+		{
+			vertex.r = mesh->mColors[0][i].r;
+			vertex.g = mesh->mColors[0][i].g;
+			vertex.b = mesh->mColors[0][i].b;
+			vertex.a = mesh->mColors[0][i].a;
+		}
+		else
+		{
+			vertex.r = vertex.g = vertex.b = vertex.a = 1.0f;
+		}
+	}
+};
+
+// Normalized integers, so the shader still gets the same floats it would from sColoredVertex.
+// Positions are relative to the mesh bounds, see PackColoredVertices in ModelCooker.h
+template <>
+struct VertexLayout<sPackedColoredVertex>
+{
+	static const eVertexFormat format = VERTEX_FORMAT_PACKED_COLORED;
+	static const unsigned int attributes = ATTRIBUTE_POSITION | ATTRIBUTE_NORMAL | ATTRIBUTE_COLOR;
+
+	static void SetupAttributes()
+	{
+		SetupVertexAttribute<sPackedColoredVertex>(ATTRIBUTE_LOCATION_POSITION, 3, GL_SHORT, GL_TRUE, offsetof(sPackedColoredVertex, x));
+		SetupVertexAttribute<sPackedColoredVertex>(ATTRIBUTE_LOCATION_NORMAL, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(sPackedColoredVertex, normal));
+		SetupVertexAttribute<sPackedColoredVertex>(ATTRIBUTE_LOCATION_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(sPackedColoredVertex, r));
+	}
+	// No FromAssimp, packed vertices are made from sColoredVertex once the bounds are known
+};
+
+template <>
+struct VertexLayout<sVertex>
+{
+	static const eVertexFormat format = VERTEX_FORMAT_TEXTURED;
+	static const unsigned int attributes = ATTRIBUTE_POSITION | ATTRIBUTE_NORMAL | ATTRIBUTE_UV;
+
+	static void SetupAttributes()
+	{
+		SetupVertexAttribute<sVertex>(ATTRIBUTE_LOCATION_POSITION, 3, GL_FLOAT, GL_FALSE, offsetof(sVertex, x));
+		SetupVertexAttribute<sVertex>(ATTRIBUTE_LOCATION_NORMAL, 3, GL_FLOAT, GL_FALSE, offsetof(sVertex, nx));
+		SetupVertexAttribute<sVertex>(ATTRIBUTE_LOCATION_UV, 2, GL_FLOAT, GL_FALSE, offsetof(sVertex, u0));
+	}
+
+	static void FromAssimp(const aiMesh* mesh, unsigned int i, sVertex& vertex)
+	{
+		vertex.x = mesh->mVertices[i].x;
+		vertex.y = mesh->mVertices[i].y;
+		vertex.z = mesh->mVertices[i].z;
+
+		if (mesh->HasNormals())
+		{
+			vertex.nx = mesh->mNormals[i].x;
+			vertex.ny = mesh->mNormals[i].y;
+			vertex.nz = mesh->mNormals[i].z;
+		}
+		else
+		{
+			vertex.nx = vertex.nz = 0.0f;
+			vertex.ny = 1.0f;
+		}
+
+		if (mesh->HasTextureCoords(0))
+		{
+			vertex.u0 = mesh->mTextureCoords[0][i].x;
+			vertex.v0 = mesh->mTextureCoords[0][i].y;
+		}
+		else
+		{
+			vertex.u0 = vertex.v0 = 0.0f;
+		}
+	}
+};
+
+template <>
+struct VertexLayout<sVertex_XYZW_RGBA_N_UV_T_B>
+{
+	static const eVertexFormat format = VERTEX_FORMAT_FULL;
+	static const unsigned int attributes = ATTRIBUTE_POSITION | ATTRIBUTE_NORMAL | ATTRIBUTE_COLOR | ATTRIBUTE_UV | ATTRIBUTE_TANGENT | ATTRIBUTE_BINORMAL;
+
+	static void SetupAttributes()
+	{
+		SetupVertexAttribute<sVertex_XYZW_RGBA_N_UV_T_B>(ATTRIBUTE_LOCATION_POSITION, 4, GL_FLOAT, GL_FALSE, offsetof(sVertex_XYZW_RGBA_N_UV_T_B, x));
+		SetupVertexAttribute<sVertex_XYZW_RGBA_N_UV_T_B>(ATTRIBUTE_LOCATION_NORMAL, 4, GL_FLOAT, GL_FALSE, offsetof(sVertex_XYZW_RGBA_N_UV_T_B, nx));
+		SetupVertexAttribute<sVertex_XYZW_RGBA_N_UV_T_B>(ATTRIBUTE_LOCATION_COLOR, 4, GL_FLOAT, GL_FALSE, offsetof(sVertex_XYZW_RGBA_N_UV_T_B, r));
+		SetupVertexAttribute<sVertex_XYZW_RGBA_N_UV_T_B>(ATTRIBUTE_LOCATION_UV, 4, GL_FLOAT, GL_FALSE, offsetof(sVertex_XYZW_RGBA_N_UV_T_B, u0));
+		SetupVertexAttribute<sVertex_XYZW_RGBA_N_UV_T_B>(ATTRIBUTE_LOCATION_TANGENT, 4, GL_FLOAT, GL_FALSE, offsetof(sVertex_XYZW_RGBA_N_UV_T_B, tx));
+		SetupVertexAttribute<sVertex_XYZW_RGBA_N_UV_T_B>(ATTRIBUTE_LOCATION_BINORMAL, 4, GL_FLOAT, GL_FALSE, offsetof(sVertex_XYZW_RGBA_N_UV_T_B, bx));
+	}
+
+	static void FromAssimp(const aiMesh* mesh, unsigned int i, sVertex_XYZW_RGBA_N_UV_T_B& vertex)
+	{
+		vertex.x = mesh->mVertices[i].x;
+		vertex.y = mesh->mVertices[i].y;
+		vertex.z = mesh->mVertices[i].z;
+		vertex.w = 1.0f;
+
+		if (mesh->HasVertexColors(0))
+		{
+			vertex.r = mesh->mColors[0][i].r;
+			vertex.g = mesh->mColors[0][i].g;
+			vertex.b = mesh->mColors[0][i].b;
+			vertex.a = mesh->mColors[0][i].a;
+		}
+		else
+		{
+			vertex.r = vertex.g = vertex.b = vertex.a = 1.0f;
+		}
+
+		if (mesh->HasNormals())
+		{
+			vertex.nx = mesh->mNormals[i].x;
+			vertex.ny = mesh->mNormals[i].y;
+			vertex.nz = mesh->mNormals[i].z;
+		}
+		else
+		{
+			vertex.nx = vertex.nz = 0.0f;
+			vertex.ny = 1.0f;
+		}
+		vertex.nw = 0.0f;
+
+		vertex.u0 = vertex.v0 = vertex.u1 = vertex.v1 = 0.0f;
+		if (mesh->HasTextureCoords(0))
+		{
+			vertex.u0 = mesh->mTextureCoords[0][i].x;
+			vertex.v0 = mesh->mTextureCoords[0][i].y;
+		}
+		if (mesh->HasTextureCoords(1))
+		{
+			vertex.u1 = mesh->mTextureCoords[1][i].x;
+			vertex.v1 = mesh->mTextureCoords[1][i].y;
+		}
+
+		vertex.tx = vertex.ty = vertex.tz = vertex.tw = 0.0f;
+		vertex.bx = vertex.by = vertex.bz = vertex.bw = 0.0f;
+		if (mesh->HasTangentsAndBitangents())
+		{
+			vertex.tx = mesh->mTangents[i].x;
+			vertex.ty = mesh->mTangents[i].y;
+			vertex.tz = mesh->mTangents[i].z;
+
+			vertex.bx = mesh->mBitangents[i].x;
+			vertex.by = mesh->mBitangents[i].y;
+			vertex.bz = mesh->mBitangents[i].z;
+		}
+	}
+};
+
+// Converts every vertex of an assimp mesh into TVertex
+template <class TVertex>
+inline void ConvertAssimpVertices(const aiMesh* mesh, std::vector<TVertex>& vertices)
+{
+	vertices.resize(mesh->mNumVertices);
+	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+	{
+		VertexLayout<TVertex>::FromAssimp(mesh, i, vertices[i]);
+	}
+}
+
+// assimp's arrays as they are, aiVector3D and aiColor4D are just floats
+inline sVertexStreams GetAssimpStreams(const aiMesh* mesh)
+{
+	static_assert(sizeof(aiVector3D) == 3 * sizeof(float) && sizeof(aiColor4D) == 4 * sizeof(float), "assimp was built with double precision");
+
+	sVertexStreams streams;
+	streams.positions = reinterpret_cast<const float*>(mesh->mVertices);
+	streams.normals = mesh->HasNormals() ? reinterpret_cast<const float*>(mesh->mNormals) : NULL;
+	streams.colors = mesh->HasVertexColors(0) ? reinterpret_cast<const float*>(mesh->mColors[0]) : NULL;
+	streams.texCoords = mesh->HasTextureCoords(0) ? reinterpret_cast<const float*>(mesh->mTextureCoords[0]) : NULL;
+	streams.count = mesh->mNumVertices;
+	return streams;
+}
+
+// The layouts the cooker uses are interleaved in one SIMD pass instead (see VertexConversion.h), with the same results as FromAssimp
+template <>
+inline void ConvertAssimpVertices(const aiMesh* mesh, std::vector<sPositionNormalVertex>& vertices)
+{
+	vertices.resize(mesh->mNumVertices);
+	InterleaveVertices(GetAssimpStreams(mesh), vertices.data());
+}
+
+template <>
+inline void ConvertAssimpVertices(const aiMesh* mesh, std::vector<sColoredVertex>& vertices)
+{
+	vertices.resize(mesh->mNumVertices);
+	InterleaveVertices(GetAssimpStreams(mesh), vertices.data());
+}
+
+template <>
+inline void ConvertAssimpVertices(const aiMesh* mesh, std::vector<sVertex>& vertices)
+{
+	vertices.resize(mesh->mNumVertices);
+	InterleaveVertices(GetAssimpStreams(mesh), vertices.data());
+}
+
+// The same information looked up at runtime, for vertex data whose format is only known once it's loaded (e.g. cooked meshes)
+struct sVertexFormatInfo
+{
+	unsigned int stride;
+	unsigned int attributes;	// eVertexAttributeBits
+	void (*setupAttributes)();
+};
+
+template <class TVertex>
+inline sVertexFormatInfo MakeVertexFormatInfo()
+{
+	sVertexFormatInfo info = { sizeof(TVertex), VertexLayout<TVertex>::attributes, &VertexLayout<TVertex>::SetupAttributes };
+	return info;
+}
+
+// Returns false for VERTEX_FORMAT_NONE or anything unknown
+inline bool GetVertexFormatInfo(eVertexFormat format, sVertexFormatInfo& info)
+{
+	switch (format)
+	{
+	case VERTEX_FORMAT_POSITION_NORMAL:	info = MakeVertexFormatInfo<sPositionNormalVertex>(); return true;
+	case VERTEX_FORMAT_COLORED:			info = MakeVertexFormatInfo<sColoredVertex>(); return true;
+	case VERTEX_FORMAT_PACKED_COLORED:	info = MakeVertexFormatInfo<sPackedColoredVertex>(); return true;
+	case VERTEX_FORMAT_TEXTURED:		info = MakeVertexFormatInfo<sVertex>(); return true;
+	case VERTEX_FORMAT_FULL:			info = MakeVertexFormatInfo<sVertex_XYZW_RGBA_N_UV_T_B>(); return true;
+	default:							return false;
+	}
+}
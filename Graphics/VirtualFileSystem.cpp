@@ -0,0 +1,120 @@
+#include "VirtualFileSystem.h"
+
+#include <iostream>
+
+VirtualFileSystem* VirtualFileSystem::instance = NULL;
+
+VirtualFileSystem::VirtualFileSystem()
+{
+
+}
+
+VirtualFileSystem::~VirtualFileSystem()
+{
+	this->UnmountAll();
+}
+
+VirtualFileSystem* VirtualFileSystem::GetInstance()
+{
+	if (VirtualFileSystem::instance == NULL)
+	{
+		VirtualFileSystem::instance = new VirtualFileSystem();
+	}
+
+	return instance;
+}
+
+bool VirtualFileSystem::Mount(const std::string& archivePath, const std::string& mountPoint)
+{
+	AssetArchive* archive = new AssetArchive();
+	if (!archive->Open(archivePath))
+	{
+		delete archive;
+		return false;
+	}
+
+	archive->Prefetch(); // Startup reads most of it anyway, one sequential read beats faulting it in piece by piece
+
+	sMount mount;
+	mount.mountPoint = AssetArchive::NormalizeName(mountPoint);
+	if (!mount.mountPoint.empty() && mount.mountPoint.back() != '/')
+	{
+		mount.mountPoint += '/';
+	}
+	mount.archive = archive;
+	this->mounts.push_back(mount);
+
+	std::cout << "Mounted " << archivePath << " (" << archive->GetEntryCount() << " files, " << archive->GetFileSize() / 1024 << " KB)" << std::endl;
+	return true;
+}
+
+void VirtualFileSystem::UnmountAll()
+{
+	for (sMount& mount : this->mounts)
+	{
+		delete mount.archive;
+	}
+
+	this->mounts.clear();
+}
+
+bool VirtualFileSystem::Find(const std::string& path, sFileView& view) const
+{
+	if (this->mounts.empty())
+	{
+		return false;
+	}
+
+	std::string normalized = AssetArchive::NormalizeName(path);
+	for (size_t i = this->mounts.size(); i-- > 0;)
+	{
+		const sMount& mount = this->mounts[i];
+		if (normalized.compare(0, mount.mountPoint.size(), mount.mountPoint) != 0)
+		{
+			continue;
+		}
+
+		size_t size = 0;
+		const unsigned char* data = mount.archive->Find(normalized.substr(mount.mountPoint.size()), size);
+		if (data)
+		{
+			view.data = data;
+			view.size = size;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool VirtualFileSystem::FindUnder(const std::string& path, const sFileView& found, sFileView& view) const
+{
+	std::string normalized = AssetArchive::NormalizeName(path);
+	bool isPastFound = false;
+	for (size_t i = this->mounts.size(); i-- > 0;)
+	{
+		const sMount& mount = this->mounts[i];
+		if (normalized.compare(0, mount.mountPoint.size(), mount.mountPoint) != 0)
+		{
+			continue;
+		}
+
+		size_t size = 0;
+		const unsigned char* data = mount.archive->Find(normalized.substr(mount.mountPoint.size()), size);
+		if (!data)
+		{
+			continue;
+		}
+
+		if (isPastFound)
+		{
+			view.data = data;
+			view.size = size;
+			return true;
+		}
+
+		isPastFound = data == found.data;
+	}
+
+	return false;
+}
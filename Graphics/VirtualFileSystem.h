@@ -0,0 +1,53 @@
+#pragma once
+
+#include "AssetArchive.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A file's contents somewhere in memory, owned by whoever handed it out
+struct sFileView
+{
+	const unsigned char* data;
+	size_t size;
+};
+
+// Serves asset paths out of mounted archives, so the managers can keep using the same paths whether the assets are
+// loose files or packed. Anything that isn't in an archive is left to the disk.
+class VirtualFileSystem
+{
+public:
+	~VirtualFileSystem();
+
+	static VirtualFileSystem* GetInstance();
+
+	// Every path under mountPoint resolves into the archive, e.g. mounting assets.pak at "Extern\assets\" makes
+	// "Extern\assets\models\ISO_Sphere.ply" the archive's "models/iso_sphere.ply". Archives mounted later win.
+	bool Mount(const std::string& archivePath, const std::string& mountPoint);
+	void UnmountAll();
+
+	// Zero copy, the view points into the archive's mapping. False if no mounted archive has the file.
+	bool Find(const std::string& path, sFileView& view) const;
+
+	// The same file in the archives mounted before the one found holds, e.g. the source model under an out of date
+	// cooked one. False if found didn't come from a mounted archive or none of the earlier ones have the file.
+	bool FindUnder(const std::string& path, const sFileView& found, sFileView& view) const;
+
+	inline bool HasMounts() const
+	{
+		return !this->mounts.empty();
+	}
+
+private:
+	VirtualFileSystem();
+
+	static VirtualFileSystem* instance;
+
+	struct sMount
+	{
+		std::string mountPoint; // Normalized like the archive's names
+		AssetArchive* archive;
+	};
+	std::vector<sMount> mounts;
+};
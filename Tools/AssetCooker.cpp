@@ -0,0 +1,403 @@
+// Cooks an asset directory into an archive the engine can upload from without importing anything at startup.
+// Models are imported, laid out, optimized and packed the same way ModelManager::LoadModel would (see ModelCooker.h),
+// scenes are cooked to their binary form (see SceneFile.h), everything else is copied as is. Cooked models are cached by
+// the hash of their source, so only changed ones get recooked.
+// Usage: AssetCooker <asset directory> <output archive> [cook settings]
+// e.g.   AssetCooker Extern\assets Extern\assets.cooked.pak Tools\CookSettings.txt
+
+#include "AssetArchive.h"
+#include "JobSystem.h"
+#include "ModelCooker.h"
+#include "SceneFile.h"
+#include "VirtualFileSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct sCookJob
+{
+	AssetArchive::sBuildInput* input;
+	unsigned int cookFlags;
+	bool wasCached = false;
+	bool failed = false;
+	std::string cacheFile;
+	std::string error;
+};
+
+static eArchiveEntryType GetEntryType(const std::filesystem::path& path)
+{
+	std::string extension = AssetArchive::NormalizeName(path.extension().string());
+	if (extension == ".ply" || extension == ".obj" || extension == ".fbx" || extension == ".glb" || extension == ".gltf")
+	{
+		return ARCHIVE_ENTRY_MESH;
+	}
+	if (extension == ".png" || extension == ".jpg" || extension == ".bmp" || extension == ".tga" || extension == ".dds")
+	{
+		return ARCHIVE_ENTRY_TEXTURE;
+	}
+	if (extension == ".glsl" || extension == ".vert" || extension == ".frag")
+	{
+		return ARCHIVE_ENTRY_SHADER;
+	}
+
+	return ARCHIVE_ENTRY_RAW;
+}
+
+// Lines of "<path in the asset directory> <flags...>", "*" for every model that isn't listed. # starts a comment.
+static bool LoadCookSettings(const std::string& path, std::map<std::string, unsigned int>& settings)
+{
+	std::ifstream file(path.c_str());
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		line = line.substr(0, line.find('#'));
+
+		std::istringstream words(line);
+		std::string name;
+		if (!(words >> name))
+		{
+			continue;
+		}
+
+		unsigned int cookFlags = COOK_DEFAULT;
+		std::string flag;
+		while (words >> flag)
+		{
+			if (flag == "packed")
+			{
+				cookFlags |= COOK_PACKED_VERTICES;
+			}
+			else if (flag == "no_vertex_colors")
+			{
+				cookFlags |= COOK_NO_VERTEX_COLORS;
+			}
+			else if (flag == "force_assimp")
+			{
+				cookFlags |= COOK_FORCE_ASSIMP;
+			}
+			else
+			{
+				std::cout << path << ": unknown cook flag '" << flag << "'" << std::endl;
+			}
+		}
+
+		settings[name == "*" ? name : AssetArchive::NormalizeName(name)] = cookFlags;
+	}
+
+	return true;
+}
+
+static bool ReadWholeFile(const std::string& path, std::vector<unsigned char>& data)
+{
+	std::ifstream file(path.c_str(), std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+// FNV-1a, 64 bit
+static uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+static void CookOne(sCookJob& job, const std::filesystem::path& cacheDirectory)
+{
+	AssetArchive::sBuildInput& input = *job.input;
+
+	std::vector<unsigned char> source;
+	if (!ReadWholeFile(input.sourcePath, source))
+	{
+		job.failed = true;
+		job.error = "couldn't read it";
+		return;
+	}
+
+	// Anything that changes the result goes into the key, so a changed file, flag or cooker version gets a new entry
+	uint64_t hash = HashBytes(source.data(), source.size());
+	hash = HashBytes(&job.cookFlags, sizeof(job.cookFlags), hash);
+	hash = HashBytes(&COOKED_MODEL_VERSION, sizeof(COOKED_MODEL_VERSION), hash);
+
+	char hashText[17];
+	snprintf(hashText, sizeof(hashText), "%016llx", (unsigned long long) hash);
+	job.cacheFile = std::string(hashText) + ".cmdl";
+	std::filesystem::path cachePath = cacheDirectory / job.cacheFile;
+
+	if (ReadWholeFile(cachePath.string(), input.data) && IsCookedModel(input.data.data(), input.data.size()))
+	{
+		job.wasCached = true;
+		return;
+	}
+
+	// From the path rather than the bytes we just read, so formats that reference other files (.gltf, .obj) can find them
+	sCookedModel model;
+	if (!CookModel(input.sourcePath, NULL, 0, job.cookFlags, model, job.error))
+	{
+		input.data.clear();
+		job.failed = true;
+		return;
+	}
+
+	WriteCookedModel(model, input.data, true);
+
+	// Written next to it and renamed over it, so a cooker that's stopped halfway never leaves a truncated entry behind.
+	// The temporary name has the thread in it, two jobs with the same source can be writing the same entry.
+	std::ostringstream tempName;
+	tempName << job.cacheFile << "." << std::this_thread::get_id() << ".tmp";
+	std::filesystem::path tempPath = cacheDirectory / tempName.str();
+	{
+		std::ofstream cache(tempPath.string().c_str(), std::ios::binary | std::ios::trunc);
+		cache.write((const char*) input.data.data(), (std::streamsize) input.data.size());
+		if (!cache.good())
+		{
+			cache.close();
+			std::error_code errorCode;
+			std::filesystem::remove(tempPath, errorCode);
+			return; // Just not cached, the cooked data is still in input.data
+		}
+	}
+
+	std::error_code errorCode;
+	std::filesystem::rename(tempPath, cachePath, errorCode);
+	if (errorCode)
+	{
+		std::filesystem::remove(tempPath, errorCode);
+	}
+}
+
+// How much the geometry compressed, and how fast all of it decodes the way ModelManager does it
+static void PrintDecodeBenchmark(const std::vector<sCookJob>& jobs)
+{
+	std::vector<std::vector<sCookedMeshView>> models;
+	std::vector<sStreamDecode> decodes;
+	size_t rawBytes = 0;
+	size_t storedBytes = 0;
+	for (const sCookJob& job : jobs)
+	{
+		unsigned int cookFlags = 0;
+		models.emplace_back();
+		if (job.failed || !ReadCookedModel(job.input->data.data(), job.input->data.size(), cookFlags, models.back()))
+		{
+			continue;
+		}
+
+		for (const sCookedMeshView& mesh : models.back())
+		{
+			rawBytes += mesh.vertexStream.rawSize + mesh.indexStream.rawSize;
+			storedBytes += mesh.vertexStream.storedSize + mesh.indexStream.storedSize;
+		}
+	}
+
+	std::vector<unsigned char> destination(rawBytes);
+	size_t offset = 0;
+	for (const std::vector<sCookedMeshView>& meshes : models)
+	{
+		for (const sCookedMeshView& mesh : meshes)
+		{
+			decodes.push_back({ &mesh.vertexStream, destination.data() + offset });
+			offset += mesh.vertexStream.rawSize;
+			decodes.push_back({ &mesh.indexStream, destination.data() + offset });
+			offset += mesh.indexStream.rawSize;
+		}
+	}
+
+	DecodeCookedStreams(decodes); // Once to fault the destination in
+	std::chrono::steady_clock::time_point decodeStart = std::chrono::steady_clock::now();
+	bool isDecoded = DecodeCookedStreams(decodes);
+	double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeStart).count();
+
+	double rawMB = rawBytes / (1024.0 * 1024.0);
+	std::cout << "Geometry: " << rawMB << " MB, stored as " << storedBytes / (1024.0 * 1024.0) << " MB ("
+		<< 100.0 * storedBytes / std::max<size_t>(rawBytes, 1) << "%)" << std::endl;
+	std::cout << "Decoding all of it on " << JobSystem::GetInstance()->GetWorkerCount() << " job workers: " << decodeSeconds * 1000.0 << " ms, "
+		<< rawMB / std::max(decodeSeconds, 1e-9) << " MB/s" << (isDecoded ? "" : " (FAILED, the cooked data is corrupt)") << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 3 && argc != 4)
+	{
+		std::cout << "Usage: AssetCooker <asset directory> <output archive> [cook settings]" << std::endl;
+		return 1;
+	}
+
+	std::filesystem::path root(argv[1]);
+	if (!std::filesystem::is_directory(root))
+	{
+		std::cout << root.string() << " is not a directory" << std::endl;
+		return 1;
+	}
+
+	std::map<std::string, unsigned int> cookSettings;
+	if (argc == 4 && !LoadCookSettings(argv[3], cookSettings))
+	{
+		std::cout << "Couldn't read " << argv[3] << std::endl;
+		return 1;
+	}
+
+	std::filesystem::path cacheDirectory = std::string(argv[2]) + ".cache";
+	std::error_code errorCode;
+	std::filesystem::create_directories(cacheDirectory, errorCode);
+
+	std::vector<AssetArchive::sBuildInput> inputs;
+	for (const std::filesystem::directory_entry& file : std::filesystem::recursive_directory_iterator(root))
+	{
+		if (!file.is_regular_file())
+		{
+			continue;
+		}
+
+		AssetArchive::sBuildInput input;
+		input.name = std::filesystem::relative(file.path(), root).generic_string();
+		input.type = GetEntryType(file.path());
+		input.sourcePath = file.path().string();
+		inputs.push_back(input);
+	}
+
+	// Same order as AssetPacker, shaders first, then meshes, then textures
+	std::stable_sort(inputs.begin(), inputs.end(), [](const AssetArchive::sBuildInput& a, const AssetArchive::sBuildInput& b)
+	{
+		static const int order[] = { 3, 1, 2, 0 }; // Indexed by eArchiveEntryType
+		return order[a.type] < order[b.type];
+	});
+
+	// Models get cooked, everything else is packed straight from its file
+	std::vector<sCookJob> jobs;
+	for (AssetArchive::sBuildInput& input : inputs)
+	{
+		if (input.type != ARCHIVE_ENTRY_MESH)
+		{
+			continue;
+		}
+
+		sCookJob job;
+		job.input = &input;
+		std::map<std::string, unsigned int>::const_iterator setting = cookSettings.find(AssetArchive::NormalizeName(input.name));
+		if (setting == cookSettings.end())
+		{
+			setting = cookSettings.find("*");
+		}
+		job.cookFlags = setting != cookSettings.end() ? setting->second : COOK_DEFAULT;
+		jobs.push_back(job);
+	}
+
+	VirtualFileSystem::GetInstance(); // The cook threads look textures up through it, create it before they start
+
+	// Models don't depend on each other, so one worker per core pulling the next job
+	std::chrono::steady_clock::time_point cookStart = std::chrono::steady_clock::now();
+	std::atomic<size_t> nextJob(0);
+	unsigned int threadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), (unsigned int) jobs.size()));
+	std::vector<std::thread> threads;
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		threads.emplace_back([&jobs, &nextJob, &cacheDirectory]()
+		{
+			for (size_t job = nextJob++; job < jobs.size(); job = nextJob++)
+			{
+				CookOne(jobs[job], cacheDirectory);
+			}
+		});
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	double cookSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - cookStart).count();
+
+	unsigned int cookedCount = 0;
+	unsigned int cachedCount = 0;
+	std::set<std::string> usedCacheFiles;
+	for (const sCookJob& job : jobs)
+	{
+		if (job.failed)
+		{
+			// The runtime can still import it, so pack the source instead of leaving it out
+			std::cout << "Couldn't cook " << job.input->name << " (" << job.error << "), packing the source file" << std::endl;
+			continue;
+		}
+
+		usedCacheFiles.insert(job.cacheFile);
+		if (job.wasCached)
+		{
+			cachedCount++;
+		}
+		else
+		{
+			cookedCount++;
+		}
+	}
+
+	// Whatever wasn't used this time belongs to a version of a model that's gone now, .tmp files to a cooker that was stopped
+	for (const std::filesystem::directory_entry& file : std::filesystem::directory_iterator(cacheDirectory, errorCode))
+	{
+		if ((file.path().extension() == ".cmdl" && usedCacheFiles.find(file.path().filename().string()) == usedCacheFiles.end())
+			|| file.path().extension() == ".tmp")
+		{
+			std::filesystem::remove(file.path(), errorCode);
+		}
+	}
+
+	// Scenes are small, parsing them here is so the runtime doesn't have to
+	unsigned int sceneCount = 0;
+	for (AssetArchive::sBuildInput& input : inputs)
+	{
+		if (AssetArchive::NormalizeName(std::filesystem::path(input.sourcePath).extension().string()) != ".scene")
+		{
+			continue;
+		}
+
+		std::vector<unsigned char> source;
+		sScene scene;
+		std::string sceneError;
+		if (!ReadWholeFile(input.sourcePath, source) || !ParseSceneText((const char*) source.data(), source.size(), scene, sceneError))
+		{
+			std::cout << "Couldn't cook " << input.name << " (" << (sceneError.empty() ? "couldn't read it" : sceneError) << "), packing the source file" << std::endl;
+			continue;
+		}
+
+		WriteCookedScene(scene, input.data);
+		sceneCount++;
+	}
+
+	std::string error;
+	if (!AssetArchive::Build(argv[2], inputs, error))
+	{
+		std::cout << "Failed: " << error << std::endl;
+		return 1;
+	}
+
+	std::cout << "Cooked " << cookedCount << " models on " << threadCount << " threads in " << cookSeconds * 1000.0 << " ms, "
+		<< cachedCount << " unchanged ones came from the cache" << std::endl;
+	std::cout << "Cooked " << sceneCount << " scenes" << std::endl;
+	std::cout << "Packed " << inputs.size() << " files into " << argv[2] << std::endl;
+
+	PrintDecodeBenchmark(jobs);
+	return 0;
+}
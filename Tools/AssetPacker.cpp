@@ -0,0 +1,78 @@
+// Packs an asset directory into one archive for VirtualFileSystem to mount.
+// Usage: AssetPacker <asset directory> <output archive>
+// e.g.   AssetPacker Extern\assets Extern\assets.pak
+
+#include "AssetArchive.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static eArchiveEntryType GetEntryType(const std::filesystem::path& path)
+{
+	std::string extension = AssetArchive::NormalizeName(path.extension().string());
+	if (extension == ".ply" || extension == ".obj" || extension == ".fbx" || extension == ".glb" || extension == ".gltf")
+	{
+		return ARCHIVE_ENTRY_MESH;
+	}
+	if (extension == ".png" || extension == ".jpg" || extension == ".bmp" || extension == ".tga" || extension == ".dds")
+	{
+		return ARCHIVE_ENTRY_TEXTURE;
+	}
+	if (extension == ".glsl" || extension == ".vert" || extension == ".frag")
+	{
+		return ARCHIVE_ENTRY_SHADER;
+	}
+
+	return ARCHIVE_ENTRY_RAW;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 3)
+	{
+		std::cout << "Usage: AssetPacker <asset directory> <output archive>" << std::endl;
+		return 1;
+	}
+
+	std::filesystem::path root(argv[1]);
+	if (!std::filesystem::is_directory(root))
+	{
+		std::cout << root.string() << " is not a directory" << std::endl;
+		return 1;
+	}
+
+	std::vector<AssetArchive::sBuildInput> inputs;
+	for (const std::filesystem::directory_entry& file : std::filesystem::recursive_directory_iterator(root))
+	{
+		if (!file.is_regular_file())
+		{
+			continue;
+		}
+
+		AssetArchive::sBuildInput input;
+		input.name = std::filesystem::relative(file.path(), root).generic_string();
+		input.type = GetEntryType(file.path());
+		input.sourcePath = file.path().string();
+		inputs.push_back(input);
+	}
+
+	// Shaders first, then meshes, then textures, the order main() loads them in, so startup reads the archive front to back
+	std::stable_sort(inputs.begin(), inputs.end(), [](const AssetArchive::sBuildInput& a, const AssetArchive::sBuildInput& b)
+	{
+		static const int order[] = { 3, 1, 2, 0 }; // Indexed by eArchiveEntryType
+		return order[a.type] < order[b.type];
+	});
+
+	std::string error;
+	if (!AssetArchive::Build(argv[2], inputs, error))
+	{
+		std::cout << "Failed: " << error << std::endl;
+		return 1;
+	}
+
+	std::cout << "Packed " << inputs.size() << " files into " << argv[2] << std::endl;
+	return 0;
+}
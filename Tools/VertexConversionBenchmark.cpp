@@ -0,0 +1,127 @@
+// Times converting assimp meshes into our vertex layouts: the old one vertex at a time FromAssimp loop against
+// InterleaveVertices at every SIMD level this CPU has, and checks they all write the same bytes.
+// Usage: VertexConversionBenchmark [vertex count, default 1000000]
+
+#include "SimdLevel.h"
+#include "VertexLayout.h"
+#include "VertexConversion.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const int RUNS = 5;
+
+// Random but repeatable, so every run converts the same mesh
+static float NextFloat(unsigned int& seed)
+{
+	seed = seed * 1664525u + 1013904223u;
+	return (float) (seed >> 8) / (float) (1 << 24);
+}
+
+static aiMesh* MakeMesh(unsigned int vertexCount, bool hasColors, bool hasTexCoords)
+{
+	aiMesh* mesh = new aiMesh();
+	mesh->mNumVertices = vertexCount;
+	mesh->mVertices = new aiVector3D[vertexCount];
+	mesh->mNormals = new aiVector3D[vertexCount];
+	mesh->mColors[0] = hasColors ? new aiColor4D[vertexCount] : NULL;
+	mesh->mTextureCoords[0] = hasTexCoords ? new aiVector3D[vertexCount] : NULL;
+
+	unsigned int seed = 1;
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		mesh->mVertices[i] = aiVector3D(NextFloat(seed), NextFloat(seed), NextFloat(seed));
+		mesh->mNormals[i] = aiVector3D(NextFloat(seed), NextFloat(seed), NextFloat(seed));
+		if (hasColors)
+		{
+			mesh->mColors[0][i] = aiColor4D(NextFloat(seed), NextFloat(seed), NextFloat(seed), NextFloat(seed));
+		}
+		if (hasTexCoords)
+		{
+			mesh->mTextureCoords[0][i] = aiVector3D(NextFloat(seed), NextFloat(seed), 0.0f);
+		}
+	}
+
+	return mesh;
+}
+
+// Best of a few runs, so it's the conversion that's measured and not the first touch of the pages
+template <class TConvert>
+static double TimeConversion(TConvert convert)
+{
+	double bestSeconds = 1e9;
+	for (int run = 0; run < RUNS; run++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		convert();
+		bestSeconds = std::min(bestSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+	return bestSeconds;
+}
+
+template <class TVertex>
+static bool Benchmark(const char* name, const aiMesh* mesh)
+{
+	unsigned int vertexCount = mesh->mNumVertices;
+	double outputMB = (double) vertexCount * sizeof(TVertex) / (1024.0 * 1024.0);
+	std::vector<TVertex> expected(vertexCount);
+	std::vector<TVertex> vertices(vertexCount);
+
+	double perVertexSeconds = TimeConversion([&]()
+	{
+		for (unsigned int i = 0; i < vertexCount; i++)
+		{
+			VertexLayout<TVertex>::FromAssimp(mesh, i, expected[i]);
+		}
+	});
+	std::cout << name << " (" << vertexCount << " vertices, " << outputMB << " MB)" << std::endl;
+	std::cout << "  FromAssimp per vertex: " << perVertexSeconds * 1000.0 << " ms, " << outputMB / perVertexSeconds << " MB/s" << std::endl;
+
+	bool isSame = true;
+	sVertexStreams streams = GetAssimpStreams(mesh);
+	for (int level = SIMD_SCALAR; level <= GetSimdLevel(); level++)
+	{
+		memset(vertices.data(), 0xCD, vertices.size() * sizeof(TVertex));
+		double seconds = TimeConversion([&]()
+		{
+			InterleaveVertices(streams, vertices.data(), (eSimdLevel) level);
+		});
+
+		bool matches = memcmp(vertices.data(), expected.data(), vertices.size() * sizeof(TVertex)) == 0;
+		isSame &= matches;
+		std::cout << "  InterleaveVertices " << GetSimdLevelName((eSimdLevel) level) << ": " << seconds * 1000.0 << " ms, " << outputMB / seconds << " MB/s, "
+			<< perVertexSeconds / seconds << "x" << (matches ? "" : " (DIFFERENT from FromAssimp!)") << std::endl;
+	}
+
+	return isSame;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int vertexCount = argc > 1 ? (unsigned int) strtoul(argv[1], NULL, 10) : 1000000;
+	if (vertexCount == 0)
+	{
+		std::cout << "Usage: VertexConversionBenchmark [vertex count]" << std::endl;
+		return 1;
+	}
+
+	std::cout << "Best SIMD on this CPU: " << GetSimdLevelName(GetSimdLevel()) << ", best of " << RUNS << " runs each" << std::endl;
+
+	aiMesh* coloredMesh = MakeMesh(vertexCount, true, false);
+	aiMesh* plainMesh = MakeMesh(vertexCount, false, true);
+
+	bool isSame = true;
+	isSame &= Benchmark<sPositionNormalVertex>("sPositionNormalVertex", plainMesh);
+	isSame &= Benchmark<sColoredVertex>("sColoredVertex", coloredMesh);
+	isSame &= Benchmark<sColoredVertex>("sColoredVertex, no colors in the mesh", plainMesh);
+	isSame &= Benchmark<sVertex>("sVertex", plainMesh);
+
+	delete coloredMesh;
+	delete plainMesh;
+	return isSame ? 0 : 1;
+}
@@ -28,10 +28,24 @@
 #include "ModelManager.h"
 #include "TextureManager.h"
 #include "LightManager.h"
+#include "AssetReader.h"
+#include "VirtualFileSystem.h"
+#include "JobSystem.h"
+#include "FrameAllocator.h"
+#include "AllocationCounter.h"
+#include "RenderQueue.h"
+#include "RenderThread.h"
+#include "PanelAnimator.h"
+#include "PropertyAnimator.h"
+#include "SceneFile.h"
+#include "EntityRegistry.h"
 
 const float windowWidth = 1200;
 const float windowHeight = 640;
 bool editMode = true;
+const unsigned int maxFramesInFlight = 1; // Frames the render thread can be behind the simulation, see RenderThread
+const float simulationStep = 1.0f / 30.0f; // The simulation ticks at this rate whatever the frame rate, frames draw between ticks
+const float maxSimulationCatchUp = 0.25f; // Seconds of simulation a frame can run, so a long hitch doesn't snowball into more ticks
 
 ShaderManager gShaderManager;
 
@@ -41,159 +55,38 @@ float lightMoveSpeed = 0.01f;
 
 int currentEditIndex = 0;
 
-bool emergencyLightOn = false;
+LightHandle emergencyLightHandle; // Resolved in SetupLights
+PropertyAnimator gAnimator; // Evaluated once per frame, on the simulation clock
+PropertyAnimator::TrackID emergencySweepTrack = 0; // Turns the emergency light around while the alarm is on, made in SetupLights
 
-struct sPanel
-{
-	glm::vec3 currentPosition;
-	glm::vec3 closedPosition;
-	float openedDistance;
+sScene gScene; // Everything that's placed, from the scene file (see SceneFile.h)
 
-	bool IsOpened()
-	{
-		return glm::distance(currentPosition, closedPosition) >= openedDistance;
-	}
+// Handles to the scene's models by their index in gScene.models, resolved once after LoadModels so drawing doesn't look
+// models up by name
+std::vector<ModelHandle> gSceneModels;
+ModelHandle gLightFrameModel, gStarModel; // The scene loads these, main places them
 
-	bool IsClosed()
-	{
-		return glm::distance(currentPosition, closedPosition) <= 0.01;
-	}
-};
+PanelAnimator gPanels; // The scene's panel lines, like the hangar's back wall
+EntityRegistry gEntities; // Everything that's drawn, made from the scene in CreateEntities
 
-struct sPanelLine
+// The alarm, the emergency light sweeps around while it's on. Scenes don't need to have an emergency light.
+static void SetEmergency(bool isOn)
 {
-	enum ItOrder
+	Light* emergencyLight = LightManager::GetInstance()->GetLight(emergencyLightHandle);
+	if (emergencyLight)
 	{
-		Normal,
-		Reverse
-	};
-
-	std::vector<sPanel> panels;
-	glm::vec3 openDirection;
-	bool opening;
-	bool closing;
-	ItOrder itOrder;
+		emergencyLight->EditState(isOn);
+	}
 
-	void OnUpdate(float deltaTime)
+	if (isOn)
 	{
-		if (opening) // Try to open the doors
-		{
-			if (itOrder == Normal)
-			{
-				int needsUpdateIndex = -1;
-				for (int i = 0; i < panels.size(); i++)
-				{
-					if (panels[i].IsOpened()) // This panel has finished its opening process, move to the next one
-					{
-						if (i == panels.size() - 1) // All opened
-						{
-							emergencyLightOn = false;
-							LightManager::GetInstance()->GetLight("emergency")->EditState(false);
-							closing = false;
-							opening = false;
-						}
-
-						continue;
-					}
-
-					needsUpdateIndex = i;
-					break; // We break here because we only want one panel to move at a time
-				}
-
-				if (needsUpdateIndex == -1) // Finished opening process
-				{
-					return;
-				}
-
-				// We found the panel that needs updating, now iterate for start to that position an update panels
-				for (int i = 0; i < std::min((int) panels.size(), needsUpdateIndex + 1); i++)
-				{
-					panels[i].currentPosition += (openDirection * deltaTime);
-				}
-			}
-			else
-			{
-				int needsUpdateIndex = -1;
-				for (int i = panels.size() - 1; i >= 0; i--)
-				{
-					if (panels[i].IsOpened()) // This panel has finished its opening process, move to the next one
-					{
-						if (i == 0) // All opened
-						{
-							emergencyLightOn = false;
-							LightManager::GetInstance()->GetLight("emergency")->EditState(false);
-							closing = false;
-							opening = false;
-						}
-						continue;
-					}
-
-					needsUpdateIndex = i;
-					break; // We break here because we only want one panel to move at a time
-				}
-
-				if (needsUpdateIndex == -1) // Finished opening process
-				{
-					return;
-				}
-					
-				// We found the panel that needs updating, now iterate for start to that position an update panels
-				for (int i = panels.size() - 1; i >= std::max(0, needsUpdateIndex); i--)
-				{
-					panels[i].currentPosition += (openDirection * deltaTime);
-				}
-
-			}
-
-		}
-		else if(closing) // Try to close the doors
-		{
-			if (itOrder == Normal)
-			{
-				int needsUpdateIndex = -1;
-				for (int i = panels.size() - 1; i >= 0; i--)
-				{
-					if (panels[i].IsClosed()) // This panel has finished its closing process, move to the next one
-					{
-						if (i == 0) // All closed
-						{
-							emergencyLightOn = false;
-							LightManager::GetInstance()->GetLight("emergency")->EditState(false);
-							closing = false;
-							opening = false;
-						}
-
-						continue;
-					}
-
-					panels[i].currentPosition -= (openDirection * deltaTime);
-				}
-			}
-			else
-			{
-				int needsUpdateIndex = -1;
-				for (int i = 0; i < panels.size(); i++)
-				{
-					if (panels[i].IsClosed()) // This panel has finished its closing process, move to the next one
-					{
-						if (i == panels.size() - 1) // All closed
-						{
-							emergencyLightOn = false;
-							LightManager::GetInstance()->GetLight("emergency")->EditState(false);
-							closing = false;
-							opening = false;
-						}
-						continue;
-					}
-
-					panels[i].currentPosition -= (openDirection * deltaTime);
-				}
-			}
-		}
+		gAnimator.Play(emergencySweepTrack);
 	}
-};
-
-std::vector<sPanelLine> panelLines(8);
+	else
+	{
+		gAnimator.Stop(emergencySweepTrack);
+	}
+}
 
 static void error_callback(int error, const char* description)
 {
@@ -247,24 +140,19 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
 		glfwSetInputMode(window, GLFW_CURSOR, cursorOption);
 	}
 
-	if (key == GLFW_KEY_PAGE_UP && action == GLFW_PRESS)
-	{
-		LightManager::GetInstance()->GetLight("emergency")->EditState(true);
-		emergencyLightOn = true;
-		for (sPanelLine& line : panelLines)
-		{
-			line.opening = false;
-			line.closing = true;
-		}
-	}
-	else if (key == GLFW_KEY_PAGE_DOWN && action == GLFW_PRESS)
+	if ((key == GLFW_KEY_PAGE_UP || key == GLFW_KEY_PAGE_DOWN) && action == GLFW_PRESS)
 	{
-		LightManager::GetInstance()->GetLight("emergency")->EditState(true);
-		emergencyLightOn = true;
-		for (sPanelLine& line : panelLines)
+		SetEmergency(true);
+		for (unsigned int line = 0; line < gPanels.GetLineCount(); line++)
 		{
-			line.closing = false;
-			line.opening = true;
+			if (key == GLFW_KEY_PAGE_UP)
+			{
+				gPanels.Close(line);
+			}
+			else
+			{
+				gPanels.Open(line);
+			}
 		}
 	}
 }
@@ -278,12 +166,12 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 }
 
 bool InitializerShaders();
-void LoadModels();
-void DrawTunnel(const CompiledShader& shader);
-void DrawHangar(const CompiledShader& shader, const std::vector<sPanelLine>& panelLines);
-void SetupLights(const CompiledShader& shader);
-void DrawProps(const CompiledShader& shader);
-void DrawStars(const CompiledShader& shader, const std::vector<glm::vec3>& starPositions);
+bool LoadScene(const std::string& path, sScene& scene);
+void LoadModels(const sScene& scene);
+void ResolveModelHandles(const sScene& scene);
+void SetupLights(const CompiledShader& shader, const sScene& scene);
+void SetupPanels(const sScene& scene, PanelAnimator& panels);
+void CreateEntities(const sScene& scene, const std::vector<glm::vec3>& starPositions, EntityRegistry& entities);
 
 template <class T>
 T gGetRandBetween(T LO, T HI);
@@ -294,13 +182,16 @@ int main(void)
 
 	glfwSetErrorCallback(error_callback);
 
+	JobSystem::GetInstance(); // Makes this thread worker 0 and starts the others
+
 	if (!glfwInit())
 	{
 		return -1;
 	}
 
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+	// Lights set their uniforms with glProgramUniform (4.1) and cooked meshes upload through the 4.5 buffer functions
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
 
 	// Initialize our window
 	window = glfwCreateWindow(windowWidth, windowHeight, "Midterm", NULL, NULL);
@@ -317,73 +208,88 @@ int main(void)
 
 	glfwMakeContextCurrent(window);
 	gladLoadGLLoader((GLADloadproc) glfwGetProcAddress); // Give glad this process ID
+	if (!GLAD_GL_VERSION_4_5)
+	{
+		std::cout << "OpenGL 4.5 is required" << std::endl;
+		glfwDestroyWindow(window);
+		glfwTerminate();
+		exit(EXIT_FAILURE);
+	}
 	glfwSwapInterval(1);
 
+	// Use the cooked assets if they've been built (see Tools/AssetCooker), then the packed ones (see Tools/AssetPacker),
+	// otherwise everything comes from the loose files. The packed archive goes under the cooked one, so a cooked model
+	// that's out of date can still load its source from it.
+	{
+		std::stringstream cookedArchivePath;
+		cookedArchivePath << SOLUTION_DIR << "Extern\\assets.cooked.pak";
+		std::stringstream archivePath;
+		archivePath << SOLUTION_DIR << "Extern\\assets.pak";
+		std::stringstream mountPoint;
+		mountPoint << SOLUTION_DIR << "Extern\\assets\\";
+		VirtualFileSystem::GetInstance()->Mount(archivePath.str(), mountPoint.str());
+		VirtualFileSystem::GetInstance()->Mount(cookedArchivePath.str(), mountPoint.str());
+	}
+
 	if (!InitializerShaders())
 	{
 		return -1;
 	}
 
-	LoadModels();
+	// The cooked scene if the archive has it, otherwise the text one (see Tools/AssetCooker)
+	{
+		std::stringstream scenePath;
+		scenePath << SOLUTION_DIR << "Extern\\assets\\scenes\\station.scene";
+		if (!LoadScene(scenePath.str(), gScene))
+		{
+			return -1;
+		}
+	}
 
-	CompiledShader shader = *gShaderManager.pGetShaderProgramFromFriendlyName("Shader#1");
+	LoadModels(gScene); // The driver compiles our shaders while we load models
+	ResolveModelHandles(gScene);
+	ModelManager::GetInstance()->PrintLoadReport();
+	ModelManager::GetInstance()->PrintMemoryReport();
+	ModelManager::GetInstance()->PrintPackingReport();
+	ModelManager::GetInstance()->PrintVertexCacheReport();
 
-	float fpsFrameCount = 0.f;
-	float fpsTimeElapsed = 0.f;
-
-	float previousTime = static_cast<float>(glfwGetTime());
+	gShaderManager.waitForPendingPrograms();
+	CompiledShader* pShader = gShaderManager.pGetShaderProgramFromFriendlyName("Shader#1");
+	if (!pShader)
+	{
+		std::cout << "Error making shaders: " << std::endl;
+		std::cout << gShaderManager.getLastError() << std::endl;
+		return -1;
+	}
 
-	SetupLights(shader);
+	std::cout << "Shaders compiled OK" << std::endl;
+	CompiledShader& shader = *pShader; // Reference, hot reloading swaps the program inside it
 
-	// TODO: Fill in hole by door
+	gShaderManager.enableHotReload();
+	std::vector<ShaderManager::sReloadedProgram> reloadedShaders;
 
-	// Initlaize panelLines
-	float wallZ = -17.5f;
-	float wallY = 0.0f;
-	for (int height = 0; height < 5; height++)
+	std::vector<CompiledShader*> shaderVariants;
+	for (unsigned int variantFlags = 0; variantFlags < ShaderManager::VARIANT_COUNT; variantFlags++)
 	{
-		wallZ = -17.5f;
-
-		sPanelLine panelLineLeft;
-		panelLineLeft.opening = false;
-		panelLineLeft.closing = false;
-		panelLineLeft.openDirection = glm::vec3(0.0f, 0.0f, -1.0f);
-		panelLineLeft.itOrder = sPanelLine::Reverse;
-
-		sPanelLine panelLineRight;
-		panelLineRight.opening = false;
-		panelLineRight.closing = false;
-		panelLineRight.openDirection = glm::vec3(0.0f, 0.0f, 1.0f);
-		panelLineRight.itOrder = sPanelLine::Normal;
-		for (int width = 0; width < 4; width++)
+		CompiledShader* variant = gShaderManager.pGetShaderVariant("Shader#1", variantFlags);
+		if (!variant)
 		{
-			if (width < 2)
-			{
-				glm::vec3 pos = glm::vec3(75.0f, wallY, wallZ);
-				sPanel panel;
-				panel.closedPosition = pos;
-				panel.currentPosition = pos;
-				panel.openedDistance = 10.0f;
-				panelLineLeft.panels.push_back(panel);
-			} 
-			else
-			{
-				glm::vec3 pos = glm::vec3(75.0f, wallY, wallZ);
-				sPanel panel;
-				panel.closedPosition = pos;
-				panel.currentPosition = pos;
-				panel.openedDistance = 10.0f;
-				panelLineRight.panels.push_back(panel);
-			}
-			wallZ += 10.0f;
+			std::cout << "Error making shader variant " << variantFlags << ": " << gShaderManager.getLastError() << std::endl;
+			continue;
 		}
 
-		panelLines.push_back(panelLineLeft);
-		panelLines.push_back(panelLineRight);
-
-		wallY += 5.0f;
+		shaderVariants.push_back(variant);
+		LightManager::GetInstance()->AddShader(*variant);
 	}
 
+	float fpsFrameCount = 0.f;
+	float fpsTimeElapsed = 0.f;
+
+	float previousTime = static_cast<float>(glfwGetTime());
+
+	SetupLights(shader, gScene);
+	SetupPanels(gScene, gPanels);
+
 	// Init stars
 	std::vector<glm::vec3> starPositions;
 
@@ -404,42 +310,38 @@ int main(void)
 		}
 	}
 
+	CreateEntities(gScene, starPositions, gEntities);
+
 	camera.position = glm::vec3(-5.0f, 3.0f, 2.5f);
 	camera.direction = glm::vec3(1.0f, 0.0f, 0.0f);
 
-	float emergencyLightAngle = 0.0f;
+	double simulationClock = 0.0; // Seconds simulated, a step at a time
+	float simulationTime = 0.0f; // Not simulated yet, less than a step
 
-	// Our actual render loop
-	while (!glfwWindowShouldClose(window))
+	// Draws the frames the loop below hands it, with the GL context, so the next frame is simulated meanwhile
+	RenderThread renderThread;
+	CommandListPlayer commandPlayer; // Render thread only, it keeps the uniform locations between frames
+	renderThread.Start(window, maxFramesInFlight, [&](const sFrameData& frame)
 	{
-		float currentTime = static_cast<float>(glfwGetTime());
-		float deltaTime = currentTime - previousTime;
-		previousTime = currentTime;
+		// Pick up any edited shaders before we start drawing
+		reloadedShaders.clear();
+		if (!gShaderManager.updateHotReload(reloadedShaders))
+		{
+			std::cout << gShaderManager.getLastError() << std::endl;
+		}
 
-		// FPS TITLE
+		for (const ShaderManager::sReloadedProgram& reloaded : reloadedShaders)
 		{
-			fpsTimeElapsed += deltaTime;
-			fpsFrameCount += 1.0f;
-			if (fpsTimeElapsed >= 0.03f)
+			if (reloaded.oldID == 0)
 			{
-				std::string fps = std::to_string(fpsFrameCount / fpsTimeElapsed);
-				std::string ms = std::to_string(1000.f * fpsTimeElapsed / fpsFrameCount);
-				std::string newTitle = "FPS: " + fps + "   MS: " + ms;
-				glfwSetWindowTitle(window, newTitle.c_str());
-
-	
-				fpsTimeElapsed = 0.f;
-				fpsFrameCount = 0.f;
+				// A variant that failed at startup built this time, set it up the same way
+				shaderVariants.push_back(reloaded.program);
+				LightManager::GetInstance()->AddShader(*reloaded.program);
+				continue;
 			}
-		}
 
-		float ratio;
-		int width, height;
-		glm::mat4 projection;
-		glm::mat4 view;
-
-		glfwGetFramebufferSize(window, &width, &height); // Assign width and height to our window width and height
-		ratio = width / (float)height;
+			LightManager::GetInstance()->ReplaceShader(reloaded.oldID, *reloaded.program);
+		}
 
 		glEnable(GL_BLEND);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -447,68 +349,142 @@ int main(void)
 		glEnable(GL_DEPTH);
 		glEnable(GL_DEPTH_TEST); // Enables the Depth Buffer, which decides which pixels will be drawn based on their depth (AKA don't draw pixels that are behind other pixels)
 
-		glViewport(0, 0, width, height); // Specifies the transformation of device coords to window coords 
+		glViewport(0, 0, frame.width, frame.height); // Specifies the transformation of device coords to window coords 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clears the buffers
 
-		view = camera.GetViewMatrix();
-		projection = glm::perspective(0.6f, ratio, 0.1f, 1000.0f);
+		for (CompiledShader* variant : shaderVariants) // Every variant is its own program, so they all need the camera
+		{
+			variant->Bind();
+			glUniformMatrix4fv(glGetUniformLocation(variant->ID, "matView"), 1, GL_FALSE, glm::value_ptr(frame.view)); // Assign new view matrix
+			glUniformMatrix4fv(glGetUniformLocation(variant->ID, "matProjection"), 1, GL_FALSE, glm::value_ptr(frame.projection)); // Assign projection
+			glUniform4f(glGetUniformLocation(variant->ID, "cameraPosition"), frame.cameraPosition.x, frame.cameraPosition.y, frame.cameraPosition.z, 1.0f);
+		}
+
+		LightManager::GetInstance()->SendLights(frame.lights);
+		frame.queue.Submit(shader, commandPlayer);
+	});
+
+	unsigned int visibleCount = 0;
+	unsigned int meshCount = 0;
+	unsigned int patchedCount = 0;
+	JobSystem::GetInstance()->ResetStats(); // Only count the frames
+
+	// Heap allocations of the frames after the first few, which record the scene and grow everything to size. Once
+	// they're done nothing should allocate, transient data comes from the frame arenas.
+	const unsigned long long allocationWarmUpFrames = 10;
+	unsigned long long frameNumber = 0;
+	unsigned long long allocatingFrames = 0;
+	unsigned long long steadyAllocations = 0;
+	unsigned long long lastAllocationCount = GetHeapAllocationCount();
+
+	// Our actual render loop, it only simulates and builds frames now
+	while (!glfwWindowShouldClose(window))
+	{
+		float currentTime = static_cast<float>(glfwGetTime());
+		float deltaTime = currentTime - previousTime;
+		previousTime = currentTime;
 
-		shader.Bind();
-		glUniformMatrix4fv(glGetUniformLocation(shader.ID, "matView"), 1, GL_FALSE, glm::value_ptr(view)); // Assign new view matrix
-		glUniformMatrix4fv(glGetUniformLocation(shader.ID, "matProjection"), 1, GL_FALSE, glm::value_ptr(projection)); // Assign projection
-		glUniform4f(glGetUniformLocation(shader.ID, "cameraPosition"), camera.position.x, camera.position.y, camera.position.z, 1.0f);
+		FrameArena::GetThreadArena().Reset(); // Nothing from the last frame is used past its EndFrame
 
-		// Safety, mostly for first frame
-		if (deltaTime == 0.0f)
+		unsigned long long allocationCount = GetHeapAllocationCount();
+		if (frameNumber++ >= allocationWarmUpFrames && allocationCount != lastAllocationCount)
 		{
-			deltaTime = 0.03f;
+			// Something in the last frame went to the heap when it should have used the frame arena or kept its capacity
+			std::cout << "Frame " << frameNumber - 2 << " made " << allocationCount - lastAllocationCount << " heap allocations after warm-up!" << std::endl;
+			allocatingFrames++;
+			steadyAllocations += allocationCount - lastAllocationCount;
 		}
+		lastAllocationCount = allocationCount;
 
-		for (sPanelLine& line : panelLines)
+		// FPS TITLE
 		{
-			line.OnUpdate(deltaTime);
+			fpsTimeElapsed += deltaTime;
+			fpsFrameCount += 1.0f;
+			if (fpsTimeElapsed >= 0.03f)
+			{
+				char newTitle[256]; // Formatted in place, std::to_string and concatenating allocated every time
+				snprintf(newTitle, sizeof(newTitle), "FPS: %f   MS: %f   Drawn: %u/%u   Patched: %u", fpsFrameCount / fpsTimeElapsed, 1000.f * fpsTimeElapsed / fpsFrameCount,
+					visibleCount, meshCount, patchedCount);
+				glfwSetWindowTitle(window, newTitle);
+
+	
+				fpsTimeElapsed = 0.f;
+				fpsFrameCount = 0.f;
+			}
 		}
 
-		if (emergencyLightOn)
+		// Tick the simulation for the time that passed, in fixed steps so it behaves the same at any frame rate
+		simulationTime += std::min(deltaTime, maxSimulationCatchUp);
+		while (simulationTime >= simulationStep)
 		{
-			Light* light = LightManager::GetInstance()->GetLight("emergency");
-			glm::vec3 lightPos =  light->GetPosition();
-			emergencyLightAngle += glm::radians(10.0f);
+			gPanels.Update(simulationStep);
+			if (!gPanels.GetEvents().empty())
+			{
+				// A line finished opening or closing, the alarm is over
+				SetEmergency(false);
+			}
 
-			glm::vec3 newPos = glm::vec3(lightPos.x + (cos(emergencyLightAngle)) * 5.0f, lightPos.y, lightPos.z + (sin(emergencyLightAngle) * 5.0f));
-			glm::vec3 newDirection = glm::normalize(newPos - lightPos);
-			light->EditDirection(newDirection.x, newDirection.y, newDirection.z, 1.0f);
+			simulationClock += simulationStep;
+			simulationTime -= simulationStep;
 		}
 
-		// QUESTION 1
-		DrawTunnel(shader);
+		// How far the frame is between the last tick and the next, everything that moves is drawn that far along
+		float simulationAlpha = simulationTime / simulationStep;
 
-		// QUESTION 2
-		DrawHangar(shader, panelLines);
+		// The tracks are functions of time, so rather than blending two ticks they're evaluated right where the frame is
+		gAnimator.Update(simulationClock + simulationAlpha * simulationStep, gEntities);
 
-		// QUESTION 3
-		DrawProps(shader);
+		// Only what moved gets its bounds rebuilt and its light moved
+		gEntities.UpdateLights();
+		gEntities.UpdatePanels(gPanels, simulationAlpha);
+		gEntities.UpdateTransforms();
 
-		// QUESTION 4
-		DrawStars(shader, starPositions);
+		// Waits if the render thread is maxFramesInFlight frames behind
+		sFrameData& frame = renderThread.BeginFrame();
 
-		// Draw lights
-		for (Light* light : LightManager::GetInstance()->GetLights())
-		{
-			ModelManager::GetInstance()->Draw("lightFrame", shader, light->GetPosition(), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-		}
+		glfwGetFramebufferSize(window, &frame.width, &frame.height); // Assign width and height to our window width and height
+		float ratio = frame.width / (float) std::max(frame.height, 1);
+
+		frame.view = camera.GetViewMatrix();
+		frame.projection = glm::perspective(0.6f, ratio, 0.1f, 1000.0f);
+		frame.cameraPosition = camera.position;
+		LightManager::GetInstance()->GetLightUniforms(frame.lights);
+
+		// Everything below only queues draws, Prepare records (or patches what moved) and culls them on the job system and
+		// the render thread draws them
+		frame.queue.Clear();
 
-		// Show what we've drawn
-		glfwSwapBuffers(window);
+		gEntities.Cull(frame.projection * frame.view);
+		gEntities.Submit(frame.queue);
+
+		frame.queue.Prepare(frame.projection * frame.view);
+		visibleCount = frame.queue.GetVisibleCount();
+		meshCount = frame.queue.GetMeshCount();
+		patchedCount = frame.queue.GetPatchedCount();
+
+		renderThread.EndFrame(); // The frame is the render thread's now
 		glfwPollEvents();
 	}
 
+	renderThread.Stop(); // The context is back on this thread for the clean up
+	renderThread.PrintStats();
+
+	std::cout << "Heap allocations after the first " << allocationWarmUpFrames << " frames: " << steadyAllocations << " in " << allocatingFrames << " of "
+		<< (frameNumber > allocationWarmUpFrames ? frameNumber - allocationWarmUpFrames : 0) << " frames, main thread frame arena peaked at "
+		<< FrameArena::GetThreadArena().GetHighWater() << " bytes" << std::endl;
+
+	JobSystem::GetInstance()->PrintStats();
+	delete JobSystem::GetInstance();
+
 	TextureManager::GetInstance()->CleanUp();
 	delete TextureManager::GetInstance();
 
 	ModelManager::GetInstance()->CleanUp();
 	delete ModelManager::GetInstance();
 
+	delete AssetReader::GetInstance();
+	delete VirtualFileSystem::GetInstance(); // Unmounts, so after everything that could still point into an archive
+
 	glfwDestroyWindow(window); // Clean up the window
 
 	glfwTerminate(); 
@@ -531,239 +507,112 @@ bool InitializerShaders()
 	fragmentShader.fileName = ss.str();
 	ss.str("");
 
-	bool success = gShaderManager.createProgramFromFile("Shader#1", vertexShader, fragmentShader);
-	if (success)
-	{
-		std::cout << "Shaders compiled OK" << std::endl;
-	}
-	else
+	// Read both in one go, the shader manager parses them from memory
+	AssetReader::GetInstance()->Request(vertexShader.fileName);
+	AssetReader::GetInstance()->Request(fragmentShader.fileName);
+	AssetReader::GetInstance()->ReadRequested();
+
+	// Only submits the compile, main() waits for it after loading the models
+	bool success = gShaderManager.submitProgramFromFile("Shader#1", vertexShader, fragmentShader);
+	if (!success)
 	{
 		std::cout << "Error making shaders: " << std::endl;
 		std::cout << gShaderManager.getLastError() << std::endl;
-		return 1;
+		return false;
 	}
 
-	return success;
-}
-
-void DrawTunnel(const CompiledShader& shader)
-{
-	// Section 0
-	ModelManager::GetInstance()->Draw("wall3", shader, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("wall3", shader, glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-
-	// Section 1
-	ModelManager::GetInstance()->Draw("wall2", shader, glm::vec3(5.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("wall4", shader, glm::vec3(5.0f, 0.0f, 5.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-
-	// Section 2
-	ModelManager::GetInstance()->Draw("wall4", shader, glm::vec3(10.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("wall5", shader, glm::vec3(10.0f, 0.0f, 5.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-
-	// Section 3
-	ModelManager::GetInstance()->Draw("wall5", shader, glm::vec3(15.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("wall5", shader, glm::vec3(15.0f, 0.0f, 5.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-
-	// Tunnel floor
-	float floorX = 0.0f;
-	float lightX = -2.5f;
-	for (int i = 0; i < 4; i++)
+	// Submit every variant of our shader up front too, so we don't hitch the first time a mesh needs one
+	for (unsigned int variantFlags = 0; variantFlags < ShaderManager::VARIANT_COUNT; variantFlags++)
 	{
-		ModelManager::GetInstance()->Draw("clight", shader, glm::vec3(lightX, 5.0f, 2.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-		ModelManager::GetInstance()->Draw("floor", shader, glm::vec3(floorX, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-		ModelManager::GetInstance()->Draw("floor", shader, glm::vec3(floorX, 5.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-
-		lightX += 5.0f;
-		floorX += 5.0f;
+		gShaderManager.submitShaderVariant("Shader#1", variantFlags);
 	}
 
-	// Tunnel Door
-	ModelManager::GetInstance()->Draw("tdoor1", shader, glm::vec3(17.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("door", shader, glm::vec3(17.5f, 0.0f, 1.5f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
+	AssetReader::GetInstance()->Release(vertexShader.fileName);
+	AssetReader::GetInstance()->Release(fragmentShader.fileName);
 
+	return success;
 }
 
-void DrawHangar(const CompiledShader& shader, const std::vector<sPanelLine>& panelLines)
+bool LoadScene(const std::string& path, sScene& scene)
 {
-	float floorX = 20.0f;
-	float floorZ = -(3.5f * 5.0f);
-
-	// Draw hangar floor & ceiling
-	for (int i = 0; i < 12; i++)
-	{
-		floorZ = -(3.5f * 5.0f); // Reset z to base value
-		for (int j = 0; j < 8; j++)
-		{
-			ModelManager::GetInstance()->Draw("hangarFloor", shader, glm::vec3(floorX, 0.0f, floorZ), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-			ModelManager::GetInstance()->Draw("hangarFloor", shader, glm::vec3(floorX, 25.0f, floorZ), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-
-			floorZ += 5.0f;
-		}
-
-		floorX += 5.0f;
-	}
+	AssetReader::GetInstance()->Request(path);
+	AssetReader::GetInstance()->ReadRequested();
 
-	// Draw hangar lights
-	float lightX = 25.0f;
-	for (int i = 0; i < 3; i++)
+	sFileView file;
+	if (!AssetReader::GetInstance()->GetFile(path, file))
 	{
-		ModelManager::GetInstance()->Draw("hangarLight", shader, glm::vec3(lightX, 23.5f, -7.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-		ModelManager::GetInstance()->Draw("hangarLight", shader, glm::vec3(lightX, 23.5f, 7.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-		lightX += 20.0f;
+		std::cout << "Couldn't read the scene " << path << std::endl;
+		return false;
 	}
 
-
-	// Left Hangar Wall
-	float wallX = 15.0f;
-	float wallY = 0.0f;
-	for (int width = 0; width < 6; width++)
+	bool success = true;
+	if (IsCookedScene(file.data, file.size))
 	{
-		wallY = 0.0f;
-		for (int height = 0; height < 5; height++)
+		success = ReadCookedScene(file.data, file.size, scene);
+		if (!success)
 		{
-			ModelManager::GetInstance()->Draw("cwall", shader, glm::vec3(wallX, wallY, -17.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-
-			wallY += 5.0f;
+			std::cout << "The cooked scene " << path << " is corrupt or from another version, cook the assets again" << std::endl;
 		}
-		wallX += 10.0f;
 	}
-
-	// Right Hangar Wall
-	wallX = 25.0f;
-	wallY = 0.0f;
-	for (int width = 0; width < 6; width++)
+	else
 	{
-		wallY = 0.0f;
-		for (int height = 0; height < 5; height++)
+		std::string error;
+		success = ParseSceneText((const char*) file.data, file.size, scene, error);
+		if (!success)
 		{
-			ModelManager::GetInstance()->Draw("cwall", shader, glm::vec3(wallX, wallY, 22.5f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-			wallY += 5.0f;
+			std::cout << "Error in the scene " << path << ": " << error << std::endl;
 		}
-		wallX += 10.0f;
 	}
 
-	// Back wall, but since we can open these, they are a bit special
-	for (const sPanelLine& panelLine : panelLines)
-	{
-		for (const sPanel& panel : panelLine.panels)
-		{
-			ModelManager::GetInstance()->Draw("cwall", shader, panel.currentPosition, glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-		}
-	}
+	AssetReader::GetInstance()->Release(path);
+	return success;
+}
 
-	// Front wall (by door)
-	wallX = -7.5f;
-	wallY = 0.0f;
-	for (int width = 0; width < 4; width++)
+void SetupLights(const CompiledShader& shader, const sScene& scene)
+{
+	for (const sSceneLight& sceneLight : scene.lights)
 	{
-		wallY = 0.0f;
-		for (int height = 0; height < 5; height++)
+		LightHandle handle = LightManager::GetInstance()->AddLight(shader, scene.GetString(sceneLight.name), sceneLight.position);
+		Light* light = LightManager::GetInstance()->GetLight(handle);
+		if (!light)
 		{
-			if ((width == 1 || width == 2) && height == 0) // Don't draw panels blocking door
-			{
-				wallY += 5.0f;
-				continue;
-			}
-
-			ModelManager::GetInstance()->Draw("cwall", shader, glm::vec3(15.0f, wallY, wallX), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-			wallY += 5.0f;
+			continue;
 		}
-		wallX += 10.0f;
-	}
 
-	ModelManager::GetInstance()->Draw("connector", shader, glm::vec3(15.25f, 2.5f, -3.75f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("connector", shader, glm::vec3(15.25f, 2.5f, 8.75f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-
-	ModelManager::GetInstance()->Draw("corner", shader, glm::vec3(14.6f, 6.4f, 8.25f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("corner2", shader, glm::vec3(14.6f, 2.4f, 8.1f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("corner3", shader, glm::vec3(14.6f, 2.4f, 4.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("corner4", shader, glm::vec3(14.6f, 6.4f, 3.75f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
+		light->EditLightType((Light::LightType) sceneLight.type, sceneLight.innerAngle, sceneLight.outerAngle);
+		light->EditDirection(sceneLight.direction.x, sceneLight.direction.y, sceneLight.direction.z, sceneLight.direction.w);
+		light->EditDiffuse(sceneLight.diffuse.x, sceneLight.diffuse.y, sceneLight.diffuse.z, sceneLight.diffuse.w);
+		light->EditSpecular(sceneLight.specular.x, sceneLight.specular.y, sceneLight.specular.z, sceneLight.specular.w);
+		light->EditAttenuation(sceneLight.attenuation.x, sceneLight.attenuation.y, sceneLight.attenuation.z, sceneLight.attenuation.w);
+		light->EditState(sceneLight.isOn != 0);
+	}
+
+	emergencyLightHandle = LightManager::GetInstance()->GetLightHandle("emergency");
+
+	// Sweeps around at 600 degrees a second, (cos, 0, sin) of the angle
+	sAnimationTarget sweepTarget;
+	sweepTarget.property = ANIMATE_LIGHT_DIRECTION;
+	sweepTarget.light = emergencyLightHandle;
+	sOscillator sweep;
+	sweep.offset = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	sweep.amplitude = glm::vec4(1.0f, 0.0f, 1.0f, 0.0f);
+	sweep.frequency = glm::vec4(600.0f / 360.0f);
+	sweep.phase = glm::vec4(glm::radians(90.0f), 0.0f, 0.0f, 0.0f);
+	emergencySweepTrack = gAnimator.AddOscillatorTrack(sweepTarget, sweep);
 }
 
-void SetupLights(const CompiledShader& shader)
+void SetupPanels(const sScene& scene, PanelAnimator& panels)
 {
-	LightManager::GetInstance()->AddLight(shader, "tunnel", glm::vec3(0.0f, 2.5f, 2.5f));
-	Light* tunnelLight = LightManager::GetInstance()->GetLight("tunnel");
-	tunnelLight->EditLightType(Light::LightType::POINT, 0.0f, 0.0f);
-	tunnelLight->EditDirection(1.0f, 0.0f, 0.0f, 1.0f);
-	tunnelLight->EditDiffuse(1.0f, 1.0f, 0.0f, 1.0f); // Yellow
-	tunnelLight->EditAttenuation(0.24f, 1.35f, 0.72f, 50.0f);
-
-	LightManager::GetInstance()->AddLight(shader, "emergency", glm::vec3(55.0f, 20.0f, 0.0f));
-	Light* emergencyLight = LightManager::GetInstance()->GetLight("emergency");
-	emergencyLight->EditLightType(Light::LightType::SPOT, 30.0f, 35.0f);
-	emergencyLight->EditDirection(1.0f, 0.0f, 0.0f, 1.0f);
-	emergencyLight->EditDiffuse(1.0f, 0.0f, 0.0f, 1.0f);
-	emergencyLight->EditSpecular(1.0f, 0.0f, 0.0f, 100.0f);
-	emergencyLight->EditState(false);
-
-	LightManager::GetInstance()->AddLight(shader, "hangar", glm::vec3(50.0f, 12.0f, 0.0f));
-	Light* hangarLight = LightManager::GetInstance()->GetLight("hangar");
-	hangarLight->EditLightType(Light::LightType::POINT, 0.0f, 0.0f);
-	hangarLight->EditDirection(0.0f, 1.0f, 0.0f, 1.0f);
-	hangarLight->EditAttenuation(0.8f, 0.3f, 0.05f, 50.0f);
-
-	float lightX = 25.0f;
-	for (int i = 0; i < 3; i++)
+	for (const sScenePanelLine& line : scene.panelLines)
 	{
-		std::stringstream ss;
-		ss << "spot" << i + "_1";
-		std::string firstSpot = ss.str();
-		ss.str("");
-		LightManager::GetInstance()->AddLight(shader, firstSpot, glm::vec3(lightX, 21.5f, -7.5f));
-		Light* spot1 = LightManager::GetInstance()->GetLight(firstSpot);
-		spot1->EditLightType(Light::LightType::SPOT, 2.0f, 40.0f);
-		spot1->EditDirection(0.0f, -1.0f, 0.0f, 1.0f);
-
-		ss << "spot" << i << "_2";
-		std::string secondSpot = ss.str();
-		ss.str("");
-		LightManager::GetInstance()->AddLight(shader, secondSpot, glm::vec3(lightX, 21.5f, 7.5f));
-		Light* spot2 = LightManager::GetInstance()->GetLight(secondSpot);
-		if (i == 2)
-		{ // Make one of the lights super bright
-			spot2->EditLightType(Light::LightType::SPOT, 15.0f, 25.0f);
-		}
-		else
+		panels.AddLine(line.openDirection, line.speed, line.sequence == SCENE_PANELS_FORWARD ? PanelAnimator::SEQUENCE_FORWARD : PanelAnimator::SEQUENCE_REVERSE);
+		for (unsigned int panel = line.firstPanel; panel < line.firstPanel + line.panelCount; panel++)
 		{
-			spot2->EditLightType(Light::LightType::SPOT, 2.0f, 40.0f);
+			panels.AddPanel(scene.panels[panel].closedPosition, scene.panels[panel].openedDistance);
 		}
-		
-		spot2->EditDirection(0.0f, -1.0f, 0.0f, 1.0f);
-
-
-		lightX += 20.0f;
 	}
 }
 
-void DrawProps(const CompiledShader& shader)
-{
-	// Desks
-	ModelManager::GetInstance()->Draw("desk1", shader, glm::vec3(20.0f, 0.0f, -10.0f), glm::vec3(0.764842f, 0.0f, -0.644218f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.644218f, 0.0f, 0.764842f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("desk2", shader, glm::vec3(20.0f, 0.0f, 15.0f), glm::vec3(-0.856888f, 0.0f, -0.515502f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.515502f, 0.0f, -0.856888f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-
-	ModelManager::GetInstance()->Draw("smallDesk", shader, glm::vec3(70.0f, 0.0f, -10.0f), glm::vec3(-0.702712f, 0.0f, -0.711474f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.711474f, 0.0f, -0.702712f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("bigDesk", shader, glm::vec3(70.0f, 0.0f, 15.0f), glm::vec3(0.659983f, 0.0f, -0.751281f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.751281f, 0.0f, 0.659983f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-
-	// Beakers
-	ModelManager::GetInstance()->Draw("beaker", shader, glm::vec3(70.0f, 1.5f, 15.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 0.5f);
-	ModelManager::GetInstance()->Draw("beaker", shader, glm::vec3(69.5f, 1.5f, 16.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 0.5f);
-	ModelManager::GetInstance()->Draw("beaker", shader, glm::vec3(69.0f, 1.5f, 16.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 0.5f);
-	ModelManager::GetInstance()->Draw("beaker", shader, glm::vec3(71.5f, 1.5f, 14.2f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 0.5f);
-
-	// WhatModelsShouldIUseINFO6028Midterm.exe models
-	ModelManager::GetInstance()->Draw("locker1", shader, glm::vec3(30.0f, 0.0f, -16.8f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("locker1", shader, glm::vec3(31.0f, 0.0f, -16.8f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("locker2", shader, glm::vec3(32.8f, 0.0f, -16.8f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("plant1", shader, glm::vec3(54.0f, 0.0f, 22.2f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("plant2", shader, glm::vec3(60.0f, 0.0f, 20.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("rocket", shader, glm::vec3(70.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("scales", shader, glm::vec3(70.0f, 1.5f, -10.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("server", shader, glm::vec3(72.5f, 0.0f, -16.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("sign", shader, glm::vec3(63.0f, 0.0f, 19.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-	ModelManager::GetInstance()->Draw("monitor", shader, glm::vec3(20.0f, 1.5f, 15.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
-}
-
 template <class T>
 T gGetRandBetween(T LO, T HI)
 {
@@ -773,189 +622,134 @@ T gGetRandBetween(T LO, T HI)
 	return r3;
 }
 
-void DrawStars(const CompiledShader& shader, const std::vector<glm::vec3>& starPositions)
+void CreateEntities(const sScene& scene, const std::vector<glm::vec3>& starPositions, EntityRegistry& entities)
 {
-	for (const glm::vec3& pos : starPositions)
+	for (const sSceneInstance& instance : scene.instances)
 	{
-		ModelManager::GetInstance()->Draw("star", shader, pos, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f);
+		EntityHandle entity = entities.CreateEntity();
+		entities.AddTransform(entity, { instance.position, instance.xRot, instance.yRot, instance.zRot, instance.scale });
+		entities.AddRenderable(entity, { gSceneModels[instance.model], instance.transparency });
+		entities.AddBounds(entity);
 	}
-}
 
-void LoadModels()
-{
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\ISO_Sphere.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "lightFrame");
-		model->SetWireframe(true);
-		model->SetIgnoreLighting(true);
-		model->SetIsOverrideColor(true);
-		model->SetColorOverride(glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\ISO_Sphere.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "star");
-		model->SetIgnoreLighting(true);
-		model->SetIsOverrideColor(true);
-		model->SetColorOverride(glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Env_Wall_Curved_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "wall1");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Env_Wall_Curved_02_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "wall2");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Env_Wall_Curved_03_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "wall3");
-	}
+	// SetupPanels added the lines and panels in the scene's order, so the indices are the same
+	for (const sScenePanelLine& line : scene.panelLines)
 	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Env_Wall_Curved_04_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "wall4");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Env_Wall_Curved_05_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "wall5");
+		for (unsigned int panel = line.firstPanel; panel < line.firstPanel + line.panelCount; panel++)
+		{
+			EntityHandle entity = entities.CreateEntity();
+			entities.AddTransform(entity, { scene.panels[panel].closedPosition, line.xRot, line.yRot, line.zRot, glm::vec3(1.0f, 1.0f, 1.0f) });
+			entities.AddRenderable(entity, { gSceneModels[line.model], 1.0f });
+			entities.AddBounds(entity);
+			entities.AddPanelAnimation(entity, { panel });
+		}
 	}
 
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Env_Transition_Door_Curved_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "tdoor1");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Env_Floor_04_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "floor");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Env_Ceiling_Light_02_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "clight");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Env_Door_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "door");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Env_Floor_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "hangarFloor");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Env_Construction_Wall_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "cwall");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Env_Ceiling_Light_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "hangarLight");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Desk_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "desk1");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Desk_02_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "desk2");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Desk_04_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "smallDesk");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Desk_03_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "bigDesk");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Beaker_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "beaker");
-	}
+	sTransformComponent transform;
+	transform.xRot = glm::vec3(1.0f, 0.0f, 0.0f);
+	transform.yRot = glm::vec3(0.0f, 1.0f, 0.0f);
+	transform.zRot = glm::vec3(0.0f, 0.0f, 1.0f);
+	transform.scale = glm::vec3(1.0f, 1.0f, 1.0f);
 
-	// WhatModelsShouldIUseINFO6028Midterm.exe models
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Lockers_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "locker1");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Lockers_02_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "locker2");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Monitor_03_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "monitor");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Plants_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "plant1");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Plants_03_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "plant2");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Rocket_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "rocket");
-	}
-	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Scales_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "scales");
-	}
+	for (const glm::vec3& position : starPositions)
 	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Server_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "server");
+		if (!gStarModel.IsValid())
+		{
+			break;
+		}
+
+		EntityHandle entity = entities.CreateEntity();
+		transform.position = position;
+		entities.AddTransform(entity, transform);
+		entities.AddRenderable(entity, { gStarModel, 1.0f });
+		entities.AddBounds(entity);
 	}
+
+	// Every light gets a frame drawn where it is, and goes wherever the entity is moved
+	for (const sSceneLight& sceneLight : scene.lights)
 	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\SM_Prop_Sign_01_xyz_n_rgba_uv.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "sign");
+		LightHandle light = LightManager::GetInstance()->GetLightHandle(scene.GetString(sceneLight.name));
+		if (!light.IsValid())
+		{
+			continue;
+		}
+
+		EntityHandle entity = entities.CreateEntity();
+		transform.position = sceneLight.position;
+		entities.AddTransform(entity, transform);
+		if (gLightFrameModel.IsValid()) // The light still follows the entity without one
+		{
+			entities.AddRenderable(entity, { gLightFrameModel, 1.0f });
+			entities.AddBounds(entity);
+		}
+		entities.AddLight(entity, { light });
 	}
+}
+
+void LoadModels(const sScene& scene)
+{
+	for (const sSceneModel& sceneModel : scene.models)
 	{
+		unsigned int loadFlags = ModelManager::LOAD_DEFAULT;
+		if (sceneModel.flags & SCENE_MODEL_PACKED_VERTICES)
+		{
+			loadFlags |= ModelManager::LOAD_PACKED_VERTICES; // Packed vertices are less than half the size, see PrintPackingReport for the error
+		}
+		if (sceneModel.flags & SCENE_MODEL_NO_VERTEX_COLORS)
+		{
+			loadFlags |= ModelManager::LOAD_NO_VERTEX_COLORS;
+		}
+
 		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\connector.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "connector");
+		ss << SOLUTION_DIR << "Extern\\assets\\" << scene.GetString(sceneModel.path);
+		ModelManager::GetInstance()->QueueModel(ss.str(), scene.GetString(sceneModel.name), loadFlags);
 	}
+
+	ModelManager::GetInstance()->LoadQueuedModels(); // Reads all the files in one batch
+
+	for (const sSceneModel& sceneModel : scene.models)
 	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\corner.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "corner");
+		Model* model = ModelManager::GetInstance()->GetModel(scene.GetString(sceneModel.name));
+		if (!model)
+		{
+			continue;
+		}
+
+		if (sceneModel.flags & SCENE_MODEL_WIREFRAME)
+		{
+			model->SetWireframe(true);
+		}
+		if (sceneModel.flags & SCENE_MODEL_IGNORE_LIGHTING)
+		{
+			model->SetIgnoreLighting(true);
+		}
+		if (sceneModel.flags & SCENE_MODEL_OVERRIDE_COLOR)
+		{
+			model->SetIsOverrideColor(true);
+			model->SetColorOverride(sceneModel.colorOverride);
+		}
 	}
+}
+
+void ResolveModelHandles(const sScene& scene)
+{
+	ModelManager* modelManager = ModelManager::GetInstance();
+	gSceneModels.clear();
+	for (const sSceneModel& sceneModel : scene.models)
 	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\corner2.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "corner2");
+		gSceneModels.push_back(modelManager->GetModelHandle(scene.GetString(sceneModel.name)));
 	}
+
+	// main places these itself, without them there are just no stars or light frames
+	gLightFrameModel = modelManager->GetModelHandle("lightFrame");
+	if (!gLightFrameModel.IsValid())
 	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\corner3.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "corner3");
+		std::cout << "The scene has no 'lightFrame' model, lights won't have frames" << std::endl;
 	}
+
+	gStarModel = modelManager->GetModelHandle("star");
+	if (!gStarModel.IsValid())
 	{
-		std::stringstream ss;
-		ss << SOLUTION_DIR << "Extern\\assets\\models\\corner4.ply";
-		Model* model = ModelManager::GetInstance()->LoadModel(ss.str(), "corner4");
+		std::cout << "The scene has no 'star' model, there won't be stars" << std::endl;
 	}
-}
\ No newline at end of file
+}